@@ -0,0 +1,158 @@
+#include "BoundingVolume.h"
+#include <cmath>
+#include <cfloat>
+
+/* Works out both the sphere and the box around a set of points. */
+void CBoundingVolume::ComputeBounds(const D3DXVECTOR3* points, unsigned int numberOfPoints, BoundsType& bounds)
+{
+	ComputeSphere(points, numberOfPoints, bounds.centre, bounds.radius);
+	ComputeBox(points, numberOfPoints, bounds.minPoint, bounds.maxPoint);
+}
+
+/* Finds a sphere close to the smallest one which holds every point, using Ritter's method.
+* Two points far apart are found to make a first guess, which is then grown to take in any point left outside it.
+* A sphere around the centre of the box is grown the same way, and whichever ends up smaller is kept.
+*/
+void CBoundingVolume::ComputeSphere(const D3DXVECTOR3* points, unsigned int numberOfPoints, D3DXVECTOR3& centre, float& radius)
+{
+	centre = D3DXVECTOR3(0.0f, 0.0f, 0.0f);
+	radius = 0.0f;
+
+	if (numberOfPoints == 0)
+	{
+		return;
+	}
+
+	// Find the point furthest from the first, then the point furthest from that.
+	unsigned int first = 0;
+	float furthestDistance = -1.0f;
+	for (unsigned int point = 0; point < numberOfPoints; point++)
+	{
+		D3DXVECTOR3 difference = points[point] - points[0];
+		float distance = D3DXVec3LengthSq(&difference);
+		if (distance > furthestDistance)
+		{
+			furthestDistance = distance;
+			first = point;
+		}
+	}
+
+	unsigned int second = first;
+	furthestDistance = -1.0f;
+	for (unsigned int point = 0; point < numberOfPoints; point++)
+	{
+		D3DXVECTOR3 difference = points[point] - points[first];
+		float distance = D3DXVec3LengthSq(&difference);
+		if (distance > furthestDistance)
+		{
+			furthestDistance = distance;
+			second = point;
+		}
+	}
+
+	centre = (points[first] + points[second]) * 0.5f;
+	radius = sqrtf(furthestDistance) * 0.5f;
+	GrowSphere(points, numberOfPoints, centre, radius);
+
+	// Boxy meshes are sometimes better served by a sphere around the middle of the box.
+	D3DXVECTOR3 minPoint;
+	D3DXVECTOR3 maxPoint;
+	ComputeBox(points, numberOfPoints, minPoint, maxPoint);
+
+	D3DXVECTOR3 boxCentre = (minPoint + maxPoint) * 0.5f;
+	float boxRadius = 0.0f;
+	GrowSphere(points, numberOfPoints, boxCentre, boxRadius);
+
+	if (boxRadius < radius)
+	{
+		centre = boxCentre;
+		radius = boxRadius;
+	}
+}
+
+/* Finds the smallest box lined up with the axes which holds every point. */
+void CBoundingVolume::ComputeBox(const D3DXVECTOR3* points, unsigned int numberOfPoints, D3DXVECTOR3& minPoint, D3DXVECTOR3& maxPoint)
+{
+	if (numberOfPoints == 0)
+	{
+		minPoint = D3DXVECTOR3(0.0f, 0.0f, 0.0f);
+		maxPoint = D3DXVECTOR3(0.0f, 0.0f, 0.0f);
+		return;
+	}
+
+	minPoint = points[0];
+	maxPoint = points[0];
+
+	for (unsigned int point = 1; point < numberOfPoints; point++)
+	{
+		D3DXVec3Minimize(&minPoint, &minPoint, &points[point]);
+		D3DXVec3Maximize(&maxPoint, &maxPoint, &points[point]);
+	}
+}
+
+/* Moves a sphere into world space. The radius is scaled by the longest axis of the matrix, so it still holds the mesh under uneven scaling. */
+void CBoundingVolume::TransformSphere(const D3DXVECTOR3& centre, float radius, const D3DXMATRIX& world, D3DXVECTOR3& worldCentre, float& worldRadius)
+{
+	D3DXVec3TransformCoord(&worldCentre, &centre, &world);
+
+	float scaleX = world._11 * world._11 + world._12 * world._12 + world._13 * world._13;
+	float scaleY = world._21 * world._21 + world._22 * world._22 + world._23 * world._23;
+	float scaleZ = world._31 * world._31 + world._32 * world._32 + world._33 * world._33;
+
+	float largestScale = scaleX > scaleY ? scaleX : scaleY;
+	largestScale = largestScale > scaleZ ? largestScale : scaleZ;
+
+	worldRadius = radius * sqrtf(largestScale);
+}
+
+/* Moves a box into world space and finds the box lined up with the world axes which holds it, using Arvo's method.
+* Each row of the matrix adds its smallest and largest contribution to the new box, rather than transforming all eight corners.
+*/
+void CBoundingVolume::TransformBox(const D3DXVECTOR3& minPoint, const D3DXVECTOR3& maxPoint, const D3DXMATRIX& world, D3DXVECTOR3& worldMin, D3DXVECTOR3& worldMax)
+{
+	float newMin[3] = { world._41, world._42, world._43 };
+	float newMax[3] = { world._41, world._42, world._43 };
+
+	const float oldMin[3] = { minPoint.x, minPoint.y, minPoint.z };
+	const float oldMax[3] = { maxPoint.x, maxPoint.y, maxPoint.z };
+
+	for (int row = 0; row < 3; row++)
+	{
+		for (int column = 0; column < 3; column++)
+		{
+			float a = world.m[row][column] * oldMin[row];
+			float b = world.m[row][column] * oldMax[row];
+
+			newMin[column] += a < b ? a : b;
+			newMax[column] += a < b ? b : a;
+		}
+	}
+
+	worldMin = D3DXVECTOR3(newMin[0], newMin[1], newMin[2]);
+	worldMax = D3DXVECTOR3(newMax[0], newMax[1], newMax[2]);
+}
+
+/* Grows a sphere just enough to take in each point which lies outside it, moving the centre towards that point. */
+void CBoundingVolume::GrowSphere(const D3DXVECTOR3* points, unsigned int numberOfPoints, D3DXVECTOR3& centre, float& radius)
+{
+	float radiusSquared = radius * radius;
+
+	for (unsigned int point = 0; point < numberOfPoints; point++)
+	{
+		D3DXVECTOR3 difference = points[point] - centre;
+		float distanceSquared = D3DXVec3LengthSq(&difference);
+
+		if (distanceSquared <= radiusSquared)
+		{
+			continue;
+		}
+
+		float distance = sqrtf(distanceSquared);
+		float newRadius = (radius + distance) * 0.5f;
+
+		// Slide the centre towards the point so the far side of the old sphere stays inside.
+		centre += difference * ((newRadius - radius) / distance);
+		radius = newRadius;
+		radiusSquared = radius * radius;
+	}
+}
@@ -0,0 +1,33 @@
+#ifndef BOUNDINGVOLUME_H
+#define BOUNDINGVOLUME_H
+
+#include <D3DX10math.h>
+#include "PrioEngineVars.h"
+
+/* Works out tight bounding spheres and boxes around a set of points, and moves them into world space.
+* These have no device dependencies, so they can be worked out and checked on the CPU alone.
+*/
+class CBoundingVolume
+{
+private:
+	CLogger* logger;
+public:
+	struct BoundsType
+	{
+		D3DXVECTOR3 centre;
+		float radius;
+		D3DXVECTOR3 minPoint;
+		D3DXVECTOR3 maxPoint;
+	};
+public:
+	static void ComputeBounds(const D3DXVECTOR3* points, unsigned int numberOfPoints, BoundsType& bounds);
+	static void ComputeSphere(const D3DXVECTOR3* points, unsigned int numberOfPoints, D3DXVECTOR3& centre, float& radius);
+	static void ComputeBox(const D3DXVECTOR3* points, unsigned int numberOfPoints, D3DXVECTOR3& minPoint, D3DXVECTOR3& maxPoint);
+
+	static void TransformSphere(const D3DXVECTOR3& centre, float radius, const D3DXMATRIX& world, D3DXVECTOR3& worldCentre, float& worldRadius);
+	static void TransformBox(const D3DXVECTOR3& minPoint, const D3DXVECTOR3& maxPoint, const D3DXMATRIX& world, D3DXVECTOR3& worldMin, D3DXVECTOR3& worldMax);
+private:
+	static void GrowSphere(const D3DXVECTOR3* points, unsigned int numberOfPoints, D3DXVECTOR3& centre, float& radius);
+};
+
+#endif
@@ -68,7 +68,7 @@ bool CCloudShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::strin
 	pixelShaderBuffer = nullptr;
 
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsFilename.c_str(), NULL, NULL, "CloudVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &vertexShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(vsFilename, "CloudVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &vertexShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -86,7 +86,7 @@ bool CCloudShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::strin
 
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(psFilename.c_str(), NULL, NULL, "CloudPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(psFilename, "CloudPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		// If we recieved an error message.
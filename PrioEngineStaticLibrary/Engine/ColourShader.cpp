@@ -64,7 +64,7 @@ bool CColourShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::stri
 	pixelShaderBuffer = nullptr;
 	
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsFilename.c_str(), NULL, NULL, "ColourVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &vertexShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(vsFilename, "ColourVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &vertexShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -81,7 +81,7 @@ bool CColourShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::stri
 	}
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(psFilename.c_str(), NULL, NULL, "ColourPixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(psFilename, "ColourPixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		// If we recieved an error message.
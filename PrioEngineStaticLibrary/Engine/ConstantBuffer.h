@@ -0,0 +1,250 @@
+#ifndef CONSTANTBUFFER_H
+#define CONSTANTBUFFER_H
+
+#include <d3d11.h>
+#include <D3DX10math.h>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include "PrioEngineVars.h"
+#include "RenderDevice.h"
+
+/* HLSL packs a cbuffer into 16 byte registers. A member may only cross from one register into the next if it starts at the beginning of one,
+* and every HLSL scalar is 4 bytes, so a C++ bool never lines up with an HLSL bool. Use this on each member of a constant buffer struct,
+* from anywhere the struct is visible, so a struct which doesn't match its cbuffer fails to compile rather than reading the wrong values.
+*/
+#define CHECK_CONSTANT_BUFFER_MEMBER(type, member) \
+	static_assert(sizeof(((type*)nullptr)->member) % 4 == 0 && \
+		(offsetof(type, member) % 16 == 0 || offsetof(type, member) % 16 + sizeof(((type*)nullptr)->member) <= 16), \
+		#type "::" #member " doesn't follow the HLSL packing rules, it must be made of 4 byte values and mustn't cross a 16 byte boundary.")
+
+/* A dynamic constant buffer along with a CPU copy of its contents.
+* Members are changed through Set, which only marks the bytes it covers as dirty when the value is actually different, and Update only maps the buffer when
+* something is dirty, so a shader which is given the same values every draw doesn't write them every draw. Matrices are stored transposed, ready for HLSL.
+*/
+template <typename BufferType>
+class CConstantBuffer
+{
+	static_assert(sizeof(BufferType) % 16 == 0, "A constant buffer must be a multiple of 16 bytes, pad the end of the struct to match the HLSL cbuffer.");
+	static_assert(std::is_trivially_copyable<BufferType>::value, "A constant buffer must be plain data, as it is copied to the GPU byte for byte.");
+private:
+	CLogger* logger;
+public:
+	CConstantBuffer()
+	{
+		mpBuffer = nullptr;
+		mpDevice = nullptr;
+		mUploads = 0;
+		mDirtyStart = 0;
+		mDirtyEnd = 0;
+		std::memset(&mData, 0, sizeof(BufferType));
+		MarkDirty(0, sizeof(BufferType));
+	}
+
+	~CConstantBuffer()
+	{
+		Shutdown();
+	}
+public:
+	/* Creates the buffer. Its contents are uploaded by the first Update.
+	* @Returns bool Success
+	*/
+	bool Initialise(ID3D11Device* device)
+	{
+		D3D11_BUFFER_DESC bufferDesc = GetDesc();
+
+		Shutdown();
+
+		if (FAILED(device->CreateBuffer(&bufferDesc, NULL, &mpBuffer)))
+		{
+			logger->GetInstance().WriteLine("Failed to create a constant buffer of " + std::to_string(sizeof(BufferType)) + " bytes.");
+			mpBuffer = nullptr;
+			return false;
+		}
+
+		MarkDirty(0, sizeof(BufferType));
+
+		return true;
+	}
+
+	/* Creates the buffer through a render device, which it is released through too, so it works with the null device.
+	* The device must outlive the buffer, or Shutdown must be called before it goes.
+	* @Returns bool Success
+	*/
+	bool Initialise(CRenderDevice* device)
+	{
+		D3D11_BUFFER_DESC bufferDesc = GetDesc();
+
+		Shutdown();
+
+		if (FAILED(device->CreateBuffer(&bufferDesc, NULL, &mpBuffer)))
+		{
+			logger->GetInstance().WriteLine("Failed to create a constant buffer of " + std::to_string(sizeof(BufferType)) + " bytes.");
+			mpBuffer = nullptr;
+			return false;
+		}
+
+		mpDevice = device;
+		MarkDirty(0, sizeof(BufferType));
+
+		return true;
+	}
+
+	void Shutdown()
+	{
+		if (mpBuffer != nullptr)
+		{
+			if (mpDevice != nullptr)
+			{
+				mpDevice->ReleaseResource(mpBuffer);
+			}
+			else
+			{
+				mpBuffer->Release();
+			}
+			mpBuffer = nullptr;
+		}
+
+		mpDevice = nullptr;
+	}
+
+	template <typename MemberType>
+	void Set(MemberType BufferType::* member, const MemberType& value)
+	{
+		MemberType& destination = mData.*member;
+
+		if (std::memcmp(&destination, &value, sizeof(MemberType)) != 0)
+		{
+			destination = value;
+			MarkDirty(OffsetOf(&destination), sizeof(MemberType));
+		}
+	}
+
+	/* Stores the transpose of a matrix, comparing against what's already stored so the transpose is only written when the matrix changes. */
+	void SetTransposed(D3DXMATRIX BufferType::* member, const D3DXMATRIX& matrix)
+	{
+		D3DXMATRIX& destination = mData.*member;
+		bool changed = false;
+
+		for (unsigned int row = 0; row < 4 && !changed; row++)
+		{
+			for (unsigned int column = 0; column < 4 && !changed; column++)
+			{
+				changed = destination.m[column][row] != matrix.m[row][column];
+			}
+		}
+
+		if (changed)
+		{
+			D3DXMatrixTranspose(&destination, &matrix);
+			MarkDirty(OffsetOf(&destination), sizeof(D3DXMATRIX));
+		}
+	}
+
+	/* Copies the CPU copy into the buffer if any of it has changed since the last update.
+	* @Returns bool Success
+	*/
+	bool Update(ID3D11DeviceContext* deviceContext)
+	{
+		if (!IsDirty())
+		{
+			return true;
+		}
+
+		D3D11_MAPPED_SUBRESOURCE mappedResource;
+		if (mpBuffer == nullptr || FAILED(deviceContext->Map(mpBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource)))
+		{
+			logger->GetInstance().WriteLine("Failed to lock a constant buffer when updating it.");
+			return false;
+		}
+
+		// Discarding leaves the buffer undefined, so the whole thing is written even if only part of it is dirty.
+		std::memcpy(mappedResource.pData, &mData, sizeof(BufferType));
+		deviceContext->Unmap(mpBuffer, 0);
+		Clean();
+
+		return true;
+	}
+
+	bool Update(CRenderDevice* device)
+	{
+		if (!IsDirty())
+		{
+			return true;
+		}
+
+		D3D11_MAPPED_SUBRESOURCE mappedResource;
+		if (mpBuffer == nullptr || FAILED(device->Map(mpBuffer, 0, D3D11_MAP_WRITE_DISCARD, &mappedResource)))
+		{
+			logger->GetInstance().WriteLine("Failed to lock a constant buffer when updating it.");
+			return false;
+		}
+
+		std::memcpy(mappedResource.pData, &mData, sizeof(BufferType));
+		device->Unmap(mpBuffer, 0, 0, sizeof(BufferType));
+		Clean();
+
+		return true;
+	}
+
+	// Forces the next Update to write the buffer, for when its contents may have been lost.
+	void Invalidate() { MarkDirty(0, sizeof(BufferType)); };
+
+	const BufferType& Get() { return mData; };
+	ID3D11Buffer* GetBuffer() { return mpBuffer; };
+	// For the Set*ConstantBuffers calls, which take an array of buffers.
+	ID3D11Buffer* const* GetBufferAddress() { return &mpBuffer; };
+	bool IsDirty() { return mDirtyEnd > mDirtyStart; };
+	unsigned int GetDirtyStart() { return mDirtyStart; };
+	unsigned int GetDirtyEnd() { return mDirtyEnd; };
+	unsigned int GetNumberOfUploads() { return mUploads; };
+private:
+	static D3D11_BUFFER_DESC GetDesc()
+	{
+		D3D11_BUFFER_DESC bufferDesc;
+		bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+		bufferDesc.ByteWidth = sizeof(BufferType);
+		bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		bufferDesc.MiscFlags = 0;
+		bufferDesc.StructureByteStride = 0;
+
+		return bufferDesc;
+	}
+
+	unsigned int OffsetOf(const void* member)
+	{
+		return static_cast<unsigned int>(static_cast<const unsigned char*>(member) - reinterpret_cast<const unsigned char*>(&mData));
+	}
+
+	void MarkDirty(unsigned int start, unsigned int size)
+	{
+		if (!IsDirty())
+		{
+			mDirtyStart = start;
+			mDirtyEnd = start + size;
+			return;
+		}
+
+		mDirtyStart = start < mDirtyStart ? start : mDirtyStart;
+		mDirtyEnd = start + size > mDirtyEnd ? start + size : mDirtyEnd;
+	}
+
+	void Clean()
+	{
+		mDirtyStart = 0;
+		mDirtyEnd = 0;
+		mUploads++;
+	}
+
+	ID3D11Buffer* mpBuffer;
+	// The render device the buffer was made through, null if it was made straight on a Direct3D device.
+	CRenderDevice* mpDevice;
+	BufferType mData;
+	// The bytes which have changed since the last update.
+	unsigned int mDirtyStart;
+	unsigned int mDirtyEnd;
+	unsigned int mUploads;
+};
+
+#endif
@@ -0,0 +1,149 @@
+#include "ConstantRing.h"
+#include <cstring>
+
+CConstantRing::CConstantRing()
+{
+	mpBuffer = nullptr;
+	mBufferSize = 0;
+	mSize = 0;
+	mUploadedSize = 0;
+	mAllocations = 0;
+	mUploads = 0;
+}
+
+CConstantRing::~CConstantRing()
+{
+}
+
+/* Creates the constant buffer, it grows later if a frame needs more than this.
+* @Returns bool Success
+*/
+bool CConstantRing::Initialise(CRenderDevice* device, unsigned int size)
+{
+	mData.reserve(size);
+	Reset();
+
+	return CreateBuffer(device, size);
+}
+
+void CConstantRing::Shutdown(CRenderDevice* device)
+{
+	if (mpBuffer != nullptr)
+	{
+		device->ReleaseResource(mpBuffer);
+		mpBuffer = nullptr;
+	}
+
+	mBufferSize = 0;
+	mData.clear();
+	Reset();
+}
+
+/* Replaces the buffer with one of the given size. */
+bool CConstantRing::CreateBuffer(CRenderDevice* device, unsigned int size)
+{
+	if (mpBuffer != nullptr)
+	{
+		device->ReleaseResource(mpBuffer);
+		mpBuffer = nullptr;
+		mBufferSize = 0;
+	}
+
+	D3D11_BUFFER_DESC bufferDesc;
+	bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	bufferDesc.ByteWidth = size;
+	bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	bufferDesc.MiscFlags = 0;
+	bufferDesc.StructureByteStride = 0;
+
+	if (FAILED(device->CreateBuffer(&bufferDesc, NULL, &mpBuffer)))
+	{
+		logger->GetInstance().WriteLine("Failed to create the constant ring buffer of " + std::to_string(size) + " bytes.");
+		mpBuffer = nullptr;
+		return false;
+	}
+
+	mBufferSize = size;
+
+	return true;
+}
+
+/* Reserves room for some constants, aligned so that they can be bound by offset.
+* @Returns void* - Where to write the constants, or null if the ring has reached its largest size.
+*/
+void* CConstantRing::Allocate(unsigned int size, RangeType& range)
+{
+	const unsigned int alignedSize = (size + kAlignment - 1) / kAlignment * kAlignment;
+
+	if (size == 0 || mSize + alignedSize > kMaxSize)
+	{
+		return nullptr;
+	}
+
+	range.firstConstant = mSize / 16;
+	range.numberOfConstants = alignedSize / 16;
+
+	if (mData.size() < mSize + alignedSize)
+	{
+		mData.resize(mSize + alignedSize);
+	}
+
+	void* data = &mData[mSize];
+	std::memset(data, 0, alignedSize);
+
+	mSize += alignedSize;
+	mAllocations++;
+
+	return data;
+}
+
+/* Copies everything allocated since the last upload into the buffer, growing the buffer first if it's too small.
+* Draws issued before this keep the contents they were issued with, as the map discards the old buffer.
+* @Returns bool Success
+*/
+bool CConstantRing::Upload(CRenderDevice* device)
+{
+	if (mUploadedSize == mSize)
+	{
+		return true;
+	}
+
+	if (mSize > mBufferSize)
+	{
+		unsigned int size = mBufferSize * 2;
+		size = size < mSize ? mSize : size;
+		size = size > kMaxSize ? kMaxSize : size;
+
+		if (!CreateBuffer(device, size))
+		{
+			return false;
+		}
+	}
+
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	if (FAILED(device->Map(mpBuffer, 0, D3D11_MAP_WRITE_DISCARD, &mappedResource)))
+	{
+		logger->GetInstance().WriteLine("Failed to lock the constant ring buffer when uploading to it.");
+		return false;
+	}
+
+	unsigned char* destination = static_cast<unsigned char*>(mappedResource.pData);
+	std::memcpy(destination + mUploadedSize, &mData[mUploadedSize], mSize - mUploadedSize);
+
+	device->Unmap(mpBuffer, 0, mUploadedSize, mSize - mUploadedSize);
+
+	mUploadedSize = mSize;
+	mUploads++;
+
+	return true;
+}
+
+/* Starts the ring again from the beginning, call once a frame. */
+void CConstantRing::Reset()
+{
+	mSize = 0;
+	mUploadedSize = 0;
+	mAllocations = 0;
+	mUploads = 0;
+}
@@ -0,0 +1,63 @@
+#ifndef CONSTANTRING_H
+#define CONSTANTRING_H
+
+#include <d3d11.h>
+#include <vector>
+#include "PrioEngineVars.h"
+#include "RenderDevice.h"
+
+/* A linear allocator for the constant data of a frame's draws, backed by one large dynamic constant buffer.
+* Constants are written into CPU memory with Allocate, then everything allocated since the last upload is copied to the buffer with a single map in Upload,
+* and each draw binds its own part of the buffer by offset. This replaces a map of a small constant buffer for every shader and material change.
+*
+* Binding by offset needs Direct3D 11.1, so callers should check CanBind and fall back to their own constant buffers when it returns false.
+*/
+class CConstantRing
+{
+private:
+	CLogger* logger;
+public:
+	// A part of the buffer, in 16 byte constants, as taken by VSSetConstantBufferRange and PSSetConstantBufferRange.
+	struct RangeType
+	{
+		unsigned int firstConstant;
+		unsigned int numberOfConstants;
+	};
+public:
+	CConstantRing();
+	~CConstantRing();
+public:
+	bool Initialise(CRenderDevice* device, unsigned int size);
+	void Shutdown(CRenderDevice* device);
+
+	bool CanBind(CRenderDevice* device) { return mpBuffer != nullptr && device->SupportsConstantBufferOffsets(); };
+
+	// The pointer is only valid until the next call to Allocate. Returns null if the ring is full.
+	void* Allocate(unsigned int size, RangeType& range);
+	bool Upload(CRenderDevice* device);
+	void Reset();
+
+	ID3D11Buffer* GetBuffer() { return mpBuffer; };
+	unsigned int GetSize() { return mSize; };
+	unsigned int GetNumberOfAllocations() { return mAllocations; };
+	unsigned int GetNumberOfUploads() { return mUploads; };
+private:
+	bool CreateBuffer(CRenderDevice* device, unsigned int size);
+
+	// Offsets have to be a multiple of 16 constants.
+	static const unsigned int kAlignment = 256;
+	// The buffer grows to fit a frame, but no further than this.
+	const unsigned int kMaxSize = 4 * 1024 * 1024;
+
+	ID3D11Buffer* mpBuffer;
+	unsigned int mBufferSize;
+	std::vector<unsigned char> mData;
+	// Bytes allocated this frame, and how many of them have been uploaded.
+	unsigned int mSize;
+	unsigned int mUploadedSize;
+
+	unsigned int mAllocations;
+	unsigned int mUploads;
+};
+
+#endif
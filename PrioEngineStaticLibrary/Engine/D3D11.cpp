@@ -1,4 +1,5 @@
 #include "D3D11.h"
+#include "Texture.h"
 
 CD3D11::CD3D11()
 {
@@ -7,7 +8,13 @@ CD3D11::CD3D11()
 	mpAlphaBlendingStateEnabled = nullptr;	
 	mpRasterStateNoCulling = nullptr;
 	mpAdditiveAlphaBlendingStateEnabled = nullptr;
-	mpDepthState = nullptr;
+	mpStateCache = nullptr;
+	mpDeviceContext1 = nullptr;
+	mTotalStateChanges = 0;
+	mTotalStateChangesSkipped = 0;
+
+	InvalidateStateTracking();
+	ResetStateCounters();
 }
 
 
@@ -191,6 +198,11 @@ bool CD3D11::Initialise(int screenWidth, int screenHeight, bool vsync, HWND hwnd
 		return false;
 	}
 
+	QueryConstantBufferOffsets();
+
+	mpStateCache = new CStateCache(mpDevice);
+	logger->GetInstance().MemoryAllocWriteLine(typeid(mpStateCache).name());
+
 	// Grab pointer to the back buffer.
 	result = mpSwapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), (LPVOID*)&backBufferPtr);
 	// If we did not successfully grab the pointer to the back buffer.
@@ -236,7 +248,7 @@ bool CD3D11::Initialise(int screenWidth, int screenHeight, bool vsync, HWND hwnd
 	}
 
 	// Put the depth stencil buffer into effect!
-	mpDeviceContext->OMSetDepthStencilState(mpDepthEnabledStencilState, 1);
+	SetDepthStencilState(mpDepthEnabledStencilState, 1);
 
 	/* Create the depth stencil view. */
 
@@ -265,8 +277,8 @@ bool CD3D11::Initialise(int screenWidth, int screenHeight, bool vsync, HWND hwnd
 	noCullRasterDesc.SlopeScaledDepthBias = 0.0f;
 
 	// Create the no culling rasterizer state.
-	result = mpDevice->CreateRasterizerState(&noCullRasterDesc, &mpRasterStateNoCulling);
-	if (FAILED(result))
+	mpRasterStateNoCulling = mpStateCache->GetRasterizerState(noCullRasterDesc);
+	if (mpRasterStateNoCulling == nullptr)
 	{
 		logger->GetInstance().WriteLine("Failed to create the rasterizer state with no culling.");
 		return false;
@@ -307,8 +319,8 @@ bool CD3D11::Initialise(int screenWidth, int screenHeight, bool vsync, HWND hwnd
 	 blendStateDesc.RenderTarget[0].RenderTargetWriteMask = 0x0f;
 
 
-	 result = mpDevice->CreateBlendState(&blendStateDesc, &mpAlphaBlendingStateEnabled);
-	 if (FAILED(result))
+	 mpAlphaBlendingStateEnabled = mpStateCache->GetBlendState(blendStateDesc);
+	 if (mpAlphaBlendingStateEnabled == nullptr)
 	 {
 		 logger->GetInstance().WriteLine("Failed to create the alpha blending state enabled from descriptor.");
 		 return false;
@@ -317,8 +329,8 @@ bool CD3D11::Initialise(int screenWidth, int screenHeight, bool vsync, HWND hwnd
 	 // Alter to disable alpha blending.
 	 blendStateDesc.RenderTarget[0].BlendEnable = FALSE;
 
-	 result = mpDevice->CreateBlendState(&blendStateDesc, &mpAlphaBlendingStateDisabled);
-	 if (FAILED(result))
+	 mpAlphaBlendingStateDisabled = mpStateCache->GetBlendState(blendStateDesc);
+	 if (mpAlphaBlendingStateDisabled == nullptr)
 	 {
 		 logger->GetInstance().WriteLine("Failed to create the alpha blending state disabled from descriptor.");
 		 return false;
@@ -338,8 +350,8 @@ bool CD3D11::Initialise(int screenWidth, int screenHeight, bool vsync, HWND hwnd
 	 blendStateDesc.RenderTarget[0].RenderTargetWriteMask = 0x0f;
 
 
-	 result = mpDevice->CreateBlendState(&blendStateDesc, &mpAdditiveAlphaBlendingStateEnabled);
-	 if (FAILED(result))
+	 mpAdditiveAlphaBlendingStateEnabled = mpStateCache->GetBlendState(blendStateDesc);
+	 if (mpAdditiveAlphaBlendingStateEnabled == nullptr)
 	 {
 		 logger->GetInstance().WriteLine("Failed to create the additive alpha blending state enabled from descriptor.");
 		 return false;
@@ -354,12 +366,6 @@ void CD3D11::Shutdown()
 {
 	logger->GetInstance().WriteLine("DirectX Shutdown Function Initialised.");
 
-	if (mpDepthState != nullptr)
-	{
-		mpDepthState->Release();
-		mpDepthState = nullptr;
-	}
-
 	// If swap chain has been intialised.
 	if (mpSwapChain)
 	{
@@ -369,38 +375,24 @@ void CD3D11::Shutdown()
 		logger->GetInstance().WriteLine("Set to windowed mode.");
 	}
 
-	// If blending state initialised.
-	if (mpAlphaBlendingStateEnabled)
-	{
-		mpAlphaBlendingStateEnabled->Release();
-		mpAlphaBlendingStateEnabled = nullptr;
-	}
-
-	if (mpAdditiveAlphaBlendingStateEnabled)
-	{
-		mpAdditiveAlphaBlendingStateEnabled->Release();
-		mpAdditiveAlphaBlendingStateEnabled = nullptr;
-	}
-
-	// If blending state initialised.
-	if (mpAlphaBlendingStateDisabled)
-	{
-		mpAlphaBlendingStateDisabled->Release();
-		mpAlphaBlendingStateDisabled = nullptr;
-	}
-
-	// If rasterizer state has been initialised.
-	if (mpRasterizerState)
-	{
-		// Release the rasterizer.
-		mpRasterizerState->Release();
-		mpRasterizerState = nullptr;
-	}
+	// The blend, rasterizer and depth stencil states all belong to the state cache.
+	mpAlphaBlendingStateEnabled = nullptr;
+	mpAdditiveAlphaBlendingStateEnabled = nullptr;
+	mpAlphaBlendingStateDisabled = nullptr;
+	mpRasterizerState = nullptr;
+	mpRasterStateNoCulling = nullptr;
+	mpDepthEnabledStencilState = nullptr;
+	mpDepthDisabledStencilState = nullptr;
+	InvalidateStateTracking();
 
-	if (mpRasterStateNoCulling)
+	if (mpStateCache != nullptr)
 	{
-		mpRasterStateNoCulling->Release();
-		mpRasterStateNoCulling = nullptr;
+		logger->GetInstance().WriteLine("The state cache made " + std::to_string(mpStateCache->GetNumberOfStates()) + " state objects and answered " + std::to_string(mpStateCache->GetHits()) + " requests without making one.");
+		logger->GetInstance().WriteLine("State tracking skipped " + std::to_string(mTotalStateChangesSkipped) + " of " + std::to_string(mTotalStateChanges + mTotalStateChangesSkipped) + " state changes as the state was already set.");
+		mpStateCache->Shutdown();
+		delete mpStateCache;
+		mpStateCache = nullptr;
+		logger->GetInstance().MemoryDeallocWriteLine(typeid(mpStateCache).name());
 	}
 
 	// If depth stencil view has been initialised.
@@ -411,20 +403,6 @@ void CD3D11::Shutdown()
 		mpDepthStencilView = nullptr;
 	}
 
-	// If depth stencil state has been initialised.
-	if (mpDepthEnabledStencilState)
-	{
-		// Release the depth stencil state.
-		mpDepthEnabledStencilState->Release();
-		mpDepthEnabledStencilState = nullptr;
-	}
-
-	if (mpDepthDisabledStencilState)
-	{
-		mpDepthDisabledStencilState->Release();
-		mpDepthDisabledStencilState = nullptr;
-	}
-
 	// If depth stencil buffer has been initialised.
 	if (mpDepthStencilBuffer)
 	{
@@ -443,6 +421,12 @@ void CD3D11::Shutdown()
 
 	TwTerminate();
 
+	if (mpDeviceContext1)
+	{
+		mpDeviceContext1->Release();
+		mpDeviceContext1 = nullptr;
+	}
+
 	// If device context has been initialised.
 	if (mpDeviceContext)
 	{
@@ -490,6 +474,10 @@ void CD3D11::BeginScene(float red, float green, float blue, float alpha)
 	// Clear the depth buffer.
 	mpDeviceContext->ClearDepthStencilView(mpDepthStencilView, D3D11_CLEAR_DEPTH, 1.0f, 0);
 
+	// The tweak bar draws with its own states at the end of each frame, so start each frame without trusting what we think is set.
+	InvalidateStateTracking();
+	ResetStateCounters();
+
 	return;
 }
 
@@ -540,105 +528,76 @@ void CD3D11::GetOrthogonalMatrix(D3DMATRIX & orthogMatrix)
 
 void CD3D11::EnableWireframeFill()
 {
-	HRESULT	result;
-
-	mpRasterizerState->Release();
-
-	D3D11_RASTERIZER_DESC rasterDesc;
-
-	// Set up the description for the raster which dictates how many polygons are drawn.
-	rasterDesc.AntialiasedLineEnable = false;
-	//rasterDesc.CullMode = D3D11_CULL_BACK;
-	rasterDesc.CullMode = D3D11_CULL_BACK;
-	rasterDesc.DepthBias = 0;
-	rasterDesc.DepthBiasClamp = 0.0f;
-	rasterDesc.DepthClipEnable = true;
-	rasterDesc.FillMode = D3D11_FILL_WIREFRAME;
-	rasterDesc.FrontCounterClockwise = false;
-	rasterDesc.MultisampleEnable = false;
-	rasterDesc.ScissorEnable = false;
-	rasterDesc.SlopeScaledDepthBias = 0.0f;
-
-	// Create the rasterizer state from the previously defined description.
-	result = mpDevice->CreateRasterizerState(&rasterDesc, &mpRasterizerState);
-	// If we failed to create the rasterizer.
-	if (FAILED(result))
+	if (SetFillMode(D3D11_FILL_WIREFRAME))
 	{
-		// Log the error message
-		logger->GetInstance().WriteLine("Failed to create the rasterizer from the description provided.");
+		logger->GetInstance().WriteLine("Rasterizer state changed to use wireframe fill.");
 	}
-
-	// Set the rasterizer state.
-	mpDeviceContext->RSSetState(mpRasterizerState);
-	logger->GetInstance().WriteLine("Rasterizer state changed to use wireframe fill.");
 }
 
 void CD3D11::EnableSolidFill()
 {
-	HRESULT result;
-	mpRasterizerState->Release();
+	if (SetFillMode(D3D11_FILL_SOLID))
+	{
+		logger->GetInstance().WriteLine("Rasterizer state changed to use solid fill.");
+	}
+}
 
+/* Swaps the back face culling rasterizer state for one with the given fill mode, the state cache keeps both so toggling doesn't create anything new. */
+bool CD3D11::SetFillMode(D3D11_FILL_MODE fillMode)
+{
 	D3D11_RASTERIZER_DESC rasterDesc;
 
 	// Set up the description for the raster which dictates how many polygons are drawn.
 	rasterDesc.AntialiasedLineEnable = false;
-	//rasterDesc.CullMode = D3D11_CULL_BACK;
 	rasterDesc.CullMode = D3D11_CULL_BACK;
 	rasterDesc.DepthBias = 0;
 	rasterDesc.DepthBiasClamp = 0.0f;
 	rasterDesc.DepthClipEnable = true;
-	rasterDesc.FillMode = D3D11_FILL_SOLID;
+	rasterDesc.FillMode = fillMode;
 	rasterDesc.FrontCounterClockwise = false;
 	rasterDesc.MultisampleEnable = false;
 	rasterDesc.ScissorEnable = false;
 	rasterDesc.SlopeScaledDepthBias = 0.0f;
 
-	// Create the rasterizer state from the previously defined description.
-	result = mpDevice->CreateRasterizerState(&rasterDesc, &mpRasterizerState);
+	ID3D11RasterizerState* rasterizerState = mpStateCache->GetRasterizerState(rasterDesc);
 	// If we failed to create the rasterizer.
-	if (FAILED(result))
+	if (rasterizerState == nullptr)
 	{
 		// Log the error message
 		logger->GetInstance().WriteLine("Failed to create the rasterizer from the description provided.");
+		return false;
 	}
 
 	// Set the rasterizer state.
-	mpDeviceContext->RSSetState(mpRasterizerState);
+	mpRasterizerState = rasterizerState;
+	SetRasterizerState(mpRasterizerState);
 
-	logger->GetInstance().WriteLine("Rasterizer state changed to use solid fill.");
+	return true;
 }
 
 void CD3D11::EnableAlphaBlending()
 {
-	float blendFactor[4] = {0.0f, 0.0f, 0.0f, 0.0f};
-
-	mpDeviceContext->OMSetBlendState(mpAlphaBlendingStateEnabled, blendFactor, 0xffffffff);
+	SetBlendState(mpAlphaBlendingStateEnabled);
 }
 
 void CD3D11::DisableAlphaBlending()
 {
-	float blendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
-
-	mpDeviceContext->OMSetBlendState(mpAlphaBlendingStateDisabled, blendFactor, 0xffffffff);
+	SetBlendState(mpAlphaBlendingStateDisabled);
 }
 
 void CD3D11::EnableAdditiveAlphaBlending()
 {
-	float blendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
-
-	mpDeviceContext->OMSetBlendState(mpAdditiveAlphaBlendingStateEnabled, blendFactor, 0xffffffff);
+	SetBlendState(mpAdditiveAlphaBlendingStateEnabled);
 }
 
 void CD3D11::DisableZBuffer()
 {
-	// Create the stencil buffer from the descriptor.
-	mpDeviceContext->OMSetDepthStencilState(mpDepthDisabledStencilState, 1);
+	SetDepthStencilState(mpDepthDisabledStencilState, 1);
 }
 
 void CD3D11::EnableZBuffer()
 {
-	// Create the stencil buffer from the descriptor.
-	mpDeviceContext->OMSetDepthStencilState(mpDepthEnabledStencilState, 1);
+	SetDepthStencilState(mpDepthEnabledStencilState, 1);
 }
 
 /* Gets information about the graphics card that DirectX is using. */
@@ -735,6 +694,26 @@ bool CD3D11::CreateSwapChain(D3D_FEATURE_LEVEL & featureLevel, DXGI_SWAP_CHAIN_D
 	return true;
 }
 
+/* Asks for the Direct3D 11.1 context if the driver can bind part of a constant buffer. Without it, ranges are bound as whole buffers and the constant ring isn't used. */
+void CD3D11::QueryConstantBufferOffsets()
+{
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options;
+	ZeroMemory(&options, sizeof(options));
+
+	mpDeviceContext1 = nullptr;
+	if (FAILED(mpDevice->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))) || !options.ConstantBufferOffsetting)
+	{
+		logger->GetInstance().WriteLine("The driver can't bind constant buffers by offset, constant data will be written per draw.");
+		return;
+	}
+
+	if (FAILED(mpDeviceContext->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)&mpDeviceContext1)))
+	{
+		logger->GetInstance().WriteLine("Failed to get the Direct3D 11.1 device context, constant data will be written per draw.");
+		mpDeviceContext1 = nullptr;
+	}
+}
+
 /* Initialises a depth buffer descriptor which is passed in by reference, and creates the depth buffer from that descriptor. */
 bool CD3D11::CreateDepthBuffer(D3D11_TEXTURE2D_DESC& depthBufferDesc)
 {
@@ -805,8 +784,6 @@ bool CD3D11::CreateDepthStencilView(D3D11_DEPTH_STENCIL_VIEW_DESC& depthStencilV
 /* Initialises a depth stencil buffer descriptor which is passed in as a by reference parameter. */
 bool CD3D11::CreateDepthStencilBuffer(D3D11_DEPTH_STENCIL_DESC& depthStencilBufferDesc)
 {
-	HRESULT result;
-
 	// Initialise the description of the stencil state.
 	depthStencilBufferDesc = {};
 
@@ -832,8 +809,8 @@ bool CD3D11::CreateDepthStencilBuffer(D3D11_DEPTH_STENCIL_DESC& depthStencilBuff
 	depthStencilBufferDesc.BackFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
 
 	// Create the stencil buffer from the descriptor.
-	result = mpDevice->CreateDepthStencilState(&depthStencilBufferDesc, &mpDepthEnabledStencilState);
-	if (FAILED(result))
+	mpDepthEnabledStencilState = mpStateCache->GetDepthStencilState(depthStencilBufferDesc);
+	if (mpDepthEnabledStencilState == nullptr)
 	{
 		// Log the error message.
 		logger->GetInstance().WriteLine("Failed to create the depth stencil buffer from the descriptor provided.");
@@ -846,7 +823,6 @@ bool CD3D11::CreateDepthStencilBuffer(D3D11_DEPTH_STENCIL_DESC& depthStencilBuff
 
 bool CD3D11::CreateDepthDisabledStencilState(D3D11_DEPTH_STENCIL_DESC& depthStencilBufferDesc)
 {
-	HRESULT result;
 	// Clear the second depth stencil state before setting the parameters.
 	ZeroMemory(&depthStencilBufferDesc, sizeof(depthStencilBufferDesc));
 
@@ -868,8 +844,8 @@ bool CD3D11::CreateDepthDisabledStencilState(D3D11_DEPTH_STENCIL_DESC& depthSten
 	depthStencilBufferDesc.BackFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
 
 	// Create the stencil buffer from the descriptor.
-	result = mpDevice->CreateDepthStencilState(&depthStencilBufferDesc, &mpDepthDisabledStencilState);
-	if (FAILED(result))
+	mpDepthDisabledStencilState = mpStateCache->GetDepthStencilState(depthStencilBufferDesc);
+	if (mpDepthDisabledStencilState == nullptr)
 	{
 		// Log the error message.
 		logger->GetInstance().WriteLine("Failed to create the depth stencil buffer from the descriptor provided.");
@@ -883,8 +859,6 @@ bool CD3D11::CreateDepthDisabledStencilState(D3D11_DEPTH_STENCIL_DESC& depthSten
 /* Initialises a rasterizer descriptor which is passed in by reference, and attempts to create the rasterizer. */
 bool CD3D11::InitRasterizer(D3D11_RASTERIZER_DESC& rasterDesc)
 {
-	HRESULT result;
-
 	// Set up the description for the raster which dictates how many polygons are drawn.
 	rasterDesc.AntialiasedLineEnable = false;
 	rasterDesc.CullMode = D3D11_CULL_BACK;
@@ -898,9 +872,9 @@ bool CD3D11::InitRasterizer(D3D11_RASTERIZER_DESC& rasterDesc)
 	rasterDesc.SlopeScaledDepthBias = 0.0f;
 
 	// Create the rasterizer state from the previously defined description.
-	result = mpDevice->CreateRasterizerState(&rasterDesc, &mpRasterizerState);
+	mpRasterizerState = mpStateCache->GetRasterizerState(rasterDesc);
 	// If we failed to create the rasterizer.
-	if (FAILED(result))
+	if (mpRasterizerState == nullptr)
 	{
 		// Log the error message
 		logger->GetInstance().WriteLine("Failed to create the rasterizer from the description provided.");
@@ -909,7 +883,7 @@ bool CD3D11::InitRasterizer(D3D11_RASTERIZER_DESC& rasterDesc)
 	}
 
 	// Set the rasterizer state.
-	mpDeviceContext->RSSetState(mpRasterizerState);
+	SetRasterizerState(mpRasterizerState);
 
 	return true;
 }
@@ -943,14 +917,9 @@ void CD3D11::CreateProjMatrix(float screenDepth, float screenNear)
 	D3DXMatrixPerspectiveFovLH(&mProjectionMatrix, fieldOfView, screenAspect, screenNear, screenDepth);
 }
 
+/* Sets a depth stencil state made from these switches. Each combination is only created the first time it is asked for. */
 void CD3D11::SetDepthState(bool depth, bool stencil, bool depthWrite)
 {
-	if (mpDepthState != nullptr)
-	{
-		mpDepthState->Release();
-		mpDepthState = nullptr;
-	}
-
 	D3D11_DEPTH_STENCIL_DESC depthStateDesc;
 
 	ZeroMemory(&depthStateDesc, sizeof(depthStateDesc));
@@ -958,9 +927,15 @@ void CD3D11::SetDepthState(bool depth, bool stencil, bool depthWrite)
 	depthStateDesc.DepthFunc = D3D11_COMPARISON_LESS;
 	depthStateDesc.DepthWriteMask = depthWrite ? D3D11_DEPTH_WRITE_MASK_ALL : D3D11_DEPTH_WRITE_MASK_ZERO;
 	depthStateDesc.StencilEnable = stencil;
-	mpDevice->CreateDepthStencilState(&depthStateDesc, &mpDepthState);
-	mpDeviceContext->OMSetDepthStencilState(mpDepthState, 1);
 
+	ID3D11DepthStencilState* depthState = mpStateCache->GetDepthStencilState(depthStateDesc);
+	if (depthState == nullptr)
+	{
+		logger->GetInstance().WriteLine("Failed to create the depth stencil state from the descriptor provided.");
+		return;
+	}
+
+	SetDepthStencilState(depthState, 1);
 }
 
 bool CD3D11::ToggleFullscreen(bool fullscreenEnabled)
@@ -979,12 +954,80 @@ bool CD3D11::ToggleFullscreen(bool fullscreenEnabled)
 
 void CD3D11::TurnOnBackFaceCulling()
 {
-	mpDeviceContext->RSSetState(mpRasterizerState);
+	SetRasterizerState(mpRasterizerState);
 }
 
 void CD3D11::TurnOffBackFaceCulling()
 {
-	mpDeviceContext->RSSetState(mpRasterStateNoCulling);
+	SetRasterizerState(mpRasterStateNoCulling);
+}
+
+/////////////////////////////
+// State tracking
+/////////////////////////////
+
+void CD3D11::SetRasterizerState(ID3D11RasterizerState* state)
+{
+	if (state == mpCurrentRasterizerState)
+	{
+		mStateChangesSkipped++;
+		mTotalStateChangesSkipped++;
+		return;
+	}
+
+	mpDeviceContext->RSSetState(state);
+	mpCurrentRasterizerState = state;
+	mStateChanges++;
+	mTotalStateChanges++;
+}
+
+/* Every blend state we use has a zero blend factor and a full sample mask, so only the state itself needs comparing. */
+void CD3D11::SetBlendState(ID3D11BlendState* state)
+{
+	if (state == mpCurrentBlendState)
+	{
+		mStateChangesSkipped++;
+		mTotalStateChangesSkipped++;
+		return;
+	}
+
+	float blendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+	mpDeviceContext->OMSetBlendState(state, blendFactor, 0xffffffff);
+	mpCurrentBlendState = state;
+	mStateChanges++;
+	mTotalStateChanges++;
+}
+
+void CD3D11::SetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef)
+{
+	if (state == mpCurrentDepthStencilState && stencilRef == mCurrentStencilRef)
+	{
+		mStateChangesSkipped++;
+		mTotalStateChangesSkipped++;
+		return;
+	}
+
+	mpDeviceContext->OMSetDepthStencilState(state, stencilRef);
+	mpCurrentDepthStencilState = state;
+	mCurrentStencilRef = stencilRef;
+	mStateChanges++;
+	mTotalStateChanges++;
+}
+
+void CD3D11::InvalidateStateTracking()
+{
+	mpCurrentRasterizerState = nullptr;
+	mpCurrentBlendState = nullptr;
+	mpCurrentDepthStencilState = nullptr;
+	mCurrentStencilRef = 0;
+}
+
+/* Sets this frame's counts back to zero, the totals logged at shutdown are kept. */
+void CD3D11::ResetStateCounters()
+{
+	mStateChanges = 0;
+	mStateChangesSkipped = 0;
 }
 
 ID3D11DepthStencilView * CD3D11::GetDepthStencilView()
@@ -996,3 +1039,141 @@ void CD3D11::SetBackBufferRenderTarget()
 {
 	mpDeviceContext->OMSetRenderTargets(1, &mpRenderTargetView, mpDepthStencilView);
 }
+
+/////////////////////////////
+// Render device
+/////////////////////////////
+
+HRESULT CD3D11::CreateBuffer(const D3D11_BUFFER_DESC* desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Buffer** buffer)
+{
+	return mpDevice->CreateBuffer(desc, initialData, buffer);
+}
+
+HRESULT CD3D11::CreateTextureFromFile(const std::string& filename, ID3D11ShaderResourceView** texture)
+{
+	return D3DX11CreateShaderResourceViewFromFile(mpDevice, filename.c_str(), NULL, NULL, texture, NULL);
+}
+
+void CD3D11::ReleaseResource(IUnknown* resource)
+{
+	if (resource != nullptr)
+	{
+		resource->Release();
+	}
+}
+
+bool CD3D11::GetBufferDesc(ID3D11Buffer* buffer, D3D11_BUFFER_DESC* desc)
+{
+	if (buffer == nullptr)
+	{
+		return false;
+	}
+
+	buffer->GetDesc(desc);
+	return true;
+}
+
+unsigned long long CD3D11::GetTextureMemory(ID3D11ShaderResourceView* texture)
+{
+	return CTexture::GetMemory(texture);
+}
+
+HRESULT CD3D11::Map(ID3D11Resource* resource, unsigned int subresource, D3D11_MAP mapType, D3D11_MAPPED_SUBRESOURCE* mappedResource)
+{
+	return mpDeviceContext->Map(resource, subresource, mapType, 0, mappedResource);
+}
+
+void CD3D11::Unmap(ID3D11Resource* resource, unsigned int subresource, unsigned int writtenStart, unsigned int writtenSize)
+{
+	mpDeviceContext->Unmap(resource, subresource);
+}
+
+void CD3D11::IASetVertexBuffers(unsigned int startSlot, unsigned int numberOfBuffers, ID3D11Buffer* const* buffers, const unsigned int* strides, const unsigned int* offsets)
+{
+	mpDeviceContext->IASetVertexBuffers(startSlot, numberOfBuffers, buffers, strides, offsets);
+}
+
+void CD3D11::IASetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset)
+{
+	mpDeviceContext->IASetIndexBuffer(buffer, format, offset);
+}
+
+void CD3D11::IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+	mpDeviceContext->IASetPrimitiveTopology(topology);
+}
+
+void CD3D11::IASetInputLayout(ID3D11InputLayout* layout)
+{
+	mpDeviceContext->IASetInputLayout(layout);
+}
+
+void CD3D11::VSSetShader(ID3D11VertexShader* shader)
+{
+	mpDeviceContext->VSSetShader(shader, NULL, 0);
+}
+
+void CD3D11::PSSetShader(ID3D11PixelShader* shader)
+{
+	mpDeviceContext->PSSetShader(shader, NULL, 0);
+}
+
+void CD3D11::VSSetConstantBuffers(unsigned int startSlot, unsigned int numberOfBuffers, ID3D11Buffer* const* buffers)
+{
+	mpDeviceContext->VSSetConstantBuffers(startSlot, numberOfBuffers, buffers);
+}
+
+void CD3D11::PSSetConstantBuffers(unsigned int startSlot, unsigned int numberOfBuffers, ID3D11Buffer* const* buffers)
+{
+	mpDeviceContext->PSSetConstantBuffers(startSlot, numberOfBuffers, buffers);
+}
+
+bool CD3D11::SupportsConstantBufferOffsets()
+{
+	return mpDeviceContext1 != nullptr;
+}
+
+/* Falls back to binding the whole buffer when offsets aren't supported, callers should check SupportsConstantBufferOffsets first. */
+void CD3D11::VSSetConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int numberOfConstants)
+{
+	if (mpDeviceContext1 != nullptr)
+	{
+		mpDeviceContext1->VSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &numberOfConstants);
+	}
+	else
+	{
+		mpDeviceContext->VSSetConstantBuffers(slot, 1, &buffer);
+	}
+}
+
+void CD3D11::PSSetConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int numberOfConstants)
+{
+	if (mpDeviceContext1 != nullptr)
+	{
+		mpDeviceContext1->PSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &numberOfConstants);
+	}
+	else
+	{
+		mpDeviceContext->PSSetConstantBuffers(slot, 1, &buffer);
+	}
+}
+
+void CD3D11::PSSetSamplers(unsigned int startSlot, unsigned int numberOfSamplers, ID3D11SamplerState* const* samplers)
+{
+	mpDeviceContext->PSSetSamplers(startSlot, numberOfSamplers, samplers);
+}
+
+void CD3D11::PSSetShaderResources(unsigned int startSlot, unsigned int numberOfViews, ID3D11ShaderResourceView* const* views)
+{
+	mpDeviceContext->PSSetShaderResources(startSlot, numberOfViews, views);
+}
+
+void CD3D11::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	mpDeviceContext->DrawIndexed(indexCount, startIndex, baseVertex);
+}
+
+void CD3D11::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance)
+{
+	mpDeviceContext->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+}
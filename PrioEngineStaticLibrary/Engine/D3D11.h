@@ -10,12 +10,16 @@
 #include <dxgi.h>
 #include <d3dcommon.h>
 #include <d3d11.h>
+#include <d3d11_1.h>
 #include <d3dx10math.h>
+#include <D3DX11tex.h>
 #include <string>
 #include "PrioEngineVars.h"
 #include <AntTweakBar.h>
+#include "RenderDevice.h"
+#include "StateCache.h"
 
-class CD3D11
+class CD3D11 : public CRenderDevice
 {
 private:
 	CLogger* logger;
@@ -29,6 +33,8 @@ private:
 	IDXGISwapChain* mpSwapChain;
 	ID3D11Device* mpDevice;
 	ID3D11DeviceContext* mpDeviceContext;
+	// Only set when the driver can bind constant buffers by offset, which is what the constant ring needs.
+	ID3D11DeviceContext1* mpDeviceContext1;
 	ID3D11RenderTargetView* mpRenderTargetView;
 	ID3D11Texture2D* mpDepthStencilBuffer;
 	ID3D11DepthStencilState* mpDepthEnabledStencilState;
@@ -43,7 +49,23 @@ private:
 	ID3D11BlendState* mpAlphaBlendingStateDisabled;
 	ID3D11BlendState* mpAdditiveAlphaBlendingStateEnabled;
 	ID3D11RasterizerState* mpRasterStateNoCulling;
-	ID3D11DepthStencilState* mpDepthState;
+
+	// Every state object comes from here, so asking for the same description twice doesn't create a second state.
+	CStateCache* mpStateCache;
+	// What was last set on the context, so setting it again can be skipped.
+	ID3D11RasterizerState* mpCurrentRasterizerState;
+	ID3D11BlendState* mpCurrentBlendState;
+	ID3D11DepthStencilState* mpCurrentDepthStencilState;
+	unsigned int mCurrentStencilRef;
+	unsigned int mStateChanges;
+	unsigned int mStateChangesSkipped;
+	unsigned int mTotalStateChanges;
+	unsigned int mTotalStateChangesSkipped;
+
+	void SetRasterizerState(ID3D11RasterizerState* state);
+	void SetBlendState(ID3D11BlendState* state);
+	void SetDepthStencilState(ID3D11DepthStencilState* state, unsigned int stencilRef);
+	bool SetFillMode(D3D11_FILL_MODE fillMode);
 public:
 	CD3D11();
 	~CD3D11();
@@ -77,10 +99,44 @@ public:
 	ID3D11DepthStencilView* GetDepthStencilView();
 	void SetBackBufferRenderTarget();
 	void SetDepthState(bool depth, bool stencil, bool depthWrite);
+
+	// Forgets what is set on the context, for after something else has changed the state behind our back.
+	void InvalidateStateTracking();
+	void ResetStateCounters();
+	unsigned int GetStateChanges() { return mStateChanges; };
+	unsigned int GetStateChangesSkipped() { return mStateChangesSkipped; };
+	CStateCache* GetStateCache() { return mpStateCache; };
+/* Render device, these pass straight on to the device and immediate context. */
+public:
+	HRESULT CreateBuffer(const D3D11_BUFFER_DESC* desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Buffer** buffer);
+	HRESULT CreateTextureFromFile(const std::string& filename, ID3D11ShaderResourceView** texture);
+	void ReleaseResource(IUnknown* resource);
+	bool GetBufferDesc(ID3D11Buffer* buffer, D3D11_BUFFER_DESC* desc);
+	unsigned long long GetTextureMemory(ID3D11ShaderResourceView* texture);
+	HRESULT Map(ID3D11Resource* resource, unsigned int subresource, D3D11_MAP mapType, D3D11_MAPPED_SUBRESOURCE* mappedResource);
+	void Unmap(ID3D11Resource* resource, unsigned int subresource, unsigned int writtenStart, unsigned int writtenSize);
+
+	void IASetVertexBuffers(unsigned int startSlot, unsigned int numberOfBuffers, ID3D11Buffer* const* buffers, const unsigned int* strides, const unsigned int* offsets);
+	void IASetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset);
+	void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology);
+	void IASetInputLayout(ID3D11InputLayout* layout);
+	void VSSetShader(ID3D11VertexShader* shader);
+	void PSSetShader(ID3D11PixelShader* shader);
+	void VSSetConstantBuffers(unsigned int startSlot, unsigned int numberOfBuffers, ID3D11Buffer* const* buffers);
+	void PSSetConstantBuffers(unsigned int startSlot, unsigned int numberOfBuffers, ID3D11Buffer* const* buffers);
+	bool SupportsConstantBufferOffsets();
+	void VSSetConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int numberOfConstants);
+	void PSSetConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int numberOfConstants);
+	void PSSetSamplers(unsigned int startSlot, unsigned int numberOfSamplers, ID3D11SamplerState* const* samplers);
+	void PSSetShaderResources(unsigned int startSlot, unsigned int numberOfViews, ID3D11ShaderResourceView* const* views);
+
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+	void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance);
 /* Setup functions. */
 private:
 	void CreateSwapChainDesc(HWND hwnd, DXGI_SWAP_CHAIN_DESC& swapChainDesc, int refRateNumerator, int refRateDenominator);
 	bool CreateSwapChain(D3D_FEATURE_LEVEL& featureLevel, DXGI_SWAP_CHAIN_DESC& swapChainDesc);
+	void QueryConstantBufferOffsets();
 	bool CreateDepthBuffer(D3D11_TEXTURE2D_DESC& depthBufferDesc);
 	bool CreateDepthStencilView(D3D11_DEPTH_STENCIL_VIEW_DESC& depthStencilViewDesc);
 	bool CreateDepthDisabledStencilState(D3D11_DEPTH_STENCIL_DESC& depthStencilBufferDesc);
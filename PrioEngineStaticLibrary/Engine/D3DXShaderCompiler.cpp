@@ -0,0 +1,31 @@
+#include "D3DXShaderCompiler.h"
+
+/* Compiles one entry point of a file.
+* @Returns bool Success
+*/
+bool CD3DXShaderCompiler::Compile(const std::string& filename, const std::string& entryPoint, const std::string& profile, unsigned int flags,
+	std::vector<unsigned char>& bytecode, std::string& errors)
+{
+	ID3D10Blob* shaderBuffer = nullptr;
+	ID3D10Blob* errorMessage = nullptr;
+
+	HRESULT result = D3DX11CompileFromFile(filename.c_str(), NULL, NULL, entryPoint.c_str(), profile.c_str(), flags, 0, NULL, &shaderBuffer, &errorMessage, NULL);
+
+	errors.clear();
+	if (errorMessage != nullptr)
+	{
+		errors.assign(static_cast<const char*>(errorMessage->GetBufferPointer()), errorMessage->GetBufferSize());
+		errorMessage->Release();
+	}
+
+	if (FAILED(result) || shaderBuffer == nullptr)
+	{
+		return false;
+	}
+
+	const unsigned char* data = static_cast<const unsigned char*>(shaderBuffer->GetBufferPointer());
+	bytecode.assign(data, data + shaderBuffer->GetBufferSize());
+	shaderBuffer->Release();
+
+	return true;
+}
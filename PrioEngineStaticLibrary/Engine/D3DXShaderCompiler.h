@@ -0,0 +1,16 @@
+#ifndef D3DXSHADERCOMPILER_H
+#define D3DXSHADERCOMPILER_H
+
+#include <D3DX11async.h>
+#include "ShaderCompiler.h"
+
+/* Compiles shaders with D3DX11CompileFromFile, which is what every shader class called directly before the shader cache. */
+class CD3DXShaderCompiler : public CShaderCompiler
+{
+public:
+	bool Compile(const std::string& filename, const std::string& entryPoint, const std::string& profile, unsigned int flags,
+		std::vector<unsigned char>& bytecode, std::string& errors);
+	std::string GetName() { return "D3DX11"; };
+};
+
+#endif
@@ -6,8 +6,18 @@ CDiffuseLightShader::CDiffuseLightShader()
 	mpVertexShader = nullptr;
 	mpPixelShader = nullptr;
 	mpLayout = nullptr;
+	mpInstancedVertexShader = nullptr;
+	mpInstancedLayout = nullptr;
 	mpSampleState = nullptr;
-	mpLightBuffer = nullptr;
+
+	CHECK_CONSTANT_BUFFER_MEMBER(LightBufferType, ambientColour);
+	CHECK_CONSTANT_BUFFER_MEMBER(LightBufferType, diffuseColour);
+	CHECK_CONSTANT_BUFFER_MEMBER(LightBufferType, lightDirection);
+	CHECK_CONSTANT_BUFFER_MEMBER(LightBufferType, padding);
+	CHECK_CONSTANT_BUFFER_MEMBER(MapBufferType, useAlphaMap);
+	CHECK_CONSTANT_BUFFER_MEMBER(MapBufferType, useSpecularMap);
+	CHECK_CONSTANT_BUFFER_MEMBER(MapBufferType, padding2);
+	CHECK_CONSTANT_BUFFER_MEMBER(MapBufferType, padding3);
 }
 
 CDiffuseLightShader::~CDiffuseLightShader()
@@ -26,6 +36,14 @@ bool CDiffuseLightShader::Initialise(ID3D11Device * device, HWND hwnd)
 		return false;
 	}
 
+	// Initialise the vertex shader used to draw many instances at once.
+	result = InitialiseInstancedShader(device, hwnd, "Shaders/DiffuseLightInstanced.vs.hlsl");
+
+	if (!result)
+	{
+		return false;
+	}
+
 	return true;
 }
 
@@ -35,24 +53,170 @@ void CDiffuseLightShader::Shutdown()
 	ShutdownShader();
 }
 
-bool CDiffuseLightShader::Render(ID3D11DeviceContext* deviceContext, int indexCount, ID3D11ShaderResourceView** textures, int numberOfTextures,
-	D3DXVECTOR3 lightDirection, D3DXVECTOR4 diffuseColour, D3DXVECTOR4 ambientColour)
+/* Makes the constant buffers again through the render device the meshes are drawn with, as every draw this shader makes goes through it.
+* Initialise makes them on the Direct3D device, which a null render device can't write to.
+* @Returns bool Success
+*/
+bool CDiffuseLightShader::InitialiseConstantBuffers(CRenderDevice* device)
+{
+	if (!SetupMatrixBuffer(device))
+	{
+		return false;
+	}
+
+	if (!mLightBuffer.Initialise(device))
+	{
+		logger->GetInstance().WriteLine("Failed to create the light buffer through the render device in the diffuse light shader.");
+		return false;
+	}
+
+	if (!mMapBuffer.Initialise(device))
+	{
+		logger->GetInstance().WriteLine("Failed to create the map buffer through the render device in the diffuse light shader.");
+		return false;
+	}
+
+	return true;
+}
+
+/* Releases the constant buffers, call before the device they were made through goes away. */
+void CDiffuseLightShader::ShutdownConstantBuffers()
+{
+	ShutdownMatrixBuffer();
+	mLightBuffer.Shutdown();
+	mMapBuffer.Shutdown();
+}
+
+bool CDiffuseLightShader::Render(CRenderDevice* device, int indexCount, ID3D11ShaderResourceView** textures, int numberOfTextures,
+	D3DXVECTOR3 lightDirection, D3DXVECTOR4 diffuseColour, D3DXVECTOR4 ambientColour, int startIndex)
 {
 	bool result;
 
 	// Set the shader parameters that it will use for rendering.
-	result = SetShaderParameters(deviceContext, textures, numberOfTextures, lightDirection, diffuseColour, ambientColour);
+	SetTextures(device, textures, numberOfTextures);
+	result = SetShaderParameters(device, lightDirection, diffuseColour, ambientColour);
 	if (!result)
 	{
 		return false;
 	}
 
 	// Now render the prepared buffers with the shader.
-	RenderShader(deviceContext, indexCount);
+	RenderShader(device, indexCount, startIndex);
+
+	return true;
+}
+
+/* Draws several instances of the buffers, the world matrix of each one is read from the instance buffer bound to slot 1. */
+bool CDiffuseLightShader::RenderInstanced(CRenderDevice* device, int indexCount, int instanceCount, ID3D11ShaderResourceView** textures, int numberOfTextures,
+	D3DXVECTOR3 lightDirection, D3DXVECTOR4 diffuseColour, D3DXVECTOR4 ambientColour, int startIndex, int startInstance)
+{
+	if (!SetInstancedShader(device, lightDirection, diffuseColour, ambientColour))
+	{
+		return false;
+	}
+
+	SetTextures(device, textures, numberOfTextures);
+
+	RenderInstancedRange(device, indexCount, instanceCount, startIndex, startInstance);
+
+	return true;
+}
+
+/* Binds the instanced shaders and the matrix and light buffers, these stay bound until another shader is used.
+* @Returns bool Success
+*/
+bool CDiffuseLightShader::SetInstancedShader(CRenderDevice* device, D3DXVECTOR3 lightDirection, D3DXVECTOR4 diffuseColour, D3DXVECTOR4 ambientColour)
+{
+	// Set the shader parameters that it will use for rendering.
+	if (!SetShaderParameters(device, lightDirection, diffuseColour, ambientColour))
+	{
+		return false;
+	}
+
+	BindInstancedShaders(device);
+
+	return true;
+}
+
+/* Sets the instanced vertex input layout, shaders and sampler. */
+void CDiffuseLightShader::BindInstancedShaders(CRenderDevice* device)
+{
+	device->IASetInputLayout(mpInstancedLayout);
+	device->VSSetShader(mpInstancedVertexShader);
+	device->PSSetShader(mpPixelShader);
+	device->PSSetSamplers(0, 1, &mpSampleState);
+}
+
+/* Writes the matrix and light buffers into the constant ring.
+* @Returns bool - False if the ring is full, in which case the buffers should be set with SetInstancedShader instead.
+*/
+bool CDiffuseLightShader::WritePassConstants(CConstantRing* ring, D3DXVECTOR3 lightDirection, D3DXVECTOR4 diffuseColour, D3DXVECTOR4 ambientColour, PassConstantsType& constants)
+{
+	if (!WriteMatrixBuffer(ring, constants.matrix))
+	{
+		return false;
+	}
+
+	LightBufferType* lightBufferPtr = static_cast<LightBufferType*>(ring->Allocate(sizeof(LightBufferType), constants.light));
+	if (lightBufferPtr == nullptr)
+	{
+		logger->GetInstance().WriteLine("The constant ring had no room left for the light buffer.");
+		return false;
+	}
+
+	lightBufferPtr->diffuseColour = diffuseColour;
+	lightBufferPtr->ambientColour = ambientColour;
+	lightBufferPtr->lightDirection = lightDirection;
+	lightBufferPtr->padding = 0.0f;
 
 	return true;
 }
 
+/* Binds the instanced shaders, and the matrix and light buffers written by WritePassConstants. The ring must have been uploaded. */
+void CDiffuseLightShader::SetInstancedShader(CRenderDevice* device, CConstantRing* ring, const PassConstantsType& constants)
+{
+	device->VSSetConstantBufferRange(0, ring->GetBuffer(), constants.matrix.firstConstant, constants.matrix.numberOfConstants);
+	device->PSSetConstantBufferRange(0, ring->GetBuffer(), constants.light.firstConstant, constants.light.numberOfConstants);
+
+	BindInstancedShaders(device);
+}
+
+/* Writes the map buffer into the constant ring.
+* @Returns bool - False if the ring is full.
+*/
+bool CDiffuseLightShader::WriteMapConstants(CConstantRing* ring, bool useAlphaMap, bool useSpecularMap, CConstantRing::RangeType& range)
+{
+	MapBufferType* mapBufferPtr = static_cast<MapBufferType*>(ring->Allocate(sizeof(MapBufferType), range));
+	if (mapBufferPtr == nullptr)
+	{
+		logger->GetInstance().WriteLine("The constant ring had no room left for the map buffer.");
+		return false;
+	}
+
+	mapBufferPtr->useAlphaMap = useAlphaMap;
+	mapBufferPtr->useSpecularMap = useSpecularMap;
+
+	return true;
+}
+
+/* Binds a map buffer written by WriteMapConstants to the same slot UpdateMapBuffer uses. */
+void CDiffuseLightShader::SetMapConstants(CRenderDevice* device, CConstantRing* ring, const CConstantRing::RangeType& range)
+{
+	device->PSSetConstantBufferRange(1, ring->GetBuffer(), range.firstConstant, range.numberOfConstants);
+}
+
+/* Binds the texture maps of a material to the pixel shader. */
+void CDiffuseLightShader::SetTextures(CRenderDevice* device, ID3D11ShaderResourceView** textures, int numberOfTextures)
+{
+	device->PSSetShaderResources(0, numberOfTextures, textures);
+}
+
+/* Draws more instances, using the shaders and parameters set by the last call to RenderInstanced. */
+void CDiffuseLightShader::RenderInstancedRange(CRenderDevice* device, int indexCount, int instanceCount, int startIndex, int startInstance)
+{
+	device->DrawIndexedInstanced(indexCount, instanceCount, startIndex, 0, startInstance);
+}
+
 bool CDiffuseLightShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::string vsFilename, std::string psFilename, std::string transparentPSFilename)
 {
 	HRESULT result;
@@ -63,8 +227,6 @@ bool CDiffuseLightShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std
 	unsigned int numElements;
 	D3D11_BUFFER_DESC matrixBufferDesc;
 	D3D11_SAMPLER_DESC samplerDesc;
-	D3D11_BUFFER_DESC lightBufferDesc;
-	D3D11_BUFFER_DESC mapBufferDesc;
 
 	// Initialise pointers in this function to null.
 	errorMessage = nullptr;
@@ -72,7 +234,7 @@ bool CDiffuseLightShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std
 	pixelShaderBuffer = nullptr;
 
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsFilename.c_str(), NULL, NULL, "LightVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &vertexShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(vsFilename, "LightVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &vertexShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -90,7 +252,7 @@ bool CDiffuseLightShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std
 	}
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(psFilename.c_str(), NULL, NULL, "LightPixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(psFilename, "LightPixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -127,7 +289,7 @@ bool CDiffuseLightShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std
 	// Transparent
 	/////////////////////////////////////////
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(transparentPSFilename.c_str(), NULL, NULL, "TransparentPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(transparentPSFilename, "TransparentPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -231,51 +393,123 @@ bool CDiffuseLightShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std
 		return false;
 	}
 
-	lightBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	lightBufferDesc.ByteWidth = sizeof(LightBufferType);
-	lightBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	lightBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	lightBufferDesc.MiscFlags = 0;
-	lightBufferDesc.StructureByteStride = 0;
+	if (!mLightBuffer.Initialise(device))
+	{
+		logger->GetInstance().WriteLine("Failed to create the buffer from the light buffer descriptor from within the texture diffuse light shader class.");
+		return false;
+	}
 
-	result = device->CreateBuffer(&lightBufferDesc, NULL, &mpLightBuffer);
+	if (!mMapBuffer.Initialise(device))
+	{
+		logger->GetInstance().WriteLine("Failed to create the buffer from the map buffer descriptor from within the texture diffuse light shader class.");
+		return false;
+	}
+
+	return true;
+}
+
+bool CDiffuseLightShader::InitialiseInstancedShader(ID3D11Device * device, HWND hwnd, std::string vsFilename)
+{
+	HRESULT result;
+	ID3D10Blob* errorMessage = nullptr;
+	ID3D10Blob* vertexShaderBuffer = nullptr;
+	const unsigned int kNumberOfElements = 7;
+	D3D11_INPUT_ELEMENT_DESC polygonLayout[kNumberOfElements];
+
+	// Compile the vertex shader code.
+	result = CompileShaderFromFile(vsFilename, "LightInstancedVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &vertexShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
-		logger->GetInstance().WriteLine("Failed to create the buffer from the light buffer descriptor from within the texture diffuse light shader class.");
+		if (errorMessage)
+		{
+			OutputShaderErrorMessage(errorMessage, hwnd, vsFilename);
+		}
+		else
+		{
+			std::string errMsg = "Missing shader file. ";
+			logger->GetInstance().WriteLine("Could not find a shader file with name '" + vsFilename + "'");
+			MessageBox(hwnd, vsFilename.c_str(), errMsg.c_str(), MB_OK);
+		}
+		logger->GetInstance().WriteLine("Failed to compile the vertex shader named '" + vsFilename + "'");
 		return false;
 	}
 
-	mapBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	mapBufferDesc.ByteWidth = sizeof(MapBufferType);
-	mapBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	mapBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	mapBufferDesc.MiscFlags = 0;
-	mapBufferDesc.StructureByteStride = 0;
+	// Create the vertex shader from the buffer.
+	result = device->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), NULL, &mpInstancedVertexShader);
+	if (FAILED(result))
+	{
+		logger->GetInstance().WriteLine("Failed to create the instanced vertex shader from the buffer.");
+		return false;
+	}
+
+	// The per vertex data is the same as the normal layout, from slot 0.
+	polygonLayout[0].SemanticName = "POSITION";
+	polygonLayout[0].SemanticIndex = 0;
+	polygonLayout[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;
+	polygonLayout[0].InputSlot = 0;
+	polygonLayout[0].AlignedByteOffset = 0;
+	polygonLayout[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+	polygonLayout[0].InstanceDataStepRate = 0;
+
+	polygonLayout[1].SemanticName = "TEXCOORD";
+	polygonLayout[1].SemanticIndex = 0;
+	polygonLayout[1].Format = DXGI_FORMAT_R32G32_FLOAT;
+	polygonLayout[1].InputSlot = 0;
+	polygonLayout[1].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
+	polygonLayout[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+	polygonLayout[1].InstanceDataStepRate = 0;
+
+	polygonLayout[2].SemanticName = "NORMAL";
+	polygonLayout[2].SemanticIndex = 0;
+	polygonLayout[2].Format = DXGI_FORMAT_R32G32B32_FLOAT;
+	polygonLayout[2].InputSlot = 0;
+	polygonLayout[2].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
+	polygonLayout[2].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+	polygonLayout[2].InstanceDataStepRate = 0;
+
+	// The four rows of the world matrix come from slot 1, and step forward once per instance.
+	for (unsigned int row = 0; row < 4; row++)
+	{
+		polygonLayout[3 + row].SemanticName = "WORLD";
+		polygonLayout[3 + row].SemanticIndex = row;
+		polygonLayout[3 + row].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+		polygonLayout[3 + row].InputSlot = 1;
+		polygonLayout[3 + row].AlignedByteOffset = row * sizeof(D3DXVECTOR4);
+		polygonLayout[3 + row].InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
+		polygonLayout[3 + row].InstanceDataStepRate = 1;
+	}
 
-	result = device->CreateBuffer(&mapBufferDesc, NULL, &mpMapBuffer);
+	// Create the vertex input layout.
+	result = device->CreateInputLayout(polygonLayout, kNumberOfElements, vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), &mpInstancedLayout);
 	if (FAILED(result))
 	{
-		logger->GetInstance().WriteLine("Failed to create the buffer from the map buffer descriptor from within the texture diffuse light shader class.");
+		logger->GetInstance().WriteLine("Failed to create the instanced polygon layout.");
 		return false;
 	}
 
+	// Release the vertex shader buffer since it is no longer needed.
+	vertexShaderBuffer->Release();
+	vertexShaderBuffer = nullptr;
+
 	return true;
 }
 
 void CDiffuseLightShader::ShutdownShader()
 {
-	if (mpMapBuffer)
+	if (mpInstancedLayout)
 	{
-		mpMapBuffer->Release();
-		mpMapBuffer = nullptr;
+		mpInstancedLayout->Release();
+		mpInstancedLayout = nullptr;
 	}
 
-	if (mpLightBuffer)
+	if (mpInstancedVertexShader)
 	{
-		mpLightBuffer->Release();
-		mpLightBuffer = nullptr;
+		mpInstancedVertexShader->Release();
+		mpInstancedVertexShader = nullptr;
 	}
 
+	ShutdownConstantBuffers();
+
 	if (mpSampleState)
 	{
 		mpSampleState->Release();
@@ -333,98 +567,62 @@ void CDiffuseLightShader::OutputShaderErrorMessage(ID3D10Blob *errorMessage, HWN
 	MessageBox(hwnd, "Error compiling the shader. Check the logs for a more detailed error message.", shaderFilename.c_str(), MB_OK);
 }
 
-bool CDiffuseLightShader::SetShaderParameters(ID3D11DeviceContext * deviceContext, ID3D11ShaderResourceView** textures, int numberOfTextures, D3DXVECTOR3 lightDirection, D3DXVECTOR4 diffuseColour, D3DXVECTOR4 ambientColour)
+bool CDiffuseLightShader::SetShaderParameters(CRenderDevice* device, D3DXVECTOR3 lightDirection, D3DXVECTOR4 diffuseColour, D3DXVECTOR4 ambientColour)
 {
-	HRESULT result;
-	D3D11_MAPPED_SUBRESOURCE mappedResource;
-	unsigned int bufferNumber;
-	MatrixBufferType* dataPtr;
-	LightBufferType* dataPtr2;
-
-
-	if (!SetMatrixBuffer(deviceContext, 0, ShaderType::Vertex))
+	if (!SetMatrixBuffer(device, 0, ShaderType::Vertex))
 	{
 		logger->GetInstance().WriteLine("Failed to set matrix buffer in diffuse light shader class.");
 		return false;
 	}
 
-	deviceContext->PSSetShaderResources(0, numberOfTextures, textures);
+	// Copy the lighting variables into the light buffer, it's only written again if they've changed.
+	mLightBuffer.Set(&LightBufferType::diffuseColour, diffuseColour);
+	mLightBuffer.Set(&LightBufferType::ambientColour, ambientColour);
+	mLightBuffer.Set(&LightBufferType::lightDirection, lightDirection);
 
-	// Lock the light constant buffer so it can be written to.
-	result = deviceContext->Map(mpLightBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	if (FAILED(result))
+	if (!mLightBuffer.Update(device))
 	{
 		return false;
 	}
 
-	// Get a pointer to the data in the constant buffer.
-	dataPtr2 = (LightBufferType*)mappedResource.pData;
-
-	// Copy the lighting variables into the constant buffer.
-	dataPtr2->diffuseColour = diffuseColour;
-	dataPtr2->ambientColour = ambientColour;
-	dataPtr2->lightDirection = lightDirection;
-	dataPtr2->padding = 0.0f;
-
-	// Unlock the constant buffer.
-	deviceContext->Unmap(mpLightBuffer, 0);
-
-	// Set the position of the light constant buffer in the pixel shader.
-	bufferNumber = 0;
-
 	// Finally set the light constant buffer in the pixel shader with the updated values.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpLightBuffer);
+	device->PSSetConstantBuffers(0, 1, mLightBuffer.GetBufferAddress());
 
 	return true;
 }
 
-bool CDiffuseLightShader::UpdateMapBuffer(ID3D11DeviceContext* deviceContext, bool useAlphaMap, bool useSpecularMap)
+bool CDiffuseLightShader::UpdateMapBuffer(CRenderDevice* device, bool useAlphaMap, bool useSpecularMap)
 {
-	HRESULT result;
-	D3D11_MAPPED_SUBRESOURCE mappedResource;
-	unsigned int bufferNumber = 1;
-	MapBufferType* mapBufferPtr;
+	mMapBuffer.Set(&MapBufferType::useAlphaMap, static_cast<BOOL>(useAlphaMap));
+	mMapBuffer.Set(&MapBufferType::useSpecularMap, static_cast<BOOL>(useSpecularMap));
 
-	// Lock the constant buffer so it can be written to.
-	result = deviceContext->Map(mpMapBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	if (FAILED(result))
+	if (!mMapBuffer.Update(device))
 	{
 		logger->GetInstance().WriteLine("Failed to lock the map buffer when attempting to update it.");
 		return false;
 	}
 
-	// Get a pointer to the data in the constant buffer.
-	mapBufferPtr = (MapBufferType*)mappedResource.pData;
-
-	// Copy the bools into the constant buffer.
-	mapBufferPtr->useAlphaMap = useAlphaMap;
-	mapBufferPtr->useSpecularMap = useSpecularMap;
-	mapBufferPtr->padding2 = D3DXVECTOR3{ 0.0F, 0.0F, 0.0f };
-
-	// Unlock the constant buffer.
-	deviceContext->Unmap(mpMapBuffer, 0);
-
-	// Now set the constant buffer in the vertex shader with the updated values.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpMapBuffer);
+	// Now set the constant buffer in the pixel shader with the updated values.
+	device->PSSetConstantBuffers(1, 1, mMapBuffer.GetBufferAddress());
 
 	return true;
 }
 
-void CDiffuseLightShader::RenderShader(ID3D11DeviceContext * deviceContext, int indexCount)
+void CDiffuseLightShader::RenderShader(CRenderDevice* device, int indexCount, int startIndex)
 {
 	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(mpLayout);
+	device->IASetInputLayout(mpLayout);
 
 	// Set the vertex and pixel shaders that will be used to render this triangle.
-	deviceContext->VSSetShader(mpVertexShader, NULL, 0);
+	device->VSSetShader(mpVertexShader);
 
-	deviceContext->PSSetShader(mpPixelShader, NULL, 0);
+	device->PSSetShader(mpPixelShader);
 
 	// Set the sampler state in the pixel shader.
-	deviceContext->PSSetSamplers(0, 1, &mpSampleState);
+	device->PSSetSamplers(0, 1, &mpSampleState);
 
 	// Render the triangle.
-	deviceContext->DrawIndexed(indexCount, 0, 0);
+	device->DrawIndexed(indexCount, startIndex, 0);
 
 	return;
 }
@@ -15,39 +15,64 @@ private:
 		float padding;
 	};
 
+	// HLSL bools are 4 bytes, so these are BOOLs rather than bools.
 	struct MapBufferType
 	{
-		bool useAlphaMap;
-		bool useSpecularMap;
-		D3DXVECTOR3 padding2;
+		BOOL useAlphaMap;
+		BOOL useSpecularMap;
+		D3DXVECTOR2 padding2;
 		D3DXVECTOR4 padding3;
 	};
 
+public:
+	// Where the constants shared by every draw of a pass were written in the constant ring.
+	struct PassConstantsType
+	{
+		CConstantRing::RangeType matrix;
+		CConstantRing::RangeType light;
+	};
 public:
 	CDiffuseLightShader();
 	~CDiffuseLightShader();
 
 	bool Initialise(ID3D11Device* device, HWND hwnd);
 	void Shutdown();
-	bool Render(ID3D11DeviceContext* deviceContext, int indexCount, ID3D11ShaderResourceView** textures, int numberOfTextures, D3DXVECTOR3 lightDirection, D3DXVECTOR4 diffuseColour, D3DXVECTOR4 ambientColour);
-	bool UpdateMapBuffer(ID3D11DeviceContext* deviceContext, bool useAlphaMap, bool useSpecularMap);
+	bool InitialiseConstantBuffers(CRenderDevice* device);
+	void ShutdownConstantBuffers();
+	bool Render(CRenderDevice* device, int indexCount, ID3D11ShaderResourceView** textures, int numberOfTextures, D3DXVECTOR3 lightDirection, D3DXVECTOR4 diffuseColour, D3DXVECTOR4 ambientColour, int startIndex = 0);
+	bool RenderInstanced(CRenderDevice* device, int indexCount, int instanceCount, ID3D11ShaderResourceView** textures, int numberOfTextures, D3DXVECTOR3 lightDirection, D3DXVECTOR4 diffuseColour, D3DXVECTOR4 ambientColour, int startIndex = 0, int startInstance = 0);
+	bool SetInstancedShader(CRenderDevice* device, D3DXVECTOR3 lightDirection, D3DXVECTOR4 diffuseColour, D3DXVECTOR4 ambientColour);
+	void SetTextures(CRenderDevice* device, ID3D11ShaderResourceView** textures, int numberOfTextures);
+	void RenderInstancedRange(CRenderDevice* device, int indexCount, int instanceCount, int startIndex, int startInstance);
+	bool UpdateMapBuffer(CRenderDevice* device, bool useAlphaMap, bool useSpecularMap);
+
+	// The same as SetInstancedShader and UpdateMapBuffer, but the constants are written into a constant ring and bound by range once it has been uploaded.
+	bool WritePassConstants(CConstantRing* ring, D3DXVECTOR3 lightDirection, D3DXVECTOR4 diffuseColour, D3DXVECTOR4 ambientColour, PassConstantsType& constants);
+	void SetInstancedShader(CRenderDevice* device, CConstantRing* ring, const PassConstantsType& constants);
+	bool WriteMapConstants(CConstantRing* ring, bool useAlphaMap, bool useSpecularMap, CConstantRing::RangeType& range);
+	void SetMapConstants(CRenderDevice* device, CConstantRing* ring, const CConstantRing::RangeType& range);
 
 private:
 	bool InitialiseShader(ID3D11Device * device, HWND hwnd, std::string vsFilename, std::string psFilename, std::string transparentPSFilename);
+	bool InitialiseInstancedShader(ID3D11Device * device, HWND hwnd, std::string vsFilename);
 	void ShutdownShader();
 	void OutputShaderErrorMessage(ID3D10Blob *errorMessage, HWND hwnd, std::string shaderFilename);
 
-	bool SetShaderParameters(ID3D11DeviceContext* deviceContext, ID3D11ShaderResourceView** textures, int numberOfTextures, D3DXVECTOR3 lightDirection, D3DXVECTOR4 diffuseColour, D3DXVECTOR4 ambientColour);
-	void RenderShader(ID3D11DeviceContext* deviceContext, int indexCount);
+	bool SetShaderParameters(CRenderDevice* device, D3DXVECTOR3 lightDirection, D3DXVECTOR4 diffuseColour, D3DXVECTOR4 ambientColour);
+	void RenderShader(CRenderDevice* device, int indexCount, int startIndex);
+	void BindInstancedShaders(CRenderDevice* device);
 
 private:
 	ID3D11VertexShader* mpVertexShader;
 	ID3D11PixelShader* mpPixelShader;
 	ID3D11PixelShader* mpTransparentPixelShader;
 	ID3D11InputLayout* mpLayout;
+	// Reads the world matrix from a second vertex buffer, one per instance.
+	ID3D11VertexShader* mpInstancedVertexShader;
+	ID3D11InputLayout* mpInstancedLayout;
 	ID3D11SamplerState* mpSampleState;
-	ID3D11Buffer* mpLightBuffer;
-	ID3D11Buffer* mpMapBuffer;
+	CConstantBuffer<LightBufferType> mLightBuffer;
+	CConstantBuffer<MapBufferType> mMapBuffer;
 };
 
 #endif
\ No newline at end of file
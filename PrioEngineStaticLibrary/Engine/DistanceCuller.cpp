@@ -0,0 +1,134 @@
+#include "DistanceCuller.h"
+#include <cstring>
+
+CDistanceCuller::CDistanceCuller()
+{
+	mDrawDistance = 0.0f;
+	mMinimumScreenSize = 0.0f;
+	mThinningStart = 0.0f;
+	mThinningEnd = 0.0f;
+	mDistanceScale = 1.0f;
+
+	for (auto& counters : mCounters)
+	{
+		counters.totalCulledByDistance = 0;
+		counters.totalCulledByCoverage = 0;
+		counters.totalThinned = 0;
+	}
+	ResetCounters();
+}
+
+CDistanceCuller::~CDistanceCuller()
+{
+}
+
+/* Starts dropping instances at the start distance, fewer and fewer are kept until none are left at the end distance. */
+void CDistanceCuller::SetThinning(float startDistance, float endDistance)
+{
+	if (endDistance <= startDistance)
+	{
+		logger->GetInstance().WriteLine("The distance thinning ends at must be further than the distance it starts at, thinning has been turned off.");
+		mThinningStart = 0.0f;
+		mThinningEnd = 0.0f;
+		return;
+	}
+
+	mThinningStart = startDistance;
+	mThinningEnd = endDistance;
+}
+
+/* Runs every check against an instance's bounding sphere, cheapest first, and counts what it culled against the pass.
+* @PARAM float instanceValue - From GetInstanceValue, the instance is thinned out once the kept fraction drops below it.
+*/
+CDistanceCuller::ResultType CDistanceCuller::Check(CRenderQueue::PassType pass, D3DXVECTOR3 centre, float radius, D3DXVECTOR3 cameraPosition, float instanceValue)
+{
+	D3DXVECTOR3 toCentre = centre - cameraPosition;
+	float distance = D3DXVec3Length(&toCentre);
+
+	// Measure to the nearest point of the sphere, so large meshes don't vanish while part of them is still close.
+	float surfaceDistance = distance - radius;
+	surfaceDistance = surfaceDistance > 0.0f ? surfaceDistance : 0.0f;
+
+	if (IsBeyondDrawDistance(surfaceDistance))
+	{
+		AddCulledByDistance(pass, 1);
+		return CulledByDistance;
+	}
+
+	if (IsBelowMinimumScreenSize(radius, distance))
+	{
+		AddCulledByCoverage(pass, 1);
+		return CulledByCoverage;
+	}
+
+	if (instanceValue >= GetKeptFraction(surfaceDistance))
+	{
+		AddThinned(pass, 1);
+		return Thinned;
+	}
+
+	return Visible;
+}
+
+bool CDistanceCuller::IsBeyondDrawDistance(float distance)
+{
+	return mDrawDistance > 0.0f && distance > mDrawDistance * mDistanceScale;
+}
+
+/* Whether a sphere this far from the camera looks too small to draw, ignoring the field of view. Never true while the camera is inside it. */
+bool CDistanceCuller::IsBelowMinimumScreenSize(float radius, float distance)
+{
+	return mMinimumScreenSize > 0.0f && distance > radius && radius / distance < mMinimumScreenSize;
+}
+
+/* The fraction of instances which are still drawn at this distance, one before thinning starts and zero once it ends. */
+float CDistanceCuller::GetKeptFraction(float distance)
+{
+	const float thinningStart = mThinningStart * mDistanceScale;
+	const float thinningEnd = mThinningEnd * mDistanceScale;
+
+	if (thinningEnd <= 0.0f || distance <= thinningStart)
+	{
+		return 1.0f;
+	}
+
+	if (distance >= thinningEnd)
+	{
+		return 0.0f;
+	}
+
+	return 1.0f - (distance - thinningStart) / (thinningEnd - thinningStart);
+}
+
+/* Scrambles the bits of a position into a value between zero and one. The same position always gives the same value. */
+float CDistanceCuller::GetInstanceValue(D3DXVECTOR3 position)
+{
+	unsigned int bits[3];
+	memcpy(bits, &position.x, sizeof(bits));
+
+	unsigned int hash = 2166136261u;
+	for (unsigned int component = 0; component < 3; component++)
+	{
+		hash = (hash ^ bits[component]) * 16777619u;
+	}
+
+	// Mix the bits again so nearby positions don't give nearby values.
+	hash ^= hash >> 16;
+	hash *= 0x85EBCA6Bu;
+	hash ^= hash >> 13;
+	hash *= 0xC2B2AE35u;
+	hash ^= hash >> 16;
+
+	return static_cast<float>(hash >> 8) / static_cast<float>(1 << 24);
+}
+
+/* Sets the counts for the frame back to zero, the totals carry on. */
+void CDistanceCuller::ResetCounters()
+{
+	for (auto& counters : mCounters)
+	{
+		counters.culledByDistance = 0;
+		counters.culledByCoverage = 0;
+		counters.thinned = 0;
+	}
+}
@@ -0,0 +1,75 @@
+#ifndef DISTANCECULLER_H
+#define DISTANCECULLER_H
+
+#include <D3DX10math.h>
+#include "PrioEngineVars.h"
+#include "RenderQueue.h"
+
+/* Decides whether an instance is too far away or too small on screen to be worth drawing, and thins out instances with distance.
+* Thinning is decided per instance from a value made from its position, so the same instances always go first and nothing flickers as the camera moves.
+* Every check is off until it is given a value. The settings are shared by every pass, but each pass keeps its own counts, like the meshlet cullers.
+*/
+class CDistanceCuller
+{
+private:
+	CLogger* logger;
+public:
+	enum ResultType
+	{
+		Visible,
+		CulledByDistance,
+		CulledByCoverage,
+		Thinned
+	};
+public:
+	CDistanceCuller();
+	~CDistanceCuller();
+public:
+	void SetDrawDistance(float distance) { mDrawDistance = distance; };
+	void SetMinimumScreenSize(float screenSize) { mMinimumScreenSize = screenSize; };
+	void SetThinning(float startDistance, float endDistance);
+	// Multiplies the draw and thinning distances, so they can be brought in without losing the values they were given.
+	void SetDistanceScale(float scale) { mDistanceScale = scale; };
+
+	ResultType Check(CRenderQueue::PassType pass, D3DXVECTOR3 centre, float radius, D3DXVECTOR3 cameraPosition, float instanceValue);
+	bool IsBeyondDrawDistance(float distance);
+	bool IsBelowMinimumScreenSize(float radius, float distance);
+	float GetKeptFraction(float distance);
+	static float GetInstanceValue(D3DXVECTOR3 position);
+
+	void AddCulledByDistance(CRenderQueue::PassType pass, unsigned int count) { mCounters[pass].culledByDistance += count; mCounters[pass].totalCulledByDistance += count; };
+	void AddCulledByCoverage(CRenderQueue::PassType pass, unsigned int count) { mCounters[pass].culledByCoverage += count; mCounters[pass].totalCulledByCoverage += count; };
+	void AddThinned(CRenderQueue::PassType pass, unsigned int count) { mCounters[pass].thinned += count; mCounters[pass].totalThinned += count; };
+	void ResetCounters();
+
+	unsigned int GetCulledByDistance(CRenderQueue::PassType pass = CRenderQueue::Main) { return mCounters[pass].culledByDistance; };
+	unsigned int GetCulledByCoverage(CRenderQueue::PassType pass = CRenderQueue::Main) { return mCounters[pass].culledByCoverage; };
+	unsigned int GetThinned(CRenderQueue::PassType pass = CRenderQueue::Main) { return mCounters[pass].thinned; };
+	unsigned int GetTotalCulledByDistance(CRenderQueue::PassType pass = CRenderQueue::Main) { return mCounters[pass].totalCulledByDistance; };
+	unsigned int GetTotalCulledByCoverage(CRenderQueue::PassType pass = CRenderQueue::Main) { return mCounters[pass].totalCulledByCoverage; };
+	unsigned int GetTotalThinned(CRenderQueue::PassType pass = CRenderQueue::Main) { return mCounters[pass].totalThinned; };
+private:
+	// Zero turns each of these off.
+	float mDrawDistance;
+	float mMinimumScreenSize;
+	float mThinningStart;
+	float mThinningEnd;
+	float mDistanceScale;
+
+	struct CountersType
+	{
+		// Counts for the current frame.
+		unsigned int culledByDistance;
+		unsigned int culledByCoverage;
+		unsigned int thinned;
+		// Counts for the whole run.
+		unsigned int totalCulledByDistance;
+		unsigned int totalCulledByCoverage;
+		unsigned int totalThinned;
+	};
+
+	// Passes may be gathered on different threads at once, but a pass is only ever gathered on one, so each can count into its own set.
+	CountersType mCounters[CRenderQueue::kNumberOfPasses];
+};
+
+#endif
@@ -544,42 +544,63 @@ bool CEngine::AddSceneryToTerrain(CTerrain* terrainPtr)
 	if (terrainPtr != nullptr)
 	{
 		CMesh* treeMesh = LoadMesh("Resources/Models/firtree3.3ds", 2.0f);
+		if (treeMesh == nullptr)
+		{
+			logger->GetInstance().WriteLine("Failed to load the tree mesh.");
+			return false;
+		}
 		mpListOfTreeMeshes.push_back(treeMesh);
 
+		// Scenery never moves, so merge it per cell rather than drawing every tree on its own.
+		treeMesh->EnableStaticBatching(kSceneryCellSize);
+		treeMesh->GetDistanceCuller()->SetDrawDistance(kTreeDrawDistance);
+		treeMesh->GetDistanceCuller()->SetMinimumScreenSize(kSceneryMinimumScreenSize);
+
+		// Create all of the trees in one go, rather than allocating and logging each one on its own.
+		std::vector<CModelPool::TransformType> transforms;
 		for (auto treeInfo : terrainPtr->GetTreeInformation())
 		{
-			CModel* tree = treeMesh->CreateModel();
-
-			if (tree == nullptr)
-			{
-				logger->GetInstance().WriteLine("Failed to create the tree from the tree mesh.");
-				return false;
-			}
-
-			tree->SetPos(treeInfo.position.x, treeInfo.position.y, treeInfo.position.z);
-			tree->SetRotationX(90.0f);
-			tree->SetRotationY(treeInfo.rotation.y);
-			tree->SetScale(treeInfo.scale);
+			CModelPool::TransformType transform;
+			transform.position = treeInfo.position;
+			transform.rotation = D3DXVECTOR3(90.0f, treeInfo.rotation.y, 0.0f);
+			transform.scale = D3DXVECTOR3(treeInfo.scale, treeInfo.scale, treeInfo.scale);
+			transforms.push_back(transform);
 		}
 
+		if (!transforms.empty() && !treeMesh->CreateModels(static_cast<unsigned int>(transforms.size()), &transforms[0]))
+		{
+			logger->GetInstance().WriteLine("Failed to create the trees from the tree mesh.");
+			return false;
+		}
 
 		CMesh* plantMeshes = LoadMesh("Resources/Models/Bushes/LS13_01.3ds");
+		if (plantMeshes == nullptr)
+		{
+			logger->GetInstance().WriteLine("Failed to load the plant mesh.");
+			return false;
+		}
 		mpListOfTreeMeshes.push_back(plantMeshes);
+		plantMeshes->EnableStaticBatching(kSceneryCellSize);
 
+		// Bushes are small, so start thinning them out well before the trees would disappear.
+		plantMeshes->GetDistanceCuller()->SetDrawDistance(kPlantDrawDistance);
+		plantMeshes->GetDistanceCuller()->SetThinning(kPlantThinningStart, kPlantDrawDistance);
+		plantMeshes->GetDistanceCuller()->SetMinimumScreenSize(kSceneryMinimumScreenSize);
+
+		transforms.clear();
 		for (auto plantInfo : terrainPtr->GetPlantInformation())
 		{
-			CModel* plant = plantMeshes->CreateModel();
-
-			if (plant == nullptr)
-			{
-				logger->GetInstance().WriteLine("Failed to create the plant from the plant mesh.");
-				return false;
-			}
-
-			plant->SetPos(plantInfo.position.x, plantInfo.position.y, plantInfo.position.z);
-			plant->SetRotationX(90.0f);
-			plant->SetRotationY(plantInfo.rotation.y);
-			plant->SetScale(plantInfo.scale);
+			CModelPool::TransformType transform;
+			transform.position = plantInfo.position;
+			transform.rotation = D3DXVECTOR3(90.0f, plantInfo.rotation.y, 0.0f);
+			transform.scale = D3DXVECTOR3(plantInfo.scale, plantInfo.scale, plantInfo.scale);
+			transforms.push_back(transform);
+		}
+
+		if (!transforms.empty() && !plantMeshes->CreateModels(static_cast<unsigned int>(transforms.size()), &transforms[0]))
+		{
+			logger->GetInstance().WriteLine("Failed to create the plants from the plant mesh.");
+			return false;
 		}
 	}
 	else
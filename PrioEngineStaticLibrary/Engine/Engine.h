@@ -151,6 +151,8 @@ public:
 
 	// Get a pointer to the main camera from our graphics object.
 	CCamera* GetMainCamera() { return mpGraphics->GetMainCamera(); };
+	// Get the frame capture the meshes are drawn through, to record frames for profiling later.
+	CFrameCapture* GetFrameCapture() { return mpGraphics->GetFrameCapture(); };
 	// Get the time it took to process the last frame.
 	float GetFrameTime();
 	// Enable or disable full screen.
@@ -163,6 +165,13 @@ public:
 	bool KeyHeld(const unsigned int key);
 private:
 	std::vector<CMesh*> mpListOfTreeMeshes;
+	// The width of the cells scenery is merged into, big enough to bring thousands of draws down to tens.
+	const float kSceneryCellSize = 64.0f;
+	const float kTreeDrawDistance = 800.0f;
+	const float kPlantDrawDistance = 300.0f;
+	const float kPlantThinningStart = 100.0f;
+	// Scenery smaller than this on screen is skipped, a few pixels across at 1080p.
+	const float kSceneryMinimumScreenSize = 0.002f;
 };
 
 // Define WndProc and the application handle pointer here so that we can re-direct the windows system messaging into our message handler 
@@ -69,7 +69,7 @@ bool CFontShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::string
 	pixelShaderBuffer = nullptr;
 
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsFilename.c_str(), NULL, NULL, "FontVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &vertexShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(vsFilename, "FontVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &vertexShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -86,7 +86,7 @@ bool CFontShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::string
 	}
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(psFilename.c_str(), NULL, NULL, "FontPixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(psFilename, "FontPixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		// If we recieved an error message.
@@ -0,0 +1,810 @@
+#include "FrameCapture.h"
+#include <cstring>
+#include <fstream>
+
+CFrameCapture::CFrameCapture(CRenderDevice* device)
+{
+	mpDevice = device;
+	mCapturing = false;
+	mFramesToCapture = 0;
+	mpReplayDevice = nullptr;
+
+	Clear();
+}
+
+CFrameCapture::~CFrameCapture()
+{
+	EndReplay();
+}
+
+/////////////////////////////
+// Capturing
+/////////////////////////////
+
+/* Records the next few frames, from the next call to BeginFrame. Anything captured before is kept, call Clear first to start again. */
+void CFrameCapture::Start(unsigned int numberOfFrames)
+{
+	mFramesToCapture = numberOfFrames;
+}
+
+/* Marks the start of a frame, must be called before anything is drawn. */
+void CFrameCapture::BeginFrame()
+{
+	// The last frame gave up part way through without ending, count it as done.
+	if (mCapturing)
+	{
+		EndFrame();
+	}
+
+	if (mFramesToCapture == 0)
+	{
+		return;
+	}
+
+	mCapturing = true;
+	mFrameStarts.push_back(static_cast<unsigned int>(mStream.size()));
+}
+
+void CFrameCapture::EndFrame()
+{
+	if (!mCapturing)
+	{
+		return;
+	}
+
+	mCapturing = false;
+	mFramesToCapture--;
+	mOpenMaps.clear();
+
+	if (mFramesToCapture == 0)
+	{
+		logger->GetInstance().WriteLine("Captured " + std::to_string(mFrameStarts.size()) + " frames, " + std::to_string(mStream.size()) + " bytes referring to " + std::to_string(mObjects.size() - 1) + " objects.");
+	}
+}
+
+/* Throws away everything captured or loaded. */
+void CFrameCapture::Clear()
+{
+	EndReplay();
+
+	mStream.clear();
+	mFrameStarts.clear();
+	mObjectIds.clear();
+	mOpenMaps.clear();
+
+	// Id 0 stands for null.
+	mObjects.clear();
+	ObjectType null;
+	null.pointer = nullptr;
+	null.isBuffer = false;
+	null.desc = D3D11_BUFFER_DESC();
+	mObjects.push_back(null);
+}
+
+/* Finds the id the stream uses for an object, giving it one the first time it's seen. */
+unsigned int CFrameCapture::FindId(const void* object)
+{
+	if (object == nullptr)
+	{
+		return 0;
+	}
+
+	auto it = mObjectIds.find(object);
+	if (it != mObjectIds.end())
+	{
+		return it->second;
+	}
+
+	ObjectType entry;
+	entry.pointer = object;
+	entry.isBuffer = false;
+	entry.desc = D3D11_BUFFER_DESC();
+
+	const unsigned int id = static_cast<unsigned int>(mObjects.size());
+	mObjects.push_back(entry);
+	mObjectIds[object] = id;
+
+	return id;
+}
+
+/* As FindId, but also declares the buffer's description the first time it's seen so it can be made again when replaying. */
+unsigned int CFrameCapture::FindBufferId(ID3D11Buffer* buffer)
+{
+	const unsigned int id = FindId(buffer);
+	if (id == 0 || mObjects[id].isBuffer)
+	{
+		return id;
+	}
+
+	mObjects[id].isBuffer = true;
+
+	auto desc = mBufferDescs.find(buffer);
+	if (desc != mBufferDescs.end())
+	{
+		mObjects[id].desc = desc->second;
+	}
+	else if (!mpDevice->GetBufferDesc(buffer, &mObjects[id].desc))
+	{
+		// Nothing will be written to it when replaying, but it can still be bound.
+		mObjects[id].desc = D3D11_BUFFER_DESC();
+	}
+
+	return id;
+}
+
+void CFrameCapture::WriteOp(OpCode op)
+{
+	mStream.push_back(static_cast<unsigned char>(op));
+}
+
+void CFrameCapture::Write(std::vector<unsigned char>& stream, unsigned int value)
+{
+	WriteBytes(stream, &value, sizeof(value));
+}
+
+void CFrameCapture::WriteBytes(std::vector<unsigned char>& stream, const void* data, unsigned int size)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	stream.insert(stream.end(), bytes, bytes + size);
+}
+
+/* Reads a value and moves the position past it.
+* @Returns bool - False if the stream ends first.
+*/
+bool CFrameCapture::Read(const std::vector<unsigned char>& stream, unsigned int& position, unsigned int& value)
+{
+	if (position + sizeof(value) > stream.size())
+	{
+		return false;
+	}
+
+	std::memcpy(&value, &stream[position], sizeof(value));
+	position += sizeof(value);
+
+	return true;
+}
+
+/////////////////////////////
+// Render device, each call is passed on and written to the stream while a frame is being captured.
+/////////////////////////////
+
+HRESULT CFrameCapture::CreateBuffer(const D3D11_BUFFER_DESC* desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Buffer** buffer)
+{
+	HRESULT result = mpDevice->CreateBuffer(desc, initialData, buffer);
+	if (SUCCEEDED(result))
+	{
+		mBufferDescs[*buffer] = *desc;
+	}
+
+	return result;
+}
+
+HRESULT CFrameCapture::CreateTextureFromFile(const std::string& filename, ID3D11ShaderResourceView** texture)
+{
+	return mpDevice->CreateTextureFromFile(filename, texture);
+}
+
+void CFrameCapture::ReleaseResource(IUnknown* resource)
+{
+	mBufferDescs.erase(resource);
+	mOpenMaps.erase(resource);
+
+	// The pointer may be handed out again for something else, so it can't be used to replay on the same device any more.
+	auto it = mObjectIds.find(resource);
+	if (it != mObjectIds.end())
+	{
+		mObjects[it->second].pointer = nullptr;
+		mObjectIds.erase(it);
+	}
+
+	mpDevice->ReleaseResource(resource);
+}
+
+bool CFrameCapture::GetBufferDesc(ID3D11Buffer* buffer, D3D11_BUFFER_DESC* desc)
+{
+	return mpDevice->GetBufferDesc(buffer, desc);
+}
+
+unsigned long long CFrameCapture::GetTextureMemory(ID3D11ShaderResourceView* texture)
+{
+	return mpDevice->GetTextureMemory(texture);
+}
+
+HRESULT CFrameCapture::Map(ID3D11Resource* resource, unsigned int subresource, D3D11_MAP mapType, D3D11_MAPPED_SUBRESOURCE* mappedResource)
+{
+	HRESULT result = mpDevice->Map(resource, subresource, mapType, mappedResource);
+
+	if (mCapturing && SUCCEEDED(result))
+	{
+		// Only buffers are ever mapped by the render path.
+		const unsigned int id = FindBufferId(static_cast<ID3D11Buffer*>(resource));
+
+		OpenMapType openMap;
+		openMap.data = mappedResource->pData;
+		openMap.size = mObjects[id].desc.ByteWidth;
+		mOpenMaps[resource] = openMap;
+	}
+
+	return result;
+}
+
+void CFrameCapture::Unmap(ID3D11Resource* resource, unsigned int subresource, unsigned int writtenStart, unsigned int writtenSize)
+{
+	auto it = mOpenMaps.find(resource);
+
+	// The data has to be copied before the real unmap, after which the pointer is no longer valid.
+	// Only the written range is copied, the rest of a discarded map is undefined and reading it back from write-combined memory is slow.
+	if (mCapturing && it != mOpenMaps.end())
+	{
+		const unsigned int start = writtenStart < it->second.size ? writtenStart : it->second.size;
+		const unsigned int size = writtenSize < it->second.size - start ? writtenSize : it->second.size - start;
+
+		WriteOp(WriteBufferRangeOp);
+		Write(mStream, FindBufferId(static_cast<ID3D11Buffer*>(resource)));
+		Write(mStream, start);
+		Write(mStream, size);
+		WriteBytes(mStream, static_cast<const unsigned char*>(it->second.data) + start, size);
+	}
+
+	if (it != mOpenMaps.end())
+	{
+		mOpenMaps.erase(it);
+	}
+
+	mpDevice->Unmap(resource, subresource, writtenStart, writtenSize);
+}
+
+void CFrameCapture::IASetVertexBuffers(unsigned int startSlot, unsigned int numberOfBuffers, ID3D11Buffer* const* buffers, const unsigned int* strides, const unsigned int* offsets)
+{
+	if (mCapturing)
+	{
+		WriteOp(SetVertexBuffersOp);
+		Write(mStream, startSlot);
+		Write(mStream, numberOfBuffers);
+		for (unsigned int i = 0; i < numberOfBuffers; i++)
+		{
+			Write(mStream, FindBufferId(buffers[i]));
+			Write(mStream, strides[i]);
+			Write(mStream, offsets[i]);
+		}
+	}
+
+	mpDevice->IASetVertexBuffers(startSlot, numberOfBuffers, buffers, strides, offsets);
+}
+
+void CFrameCapture::IASetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset)
+{
+	if (mCapturing)
+	{
+		WriteOp(SetIndexBufferOp);
+		Write(mStream, FindBufferId(buffer));
+		Write(mStream, static_cast<unsigned int>(format));
+		Write(mStream, offset);
+	}
+
+	mpDevice->IASetIndexBuffer(buffer, format, offset);
+}
+
+void CFrameCapture::IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+	if (mCapturing)
+	{
+		WriteOp(SetTopologyOp);
+		Write(mStream, static_cast<unsigned int>(topology));
+	}
+
+	mpDevice->IASetPrimitiveTopology(topology);
+}
+
+void CFrameCapture::IASetInputLayout(ID3D11InputLayout* layout)
+{
+	if (mCapturing)
+	{
+		WriteOp(SetInputLayoutOp);
+		Write(mStream, FindId(layout));
+	}
+
+	mpDevice->IASetInputLayout(layout);
+}
+
+void CFrameCapture::VSSetShader(ID3D11VertexShader* shader)
+{
+	if (mCapturing)
+	{
+		WriteOp(SetVertexShaderOp);
+		Write(mStream, FindId(shader));
+	}
+
+	mpDevice->VSSetShader(shader);
+}
+
+void CFrameCapture::PSSetShader(ID3D11PixelShader* shader)
+{
+	if (mCapturing)
+	{
+		WriteOp(SetPixelShaderOp);
+		Write(mStream, FindId(shader));
+	}
+
+	mpDevice->PSSetShader(shader);
+}
+
+void CFrameCapture::VSSetConstantBuffers(unsigned int startSlot, unsigned int numberOfBuffers, ID3D11Buffer* const* buffers)
+{
+	if (mCapturing)
+	{
+		WriteOp(SetVertexConstantBuffersOp);
+		Write(mStream, startSlot);
+		Write(mStream, numberOfBuffers);
+		for (unsigned int i = 0; i < numberOfBuffers; i++)
+		{
+			Write(mStream, FindBufferId(buffers[i]));
+		}
+	}
+
+	mpDevice->VSSetConstantBuffers(startSlot, numberOfBuffers, buffers);
+}
+
+void CFrameCapture::PSSetConstantBuffers(unsigned int startSlot, unsigned int numberOfBuffers, ID3D11Buffer* const* buffers)
+{
+	if (mCapturing)
+	{
+		WriteOp(SetPixelConstantBuffersOp);
+		Write(mStream, startSlot);
+		Write(mStream, numberOfBuffers);
+		for (unsigned int i = 0; i < numberOfBuffers; i++)
+		{
+			Write(mStream, FindBufferId(buffers[i]));
+		}
+	}
+
+	mpDevice->PSSetConstantBuffers(startSlot, numberOfBuffers, buffers);
+}
+
+bool CFrameCapture::SupportsConstantBufferOffsets()
+{
+	return mpDevice->SupportsConstantBufferOffsets();
+}
+
+void CFrameCapture::VSSetConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int numberOfConstants)
+{
+	if (mCapturing)
+	{
+		WriteOp(SetVertexConstantBufferRangeOp);
+		Write(mStream, FindBufferId(buffer));
+		Write(mStream, slot);
+		Write(mStream, firstConstant);
+		Write(mStream, numberOfConstants);
+	}
+
+	mpDevice->VSSetConstantBufferRange(slot, buffer, firstConstant, numberOfConstants);
+}
+
+void CFrameCapture::PSSetConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int numberOfConstants)
+{
+	if (mCapturing)
+	{
+		WriteOp(SetPixelConstantBufferRangeOp);
+		Write(mStream, FindBufferId(buffer));
+		Write(mStream, slot);
+		Write(mStream, firstConstant);
+		Write(mStream, numberOfConstants);
+	}
+
+	mpDevice->PSSetConstantBufferRange(slot, buffer, firstConstant, numberOfConstants);
+}
+
+void CFrameCapture::PSSetSamplers(unsigned int startSlot, unsigned int numberOfSamplers, ID3D11SamplerState* const* samplers)
+{
+	if (mCapturing)
+	{
+		WriteOp(SetSamplersOp);
+		Write(mStream, startSlot);
+		Write(mStream, numberOfSamplers);
+		for (unsigned int i = 0; i < numberOfSamplers; i++)
+		{
+			Write(mStream, FindId(samplers[i]));
+		}
+	}
+
+	mpDevice->PSSetSamplers(startSlot, numberOfSamplers, samplers);
+}
+
+void CFrameCapture::PSSetShaderResources(unsigned int startSlot, unsigned int numberOfViews, ID3D11ShaderResourceView* const* views)
+{
+	if (mCapturing)
+	{
+		WriteOp(SetShaderResourcesOp);
+		Write(mStream, startSlot);
+		Write(mStream, numberOfViews);
+		for (unsigned int i = 0; i < numberOfViews; i++)
+		{
+			Write(mStream, FindId(views[i]));
+		}
+	}
+
+	mpDevice->PSSetShaderResources(startSlot, numberOfViews, views);
+}
+
+void CFrameCapture::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	if (mCapturing)
+	{
+		WriteOp(DrawIndexedOp);
+		Write(mStream, indexCount);
+		Write(mStream, startIndex);
+		Write(mStream, static_cast<unsigned int>(baseVertex));
+	}
+
+	mpDevice->DrawIndexed(indexCount, startIndex, baseVertex);
+}
+
+void CFrameCapture::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance)
+{
+	if (mCapturing)
+	{
+		WriteOp(DrawIndexedInstancedOp);
+		Write(mStream, indexCount);
+		Write(mStream, instanceCount);
+		Write(mStream, startIndex);
+		Write(mStream, static_cast<unsigned int>(baseVertex));
+		Write(mStream, startInstance);
+	}
+
+	mpDevice->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+}
+
+/////////////////////////////
+// Saving and loading
+/////////////////////////////
+
+/* Writes the objects, frames and stream to a binary file.
+* @Returns bool Success
+*/
+bool CFrameCapture::Save(std::string filename)
+{
+	std::vector<unsigned char> header;
+
+	Write(header, kFileTag);
+	Write(header, kFileVersion);
+
+	Write(header, static_cast<unsigned int>(mObjects.size()));
+	for (auto& object : mObjects)
+	{
+		Write(header, object.isBuffer ? 1 : 0);
+		Write(header, object.desc.ByteWidth);
+		Write(header, static_cast<unsigned int>(object.desc.Usage));
+		Write(header, object.desc.BindFlags);
+		Write(header, object.desc.CPUAccessFlags);
+		Write(header, object.desc.MiscFlags);
+		Write(header, object.desc.StructureByteStride);
+	}
+
+	Write(header, static_cast<unsigned int>(mFrameStarts.size()));
+	for (auto start : mFrameStarts)
+	{
+		Write(header, start);
+	}
+
+	Write(header, static_cast<unsigned int>(mStream.size()));
+
+	std::ofstream outFile(filename, std::ios::binary);
+	if (!outFile.is_open())
+	{
+		logger->GetInstance().WriteLine("Failed to open '" + filename + "' to save the frame capture to.");
+		return false;
+	}
+
+	outFile.write(reinterpret_cast<const char*>(header.data()), header.size());
+	outFile.write(reinterpret_cast<const char*>(mStream.data()), mStream.size());
+
+	if (!outFile.good())
+	{
+		logger->GetInstance().WriteLine("Failed to write the frame capture to '" + filename + "'.");
+		return false;
+	}
+
+	return true;
+}
+
+/* Replaces whatever is held with a capture saved by Save. The objects have no pointers, so it can't be replayed on the same device it was captured on.
+* @Returns bool Success
+*/
+bool CFrameCapture::Load(std::string filename)
+{
+	std::ifstream inFile(filename, std::ios::binary);
+	if (!inFile.is_open())
+	{
+		logger->GetInstance().WriteLine("Failed to open the frame capture '" + filename + "'.");
+		return false;
+	}
+
+	std::vector<unsigned char> file((std::istreambuf_iterator<char>(inFile)), std::istreambuf_iterator<char>());
+
+	Clear();
+	mObjects.clear();
+
+	unsigned int position = 0;
+	unsigned int tag = 0;
+	unsigned int version = 0;
+	unsigned int numberOfObjects = 0;
+	bool valid = Read(file, position, tag) && Read(file, position, version) && Read(file, position, numberOfObjects);
+	valid = valid && tag == kFileTag && version >= kOldestFileVersion && version <= kFileVersion;
+
+	for (unsigned int i = 0; valid && i < numberOfObjects; i++)
+	{
+		ObjectType object;
+		unsigned int isBuffer = 0;
+		unsigned int usage = 0;
+
+		object.pointer = nullptr;
+		valid = Read(file, position, isBuffer) && Read(file, position, object.desc.ByteWidth) && Read(file, position, usage) &&
+			Read(file, position, object.desc.BindFlags) && Read(file, position, object.desc.CPUAccessFlags) &&
+			Read(file, position, object.desc.MiscFlags) && Read(file, position, object.desc.StructureByteStride);
+
+		object.isBuffer = isBuffer != 0;
+		object.desc.Usage = static_cast<D3D11_USAGE>(usage);
+		mObjects.push_back(object);
+	}
+
+	unsigned int numberOfFrames = 0;
+	valid = valid && Read(file, position, numberOfFrames);
+
+	for (unsigned int i = 0; valid && i < numberOfFrames; i++)
+	{
+		unsigned int start = 0;
+		valid = Read(file, position, start);
+		mFrameStarts.push_back(start);
+	}
+
+	unsigned int streamSize = 0;
+	valid = valid && Read(file, position, streamSize) && position + streamSize == file.size() && !mObjects.empty();
+
+	// ReplayFrame reads from one frame's start up to the next, so they have to be in order and inside the stream.
+	for (unsigned int i = 0; valid && i < mFrameStarts.size(); i++)
+	{
+		valid = mFrameStarts[i] <= streamSize && (i == 0 || mFrameStarts[i] >= mFrameStarts[i - 1]);
+	}
+
+	if (!valid)
+	{
+		logger->GetInstance().WriteLine("'" + filename + "' is not a frame capture, or was saved by a different version.");
+		Clear();
+		return false;
+	}
+
+	mStream.assign(file.begin() + position, file.end());
+
+	return true;
+}
+
+/////////////////////////////
+// Replaying
+/////////////////////////////
+
+/* Gets ready to replay frames against a device, making a buffer for each buffer in the capture.
+* @PARAM bool sameDevice - True to use the original buffers, shaders and textures, only possible if the capture was made on this device in this run.
+*	Otherwise new buffers are made, and other objects such as shaders are replayed as null, which is fine for a null device.
+* @Returns bool Success
+*/
+bool CFrameCapture::BeginReplay(CRenderDevice* device, bool sameDevice)
+{
+	EndReplay();
+
+	if (device == nullptr)
+	{
+		return false;
+	}
+
+	mpReplayDevice = device;
+	mReplayObjects.assign(mObjects.size(), nullptr);
+
+	for (unsigned int id = 1; id < mObjects.size(); id++)
+	{
+		const ObjectType& object = mObjects[id];
+
+		if (sameDevice && object.pointer != nullptr)
+		{
+			mReplayObjects[id] = const_cast<void*>(object.pointer);
+			continue;
+		}
+
+		if (!object.isBuffer || object.desc.ByteWidth == 0)
+		{
+			continue;
+		}
+
+		// There's no data to fill an immutable buffer with.
+		D3D11_BUFFER_DESC desc = object.desc;
+		if (desc.Usage == D3D11_USAGE_IMMUTABLE)
+		{
+			desc.Usage = D3D11_USAGE_DEFAULT;
+		}
+
+		ID3D11Buffer* buffer = nullptr;
+		if (FAILED(device->CreateBuffer(&desc, NULL, &buffer)))
+		{
+			logger->GetInstance().WriteLine("Failed to create a buffer to replay the frame capture with.");
+			EndReplay();
+			return false;
+		}
+
+		mReplayObjects[id] = buffer;
+		mReplayBuffers.push_back(buffer);
+	}
+
+	return true;
+}
+
+/* Makes every call of one captured frame again on the device given to BeginReplay.
+* @Returns bool - False if the stream is damaged, or BeginReplay wasn't called.
+*/
+bool CFrameCapture::ReplayFrame(unsigned int frame)
+{
+	if (mpReplayDevice == nullptr || frame >= mFrameStarts.size())
+	{
+		return false;
+	}
+
+	const unsigned int end = frame + 1 < mFrameStarts.size() ? mFrameStarts[frame + 1] : static_cast<unsigned int>(mStream.size());
+	const unsigned int numberOfObjects = static_cast<unsigned int>(mReplayObjects.size());
+	unsigned int position = mFrameStarts[frame];
+
+	// Arguments are read into here, the layout of each op is the order its capture function wrote them in.
+	unsigned int values[5];
+	void* objects[kMaxBindings];
+	unsigned int strides[kMaxBindings];
+	unsigned int offsets[kMaxBindings];
+
+	while (position < end)
+	{
+		const OpCode op = static_cast<OpCode>(mStream[position++]);
+		bool valid = true;
+
+		if (op == SetVertexBuffersOp || op == SetVertexConstantBuffersOp || op == SetPixelConstantBuffersOp || op == SetSamplersOp || op == SetShaderResourcesOp)
+		{
+			// Start slot, count, then the objects.
+			valid = Read(mStream, position, values[0]) && Read(mStream, position, values[1]) && values[1] <= kMaxBindings;
+
+			for (unsigned int i = 0; valid && i < values[1]; i++)
+			{
+				unsigned int id = 0;
+				valid = Read(mStream, position, id) && id < numberOfObjects;
+				objects[i] = valid ? mReplayObjects[id] : nullptr;
+
+				if (valid && op == SetVertexBuffersOp)
+				{
+					valid = Read(mStream, position, strides[i]) && Read(mStream, position, offsets[i]);
+				}
+			}
+		}
+		else if (op == WriteBufferOp || op == WriteBufferRangeOp)
+		{
+			// Files older than version 3 wrote the whole buffer from the start.
+			unsigned int id = 0;
+			unsigned int start = 0;
+			unsigned int size = 0;
+			valid = Read(mStream, position, id) && (op == WriteBufferOp || Read(mStream, position, start)) && Read(mStream, position, size) &&
+				id < numberOfObjects && size <= end - position && start <= mObjects[id].desc.ByteWidth && size <= mObjects[id].desc.ByteWidth - start;
+
+			ID3D11Buffer* buffer = valid ? static_cast<ID3D11Buffer*>(mReplayObjects[id]) : nullptr;
+			D3D11_MAPPED_SUBRESOURCE mappedResource;
+
+			if (buffer != nullptr && size > 0 && SUCCEEDED(mpReplayDevice->Map(buffer, 0, D3D11_MAP_WRITE_DISCARD, &mappedResource)))
+			{
+				std::memcpy(static_cast<unsigned char*>(mappedResource.pData) + start, &mStream[position], size);
+				mpReplayDevice->Unmap(buffer, 0, start, size);
+			}
+
+			position += valid ? size : 0;
+		}
+		else
+		{
+			unsigned int numberOfValues = 0;
+			switch (op)
+			{
+			case SetTopologyOp:
+			case SetInputLayoutOp:
+			case SetVertexShaderOp:
+			case SetPixelShaderOp:
+				numberOfValues = 1;
+				break;
+			case SetIndexBufferOp:
+			case DrawIndexedOp:
+				numberOfValues = 3;
+				break;
+			case SetVertexConstantBufferRangeOp:
+			case SetPixelConstantBufferRangeOp:
+				numberOfValues = 4;
+				break;
+			case DrawIndexedInstancedOp:
+				numberOfValues = 5;
+				break;
+			default:
+				valid = false;
+				break;
+			}
+
+			for (unsigned int i = 0; valid && i < numberOfValues; i++)
+			{
+				valid = Read(mStream, position, values[i]);
+			}
+		}
+
+		if (!valid || position > end)
+		{
+			logger->GetInstance().WriteLine("The frame capture stream is damaged, stopped replaying frame " + std::to_string(frame) + ".");
+			return false;
+		}
+
+		// The objects of ops which take a single one.
+		void* object = (op == SetInputLayoutOp || op == SetVertexShaderOp || op == SetPixelShaderOp || op == SetIndexBufferOp ||
+			op == SetVertexConstantBufferRangeOp || op == SetPixelConstantBufferRangeOp) && values[0] < numberOfObjects ? mReplayObjects[values[0]] : nullptr;
+
+		switch (op)
+		{
+		case SetVertexBuffersOp:
+			mpReplayDevice->IASetVertexBuffers(values[0], values[1], reinterpret_cast<ID3D11Buffer* const*>(objects), strides, offsets);
+			break;
+		case SetIndexBufferOp:
+			mpReplayDevice->IASetIndexBuffer(static_cast<ID3D11Buffer*>(object), static_cast<DXGI_FORMAT>(values[1]), values[2]);
+			break;
+		case SetTopologyOp:
+			mpReplayDevice->IASetPrimitiveTopology(static_cast<D3D11_PRIMITIVE_TOPOLOGY>(values[0]));
+			break;
+		case SetInputLayoutOp:
+			mpReplayDevice->IASetInputLayout(static_cast<ID3D11InputLayout*>(object));
+			break;
+		case SetVertexShaderOp:
+			mpReplayDevice->VSSetShader(static_cast<ID3D11VertexShader*>(object));
+			break;
+		case SetPixelShaderOp:
+			mpReplayDevice->PSSetShader(static_cast<ID3D11PixelShader*>(object));
+			break;
+		case SetVertexConstantBuffersOp:
+			mpReplayDevice->VSSetConstantBuffers(values[0], values[1], reinterpret_cast<ID3D11Buffer* const*>(objects));
+			break;
+		case SetPixelConstantBuffersOp:
+			mpReplayDevice->PSSetConstantBuffers(values[0], values[1], reinterpret_cast<ID3D11Buffer* const*>(objects));
+			break;
+		case SetVertexConstantBufferRangeOp:
+			mpReplayDevice->VSSetConstantBufferRange(values[1], static_cast<ID3D11Buffer*>(object), values[2], values[3]);
+			break;
+		case SetPixelConstantBufferRangeOp:
+			mpReplayDevice->PSSetConstantBufferRange(values[1], static_cast<ID3D11Buffer*>(object), values[2], values[3]);
+			break;
+		case SetSamplersOp:
+			mpReplayDevice->PSSetSamplers(values[0], values[1], reinterpret_cast<ID3D11SamplerState* const*>(objects));
+			break;
+		case SetShaderResourcesOp:
+			mpReplayDevice->PSSetShaderResources(values[0], values[1], reinterpret_cast<ID3D11ShaderResourceView* const*>(objects));
+			break;
+		case DrawIndexedOp:
+			mpReplayDevice->DrawIndexed(values[0], values[1], static_cast<int>(values[2]));
+			break;
+		case DrawIndexedInstancedOp:
+			mpReplayDevice->DrawIndexedInstanced(values[0], values[1], values[2], static_cast<int>(values[3]), values[4]);
+			break;
+		default:
+			break;
+		}
+	}
+
+	return true;
+}
+
+/* Releases the buffers made for replaying. */
+void CFrameCapture::EndReplay()
+{
+	if (mpReplayDevice != nullptr)
+	{
+		for (auto buffer : mReplayBuffers)
+		{
+			mpReplayDevice->ReleaseResource(buffer);
+		}
+	}
+
+	mReplayBuffers.clear();
+	mReplayObjects.clear();
+	mpReplayDevice = nullptr;
+}
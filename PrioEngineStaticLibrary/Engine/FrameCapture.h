@@ -0,0 +1,139 @@
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include "RenderDevice.h"
+#include "PrioEngineVars.h"
+
+/* Sits in front of another render device, passing every call on to it, and can record the calls of whole frames into a compact binary stream.
+* The stream can be saved, loaded again and replayed against any render device, so the cost of submitting a real frame can be measured without running the game,
+* and two versions of the submission code can be compared on exactly the same input.
+*
+* Buffers, shaders, textures and so on are written as small ids. Buffers are declared once with their description, and the range the caller says it wrote
+* between a map and an unmap is stored, so the constant and instance data of the frame are in the stream. The contents of vertex and index buffers which
+* are never mapped are not, they're replayed as empty buffers of the right size.
+*/
+class CFrameCapture : public CRenderDevice
+{
+private:
+	CLogger* logger;
+public:
+	CFrameCapture(CRenderDevice* device);
+	~CFrameCapture();
+public:
+	HRESULT CreateBuffer(const D3D11_BUFFER_DESC* desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Buffer** buffer);
+	HRESULT CreateTextureFromFile(const std::string& filename, ID3D11ShaderResourceView** texture);
+	void ReleaseResource(IUnknown* resource);
+	bool GetBufferDesc(ID3D11Buffer* buffer, D3D11_BUFFER_DESC* desc);
+	unsigned long long GetTextureMemory(ID3D11ShaderResourceView* texture);
+	HRESULT Map(ID3D11Resource* resource, unsigned int subresource, D3D11_MAP mapType, D3D11_MAPPED_SUBRESOURCE* mappedResource);
+	void Unmap(ID3D11Resource* resource, unsigned int subresource, unsigned int writtenStart, unsigned int writtenSize);
+
+	void IASetVertexBuffers(unsigned int startSlot, unsigned int numberOfBuffers, ID3D11Buffer* const* buffers, const unsigned int* strides, const unsigned int* offsets);
+	void IASetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset);
+	void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology);
+	void IASetInputLayout(ID3D11InputLayout* layout);
+	void VSSetShader(ID3D11VertexShader* shader);
+	void PSSetShader(ID3D11PixelShader* shader);
+	void VSSetConstantBuffers(unsigned int startSlot, unsigned int numberOfBuffers, ID3D11Buffer* const* buffers);
+	void PSSetConstantBuffers(unsigned int startSlot, unsigned int numberOfBuffers, ID3D11Buffer* const* buffers);
+	bool SupportsConstantBufferOffsets();
+	void VSSetConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int numberOfConstants);
+	void PSSetConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int numberOfConstants);
+	void PSSetSamplers(unsigned int startSlot, unsigned int numberOfSamplers, ID3D11SamplerState* const* samplers);
+	void PSSetShaderResources(unsigned int startSlot, unsigned int numberOfViews, ID3D11ShaderResourceView* const* views);
+
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+	void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance);
+public:
+	/* Capturing. */
+	void Start(unsigned int numberOfFrames);
+	void BeginFrame();
+	void EndFrame();
+	void Clear();
+	bool IsCapturing() { return mCapturing || mFramesToCapture > 0; };
+
+	bool Save(std::string filename);
+	bool Load(std::string filename);
+
+	/* Replaying. */
+	bool BeginReplay(CRenderDevice* device, bool sameDevice);
+	bool ReplayFrame(unsigned int frame);
+	void EndReplay();
+
+	unsigned int GetNumberOfFrames() { return static_cast<unsigned int>(mFrameStarts.size()); };
+	unsigned int GetStreamSize() { return static_cast<unsigned int>(mStream.size()); };
+	unsigned int GetNumberOfObjects() { return static_cast<unsigned int>(mObjects.size()); };
+private:
+	enum OpCode
+	{
+		SetVertexBuffersOp,
+		SetIndexBufferOp,
+		SetTopologyOp,
+		SetInputLayoutOp,
+		SetVertexShaderOp,
+		SetPixelShaderOp,
+		SetVertexConstantBuffersOp,
+		SetPixelConstantBuffersOp,
+		SetSamplersOp,
+		SetShaderResourcesOp,
+		WriteBufferOp,
+		DrawIndexedOp,
+		DrawIndexedInstancedOp,
+		SetVertexConstantBufferRangeOp,
+		SetPixelConstantBufferRangeOp,
+		WriteBufferRangeOp
+	};
+
+	// Anything the stream refers to. Id 0 is always null.
+	struct ObjectType
+	{
+		// Only known while the capture is in memory, objects loaded from a file have no pointer.
+		const void* pointer;
+		bool isBuffer;
+		D3D11_BUFFER_DESC desc;
+	};
+
+	// A map which hasn't been unmapped yet, the written range is copied into the stream on unmap.
+	struct OpenMapType
+	{
+		void* data;
+		unsigned int size;
+	};
+
+	unsigned int FindId(const void* object);
+	unsigned int FindBufferId(ID3D11Buffer* buffer);
+
+	static void Write(std::vector<unsigned char>& stream, unsigned int value);
+	static void WriteBytes(std::vector<unsigned char>& stream, const void* data, unsigned int size);
+	static bool Read(const std::vector<unsigned char>& stream, unsigned int& position, unsigned int& value);
+	void WriteOp(OpCode op);
+
+	// Files start with this, then the version. Version 2 added the constant buffer range ops and version 3 the buffer range write, so older files are still read.
+	const unsigned int kFileTag = 0x50414350;
+	const unsigned int kFileVersion = 3;
+	const unsigned int kOldestFileVersion = 1;
+	// The most buffers, samplers or views one call can bind.
+	static const unsigned int kMaxBindings = 128;
+
+	CRenderDevice* mpDevice;
+
+	bool mCapturing;
+	unsigned int mFramesToCapture;
+	std::vector<unsigned char> mStream;
+	std::vector<unsigned int> mFrameStarts;
+	std::vector<ObjectType> mObjects;
+	std::unordered_map<const void*, unsigned int> mObjectIds;
+	std::unordered_map<const void*, OpenMapType> mOpenMaps;
+
+	// Buffer descriptions of everything made through this device, kept whether capturing or not so buffers made at load time can be declared later.
+	std::unordered_map<const void*, D3D11_BUFFER_DESC> mBufferDescs;
+
+	CRenderDevice* mpReplayDevice;
+	std::vector<void*> mReplayObjects;
+	std::vector<ID3D11Buffer*> mReplayBuffers;
+};
+
+#endif
@@ -0,0 +1,99 @@
+#include "FrameGovernor.h"
+
+const unsigned int CFrameGovernor::kNumberOfLevels;
+
+CFrameGovernor::CFrameGovernor()
+{
+	mEnabled = true;
+	mTargetFrameTime = 1.0f / 60.0f;
+
+	mNumberOfDowngrades = 0;
+	mNumberOfUpgrades = 0;
+	mFramesOverTarget = 0;
+	mFramesAtLowestLevel = 0;
+
+	Reset();
+}
+
+CFrameGovernor::~CFrameGovernor()
+{
+}
+
+/* Goes back to full quality and forgets the frame times seen so far. The counters carry on. */
+void CFrameGovernor::Reset()
+{
+	mLevel = 0;
+	mAverageFrameTime = 0.0f;
+	mSettleFramesLeft = kSettleFrames;
+	mFramesAbove = 0;
+	mFramesBelow = 0;
+}
+
+/* Turning the governor off goes back to full quality, the settings have to be applied again afterwards. */
+void CFrameGovernor::SetEnabled(bool enabled)
+{
+	mEnabled = enabled;
+
+	if (!mEnabled)
+	{
+		Reset();
+	}
+}
+
+/* Adds the time the last frame took, and moves up or down a level if the average has been past a threshold for long enough.
+* @PARAM float frameTime - In seconds, as given by CEngine::GetFrameTime.
+* @Returns bool Whether the level changed, so its settings need applying.
+*/
+bool CFrameGovernor::Update(float frameTime)
+{
+	// Not enabled, or the timer is stopped.
+	if (!mEnabled || mTargetFrameTime <= 0.0f || frameTime <= 0.0f)
+	{
+		return false;
+	}
+
+	const float maxSample = mTargetFrameTime * kMaxSampleTargets;
+	frameTime = frameTime > maxSample ? maxSample : frameTime;
+
+	// Start the average from the first frame rather than from zero.
+	mAverageFrameTime = mAverageFrameTime > 0.0f ? mAverageFrameTime + (frameTime - mAverageFrameTime) * kSmoothing : frameTime;
+
+	mFramesOverTarget += frameTime > mTargetFrameTime ? 1 : 0;
+	mFramesAtLowestLevel += mLevel == kNumberOfLevels - 1 ? 1 : 0;
+
+	if (mSettleFramesLeft > 0)
+	{
+		mSettleFramesLeft--;
+		return false;
+	}
+
+	mFramesAbove = mAverageFrameTime > mTargetFrameTime * kDowngradeThreshold ? mFramesAbove + 1 : 0;
+	mFramesBelow = mAverageFrameTime < mTargetFrameTime * kUpgradeThreshold ? mFramesBelow + 1 : 0;
+
+	if (mFramesAbove >= kDowngradeFrames && mLevel < kNumberOfLevels - 1)
+	{
+		mNumberOfDowngrades++;
+		return SetLevel(mLevel + 1);
+	}
+
+	if (mFramesBelow >= kUpgradeFrames && mLevel > 0)
+	{
+		mNumberOfUpgrades++;
+		return SetLevel(mLevel - 1);
+	}
+
+	return false;
+}
+
+bool CFrameGovernor::SetLevel(unsigned int level)
+{
+	logger->GetInstance().WriteLine("Frame governor moved from quality level " + std::to_string(mLevel) + " to " + std::to_string(level) + ", averaging " +
+		std::to_string(mAverageFrameTime * 1000.0f) + "ms against a target of " + std::to_string(mTargetFrameTime * 1000.0f) + "ms.");
+
+	mLevel = level;
+	mSettleFramesLeft = kSettleFrames;
+	mFramesAbove = 0;
+	mFramesBelow = 0;
+
+	return true;
+}
@@ -0,0 +1,91 @@
+#ifndef FRAMEGOVERNOR_H
+#define FRAMEGOVERNOR_H
+
+#include "PrioEngineVars.h"
+
+/* Holds a target frame time by stepping through a ladder of quality levels, level 0 being full quality.
+* Each frame time is folded into a moving average, and the level only changes once the average has stayed past a threshold for a number of frames in a row.
+* The threshold to drop a level sits above the target and the threshold to raise one sits well below it, so a frame time near the target never flips between two levels.
+* After every change the average is given time to settle before anything else is decided.
+*
+* The governor only decides, CGraphics applies the settings of the current level to the meshes, the water and the rain.
+*/
+class CFrameGovernor
+{
+private:
+	CLogger* logger;
+public:
+	struct QualitySettingsType
+	{
+		// Multiplies the screen sizes at which meshes drop to each lower detail level, above 1 drops detail sooner.
+		float meshDetailBias;
+		// Multiplies the draw and thinning distances of every mesh.
+		float drawDistanceScale;
+		// How many frames the water's reflection and refraction are kept for while the camera moves, 0 redraws them every frame.
+		unsigned int waterRefreshInterval;
+		// The fraction of the rain's particles which are simulated and drawn.
+		float rainParticleFraction;
+	};
+
+	static const unsigned int kNumberOfLevels = 5;
+public:
+	CFrameGovernor();
+	~CFrameGovernor();
+public:
+	bool Update(float frameTime);
+	void Reset();
+
+	void SetEnabled(bool enabled);
+	void SetTargetFrameTime(float frameTime) { mTargetFrameTime = frameTime; };
+
+	bool IsEnabled() { return mEnabled; };
+	float GetTargetFrameTime() { return mTargetFrameTime; };
+	float GetAverageFrameTime() { return mAverageFrameTime; };
+	unsigned int GetLevel() { return mLevel; };
+	const QualitySettingsType& GetSettings() { return kLevels[mLevel]; };
+
+	unsigned int GetNumberOfDowngrades() { return mNumberOfDowngrades; };
+	unsigned int GetNumberOfUpgrades() { return mNumberOfUpgrades; };
+	unsigned int GetFramesOverTarget() { return mFramesOverTarget; };
+	unsigned int GetFramesAtLowestLevel() { return mFramesAtLowestLevel; };
+private:
+	bool SetLevel(unsigned int level);
+
+	const QualitySettingsType kLevels[kNumberOfLevels] =
+	{
+		{ 1.0f, 1.0f, 0, 1.0f },
+		// The water and rain are cheap to turn down and hard to notice, so they go first.
+		{ 1.0f, 1.0f, 1, 0.75f },
+		{ 1.5f, 0.85f, 1, 0.5f },
+		{ 2.0f, 0.7f, 2, 0.5f },
+		{ 3.0f, 0.55f, 3, 0.25f }
+	};
+
+	// How much of each new frame time goes into the average.
+	const float kSmoothing = 0.1f;
+	// Frame times longer than this many targets are clamped, so one hitch such as a load doesn't swing the average.
+	const float kMaxSampleTargets = 4.0f;
+	// Drop a level once the average has been above this fraction of the target for kDowngradeFrames frames in a row.
+	const float kDowngradeThreshold = 1.1f;
+	const unsigned int kDowngradeFrames = 15;
+	// Raise a level once the average has been below this fraction of the target for kUpgradeFrames frames in a row.
+	const float kUpgradeThreshold = 0.75f;
+	const unsigned int kUpgradeFrames = 120;
+	// Frames to wait after a change, or after starting, before deciding anything.
+	const unsigned int kSettleFrames = 30;
+
+	bool mEnabled;
+	float mTargetFrameTime;
+	float mAverageFrameTime;
+	unsigned int mLevel;
+	unsigned int mSettleFramesLeft;
+	unsigned int mFramesAbove;
+	unsigned int mFramesBelow;
+
+	unsigned int mNumberOfDowngrades;
+	unsigned int mNumberOfUpgrades;
+	unsigned int mFramesOverTarget;
+	unsigned int mFramesAtLowestLevel;
+};
+
+#endif
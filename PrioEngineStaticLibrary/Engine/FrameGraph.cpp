@@ -0,0 +1,432 @@
+#include "FrameGraph.h"
+#include <set>
+#include <algorithm>
+
+const unsigned int CFrameGraph::kNone;
+
+CFrameGraph::CFrameGraph()
+{
+	mCompiled = false;
+}
+
+CFrameGraph::~CFrameGraph()
+{
+	Clear();
+}
+
+/* Throws away every pass and resource, ready to build the next frame. The arrays keep their memory. */
+void CFrameGraph::Clear()
+{
+	mPasses.clear();
+	mResources.clear();
+	mOrder.clear();
+	mAliasSlots.clear();
+	mCompiled = false;
+}
+
+/////////////////////////////
+// Declaring
+/////////////////////////////
+
+CFrameGraph::ResourceId CFrameGraph::ImportResource(std::string name)
+{
+	GraphResourceType resource;
+	resource.name = name;
+	resource.imported = true;
+	resource.desc.width = 0;
+	resource.desc.height = 0;
+	resource.desc.format = 0;
+	resource.firstUse = kNone;
+	resource.lastUse = kNone;
+	resource.aliasSlot = kNone;
+
+	mResources.push_back(resource);
+	mCompiled = false;
+
+	return static_cast<ResourceId>(mResources.size() - 1);
+}
+
+CFrameGraph::ResourceId CFrameGraph::CreateResource(std::string name, ResourceDescType desc)
+{
+	ResourceId resource = ImportResource(name);
+	mResources[resource].imported = false;
+	mResources[resource].desc = desc;
+
+	return resource;
+}
+
+CFrameGraph::PassId CFrameGraph::AddPass(std::string name, std::function<bool()> execute)
+{
+	GraphPassType pass;
+	pass.name = name;
+	pass.execute = execute;
+	pass.sideEffects = false;
+	pass.live = false;
+	pass.dependencies = 0;
+
+	mPasses.push_back(pass);
+	mCompiled = false;
+
+	return static_cast<PassId>(mPasses.size() - 1);
+}
+
+void CFrameGraph::Read(PassId pass, ResourceId resource)
+{
+	FindAccess(pass, resource).read = true;
+	mCompiled = false;
+}
+
+void CFrameGraph::Write(PassId pass, ResourceId resource)
+{
+	FindAccess(pass, resource).write = true;
+	mCompiled = false;
+}
+
+void CFrameGraph::SetSideEffects(PassId pass)
+{
+	mPasses[pass].sideEffects = true;
+	mCompiled = false;
+}
+
+/* Finds a pass's access to a resource, adding one in pass order if it hasn't touched the resource yet. */
+CFrameGraph::AccessType& CFrameGraph::FindAccess(PassId pass, ResourceId resource)
+{
+	std::vector<AccessType>& accesses = mResources[resource].accesses;
+
+	auto it = std::lower_bound(accesses.begin(), accesses.end(), pass, [](const AccessType& access, PassId id) { return access.pass < id; });
+
+	if (it == accesses.end() || it->pass != pass)
+	{
+		AccessType access;
+		access.pass = pass;
+		access.read = false;
+		access.write = false;
+		it = accesses.insert(it, access);
+	}
+
+	return *it;
+}
+
+/////////////////////////////
+// Compiling
+/////////////////////////////
+
+/* Culls, orders and works out resource lifetimes, see the top of FrameGraph.h.
+* @Returns bool Success, fails if a transient resource is read without ever being written, or if the passes depend on each other in a loop.
+*/
+bool CFrameGraph::Compile()
+{
+	mOrder.clear();
+	mAliasSlots.clear();
+
+	for (auto& pass : mPasses)
+	{
+		pass.live = false;
+		pass.successors.clear();
+		pass.producers.clear();
+		pass.dependencies = 0;
+	}
+
+	for (auto& resource : mResources)
+	{
+		resource.firstUse = kNone;
+		resource.lastUse = kNone;
+		resource.aliasSlot = kNone;
+	}
+
+	if (!BuildEdges())
+	{
+		return false;
+	}
+
+	CullPasses();
+
+	if (!OrderPasses())
+	{
+		return false;
+	}
+
+	AssignAliasSlots();
+
+	mCompiled = true;
+
+	return true;
+}
+
+void CFrameGraph::AddEdge(PassId from, PassId to, bool producer)
+{
+	if (from == to)
+	{
+		return;
+	}
+
+	mPasses[from].successors.push_back(to);
+
+	if (producer)
+	{
+		mPasses[to].producers.push_back(from);
+	}
+}
+
+/* Works out which passes have to run before which, by walking each resource's accesses in the order the passes were added.
+* @Returns bool Success
+*/
+bool CFrameGraph::BuildEdges()
+{
+	for (auto& resource : mResources)
+	{
+		PassId lastWriter = kNone;
+		std::vector<PassId> readersSinceWrite;
+
+		for (auto& access : resource.accesses)
+		{
+			if (access.read && !access.write && lastWriter == kNone && !resource.imported)
+			{
+				// Nothing has written it yet, so it reads the finished resource from every writer added after it.
+				bool written = false;
+				for (auto& writer : resource.accesses)
+				{
+					if (writer.write && writer.pass != access.pass)
+					{
+						AddEdge(writer.pass, access.pass, true);
+						written = true;
+					}
+				}
+
+				if (!written)
+				{
+					logger->GetInstance().WriteLine("The " + mPasses[access.pass].name + " pass reads " + resource.name + ", which no pass writes.");
+					return false;
+				}
+			}
+			else if (access.read && !access.write && lastWriter != kNone)
+			{
+				AddEdge(lastWriter, access.pass, true);
+			}
+
+			// A pass which modifies a resource nothing has written yet is simply its first writer.
+			if (access.write)
+			{
+				// Drawing over something keeps what was there before, so an earlier write is always needed by a later one.
+				if (lastWriter != kNone)
+				{
+					AddEdge(lastWriter, access.pass, true);
+				}
+
+				// Anything which read the old contents has to finish before they're overwritten.
+				for (auto reader : readersSinceWrite)
+				{
+					AddEdge(reader, access.pass, false);
+				}
+
+				lastWriter = access.pass;
+				readersSinceWrite.clear();
+			}
+			else if (lastWriter != kNone || resource.imported)
+			{
+				// An imported resource holds whatever was put in it before the frame, which has to be read before it's replaced.
+				readersSinceWrite.push_back(access.pass);
+			}
+		}
+	}
+
+	return true;
+}
+
+/* Keeps passes with side effects and passes which write imported resources, then every pass which writes something a kept pass uses. */
+void CFrameGraph::CullPasses()
+{
+	std::vector<PassId> toVisit;
+
+	for (PassId pass = 0; pass < mPasses.size(); pass++)
+	{
+		if (mPasses[pass].sideEffects)
+		{
+			toVisit.push_back(pass);
+		}
+	}
+
+	for (auto& resource : mResources)
+	{
+		if (!resource.imported)
+		{
+			continue;
+		}
+
+		for (auto& access : resource.accesses)
+		{
+			if (access.write)
+			{
+				toVisit.push_back(access.pass);
+			}
+		}
+	}
+
+	while (!toVisit.empty())
+	{
+		PassId pass = toVisit.back();
+		toVisit.pop_back();
+
+		if (mPasses[pass].live)
+		{
+			continue;
+		}
+
+		mPasses[pass].live = true;
+
+		for (auto producer : mPasses[pass].producers)
+		{
+			toVisit.push_back(producer);
+		}
+	}
+}
+
+/* Sorts the kept passes so each one comes after everything it depends on, always picking the earliest added pass which is ready.
+* @Returns bool Success, fails if the passes depend on each other in a loop.
+*/
+bool CFrameGraph::OrderPasses()
+{
+	std::set<PassId> ready;
+
+	for (auto& pass : mPasses)
+	{
+		if (!pass.live)
+		{
+			continue;
+		}
+
+		for (auto successor : pass.successors)
+		{
+			if (mPasses[successor].live)
+			{
+				mPasses[successor].dependencies++;
+			}
+		}
+	}
+
+	for (PassId pass = 0; pass < mPasses.size(); pass++)
+	{
+		if (mPasses[pass].live && mPasses[pass].dependencies == 0)
+		{
+			ready.insert(pass);
+		}
+	}
+
+	while (!ready.empty())
+	{
+		PassId pass = *ready.begin();
+		ready.erase(ready.begin());
+		mOrder.push_back(pass);
+
+		for (auto successor : mPasses[pass].successors)
+		{
+			if (mPasses[successor].live && --mPasses[successor].dependencies == 0)
+			{
+				ready.insert(successor);
+			}
+		}
+	}
+
+	unsigned int numberOfLivePasses = 0;
+	for (auto& pass : mPasses)
+	{
+		numberOfLivePasses += pass.live ? 1 : 0;
+	}
+
+	if (mOrder.size() != numberOfLivePasses)
+	{
+		logger->GetInstance().WriteLine("The frame graph couldn't be ordered, its passes depend on each other in a loop.");
+		mOrder.clear();
+		return false;
+	}
+
+	return true;
+}
+
+/* Finds when each resource is in use, then shares a slot between transient resources of the same size and format which are never in use at once. */
+void CFrameGraph::AssignAliasSlots()
+{
+	std::vector<unsigned int> positions(mPasses.size(), kNone);
+	for (unsigned int position = 0; position < mOrder.size(); position++)
+	{
+		positions[mOrder[position]] = position;
+	}
+
+	std::vector<ResourceId> transients;
+
+	for (ResourceId id = 0; id < mResources.size(); id++)
+	{
+		GraphResourceType& resource = mResources[id];
+
+		for (auto& access : resource.accesses)
+		{
+			const unsigned int position = positions[access.pass];
+			if (position == kNone)
+			{
+				continue;
+			}
+
+			resource.firstUse = resource.firstUse == kNone || position < resource.firstUse ? position : resource.firstUse;
+			resource.lastUse = resource.lastUse == kNone || position > resource.lastUse ? position : resource.lastUse;
+		}
+
+		if (!resource.imported && resource.firstUse != kNone)
+		{
+			transients.push_back(id);
+		}
+	}
+
+	std::sort(transients.begin(), transients.end(), [this](ResourceId a, ResourceId b) { return mResources[a].firstUse < mResources[b].firstUse; });
+
+	for (auto id : transients)
+	{
+		GraphResourceType& resource = mResources[id];
+
+		for (unsigned int slot = 0; slot < mAliasSlots.size() && resource.aliasSlot == kNone; slot++)
+		{
+			AliasSlotType& aliasSlot = mAliasSlots[slot];
+
+			if (aliasSlot.lastUse < resource.firstUse && aliasSlot.desc.width == resource.desc.width &&
+				aliasSlot.desc.height == resource.desc.height && aliasSlot.desc.format == resource.desc.format)
+			{
+				resource.aliasSlot = slot;
+				aliasSlot.lastUse = resource.lastUse;
+			}
+		}
+
+		if (resource.aliasSlot == kNone)
+		{
+			AliasSlotType aliasSlot;
+			aliasSlot.desc = resource.desc;
+			aliasSlot.lastUse = resource.lastUse;
+			mAliasSlots.push_back(aliasSlot);
+			resource.aliasSlot = static_cast<unsigned int>(mAliasSlots.size() - 1);
+		}
+	}
+}
+
+/////////////////////////////
+// Executing
+/////////////////////////////
+
+/* Runs the kept passes in order, stopping at the first one which fails. Compiles first if anything has changed since the last compile.
+* @Returns bool Success
+*/
+bool CFrameGraph::Execute()
+{
+	if (!mCompiled && !Compile())
+	{
+		return false;
+	}
+
+	for (auto pass : mOrder)
+	{
+		if (!mPasses[pass].execute())
+		{
+			logger->GetInstance().WriteLine("The " + mPasses[pass].name + " pass failed.");
+			return false;
+		}
+	}
+
+	return true;
+}
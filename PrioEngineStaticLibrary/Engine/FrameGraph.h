@@ -0,0 +1,127 @@
+#ifndef FRAMEGRAPH_H
+#define FRAMEGRAPH_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include "PrioEngineVars.h"
+
+/* Schedules the passes of a frame from what each one says it reads and writes, rather than from the order they're written in.
+* The graph is rebuilt every frame: declare the resources, add the passes along with their reads and writes, then Compile and Execute.
+*
+* Compiling works on the declarations alone and doesn't touch Direct3D, it:
+* - Removes passes whose results are never used. A pass is kept if it has side effects, writes an imported resource, or writes something a kept pass reads.
+* - Orders the rest so that every pass runs after the passes it depends on, keeping the order they were added in wherever it's free to.
+* - Works out the first and last pass to use each transient resource, and gives transient resources which are never in use at the same time,
+*   and have the same size and format, the same alias slot, so they could share memory.
+*
+* Accesses to a resource happen in the order the passes were added. Reading a resource reads whatever the last pass added before it wrote.
+* If no pass added before it wrote anything, an imported resource reads what it held before the frame, and a transient resource reads what every pass added after it writes.
+* A pass which reads and writes a resource modifies it.
+*/
+class CFrameGraph
+{
+private:
+	CLogger* logger;
+public:
+	typedef unsigned int PassId;
+	typedef unsigned int ResourceId;
+	static const unsigned int kNone = 0xFFFFFFFF;
+
+	struct ResourceDescType
+	{
+		unsigned int width;
+		unsigned int height;
+		// A DXGI_FORMAT, kept as a number so the graph doesn't need Direct3D.
+		unsigned int format;
+	};
+public:
+	CFrameGraph();
+	~CFrameGraph();
+public:
+	void Clear();
+
+	// Something which lives outside the frame, such as the back buffer or a texture kept between frames. Never culled away or aliased.
+	ResourceId ImportResource(std::string name);
+	// Something which only has to exist while the frame uses it.
+	ResourceId CreateResource(std::string name, ResourceDescType desc);
+
+	PassId AddPass(std::string name, std::function<bool()> execute);
+	void Read(PassId pass, ResourceId resource);
+	void Write(PassId pass, ResourceId resource);
+	// Keeps a pass even though nothing reads what it writes.
+	void SetSideEffects(PassId pass);
+
+	bool Compile();
+	bool Execute();
+
+	unsigned int GetNumberOfPasses() { return static_cast<unsigned int>(mPasses.size()); };
+	unsigned int GetNumberOfCulledPasses() { return static_cast<unsigned int>(mPasses.size() - mOrder.size()); };
+	const std::vector<PassId>& GetExecutionOrder() { return mOrder; };
+	std::string GetPassName(PassId pass) { return mPasses[pass].name; };
+	bool IsPassCulled(PassId pass) { return !mPasses[pass].live; };
+
+	unsigned int GetNumberOfResources() { return static_cast<unsigned int>(mResources.size()); };
+	std::string GetResourceName(ResourceId resource) { return mResources[resource].name; };
+	ResourceDescType GetResourceDesc(ResourceId resource) { return mResources[resource].desc; };
+
+	// Positions in the execution order, kNone if no kept pass uses the resource.
+	unsigned int GetFirstUse(ResourceId resource) { return mResources[resource].firstUse; };
+	unsigned int GetLastUse(ResourceId resource) { return mResources[resource].lastUse; };
+	// kNone for imported and unused resources.
+	unsigned int GetAliasSlot(ResourceId resource) { return mResources[resource].aliasSlot; };
+	unsigned int GetNumberOfAliasSlots() { return static_cast<unsigned int>(mAliasSlots.size()); };
+private:
+	struct AccessType
+	{
+		PassId pass;
+		bool read;
+		bool write;
+	};
+
+	struct GraphResourceType
+	{
+		std::string name;
+		bool imported;
+		ResourceDescType desc;
+		// Every pass which touches the resource, sorted by pass id, which is the order the passes were added in.
+		std::vector<AccessType> accesses;
+		unsigned int firstUse;
+		unsigned int lastUse;
+		unsigned int aliasSlot;
+	};
+
+	struct GraphPassType
+	{
+		std::string name;
+		std::function<bool()> execute;
+		bool sideEffects;
+		bool live;
+		// Passes which must run after this one.
+		std::vector<PassId> successors;
+		// Passes whose writes this one uses, which decides whether they're kept.
+		std::vector<PassId> producers;
+		unsigned int dependencies;
+	};
+
+	struct AliasSlotType
+	{
+		ResourceDescType desc;
+		unsigned int lastUse;
+	};
+
+	AccessType& FindAccess(PassId pass, ResourceId resource);
+	void AddEdge(PassId from, PassId to, bool producer);
+	bool BuildEdges();
+	void CullPasses();
+	bool OrderPasses();
+	void AssignAliasSlots();
+
+	std::vector<GraphPassType> mPasses;
+	std::vector<GraphResourceType> mResources;
+	std::vector<PassId> mOrder;
+	std::vector<AliasSlotType> mAliasSlots;
+	bool mCompiled;
+};
+
+#endif
@@ -2,6 +2,8 @@
 
 CFrustum::CFrustum()
 {
+	mClipPlane = D3DXPLANE(0.0f, 1.0f, 0.0f, 0.0f);
+	mUseClipPlane = false;
 }
 
 
@@ -76,6 +78,11 @@ bool CFrustum::CheckPoint(float x, float y, float z)
 		}
 	}
 
+	if (mUseClipPlane && D3DXPlaneDotCoord(&mClipPlane, &D3DXVECTOR3(x, y, z)) < 0.0f)
+	{
+		return false;
+	}
+
 	// Success!
 	return true;
 }
@@ -89,6 +96,91 @@ bool CFrustum::CheckSphere(D3DXVECTOR3 position, float radius)
 			return false;
 		}
 	}
+
+	// Check the sphere isn't entirely behind the clip plane.
+	if (mUseClipPlane && mClipPlane.a * position.x + mClipPlane.b * position.y + mClipPlane.c * position.z + mClipPlane.d <= -radius)
+	{
+		return false;
+	}
+
 	// Success!
 	return true;
 }
+
+/* Checks whether an axis aligned box is at least partly inside the frustum.
+* @Returns bool - False if the box is entirely outside one of the planes.
+*/
+bool CFrustum::CheckBox(D3DXVECTOR3 minPoint, D3DXVECTOR3 maxPoint)
+{
+	for (int i = 0; i < kNumberOfPlanes; i++)
+	{
+		// Test the corner which lies furthest along the plane normal.
+		float x = mPlanes[i].a >= 0.0f ? maxPoint.x : minPoint.x;
+		float y = mPlanes[i].b >= 0.0f ? maxPoint.y : minPoint.y;
+		float z = mPlanes[i].c >= 0.0f ? maxPoint.z : minPoint.z;
+
+		if (mPlanes[i].a * x + mPlanes[i].b * y + mPlanes[i].c * z + mPlanes[i].d < 0.0f)
+		{
+			return false;
+		}
+	}
+
+	if (mUseClipPlane)
+	{
+		float x = mClipPlane.a >= 0.0f ? maxPoint.x : minPoint.x;
+		float y = mClipPlane.b >= 0.0f ? maxPoint.y : minPoint.y;
+		float z = mClipPlane.c >= 0.0f ? maxPoint.z : minPoint.z;
+
+		if (mClipPlane.a * x + mClipPlane.b * y + mClipPlane.c * z + mClipPlane.d < 0.0f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Finds how far a sphere is from changing its result against the frustum.
+* @Returns float - The smallest distance by which the sphere clears any plane. This is positive when the sphere
+* would pass CheckSphere, and zero or negative when it would be rejected.
+*/
+float CFrustum::GetSphereMargin(D3DXVECTOR3 position, float radius)
+{
+	float margin = mPlanes[0].a * position.x + mPlanes[0].b * position.y + mPlanes[0].c * position.z + mPlanes[0].d + radius;
+
+	for (int i = 1; i < kNumberOfPlanes; i++)
+	{
+		float planeMargin = mPlanes[i].a * position.x + mPlanes[i].b * position.y + mPlanes[i].c * position.z + mPlanes[i].d + radius;
+
+		if (planeMargin < margin)
+		{
+			margin = planeMargin;
+		}
+	}
+
+	if (mUseClipPlane)
+	{
+		float planeMargin = mClipPlane.a * position.x + mClipPlane.b * position.y + mClipPlane.c * position.z + mClipPlane.d + radius;
+
+		if (planeMargin < margin)
+		{
+			margin = planeMargin;
+		}
+	}
+
+	return margin;
+}
+
+/* Adds an extra plane to the frustum, anything entirely behind it will be rejected.
+* @PARAM D3DXPLANE plane - The plane, with its normal pointing towards the side which should be kept.
+*/
+void CFrustum::SetClipPlane(D3DXPLANE plane)
+{
+	D3DXPlaneNormalize(&mClipPlane, &plane);
+	mUseClipPlane = true;
+}
+
+void CFrustum::DisableClipPlane()
+{
+	mUseClipPlane = false;
+}
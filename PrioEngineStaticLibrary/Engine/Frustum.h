@@ -16,8 +16,15 @@ public:
 	void ConstructFrustum(float farClip, D3DXMATRIX projMatrix, D3DXMATRIX viewMatrix);
 	bool CheckPoint(float x, float y, float z);
 	bool CheckSphere(D3DXVECTOR3 position, float radius);
+	float GetSphereMargin(D3DXVECTOR3 position, float radius);
+	bool CheckBox(D3DXVECTOR3 minPoint, D3DXVECTOR3 maxPoint);
+	void SetClipPlane(D3DXPLANE plane);
+	void DisableClipPlane();
 private:
 	D3DXPLANE mPlanes[6];
+	// An optional extra plane, such as the surface of the water for a reflection.
+	D3DXPLANE mClipPlane;
+	bool mUseClipPlane;
 };
 
 #endif
\ No newline at end of file
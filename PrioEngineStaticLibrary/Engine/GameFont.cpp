@@ -206,7 +206,7 @@ bool CGameFont::LoadTextureFile(ID3D11Device * device, std::string fontTexture)
 	logger->GetInstance().MemoryAllocWriteLine(typeid(mpTexture).name());
 	
 	// Intialise the texture which we allocated memory too.
-	result = mpTexture->Initialise(device, fontTexture);
+	result = mpTexture->Initialise(device, fontTexture, CGpuMemoryTracker::Fonts);
 
 	// Check if we initialised our texture.
 	if (!result)
@@ -200,6 +200,7 @@ bool CGameText::InitialiseSentence(SentenceType** sentence, int maxLength, ID3D1
 		logger->GetInstance().WriteLine("Failed to create the vertex buffer in DirectX after passing it vertex data in GameText.cpp.");
 		return false;
 	}
+	CGpuMemoryTracker::GetInstance().Register((*sentence)->vertexBuffer, CGpuMemoryTracker::Fonts, vertexBufferDesc.ByteWidth);
 
 	// Set up descriptor for index buffer.
 	indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
@@ -222,6 +223,7 @@ bool CGameText::InitialiseSentence(SentenceType** sentence, int maxLength, ID3D1
 		logger->GetInstance().WriteLine("Faield to create the index buffer in DirectX after passing it index data in GameText.cpp.");
 		return false;
 	}
+	CGpuMemoryTracker::GetInstance().Register((*sentence)->indexBuffer, CGpuMemoryTracker::Fonts, indexBufferDesc.ByteWidth);
 
 	delete[] vertices;
 	vertices = nullptr;
@@ -357,6 +359,7 @@ void CGameText::ReleaseSentence(SentenceType* sentence)
 		if ((sentence)->vertexBuffer)
 		{
 			//delete[](sentence)->vertexBuffer;
+			CGpuMemoryTracker::GetInstance().Unregister(sentence->vertexBuffer);
 			sentence->vertexBuffer->Release();
 			(sentence)->vertexBuffer = nullptr;
 		}
@@ -365,6 +368,7 @@ void CGameText::ReleaseSentence(SentenceType* sentence)
 		if ((sentence)->indexBuffer)
 		{
 			//delete[](sentence)->indexBuffer;
+			CGpuMemoryTracker::GetInstance().Unregister(sentence->indexBuffer);
 			sentence->indexBuffer->Release();
 			(sentence)->indexBuffer = nullptr;
 		}
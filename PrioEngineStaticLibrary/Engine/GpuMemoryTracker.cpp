@@ -0,0 +1,346 @@
+#include "GpuMemoryTracker.h"
+#include <vector>
+#include <algorithm>
+
+CGpuMemoryTracker::CGpuMemoryTracker()
+{
+	for (unsigned int category = 0; category < kNumberOfCategories; category++)
+	{
+		mCategories[category].memory = 0;
+		mCategories[category].peakMemory = 0;
+		mCategories[category].budget = 0;
+		mCategories[category].numberOfResources = 0;
+		mCategories[category].numberOfEvictions = 0;
+	}
+
+	mMemory = 0;
+	mPeakMemory = 0;
+	mNextOrder = 0;
+	mFrame = 0;
+}
+
+/////////////////////////////
+// Registry
+/////////////////////////////
+
+/* Starts counting a resource. It counts as used this frame.
+* @PARAM CStreamable* owner - Who to ask to evict the resource, nullptr if it must never be evicted.
+*/
+void CGpuMemoryTracker::Register(const void* resource, CategoryType category, unsigned long long size, CStreamable* owner)
+{
+	if (resource == nullptr)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	auto it = mResources.find(resource);
+	if (it != mResources.end())
+	{
+		// Registered again without being unregistered, so the old entry is stale.
+		mCategories[it->second.category].memory -= it->second.size;
+		mCategories[it->second.category].numberOfResources--;
+		mMemory -= it->second.size;
+	}
+
+	TrackedResourceType& trackedResource = mResources[resource];
+	trackedResource.category = category;
+	trackedResource.size = size;
+	trackedResource.owner = owner;
+	trackedResource.lastUsedFrame = mFrame;
+	trackedResource.order = mNextOrder++;
+
+	CategoryStatsType& stats = mCategories[category];
+	stats.memory += size;
+	stats.numberOfResources++;
+	stats.peakMemory = stats.memory > stats.peakMemory ? stats.memory : stats.peakMemory;
+
+	mMemory += size;
+	mPeakMemory = mMemory > mPeakMemory ? mMemory : mPeakMemory;
+}
+
+/* Stops counting a resource, call it just before the resource is released. Does nothing if the resource was never registered. */
+void CGpuMemoryTracker::Unregister(const void* resource)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	auto it = mResources.find(resource);
+	if (it == mResources.end())
+	{
+		return;
+	}
+
+	mCategories[it->second.category].memory -= it->second.size;
+	mCategories[it->second.category].numberOfResources--;
+	mMemory -= it->second.size;
+
+	mResources.erase(it);
+}
+
+/* Marks a resource as used this frame, which keeps it from being evicted for longest. */
+void CGpuMemoryTracker::Touch(const void* resource)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	auto it = mResources.find(resource);
+	if (it != mResources.end())
+	{
+		it->second.lastUsedFrame = mFrame;
+	}
+}
+
+void CGpuMemoryTracker::BeginFrame()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mFrame++;
+}
+
+bool CGpuMemoryTracker::IsRegistered(const void* resource)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mResources.find(resource) != mResources.end();
+}
+
+/////////////////////////////
+// Budgets
+/////////////////////////////
+
+/* @PARAM unsigned long long budget - The most memory the category should use in bytes, 0 for no limit. */
+void CGpuMemoryTracker::SetBudget(CategoryType category, unsigned long long budget)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mCategories[category].budget = budget;
+}
+
+/* Evicts from every category which is over its budget. Owners release resources from inside this call, so it must be made
+* where nothing else is using them, such as at the start of the frame.
+* @Returns unsigned int The number of resources evicted.
+*/
+unsigned int CGpuMemoryTracker::EnforceBudgets()
+{
+	unsigned int numberOfEvictions = 0;
+
+	for (unsigned int category = 0; category < kNumberOfCategories; category++)
+	{
+		numberOfEvictions += EnforceBudget(static_cast<CategoryType>(category));
+	}
+
+	return numberOfEvictions;
+}
+
+/* Evicts the streamable resources of a category which were used longest ago until it's within its budget, or there's nothing left which can go.
+* Budgets are enforced just after BeginFrame, before anything has been drawn, so resources used last frame are kept as well as those used this one.
+* @Returns unsigned int The number of resources evicted.
+*/
+unsigned int CGpuMemoryTracker::EnforceBudget(CategoryType category)
+{
+	struct CandidateType
+	{
+		const void* resource;
+		CStreamable* owner;
+		unsigned int lastUsedFrame;
+		unsigned long long order;
+	};
+
+	std::vector<CandidateType> candidates;
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		const CategoryStatsType& stats = mCategories[category];
+		if (stats.budget == 0 || stats.memory <= stats.budget)
+		{
+			return 0;
+		}
+
+		for (auto& trackedResource : mResources)
+		{
+			if (trackedResource.second.category == category && trackedResource.second.owner != nullptr && trackedResource.second.lastUsedFrame + 1 < mFrame)
+			{
+				CandidateType candidate;
+				candidate.resource = trackedResource.first;
+				candidate.owner = trackedResource.second.owner;
+				candidate.lastUsedFrame = trackedResource.second.lastUsedFrame;
+				candidate.order = trackedResource.second.order;
+				candidates.push_back(candidate);
+			}
+		}
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [](const CandidateType& a, const CandidateType& b)
+	{
+		return a.lastUsedFrame != b.lastUsedFrame ? a.lastUsedFrame < b.lastUsedFrame : a.order < b.order;
+	});
+
+	unsigned int numberOfEvictions = 0;
+
+	for (auto& candidate : candidates)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (mCategories[category].memory <= mCategories[category].budget)
+			{
+				break;
+			}
+		}
+
+		// Not locked, as the owner unregisters the resource while evicting it.
+		if (!candidate.owner->Evict(candidate.resource))
+		{
+			continue;
+		}
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (mResources.find(candidate.resource) != mResources.end())
+		{
+			logger->GetInstance().WriteLine("A resource was evicted from " + GetCategoryName(category) + " memory without being unregistered.");
+			continue;
+		}
+
+		mCategories[category].numberOfEvictions++;
+		numberOfEvictions++;
+	}
+
+	return numberOfEvictions;
+}
+
+/////////////////////////////
+// Stats
+/////////////////////////////
+
+CGpuMemoryTracker::CategoryStatsType CGpuMemoryTracker::GetStats(CategoryType category)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mCategories[category];
+}
+
+unsigned long long CGpuMemoryTracker::GetMemory()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mMemory;
+}
+
+unsigned long long CGpuMemoryTracker::GetPeakMemory()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mPeakMemory;
+}
+
+unsigned int CGpuMemoryTracker::GetNumberOfResources()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return static_cast<unsigned int>(mResources.size());
+}
+
+/* Writes the memory used by each category to the log. */
+void CGpuMemoryTracker::LogStats()
+{
+	logger->GetInstance().WriteLine("Video memory tracked: " + std::to_string(GetMemory() / 1024) + "KB, peak " + std::to_string(GetPeakMemory() / 1024) + "KB.");
+
+	for (unsigned int category = 0; category < kNumberOfCategories; category++)
+	{
+		CategoryStatsType stats = GetStats(static_cast<CategoryType>(category));
+
+		logger->GetInstance().WriteLine(GetCategoryName(static_cast<CategoryType>(category)) + ": " + std::to_string(stats.memory / 1024) + "KB in " +
+			std::to_string(stats.numberOfResources) + " resources, peak " + std::to_string(stats.peakMemory / 1024) + "KB, budget " +
+			(stats.budget == 0 ? std::string("none") : std::to_string(stats.budget / 1024) + "KB") + ", " + std::to_string(stats.numberOfEvictions) + " evictions.");
+	}
+}
+
+std::string CGpuMemoryTracker::GetCategoryName(CategoryType category)
+{
+	switch (category)
+	{
+	case Terrain:
+		return "Terrain";
+	case Meshes:
+		return "Meshes";
+	case Textures:
+		return "Textures";
+	case RenderTargets:
+		return "Render targets";
+	case Fonts:
+		return "Fonts";
+	case StaticBatches:
+		return "Static batches";
+	default:
+		return "Other";
+	}
+}
+
+/* The memory taken by a 2D texture and its mip levels. Formats which aren't listed are counted as 4 bytes a pixel.
+* @PARAM unsigned int mipLevels - 0 for a full mip chain, as Direct3D takes it.
+* @PARAM unsigned int format - A DXGI_FORMAT value.
+*/
+unsigned long long CGpuMemoryTracker::GetTextureMemory(unsigned int width, unsigned int height, unsigned int mipLevels, unsigned int arraySize, unsigned int format)
+{
+	// Block compressed formats store each 4x4 block of pixels in a fixed number of bytes.
+	unsigned int blockSize = 0;
+	unsigned int bytesPerPixel = 4;
+
+	switch (format)
+	{
+	case FormatBC1Unorm:
+	case FormatBC1UnormSrgb:
+	case FormatBC4Unorm:
+	case FormatBC4Snorm:
+		blockSize = 8;
+		break;
+	case FormatBC2Unorm:
+	case FormatBC2UnormSrgb:
+	case FormatBC3Unorm:
+	case FormatBC3UnormSrgb:
+	case FormatBC5Unorm:
+	case FormatBC5Snorm:
+	case FormatBC7Unorm:
+	case FormatBC7UnormSrgb:
+		blockSize = 16;
+		break;
+	case FormatR32G32B32A32Float:
+		bytesPerPixel = 16;
+		break;
+	case FormatR16G16B16A16Float:
+	case FormatR32G32Float:
+		bytesPerPixel = 8;
+		break;
+	case FormatR8G8Unorm:
+	case FormatR16Float:
+	case FormatB5G6R5Unorm:
+		bytesPerPixel = 2;
+		break;
+	case FormatR8Unorm:
+	case FormatA8Unorm:
+		bytesPerPixel = 1;
+		break;
+	default:
+		break;
+	}
+
+	unsigned long long size = 0;
+	unsigned int level = 0;
+
+	while (true)
+	{
+		if (blockSize > 0)
+		{
+			size += static_cast<unsigned long long>((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+		}
+		else
+		{
+			size += static_cast<unsigned long long>(width) * height * bytesPerPixel;
+		}
+
+		level++;
+
+		if ((mipLevels != 0 && level >= mipLevels) || (width == 1 && height == 1))
+		{
+			break;
+		}
+
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+
+	return size * (arraySize > 0 ? arraySize : 1);
+}
@@ -0,0 +1,130 @@
+#ifndef GPUMEMORYTRACKER_H
+#define GPUMEMORYTRACKER_H
+
+#include <string>
+#include <mutex>
+#include <unordered_map>
+#include "PrioEngineVars.h"
+
+/* Something which owns resources the memory tracker is allowed to evict, and which can create them again the next time they're needed. */
+class CStreamable
+{
+public:
+	virtual ~CStreamable() {};
+
+	// Releases a resource registered by this owner, which must unregister it as it normally would. Returns false if it can't be released right now.
+	virtual bool Evict(const void* resource) = 0;
+};
+
+/* Keeps count of the video memory used by every buffer and texture which has been registered with it, by category.
+* Each category can be given a budget. When a category goes over its budget, the streamable resources in it which have gone unused the longest are evicted
+* until it's back under, anything used this frame or the one before is left alone. Resources which aren't streamable are counted but never evicted.
+*
+* The tracker never touches Direct3D, resources are only addresses to it and their sizes are worked out by whoever registers them,
+* so it works the same with the null render device as on a GPU.
+*/
+class CGpuMemoryTracker
+{
+/* Singleton class methods. */
+public:
+	static CGpuMemoryTracker& GetInstance()
+	{
+		static CGpuMemoryTracker instance;
+
+		return instance;
+	}
+private:
+	CGpuMemoryTracker();
+	CGpuMemoryTracker(CGpuMemoryTracker const&) = delete;
+	void operator=(CGpuMemoryTracker const&) = delete;
+private:
+	CLogger* logger;
+public:
+	enum CategoryType
+	{
+		Terrain,
+		Meshes,
+		Textures,
+		RenderTargets,
+		Fonts,
+		// Merged scenery cells. Not streamable, as a cell can only be made again by merging its models, so they're kept out of the mesh budget.
+		StaticBatches,
+		Other,
+		kNumberOfCategories
+	};
+
+	struct CategoryStatsType
+	{
+		unsigned long long memory;
+		unsigned long long peakMemory;
+		// 0 for no budget.
+		unsigned long long budget;
+		unsigned int numberOfResources;
+		unsigned int numberOfEvictions;
+	};
+public:
+	void Register(const void* resource, CategoryType category, unsigned long long size, CStreamable* owner = nullptr);
+	void Unregister(const void* resource);
+	void Touch(const void* resource);
+
+	void BeginFrame();
+	void SetBudget(CategoryType category, unsigned long long budget);
+	unsigned int EnforceBudgets();
+
+	CategoryStatsType GetStats(CategoryType category);
+	unsigned long long GetMemory();
+	unsigned long long GetPeakMemory();
+	unsigned int GetNumberOfResources();
+	bool IsRegistered(const void* resource);
+	void LogStats();
+
+	static std::string GetCategoryName(CategoryType category);
+	static unsigned long long GetTextureMemory(unsigned int width, unsigned int height, unsigned int mipLevels, unsigned int arraySize, unsigned int format);
+private:
+	// The DXGI_FORMAT values GetTextureMemory knows the size of, copied here so the tracker doesn't need the Direct3D headers.
+	enum FormatType
+	{
+		FormatR32G32B32A32Float = 2,
+		FormatR16G16B16A16Float = 10,
+		FormatR32G32Float = 16,
+		FormatR8G8Unorm = 49,
+		FormatR16Float = 54,
+		FormatR8Unorm = 61,
+		FormatA8Unorm = 65,
+		FormatBC1Unorm = 71,
+		FormatBC1UnormSrgb = 72,
+		FormatBC2Unorm = 74,
+		FormatBC2UnormSrgb = 75,
+		FormatBC3Unorm = 77,
+		FormatBC3UnormSrgb = 78,
+		FormatBC4Unorm = 80,
+		FormatBC4Snorm = 81,
+		FormatBC5Unorm = 83,
+		FormatBC5Snorm = 84,
+		FormatB5G6R5Unorm = 85,
+		FormatBC7Unorm = 98,
+		FormatBC7UnormSrgb = 99
+	};
+
+	struct TrackedResourceType
+	{
+		CategoryType category;
+		unsigned long long size;
+		CStreamable* owner;
+		unsigned int lastUsedFrame;
+		// Breaks ties between resources last used in the same frame, so the oldest registration goes first.
+		unsigned long long order;
+	};
+
+	unsigned int EnforceBudget(CategoryType category);
+
+	std::mutex mMutex;
+	std::unordered_map<const void*, TrackedResourceType> mResources;
+	CategoryStatsType mCategories[kNumberOfCategories];
+	unsigned long long mMemory;
+	unsigned long long mPeakMemory;
+	unsigned long long mNextOrder;
+	unsigned int mFrame;
+};
+
+#endif
@@ -15,6 +15,28 @@ CGraphics::CGraphics()
 	mpText = nullptr;
 	mFullScreen = false;
 	mpFrustum = nullptr;
+	mpHorizonCuller = nullptr;
+	mpVisibilityCache = nullptr;
+	mpReflectionFrustum = nullptr;
+	mpReflectionVisibilityCache = nullptr;
+	for (auto& renderQueue : mpRenderQueues)
+	{
+		renderQueue = nullptr;
+	}
+	mParallelMeshPasses = true;
+	mpRenderDevice = nullptr;
+	mpFrameCapture = nullptr;
+	mpConstantRing = nullptr;
+	mpShaderCompiler = nullptr;
+	mpShaderCache = nullptr;
+	mpFrameGraph = nullptr;
+	mpRenderTargetPool = nullptr;
+	mpFrameGovernor = nullptr;
+	mpWaterRefractionTarget = nullptr;
+	mpWaterReflectionTarget = nullptr;
+	mReflectionClipHeight = 0.0f;
+	mpLastRefreshedWater = nullptr;
+	D3DXMatrixIdentity(&mLastWaterRefreshView);
 	mpSkyboxShader = nullptr;
 	mpTerrain = nullptr;
 	mpSkybox = nullptr;
@@ -63,6 +85,41 @@ bool CGraphics::Initialise(int screenWidth, int screenHeight, HWND hwnd)
 		return false;
 	}
 
+	// Meshes go through the frame capture, which does nothing but pass calls on until asked to capture.
+	mpFrameCapture = new CFrameCapture(mpD3D);
+	logger->GetInstance().MemoryAllocWriteLine(typeid(mpFrameCapture).name());
+	mpRenderDevice = mpFrameCapture;
+
+	// Without it, or without Direct3D 11.1, the render queue writes constants through the shader's own buffers.
+	mpConstantRing = new CConstantRing();
+	logger->GetInstance().MemoryAllocWriteLine(typeid(mpConstantRing).name());
+	if (!mpConstantRing->Initialise(mpRenderDevice, kConstantRingSize))
+	{
+		logger->GetInstance().WriteLine("Failed to initialise the constant ring, mesh constants will be mapped per draw.");
+	}
+
+	mpRenderTargetPool = new CRenderTargetPool();
+	logger->GetInstance().MemoryAllocWriteLine(typeid(mpRenderTargetPool).name());
+	mpRenderTargetPool->Initialise(mpD3D->GetDevice());
+
+	CGpuMemoryTracker::GetInstance().SetBudget(CGpuMemoryTracker::Meshes, kMeshMemoryBudget);
+	CGpuMemoryTracker::GetInstance().SetBudget(CGpuMemoryTracker::Textures, kTextureMemoryBudget);
+
+	// Compile anything used last run which isn't cached yet before the shaders ask for it, a failure here only means shaders are compiled without the cache.
+	mpShaderCompiler = new CD3DXShaderCompiler();
+	logger->GetInstance().MemoryAllocWriteLine(typeid(mpShaderCompiler).name());
+	mpShaderCache = new CShaderCache(mpShaderCompiler, "ShaderCache");
+	logger->GetInstance().MemoryAllocWriteLine(typeid(mpShaderCache).name());
+	if (mpShaderCache->Initialise())
+	{
+		mpShaderCache->WarmUp();
+		CShader::SetShaderCache(mpShaderCache);
+	}
+	else
+	{
+		logger->GetInstance().WriteLine("Failed to initialise the shader cache, shaders will be compiled every run.");
+	}
+
 	// Create a colour shader now, it's necessary for terrain.
 	CreateColourShader(hwnd);
 	CreateTextureShaderForModel(hwnd);
@@ -70,6 +127,17 @@ bool CGraphics::Initialise(int screenWidth, int screenHeight, HWND hwnd)
 	CreateTerrainShader(hwnd);
 
 	mpFrustum = new CFrustum();
+	mpHorizonCuller = new CHorizonCuller();
+	mpVisibilityCache = new CVisibilityCache();
+	mpReflectionFrustum = new CFrustum();
+	mpReflectionVisibilityCache = new CVisibilityCache();
+	for (auto& renderQueue : mpRenderQueues)
+	{
+		renderQueue = new CRenderQueue();
+	}
+	mpFrameGraph = new CFrameGraph();
+	mpFrameGovernor = new CFrameGovernor();
+	logger->GetInstance().MemoryAllocWriteLine(typeid(mpFrameGovernor).name());
 
 	mpCamera = CreateCamera();
 	mpCamera->Render();
@@ -176,7 +244,7 @@ bool CGraphics::Initialise(int screenWidth, int screenHeight, HWND hwnd)
 	}
 
 	mpRain = new CRain();
-	if (!mpRain->Initialise(mpD3D->GetDevice(), "Resources/Textures/raindrop.dds", 25000))
+	if (!mpRain->Initialise(mpD3D->GetDevice(), "Resources/Textures/raindrop.dds", kNumberOfRainParticles))
 	{
 		logger->GetInstance().WriteLine("Failed to initialise the rain particle emitter.");
 		return false;
@@ -198,6 +266,13 @@ bool CGraphics::Initialise(int screenWidth, int screenHeight, HWND hwnd)
 
 void CGraphics::Shutdown()
 {
+	for (auto& worker : mMeshPassWorkers)
+	{
+		worker.Stop();
+	}
+
+	CGpuMemoryTracker::GetInstance().LogStats();
+
 	if (mpRain)
 	{
 		mpRain->Shutdown();
@@ -262,6 +337,59 @@ void CGraphics::Shutdown()
 		delete mpFrustum;
 	}
 
+	if (mpHorizonCuller != nullptr)
+	{
+		// Report how much of the scenery the terrain managed to hide over the whole run.
+		logger->GetInstance().WriteLine("Horizon culling rejected " + std::to_string(mpHorizonCuller->GetTotalCulledShare() * 100.0f) + "% of the instances which passed the frustum test.");
+		delete mpHorizonCuller;
+		mpHorizonCuller = nullptr;
+	}
+
+	if (mpVisibilityCache != nullptr)
+	{
+		if (mpVisibilityCache->GetEnabled())
+			logger->GetInstance().WriteLine("Visibility cache answered " + std::to_string(mpVisibilityCache->GetTotalHitRate() * 100.0f) + "% of frustum tests without re-testing.");
+		delete mpVisibilityCache;
+		mpVisibilityCache = nullptr;
+	}
+
+	if (mpReflectionFrustum != nullptr)
+	{
+		delete mpReflectionFrustum;
+		mpReflectionFrustum = nullptr;
+	}
+
+	if (mpReflectionVisibilityCache != nullptr)
+	{
+		delete mpReflectionVisibilityCache;
+		mpReflectionVisibilityCache = nullptr;
+	}
+
+	for (auto& renderQueue : mpRenderQueues)
+	{
+		if (renderQueue != nullptr)
+		{
+			delete renderQueue;
+			renderQueue = nullptr;
+		}
+	}
+
+	if (mpFrameGraph != nullptr)
+	{
+		delete mpFrameGraph;
+		mpFrameGraph = nullptr;
+	}
+
+	if (mpFrameGovernor != nullptr)
+	{
+		logger->GetInstance().WriteLine("Frame governor lowered the quality " + std::to_string(mpFrameGovernor->GetNumberOfDowngrades()) + " times and raised it " +
+			std::to_string(mpFrameGovernor->GetNumberOfUpgrades()) + " times, " + std::to_string(mpFrameGovernor->GetFramesOverTarget()) + " frames went over the target time and " +
+			std::to_string(mpFrameGovernor->GetFramesAtLowestLevel()) + " were at the lowest quality.");
+		delete mpFrameGovernor;
+		mpFrameGovernor = nullptr;
+		logger->GetInstance().MemoryDeallocWriteLine(typeid(mpFrameGovernor).name());
+	}
+
 	mpUIImages.clear();
 
 	if (mpDiffuseLightShader)
@@ -317,6 +445,39 @@ void CGraphics::Shutdown()
 	// Deallocate any allocated memroy on the mesh list.
 	for (auto mesh : mpMeshes)
 	{
+		// Report how many indices meshlet culling saved on this mesh over the whole run, across every pass.
+		unsigned long long indicesCulled = 0;
+		unsigned long long totalIndices = 0;
+		for (unsigned int pass = 0; pass < CRenderQueue::kNumberOfPasses; pass++)
+		{
+			CMeshletCuller* meshletCuller = mesh->GetMeshletCuller(static_cast<CRenderQueue::PassType>(pass));
+			indicesCulled += meshletCuller->GetTotalIndicesCulled();
+			totalIndices += meshletCuller->GetTotalIndicesSubmitted() + meshletCuller->GetTotalIndicesCulled();
+		}
+		if (totalIndices > 0)
+		{
+			logger->GetInstance().WriteLine("Meshlet culling rejected " + std::to_string(indicesCulled) + " of " + std::to_string(totalIndices) + " indices on mesh '" + mesh->GetFilename() + "'.");
+		}
+
+		// Each pass counts its own instances, so the reflection doesn't count the same instances a second time.
+		CDistanceCuller* distanceCuller = mesh->GetDistanceCuller();
+		for (unsigned int pass = 0; pass < CRenderQueue::kNumberOfPasses; pass++)
+		{
+			const CRenderQueue::PassType passType = static_cast<CRenderQueue::PassType>(pass);
+			const std::string passName = passType == CRenderQueue::Main ? "main" : "reflection";
+
+			if (distanceCuller->GetTotalCulledByDistance(passType) + distanceCuller->GetTotalCulledByCoverage(passType) + distanceCuller->GetTotalThinned(passType) > 0)
+			{
+				logger->GetInstance().WriteLine("Mesh '" + mesh->GetFilename() + "' skipped " + std::to_string(distanceCuller->GetTotalCulledByDistance(passType)) + " instances by distance, " + std::to_string(distanceCuller->GetTotalCulledByCoverage(passType)) + " by screen size and thinned out " + std::to_string(distanceCuller->GetTotalThinned(passType)) + " in the " + passName + " pass.");
+			}
+		}
+
+		if (mesh->IsStaticBatched())
+		{
+			CStaticBatcher* batcher = mesh->GetStaticBatcher();
+			logger->GetInstance().WriteLine("Mesh '" + mesh->GetFilename() + "' was merged into " + std::to_string(batcher->GetNumberOfCells()) + " cells, with " + std::to_string(batcher->GetCellsRebuilt()) + " cell rebuilds.");
+		}
+
 		mesh->Shutdown();
 		delete mesh;
 	}
@@ -358,6 +519,49 @@ void CGraphics::Shutdown()
 		mpRefractionShader = nullptr;
 	}
 
+	if (mpConstantRing)
+	{
+		mpConstantRing->Shutdown(mpRenderDevice);
+		delete mpConstantRing;
+		mpConstantRing = nullptr;
+		logger->GetInstance().MemoryDeallocWriteLine(typeid(mpConstantRing).name());
+	}
+
+	if (mpRenderTargetPool)
+	{
+		ReleaseWaterTargets();
+		logger->GetInstance().WriteLine("Peak render target memory: " + std::to_string(mpRenderTargetPool->GetPeakMemory() / 1024) + "KB in " + std::to_string(mpRenderTargetPool->GetNumberOfTargetsCreated()) + " targets created.");
+		mpRenderTargetPool->Shutdown();
+		delete mpRenderTargetPool;
+		mpRenderTargetPool = nullptr;
+		logger->GetInstance().MemoryDeallocWriteLine(typeid(mpRenderTargetPool).name());
+	}
+
+	if (mpShaderCache)
+	{
+		CShader::SetShaderCache(nullptr);
+		mpShaderCache->SaveManifest();
+		logger->GetInstance().WriteLine("Shader cache: " + std::to_string(mpShaderCache->GetHits()) + " hits, " + std::to_string(mpShaderCache->GetMisses()) + " misses, " + std::to_string(mpShaderCache->GetNumberOfCompiles()) + " compiles.");
+		delete mpShaderCache;
+		mpShaderCache = nullptr;
+		logger->GetInstance().MemoryDeallocWriteLine(typeid(mpShaderCache).name());
+	}
+
+	if (mpShaderCompiler)
+	{
+		delete mpShaderCompiler;
+		mpShaderCompiler = nullptr;
+		logger->GetInstance().MemoryDeallocWriteLine(typeid(mpShaderCompiler).name());
+	}
+
+	if (mpFrameCapture)
+	{
+		delete mpFrameCapture;
+		mpFrameCapture = nullptr;
+		mpRenderDevice = nullptr;
+		logger->GetInstance().MemoryDeallocWriteLine(typeid(mpFrameCapture).name());
+	}
+
 	// If the Direct 3D object exists.
 	if (mpD3D)
 	{
@@ -365,6 +569,7 @@ void CGraphics::Shutdown()
 		mpD3D->Shutdown();
 		delete mpD3D;
 		mpD3D = nullptr;
+		mpRenderDevice = nullptr;
 		logger->GetInstance().MemoryDeallocWriteLine(typeid(mpD3D).name());
 		// Output message to log to let us know that this object is gone.
 		logger->GetInstance().WriteLine("Direct3D object has been shutdown, deallocated and pointer set to null.");
@@ -377,6 +582,12 @@ bool CGraphics::Frame(float updateTime)
 {
 	bool success;
 
+	// Turn the quality up or down if the frames have been taking too long, or have had time to spare.
+	if (mpFrameGovernor->Update(updateTime))
+	{
+		ApplyQualitySettings();
+	}
+
 	UpdateScene(updateTime);
 
 	// Render the graphics scene.
@@ -496,6 +707,14 @@ bool CGraphics::Render()
 	D3DXMATRIX orthoMatrix;
 	mpD3D->GetOrthogonalMatrix(orthoMatrix);
 
+	mpFrameCapture->BeginFrame();
+	mpConstantRing->Reset();
+	mpRenderTargetPool->BeginFrame();
+
+	// Nothing is gathering or drawing yet, so it's safe for meshes to release what the tracker evicts.
+	CGpuMemoryTracker::GetInstance().BeginFrame();
+	CGpuMemoryTracker::GetInstance().EnforceBudgets();
+
 	// Set the back buffer as the render target
 	mpD3D->SetBackBufferRenderTarget();
 	mpD3D->GetDeviceContext()->ClearDepthStencilView(mpD3D->GetDepthStencilView(), D3D11_CLEAR_DEPTH, 1.0f, 0);
@@ -511,21 +730,108 @@ bool CGraphics::Render()
 	mpCamera->GetViewProjMatrix(viewProj, projMatrix);
 
 	mpFrustum->ConstructFrustum(SCREEN_DEPTH, projMatrix, viewMatrix);
+	mpVisibilityCache->BeginFrame(viewMatrix, projMatrix);
+	for (auto renderQueue : mpRenderQueues)
+	{
+		renderQueue->ResetCounters();
+	}
 
-	if (!RenderSkybox(worldMatrix, viewMatrix, projMatrix, viewProj))
-		return false;
+	// Bring every world matrix and merged cell up to date before anything is culled against them.
+	for (auto mesh : mpMeshes)
+	{
+		mesh->UpdateTransforms();
+		mesh->GetDistanceCuller()->ResetCounters();
+		for (unsigned int pass = 0; pass < CRenderQueue::kNumberOfPasses; pass++)
+		{
+			mesh->GetMeshletCuller(static_cast<CRenderQueue::PassType>(pass))->ResetCounters();
+		}
+	}
+	CSceneGraph::GetInstance().Update();
+	for (auto mesh : mpMeshes)
+	{
+		mesh->UpdateStaticBatches();
+	}
 
-	if (!RenderModels(worldMatrix, viewMatrix, projMatrix, viewProj))
-		return false;
+	// Build the horizon around the camera, so that anything behind hills can be skipped.
+	if (mpTerrain && !mpTerrain->GetUpdateFlag())
+	{
+		mpHorizonCuller->Build(mpTerrain, mpCamera->GetPosition());
+	}
+	else
+	{
+		mpHorizonCuller->Clear();
+	}
 
-	if (!RenderBitmaps(mBaseView, mBaseView, orthoMatrix, viewProj))
-		return false;
+	// Start gathering the main pass now, so it runs alongside the sky and water passes. Meshlets facing away from the camera can be dropped, as the rasteriser would cull them anyway.
+	StartMeshPass(CRenderQueue::Main, mpFrustum, mpHorizonCuller, mpVisibilityCache, true);
+
+	/////////////////////////////
+	// Declare the passes.
+	/////////////////////////////
+
+	// Passes which draw to the back buffer depend on each other, so they run in the order they're added here.
+	mpFrameGraph->Clear();
+	CFrameGraph::ResourceId backBuffer = mpFrameGraph->ImportResource("Back buffer");
+
+	auto addBackBufferPass = [&](std::string name, std::function<bool()> execute)
+	{
+		CFrameGraph::PassId pass = mpFrameGraph->AddPass(name, execute);
+		mpFrameGraph->Write(pass, backBuffer);
+		return pass;
+	};
+
+	addBackBufferPass("Skybox", [=]() { return RenderSkybox(worldMatrix, viewMatrix, projMatrix, viewProj); });
+
+	bool refreshWaterTextures;
+	if (PrepareWater(viewMatrix, projMatrix, viewProj, refreshWaterTextures))
+	{
+		// The height is only needed while drawing the refraction, but the refraction and reflection are kept between frames, as they aren't redrawn every frame.
+		CFrameGraph::ResourceDescType heightDesc = { static_cast<unsigned int>(mScreenWidth), static_cast<unsigned int>(mScreenHeight), DXGI_FORMAT_R32_FLOAT };
+		CFrameGraph::ResourceId waterHeight = mpFrameGraph->CreateResource("Water height", heightDesc);
+		CFrameGraph::ResourceId refraction = mpFrameGraph->ImportResource("Water refraction");
+		CFrameGraph::ResourceId reflection = mpFrameGraph->ImportResource("Water reflection");
+
+		if (refreshWaterTextures)
+		{
+			CFrameGraph::PassId heightPass = mpFrameGraph->AddPass("Water height", [=]() { return RenderWaterHeight(mpRenderTargetPool->GetFrameGraphTarget(waterHeight)); });
+			mpFrameGraph->Write(heightPass, waterHeight);
+
+			// Refraction and reflection both need a light.
+			if (mpSceneLight)
+			{
+				CFrameGraph::PassId refractionPass = mpFrameGraph->AddPass("Water refraction", [=]() { return RenderWaterRefraction(mpRenderTargetPool->GetFrameGraphTarget(waterHeight), viewMatrix, projMatrix, viewProj); });
+				mpFrameGraph->Read(refractionPass, waterHeight);
+				mpFrameGraph->Write(refractionPass, refraction);
 
-	if (!RenderText(worldMatrix, mBaseView, orthoMatrix, viewProj))
+				CFrameGraph::PassId reflectionPass = mpFrameGraph->AddPass("Water reflection", [=]() { return RenderWaterReflection(projMatrix); });
+				mpFrameGraph->Write(reflectionPass, reflection);
+			}
+		}
+
+		CFrameGraph::PassId surfacePass = addBackBufferPass("Water surface", [=]() { return RenderWaterSurface(); });
+		mpFrameGraph->Read(surfacePass, refraction);
+		mpFrameGraph->Read(surfacePass, reflection);
+	}
+
+	addBackBufferPass("Primitives", [=]() { return RenderPrimitives(worldMatrix, viewMatrix, projMatrix, viewProj); });
+	addBackBufferPass("Meshes", [=]() { return RenderMeshes(worldMatrix, viewMatrix, projMatrix, viewProj); });
+	addBackBufferPass("Terrain", [=]() { return RenderTerrains(worldMatrix, viewMatrix, projMatrix, viewProj); });
+	addBackBufferPass("Rain", [=]() { return RenderRain(worldMatrix, viewMatrix, projMatrix, viewProj); });
+	addBackBufferPass("Bitmaps", [=]() { return RenderBitmaps(mBaseView, mBaseView, orthoMatrix, viewProj); });
+	addBackBufferPass("Text", [=]() { return RenderText(worldMatrix, mBaseView, orthoMatrix, viewProj); });
+
+	bool result = mpFrameGraph->Compile() && mpRenderTargetPool->AcquireFrameGraphTargets(mpFrameGraph) && mpFrameGraph->Execute();
+
+	// A pass which was never drawn may still be gathering, and the meshes can be changed as soon as we return.
+	WaitForMeshPasses();
+
+	if (!result)
 		return false;
 
 	TwDraw();
 
+	mpFrameCapture->EndFrame();
+
 	// Present the rendered scene to the screen.
 	mpD3D->EndScene();
 
@@ -594,10 +900,71 @@ bool CGraphics::RenderMeshes(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj,
 	mpDiffuseLightShader->SetProjMatrix(proj);
 	mpDiffuseLightShader->SetViewProjMatrix(viewProj);
 
-	// Render any models which belong to each mesh. Do this in batches to make it faster.
+	return RenderMeshQueue(CRenderQueue::Main);
+}
+
+/* Starts gathering a mesh pass on a worker thread, or right here if parallel passes are turned off.
+* The frustum, horizon and visibility cache must be ready for the pass, and must not change until RenderMeshQueue has been called for it.
+*/
+void CGraphics::StartMeshPass(CRenderQueue::PassType pass, CFrustum* frustum, CHorizonCuller* horizon, CVisibilityCache* visibilityCache, bool cullBackFaces)
+{
+	D3DXVECTOR3 cameraPosition = mpCamera->GetPosition();
+
+	mMeshPassWorkers[pass].Wait();
+
+	if (!mParallelMeshPasses)
+	{
+		GatherMeshPass(pass, frustum, horizon, visibilityCache, cameraPosition, cullBackFaces);
+		return;
+	}
+
+	mMeshPassWorkers[pass].Run([=]() { GatherMeshPass(pass, frustum, horizon, visibilityCache, cameraPosition, cullBackFaces); });
+}
+
+/* Gathers the visible instances of every mesh into the pass's render queue and sorts it. Doesn't touch the device, so it is safe to run on a worker thread. */
+void CGraphics::GatherMeshPass(CRenderQueue::PassType pass, CFrustum* frustum, CHorizonCuller* horizon, CVisibilityCache* visibilityCache, D3DXVECTOR3 cameraPosition, bool cullBackFaces)
+{
+	CRenderQueue* renderQueue = mpRenderQueues[pass];
+
+	renderQueue->Clear();
+	mMeshPassMeshes[pass].clear();
+
 	for (auto mesh : mpMeshes)
 	{
-		mesh->Render(mpD3D->GetDeviceContext(), mpFrustum, mpDiffuseLightShader, mpSceneLight);
+		if (mesh->Gather(pass, frustum, horizon, visibilityCache, cameraPosition, cullBackFaces))
+		{
+			mesh->Submit(renderQueue, pass);
+			mMeshPassMeshes[pass].push_back(mesh);
+		}
+	}
+
+	renderQueue->Sort();
+}
+
+/* Waits for every mesh pass still being gathered. */
+void CGraphics::WaitForMeshPasses()
+{
+	for (auto& worker : mMeshPassWorkers)
+	{
+		worker.Wait();
+	}
+}
+
+/* Waits for a pass started with StartMeshPass, uploads the instances it gathered, then draws them sorted by shader and material. */
+bool CGraphics::RenderMeshQueue(CRenderQueue::PassType pass)
+{
+	mMeshPassWorkers[pass].Wait();
+
+	// Only this thread may use the device.
+	for (auto mesh : mMeshPassMeshes[pass])
+	{
+		mesh->UploadInstances(mpRenderDevice, pass);
+	}
+
+	if (!mpRenderQueues[pass]->Execute(mpRenderDevice, mpDiffuseLightShader, mpSceneLight, mpConstantRing))
+	{
+		logger->GetInstance().WriteLine("Failed to render the meshes in the render queue.");
+		return false;
 	}
 
 	return true;
@@ -732,27 +1099,6 @@ bool CGraphics::RenderSkybox(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj,
 	return true;
 }
 
-/* Renders physical entities within the scene. */
-bool CGraphics::RenderModels(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj)
-{
-	if (!RenderWater(world, view, proj, viewProj))
-		return false;
-
-	if (!RenderPrimitives(world, view, proj, viewProj))
-		return false;
-
-	if (!RenderMeshes(world, view, proj, viewProj))
-		return false;
-
-	if (!RenderTerrains(world, view, proj, viewProj))
-		return false;
-
-	if (!RenderRain(world, view, proj, viewProj))
-		return false;
-
-	return true;
-}
-
 bool CGraphics::RenderText(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX ortho, D3DXMATRIX viewProj)
 {
 	mpD3D->DisableZBuffer();
@@ -876,6 +1222,9 @@ bool CGraphics::RemoveUIImage(C2DImage *& element)
 
 bool CGraphics::UpdateTerrainBuffers(CTerrain *& terrain, double ** heightmap, int width, int height)
 {
+	// The water is recreated along with the terrain, so its textures will need drawing again.
+	mpLastRefreshedWater = nullptr;
+
 	return terrain->UpdateBuffers(mpD3D->GetDevice(), mpD3D->GetDeviceContext(), heightmap, width, height);
 }
 
@@ -928,34 +1277,132 @@ CSkyBox * CGraphics::CreateSkybox()
 }
 
 
-bool CGraphics::RenderWater(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj)
+/* Decides whether the water is drawn this frame and whether its textures are redrawn, starts gathering the reflected meshes if they are,
+* and gives the water shader everything the height and surface passes share.
+* @Returns bool - Whether there's any water to draw.
+*/
+bool CGraphics::PrepareWater(D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj, bool& refreshWaterTextures)
 {
+	refreshWaterTextures = false;
+
 	if (mpTerrain == nullptr)
 	{
 		logger->GetInstance().WriteLine("Skipping water as there's nothing to render.");
-		return true;
+		ReleaseWaterTargets();
+		return false;
 	}
 	if (mpTerrain->GetWater() == nullptr)
 	{
 		logger->GetInstance().WriteLine("No body of water exists for this terrain yet, skipping render pass.");
-		return true;
+		ReleaseWaterTargets();
+		return false;
 	}
 	if (mpTerrain->GetUpdateFlag())
 	{
 		logger->GetInstance().WriteLine("Skipping render pass for water as the terrain is currently being updated.");
-		return true;
+		return false;
 	}
 
-	bool result = true;
+	// Skip the water entirely if none of it is on screen.
+	D3DXVECTOR3 waterMinPoint;
+	D3DXVECTOR3 waterMaxPoint;
+	mpTerrain->GetWater()->GetBoundingBox(waterMinPoint, waterMaxPoint);
 
-	// Reset the world matrix.
-	mpD3D->GetWorldMatrix(world);
+	if (!mpFrustum->CheckBox(waterMinPoint, waterMaxPoint))
+	{
+		mWaterPassesSkipped += kNumberOfWaterPasses;
+		return false;
+	}
+
+	// Rebuilding the terrain creates new water, but the same targets carry on being used for it.
+	if (mpWaterRefractionTarget == nullptr || mpWaterReflectionTarget == nullptr)
+	{
+		CRenderTargetPool::TargetDescType desc = { static_cast<unsigned int>(mScreenWidth), static_cast<unsigned int>(mScreenHeight), DXGI_FORMAT_R8G8B8A8_UNORM };
 
-	/////////////////////////////////
-	// Height
-	////////////////////////////////
+		ReleaseWaterTargets();
+		mpWaterRefractionTarget = mpRenderTargetPool->Acquire(desc);
+		mpWaterReflectionTarget = mpRenderTargetPool->Acquire(desc);
 
+		if (mpWaterRefractionTarget == nullptr || mpWaterReflectionTarget == nullptr)
+		{
+			logger->GetInstance().WriteLine("Failed to get the water refraction and reflection targets, skipping render pass for water.");
+			ReleaseWaterTargets();
+			return false;
+		}
+
+		// Whatever is in them was left by someone else.
+		mpLastRefreshedWater = nullptr;
+	}
+
+	// Decide whether the height, refraction and reflection textures need to be drawn again this frame.
+	refreshWaterTextures = true;
+
+	if (mpTerrain->GetWater() != mpLastRefreshedWater)
+	{
+		// A new body of water has never had anything drawn into its textures.
+		refreshWaterTextures = true;
+	}
+	else if (GetScreenCoverage(waterMinPoint, waterMaxPoint, viewProj) < mMinimumWaterCoverage)
+	{
+		// Too small to notice the difference, keep what we drew last time.
+		refreshWaterTextures = false;
+		mWaterPassesSkipped += kNumberOfWaterPasses;
+	}
+	else if (mAmortiseWaterPasses && view == mLastWaterRefreshView && mFramesSinceWaterRefresh < mWaterRefreshInterval)
+	{
+		// The camera hasn't moved since we last drew the textures, so only refresh them every few frames.
+		refreshWaterTextures = false;
+		mWaterPassesAmortised += kNumberOfWaterPasses;
+	}
+	else if (mFramesSinceWaterRefresh < mWaterMovingRefreshInterval)
+	{
+		// The frame governor is short of time, so the reflection lags a few frames behind the camera.
+		refreshWaterTextures = false;
+		mWaterPassesAmortised += kNumberOfWaterPasses;
+	}
+
+	// Start gathering the reflected meshes now, so it runs alongside the height and refraction passes.
+	if (refreshWaterTextures && mpSceneLight)
+	{
+		D3DXMATRIX reflectionView;
+		mpCamera->GetReflectionView(reflectionView);
+
+		// Cull the reflection against what the reflection view can actually see, and throw away anything which sits under the water.
+		mpReflectionFrustum->ConstructFrustum(SCREEN_DEPTH, proj, reflectionView);
+		mpReflectionFrustum->SetClipPlane(D3DXPLANE(0.0f, 1.0f, 0.0f, -mpTerrain->GetWater()->GetPosY()));
+
+		// The clip plane doesn't move with the view, so if the water has moved then the stored results are no good.
+		if (mpTerrain->GetWater()->GetPosY() != mReflectionClipHeight)
+		{
+			mpReflectionVisibilityCache->Invalidate();
+			mReflectionClipHeight = mpTerrain->GetWater()->GetPosY();
+		}
+		mpReflectionVisibilityCache->BeginFrame(reflectionView, proj);
+
+		// Back face culling is turned off while drawing the reflection, so meshlets can't be culled by their facing.
+		StartMeshPass(CRenderQueue::Reflection, mpReflectionFrustum, nullptr, mpReflectionVisibilityCache, false);
+	}
+
+	if (refreshWaterTextures)
+	{
+		mpLastRefreshedWater = mpTerrain->GetWater();
+		mLastWaterRefreshView = view;
+		mFramesSinceWaterRefresh = 0;
+	}
+	else
+	{
+		// Only ever compared with the intervals, so stop counting once past both rather than wrapping round during a long coverage skip.
+		const unsigned int longestInterval = mWaterRefreshInterval > mWaterMovingRefreshInterval ? mWaterRefreshInterval : mWaterMovingRefreshInterval;
+		if (mFramesSinceWaterRefresh < longestInterval)
+		{
+			mFramesSinceWaterRefresh++;
+		}
+	}
+
+	D3DXMATRIX world;
 	D3DXMATRIX camWorld;
+	mpD3D->GetWorldMatrix(world);
+
 	mpWaterShader->SetWorldMatrix(world);
 	mpWaterShader->SetViewMatrix(view);
 	mpWaterShader->SetProjMatrix(proj);
@@ -975,178 +1422,242 @@ bool CGraphics::RenderWater(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj,
 	mpWaterShader->SetLightProperties(mpSceneLight);
 	mpWaterShader->SetNormalMap(mpTerrain->GetWater()->GetNormalMap());
 
+	return true;
+}
+
+/* Gives the water's refraction and reflection targets back to the render target pool. */
+void CGraphics::ReleaseWaterTargets()
+{
+	if (mpWaterRefractionTarget != nullptr)
+	{
+		mpRenderTargetPool->Release(mpWaterRefractionTarget);
+		mpWaterRefractionTarget = nullptr;
+	}
+
+	if (mpWaterReflectionTarget != nullptr)
+	{
+		mpRenderTargetPool->Release(mpWaterReflectionTarget);
+		mpWaterReflectionTarget = nullptr;
+	}
+}
+
+/* Draws the height of the water's surface into the water height texture. */
+bool CGraphics::RenderWaterHeight(CRenderTexture* heightTarget)
+{
+	D3DXMATRIX world;
+
 	// Set render target to the height texture map.
-	mpTerrain->GetWater()->SetHeightMapRenderTarget(mpD3D->GetDeviceContext(), mpD3D->GetDepthStencilView());
-	
-	mpTerrain->GetWater()->GetHeightTexture()->ClearRenderTarget(mpD3D->GetDeviceContext(), mpD3D->GetDepthStencilView(), 0.0f, 0.0f, 0.0f, 0.0f);
+	heightTarget->SetRenderTarget(mpD3D->GetDeviceContext(), mpD3D->GetDepthStencilView());
+
+	heightTarget->ClearRenderTarget(mpD3D->GetDeviceContext(), mpD3D->GetDepthStencilView(), 0.0f, 0.0f, 0.0f, 0.0f);
 	//mpD3D->GetDeviceContext()->ClearDepthStencilView(mpD3D->GetDepthStencilView(), D3D11_CLEAR_DEPTH, 1.0f, 0);
 
 	// Render the water height map.
 	mpTerrain->GetWater()->Render(mpD3D->GetDeviceContext());
 	mpTerrain->GetWater()->GetWorldMatrix(world);
 	mpWaterShader->SetWorldMatrix(world);
-	result = mpWaterShader->RenderHeight(mpD3D->GetDeviceContext(), mpTerrain->GetWater()->GetNumberOfIndices());
 
-	if (!result)
+	return mpWaterShader->RenderHeight(mpD3D->GetDeviceContext(), mpTerrain->GetWater()->GetNumberOfIndices());
+}
+
+/* Draws the terrain under the water into the refraction texture, using the water height texture to find what's under the surface. */
+bool CGraphics::RenderWaterRefraction(CRenderTexture* heightTarget, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj)
+{
+	D3DXMATRIX world;
+
+	mpD3D->GetWorldMatrix(world);
+	// Reset the terrain world matrix
+	mpTerrain->GetWorldMatrix(world);
+
+	mpWaterRefractionTarget->SetRenderTarget(mpD3D->GetDeviceContext(), mpD3D->GetDepthStencilView());
+	//mpD3D->GetDeviceContext()->ClearDepthStencilView(mpD3D->GetDepthStencilView(), D3D11_CLEAR_DEPTH, 1.0f, 0);
+
+	// Place our refract / reflect properties into the refract reflect shader.
+	mpRefractionShader->SetWorldMatrix(world);
+	mpRefractionShader->SetViewMatrix(view);
+	mpRefractionShader->SetProjMatrix(proj);
+	mpRefractionShader->SetViewProjMatrix(viewProj);
+	mpRefractionShader->SetLightProperties(mpSceneLight);
+	mpRefractionShader->SetViewportProperties(mScreenWidth, mScreenHeight);
+	mpRefractionShader->SetTerrainAreaProperties(mpTerrain->GetSnowHeight(), mpTerrain->GetGrassHeight(), mpTerrain->GetDirtHeight(), mpTerrain->GetSandHeight());
+	mpRefractionShader->SetPositioningProperties(mpTerrain->GetPosY(), mpTerrain->GetWater()->GetPosY());
+	mpRefractionShader->SetWaterHeightmap(heightTarget->GetShaderResourceView());
+	mpRefractionShader->SetDirtTextureArray(mpTerrain->GetTexturesArray());
+	mpRefractionShader->SetGrassTextureArray(mpTerrain->GetGrassTextureArray());
+	mpRefractionShader->SetPatchMap(mpTerrain->GetPatchMap());
+	mpRefractionShader->SetRockTexture(mpTerrain->GetRockTextureArray());
+
+	mpTerrain->Render(mpD3D->GetDeviceContext());
+	mpWaterRefractionTarget->ClearRenderTarget(mpD3D->GetDeviceContext(), mpD3D->GetDepthStencilView(), mpSceneLight->GetDiffuseColour().x, mpSceneLight->GetDiffuseColour().y, mpSceneLight->GetDiffuseColour().z, 1.0f);
+
+	if (!mpRefractionShader->RefractionRender(mpD3D->GetDeviceContext(), mpTerrain->GetIndexCount()))
 	{
+		logger->GetInstance().WriteLine("Failed to render the refraction shader for water. ");
 		return false;
 	}
 
-	// Two requirements for refraction and refleciton are a light and terrain.
-	if (mpTerrain && mpSceneLight)
-	{
-		//////////////////////////////
-		// Refraction
-		//////////////////////////////
+	return true;
+}
 
-		mpD3D->GetWorldMatrix(world);
-		// Reset the terrain world matrix
-		mpTerrain->GetWorldMatrix(world);
+/* Draws the clouds, terrain and meshes as seen from under the water into the reflection texture. */
+bool CGraphics::RenderWaterReflection(D3DXMATRIX proj)
+{
+	D3DXMATRIX world;
+	D3DXMATRIX view;
 
-		
-		mpTerrain->GetWater()->SetRefractionRenderTarget(mpD3D->GetDeviceContext(), mpD3D->GetDepthStencilView());
-		//mpD3D->GetDeviceContext()->ClearDepthStencilView(mpD3D->GetDepthStencilView(), D3D11_CLEAR_DEPTH, 1.0f, 0);
-
-		// Place our refract / reflect properties into the refract reflect shader.
-		mpRefractionShader->SetWorldMatrix(world);
-		mpRefractionShader->SetViewMatrix(view);
-		mpRefractionShader->SetProjMatrix(proj);
-		mpRefractionShader->SetViewProjMatrix(viewProj);
-		mpRefractionShader->SetLightProperties(mpSceneLight);
-		mpRefractionShader->SetViewportProperties(mScreenWidth, mScreenHeight);
-		mpRefractionShader->SetTerrainAreaProperties(mpTerrain->GetSnowHeight(), mpTerrain->GetGrassHeight(), mpTerrain->GetDirtHeight(), mpTerrain->GetSandHeight());
-		mpRefractionShader->SetPositioningProperties(mpTerrain->GetPosY(), mpTerrain->GetWater()->GetPosY());
-		mpRefractionShader->SetWaterHeightmap(mpTerrain->GetWater()->GetHeightTexture()->GetShaderResourceView());
-		mpRefractionShader->SetDirtTextureArray(mpTerrain->GetTexturesArray());
-		mpRefractionShader->SetGrassTextureArray(mpTerrain->GetGrassTextureArray());
-		mpRefractionShader->SetPatchMap(mpTerrain->GetPatchMap());
-		mpRefractionShader->SetRockTexture(mpTerrain->GetRockTextureArray());
-
-		mpTerrain->Render(mpD3D->GetDeviceContext()); 
-		mpTerrain->GetWater()->GetRefractionTexture()->ClearRenderTarget(mpD3D->GetDeviceContext(), mpD3D->GetDepthStencilView(), mpSceneLight->GetDiffuseColour().x, mpSceneLight->GetDiffuseColour().y, mpSceneLight->GetDiffuseColour().z, 1.0f);
-		result = mpRefractionShader->RefractionRender(mpD3D->GetDeviceContext(), mpTerrain->GetIndexCount());
+	mpD3D->GetWorldMatrix(world);
+	mpTerrain->GetWorldMatrix(world);
 
-		if (!result)
-		{
-			logger->GetInstance().WriteLine("Failed to render the refraction shader for water. ");
-			return false;
-		}
+	//mpCamera->GetReflectionViewMatrix(view);
+	// Render vertices using reflection shader.
+	mpWaterReflectionTarget->ClearRenderTarget(mpD3D->GetDeviceContext(), mpD3D->GetDepthStencilView(), mpSceneLight->GetDiffuseColour().x, mpSceneLight->GetDiffuseColour().y, mpSceneLight->GetDiffuseColour().z, 1.0f);
 
-		/////////////////////////////////
-		// Reflection
-		/////////////////////////////////
-
-			//mpCamera->GetReflectionViewMatrix(view);
-			// Render vertices using reflection shader.
-			mpTerrain->GetWater()->GetReflectionTexture()->ClearRenderTarget(mpD3D->GetDeviceContext(), mpD3D->GetDepthStencilView(), mpSceneLight->GetDiffuseColour().x, mpSceneLight->GetDiffuseColour().y, mpSceneLight->GetDiffuseColour().z, 1.0f);
-
-			mpTerrain->GetWater()->SetReflectionRenderTarget(mpD3D->GetDeviceContext(), mpD3D->GetDepthStencilView());
-			mpD3D->GetDeviceContext()->ClearDepthStencilView(mpD3D->GetDepthStencilView(), D3D11_CLEAR_DEPTH, 1.0f, 0);
-
-			mpCamera->GetReflectionView(view);
-			mpRefractionShader->SetWorldMatrix(world);
-			mpRefractionShader->SetViewMatrix(view);
-			mpRefractionShader->SetProjMatrix(proj);
-			mpRefractionShader->SetViewProjMatrix(view * proj);
-
-			mpD3D->TurnOffBackFaceCulling();
-
-			/////////////////////////////
-			// SKYBOX
-			////////////////////////////
-			mpD3D->DisableZBuffer();
-			mpD3D->GetWorldMatrix(world);
-			// Translate the sky dome to be centered around the camera position.
-			D3DXMatrixTranslation(&world, mpCamera->GetPosition().x, mpCamera->GetPosition().y, mpCamera->GetPosition().z);
-			// Allow the clouds to additively blend with the skybox.
-			mpD3D->EnableAdditiveAlphaBlending();
-
-			// Place the cloud plane vertex / index data onto the rendering pipeline.
-			mpCloudPlane->Render(mpD3D->GetDeviceContext());
-
-			// Set shader variables before rendering clouds with the shader.
-			mpCloudShader->SetBrightness(mpCloudPlane->GetBrightness());
-			mpCloudShader->SetCloud1Movement(mpCloudPlane->GetMovement(0).x, mpCloudPlane->GetMovement(0).y);
-			mpCloudShader->SetCloud2Movement(mpCloudPlane->GetMovement(1).x, mpCloudPlane->GetMovement(1).y);
-			mpCloudShader->SetWorldMatrix(world);
-			mpCloudShader->SetViewMatrix(view);
-			mpCloudShader->SetProjMatrix(proj);
-			mpCloudShader->SetViewProjMatrix(view * proj);
-			mpCloudShader->SetCloudTexture1(mpCloudPlane->GetCloudTexture1());
-			mpCloudShader->SetCloudTexture2(mpCloudPlane->GetCloudTexture2());
-
-			// Render the clouds using vertex and pixel shaders.
-			mpCloudShader->Render(mpD3D->GetDeviceContext(), mpCloudPlane->GetIndexCount());
-
-			// Turn off alpha blending.
-			mpD3D->DisableAlphaBlending();
-			mpD3D->EnableZBuffer();
-
-			////////////////////////////
-			// Terrain
-			////////////////////////////
-
-			RenderTerrains(world, view, proj, view * proj);
-			//// Reset the terrain world matrix
-			//mpTerrain->GetWorldMatrix(world);
-
-			///* Render the reflection of the terrain. */
-
-			//// Place vertices onto render pipeline.
-			//mpTerrain->Render(mpD3D->GetDeviceContext());
-
-			//result = mpRefractionShader->ReflectionRender(mpD3D->GetDeviceContext(), mpTerrain->GetIndexCount());
-			//if (!result)
-			//{
-			//	logger->GetInstance().WriteLine("Failed to render the reflection shader for water. ");
-			//	return false;
-			//}
+	mpWaterReflectionTarget->SetRenderTarget(mpD3D->GetDeviceContext(), mpD3D->GetDepthStencilView());
+	mpD3D->GetDeviceContext()->ClearDepthStencilView(mpD3D->GetDepthStencilView(), D3D11_CLEAR_DEPTH, 1.0f, 0);
 
-			/* Render the reflection of models within the scene. */
+	mpCamera->GetReflectionView(view);
 
-			// Render any models which belong to each mesh. Do this in batches to make it faster.
-			mpDiffuseLightShader->SetViewMatrix(view);
-			mpDiffuseLightShader->SetProjMatrix(proj);
-			mpDiffuseLightShader->SetViewMatrix(view * proj);
-			if (mpTerrain->GetUpdateFlag())
-			{
-				// Skip render pass.
-				logger->GetInstance().WriteLine("Updating terrain, skip the render pass.");
-			}
-			else
-			{
-				for (auto mesh : mpMeshes)
-				{
-					mesh->Render(mpD3D->GetDeviceContext(), mpFrustum, mpDiffuseLightShader, mpSceneLight);
-				}
-			}
-			mpD3D->TurnOnBackFaceCulling();
+	mpRefractionShader->SetWorldMatrix(world);
+	mpRefractionShader->SetViewMatrix(view);
+	mpRefractionShader->SetProjMatrix(proj);
+	mpRefractionShader->SetViewProjMatrix(view * proj);
 
-		
+	mpD3D->TurnOffBackFaceCulling();
+
+	/////////////////////////////
+	// SKYBOX
+	////////////////////////////
+	mpD3D->DisableZBuffer();
+	mpD3D->GetWorldMatrix(world);
+	// Translate the sky dome to be centered around the camera position.
+	D3DXMatrixTranslation(&world, mpCamera->GetPosition().x, mpCamera->GetPosition().y, mpCamera->GetPosition().z);
+	// Allow the clouds to additively blend with the skybox.
+	mpD3D->EnableAdditiveAlphaBlending();
+
+	// Place the cloud plane vertex / index data onto the rendering pipeline.
+	mpCloudPlane->Render(mpD3D->GetDeviceContext());
+
+	// Set shader variables before rendering clouds with the shader.
+	mpCloudShader->SetBrightness(mpCloudPlane->GetBrightness());
+	mpCloudShader->SetCloud1Movement(mpCloudPlane->GetMovement(0).x, mpCloudPlane->GetMovement(0).y);
+	mpCloudShader->SetCloud2Movement(mpCloudPlane->GetMovement(1).x, mpCloudPlane->GetMovement(1).y);
+	mpCloudShader->SetWorldMatrix(world);
+	mpCloudShader->SetViewMatrix(view);
+	mpCloudShader->SetProjMatrix(proj);
+	mpCloudShader->SetViewProjMatrix(view * proj);
+	mpCloudShader->SetCloudTexture1(mpCloudPlane->GetCloudTexture1());
+	mpCloudShader->SetCloudTexture2(mpCloudPlane->GetCloudTexture2());
+
+	// Render the clouds using vertex and pixel shaders.
+	mpCloudShader->Render(mpD3D->GetDeviceContext(), mpCloudPlane->GetIndexCount());
+
+	// Turn off alpha blending.
+	mpD3D->DisableAlphaBlending();
+	mpD3D->EnableZBuffer();
+
+	////////////////////////////
+	// Terrain
+	////////////////////////////
+
+	RenderTerrains(world, view, proj, view * proj);
+	//// Reset the terrain world matrix
+	//mpTerrain->GetWorldMatrix(world);
+
+	///* Render the reflection of the terrain. */
+
+	//// Place vertices onto render pipeline.
+	//mpTerrain->Render(mpD3D->GetDeviceContext());
+
+	//result = mpRefractionShader->ReflectionRender(mpD3D->GetDeviceContext(), mpTerrain->GetIndexCount());
+	//if (!result)
+	//{
+	//	logger->GetInstance().WriteLine("Failed to render the reflection shader for water. ");
+	//	return false;
+	//}
+
+	/* Render the reflection of models within the scene. */
+
+	// Render any models which belong to each mesh. Do this in batches to make it faster.
+	mpDiffuseLightShader->SetViewMatrix(view);
+	mpDiffuseLightShader->SetProjMatrix(proj);
+	mpDiffuseLightShader->SetViewProjMatrix(view * proj);
+	if (mpTerrain->GetUpdateFlag())
+	{
+		// Skip render pass.
+		logger->GetInstance().WriteLine("Updating terrain, skip the render pass.");
 	}
+	else
+	{
+		RenderMeshQueue(CRenderQueue::Reflection);
+	}
+	mpD3D->TurnOnBackFaceCulling();
+
+	return true;
+}
 
-	/////////////////////////////////
-	// Water Model
-	/////////////////////////////////
+/* Draws the water's surface to the back buffer, distorting whatever is in the refraction and reflection textures. */
+bool CGraphics::RenderWaterSurface()
+{
+	D3DXMATRIX world;
 
 	mpD3D->SetBackBufferRenderTarget();
 	mpD3D->GetDeviceContext()->ClearDepthStencilView(mpD3D->GetDepthStencilView(), D3D11_CLEAR_DEPTH, 1.0f, 0);
 
 	mpTerrain->GetWater()->Render(mpD3D->GetDeviceContext());
+	mpTerrain->GetWater()->GetWorldMatrix(world);
+	mpWaterShader->SetWorldMatrix(world);
 
 	//mpWaterShader->SetNormalMap(mpWater->GetNormalMap());
-	mpWaterShader->SetRefractionMap(mpTerrain->GetWater()->GetRefractionTexture()->GetShaderResourceView());
-	mpWaterShader->SetReflectionMap(mpTerrain->GetWater()->GetReflectionTexture()->GetShaderResourceView());
+	mpWaterShader->SetRefractionMap(mpWaterRefractionTarget->GetShaderResourceView());
+	mpWaterShader->SetReflectionMap(mpWaterReflectionTarget->GetShaderResourceView());
 
-	result = mpWaterShader->RenderSurface(mpD3D->GetDeviceContext(), mpTerrain->GetWater()->GetNumberOfIndices());
+	return mpWaterShader->RenderSurface(mpD3D->GetDeviceContext(), mpTerrain->GetWater()->GetNumberOfIndices());
+}
 
+/* Estimates how much of the screen a box covers, by finding the screen space rectangle around its corners.
+* @Returns float - The fraction of the screen covered, from 0 to 1.
+*/
+float CGraphics::GetScreenCoverage(D3DXVECTOR3 minPoint, D3DXVECTOR3 maxPoint, D3DXMATRIX viewProj)
+{
+	float left = 1.0f;
+	float right = -1.0f;
+	float bottom = 1.0f;
+	float top = -1.0f;
 
-	if (!result)
+	for (int corner = 0; corner < 8; corner++)
 	{
-		return false;
+		D3DXVECTOR3 point = D3DXVECTOR3(corner & 1 ? maxPoint.x : minPoint.x, corner & 2 ? maxPoint.y : minPoint.y, corner & 4 ? maxPoint.z : minPoint.z);
+		D3DXVECTOR4 projected;
+		D3DXVec3Transform(&projected, &point, &viewProj);
+
+		// A corner behind the camera could stretch across the whole screen, so assume that it does.
+		if (projected.w <= SCREEN_NEAR)
+		{
+			return 1.0f;
+		}
+
+		float x = projected.x / projected.w;
+		float y = projected.y / projected.w;
+
+		left = x < left ? x : left;
+		right = x > right ? x : right;
+		bottom = y < bottom ? y : bottom;
+		top = y > top ? y : top;
 	}
 
-	return true;
+	// Clamp the rectangle to the screen.
+	left = left < -1.0f ? -1.0f : left;
+	right = right > 1.0f ? 1.0f : right;
+	bottom = bottom < -1.0f ? -1.0f : bottom;
+	top = top > 1.0f ? 1.0f : top;
+
+	if (right <= left || top <= bottom)
+	{
+		return 0.0f;
+	}
+
+	// The screen is 2 units wide and tall in normalised device coordinates.
+	return (right - left) * (top - bottom) / 4.0f;
 }
 
 bool CGraphics::RenderRain(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj)
@@ -1406,6 +1917,13 @@ bool CGraphics::CreateTextureAndDiffuseLightShaderFromModel(HWND hwnd)
 			return false;
 		}
 
+		// Meshes are drawn through the render device, so the shader's constants are written through it too.
+		if (!mpDiffuseLightShader->InitialiseConstantBuffers(mpRenderDevice))
+		{
+			logger->GetInstance().WriteLine("Failed to create the diffuse light shader's constant buffers on the render device.");
+			return false;
+		}
+
 	}
 	return true;
 }
@@ -1520,10 +2038,43 @@ bool CGraphics::RemovePrimitive(CPrimitive* &model)
 	return false;
 }
 
+/* Draws the meshes through another device, such as a CNullRenderDevice to run the mesh pass without a GPU. Null goes back to Direct3D.
+* The meshes keep the buffers of the device they were loaded on, so this must be done before any are loaded.
+* @Returns bool - False if meshes have already been loaded.
+*/
+bool CGraphics::SetRenderDevice(CRenderDevice* device)
+{
+	if (!mpMeshes.empty())
+	{
+		logger->GetInstance().WriteLine("Can't change the render device once meshes have been loaded.");
+		return false;
+	}
+
+	// Keep the capture in front of whichever device is used, and move the constant ring and the mesh shader's constant buffers over to it.
+	mpConstantRing->Shutdown(mpRenderDevice);
+	if (mpDiffuseLightShader)
+	{
+		mpDiffuseLightShader->ShutdownConstantBuffers();
+	}
+
+	delete mpFrameCapture;
+	mpFrameCapture = new CFrameCapture(device != nullptr ? device : mpD3D);
+	mpRenderDevice = mpFrameCapture;
+
+	mpConstantRing->Initialise(mpRenderDevice, kConstantRingSize);
+	if (mpDiffuseLightShader && !mpDiffuseLightShader->InitialiseConstantBuffers(mpRenderDevice))
+	{
+		logger->GetInstance().WriteLine("Failed to move the diffuse light shader's constant buffers to the new render device.");
+		return false;
+	}
+
+	return true;
+}
+
 CMesh* CGraphics::LoadMesh(std::string filename, float radius)
 {
 	// Allocate the mesh memory.
-	CMesh* mesh = new CMesh(mpD3D->GetDevice());
+	CMesh* mesh = new CMesh(mpRenderDevice);
 
 	logger->GetInstance().MemoryAllocWriteLine(typeid(mesh).name());
 
@@ -1539,6 +2090,7 @@ CMesh* CGraphics::LoadMesh(std::string filename, float radius)
 
 	// Push the pointer onto a member variable list so that we don't lose it.
 	mpMeshes.push_back(mesh);
+	ApplyQualitySettings(mesh);
 
 	return mesh;
 }
@@ -1592,9 +2144,10 @@ CTerrain * CGraphics::CreateTerrain(std::string mapFile)
 		mpTerrain = nullptr;
 	}
 
-	CTerrain* terrain = new CTerrain(mpD3D->GetDevice(), mScreenWidth, mScreenHeight);
+	CTerrain* terrain = new CTerrain(mpD3D->GetDevice());
 	logger->GetInstance().WriteLine("Created terrain from the graphics object.");
 	mpTerrain = terrain;
+	mpLastRefreshedWater = nullptr;
 
 	// Check a map file was actually passed in.
 	if (mapFile != "")
@@ -1625,9 +2178,10 @@ CTerrain * CGraphics::CreateTerrain(double ** heightMap, int mapWidth, int mapHe
 		mpTerrain = nullptr;
 	}
 
-	CTerrain* terrain = new CTerrain(mpD3D->GetDevice(), mScreenWidth, mScreenHeight);
+	CTerrain* terrain = new CTerrain(mpD3D->GetDevice());
 	logger->GetInstance().WriteLine("Created terrain from the graphics object.");
 	mpTerrain = terrain;
+	mpLastRefreshedWater = nullptr;
 
 	// Loading height map
 	terrain->SetWidth(mapWidth);
@@ -1757,3 +2311,46 @@ void CGraphics::ToggleWireframe()
 		mpD3D->EnableWireframeFill();
 	}
 }
+
+/////////////////////////////
+// Frame time governor
+/////////////////////////////
+
+/* Turning the governor off puts everything back to full quality. */
+void CGraphics::SetFrameGovernorEnabled(bool enabled)
+{
+	mpFrameGovernor->SetEnabled(enabled);
+	ApplyQualitySettings();
+}
+
+/* Gives the meshes, the water and the rain the settings of the governor's current quality level. */
+void CGraphics::ApplyQualitySettings()
+{
+	const CFrameGovernor::QualitySettingsType& settings = mpFrameGovernor->GetSettings();
+
+	for (auto mesh : mpMeshes)
+	{
+		ApplyQualitySettings(mesh);
+	}
+
+	mWaterMovingRefreshInterval = settings.waterRefreshInterval;
+
+	if (mpRain)
+	{
+		unsigned int numberOfParticles = static_cast<unsigned int>(kNumberOfRainParticles * settings.rainParticleFraction);
+		numberOfParticles = numberOfParticles > 0 ? numberOfParticles : 1;
+
+		if (!mpRain->ResizeParticles(mpD3D->GetDevice(), numberOfParticles))
+		{
+			logger->GetInstance().WriteLine("Failed to change the number of rain particles for the frame governor.");
+		}
+	}
+}
+
+void CGraphics::ApplyQualitySettings(CMesh* mesh)
+{
+	const CFrameGovernor::QualitySettingsType& settings = mpFrameGovernor->GetSettings();
+
+	mesh->SetDetailBias(settings.meshDetailBias);
+	mesh->GetDistanceCuller()->SetDistanceScale(settings.drawDistanceScale);
+}
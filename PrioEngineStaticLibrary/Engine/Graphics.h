@@ -18,7 +18,19 @@
 #include "2DImage.h"
 #include <AntTweakBar.h>
 #include "Frustum.h"
-#include <thread>
+#include "HorizonCuller.h"
+#include "VisibilityCache.h"
+#include "RenderQueue.h"
+#include "FrameGraph.h"
+#include "RenderTargetPool.h"
+#include "GpuMemoryTracker.h"
+#include "FrameGovernor.h"
+#include "FrameCapture.h"
+#include "ConstantRing.h"
+#include "ShaderCache.h"
+#include "D3DXShaderCompiler.h"
+#include "SceneGraph.h"
+#include "WorkerThread.h"
 #include <functional>
 #include "SkyBox.h"
 #include "SkyboxShader.h"
@@ -49,6 +61,18 @@ private:
 	float mFieldOfView;
 	bool mWireframeEnabled;
 	CFrustum* mpFrustum;
+	CHorizonCuller* mpHorizonCuller;
+	CVisibilityCache* mpVisibilityCache;
+	CFrustum* mpReflectionFrustum;
+	CVisibilityCache* mpReflectionVisibilityCache;
+	float mReflectionClipHeight;
+	// One queue per pass, so each pass can be gathered, submitted and sorted on its own thread.
+	CRenderQueue* mpRenderQueues[CRenderQueue::kNumberOfPasses];
+	// Each pass is gathered on its own worker, which lives as long as the engine and sleeps between frames.
+	CWorkerThread mMeshPassWorkers[CRenderQueue::kNumberOfPasses];
+	// The meshes with something to draw in each pass, filled in by the pass's gather.
+	std::vector<CMesh*> mMeshPassMeshes[CRenderQueue::kNumberOfPasses];
+	bool mParallelMeshPasses;
 	bool mFullScreen = false;
 public:
 	CGraphics();
@@ -60,15 +84,40 @@ public:
 private:
 	bool Render();
 private:
-	bool RenderModels(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj);
 	bool RenderPrimitives(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj);
 	bool RenderMeshes(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj);
+	void StartMeshPass(CRenderQueue::PassType pass, CFrustum* frustum, CHorizonCuller* horizon, CVisibilityCache* visibilityCache, bool cullBackFaces);
+	void GatherMeshPass(CRenderQueue::PassType pass, CFrustum* frustum, CHorizonCuller* horizon, CVisibilityCache* visibilityCache, D3DXVECTOR3 cameraPosition, bool cullBackFaces);
+	void WaitForMeshPasses();
+	bool RenderMeshQueue(CRenderQueue::PassType pass);
 	bool RenderTerrains(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj);
 	bool RenderSkybox(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj);
-	bool RenderWater(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj);
+	bool PrepareWater(D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj, bool& refreshWaterTextures);
+	void ReleaseWaterTargets();
+	bool RenderWaterHeight(CRenderTexture* heightTarget);
+	bool RenderWaterRefraction(CRenderTexture* heightTarget, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj);
+	bool RenderWaterReflection(D3DXMATRIX proj);
+	bool RenderWaterSurface();
 	bool RenderRain(D3DXMATRIX world, D3DXMATRIX view, D3DXMATRIX proj, D3DXMATRIX viewProj);
+	float GetScreenCoverage(D3DXVECTOR3 minPoint, D3DXVECTOR3 maxPoint, D3DXMATRIX viewProj);
 private:
 	CD3D11* mpD3D;
+	// What the meshes are created and drawn through, the frame capture in front of mpD3D unless another device has been set.
+	CRenderDevice* mpRenderDevice;
+	CFrameCapture* mpFrameCapture;
+	// The constants of the queued mesh draws are written into this each frame, and bound by offset.
+	CConstantRing* mpConstantRing;
+	const unsigned int kConstantRingSize = 64 * 1024;
+	// Every shader is compiled through the cache, which keeps the bytecode between runs.
+	CShaderCompiler* mpShaderCompiler;
+	CShaderCache* mpShaderCache;
+	// Rebuilt every frame from the passes Render needs, then run in dependency order.
+	CFrameGraph* mpFrameGraph;
+	// Every render target which isn't the back buffer comes from here.
+	CRenderTargetPool* mpRenderTargetPool;
+	// The starting budgets of the streamable categories of the memory tracker, the mesh buffers and textures which haven't been drawn for longest are evicted past these.
+	const unsigned long long kMeshMemoryBudget = 128ull * 1024 * 1024;
+	const unsigned long long kTextureMemoryBudget = 256ull * 1024 * 1024;
 	CCamera* mpCamera;
 	//CCamera* mpReflectionCamera;
 	CPrimitive* mpTriangle;
@@ -125,6 +174,17 @@ public:
 	void SetCameraPos(float x, float y, float z);
 	void ToggleWireframe();
 	CCamera* GetMainCamera() {return mpCamera;};
+	CHorizonCuller* GetHorizonCuller() { return mpHorizonCuller; };
+	CVisibilityCache* GetVisibilityCache() { return mpVisibilityCache; };
+	CVisibilityCache* GetReflectionVisibilityCache() { return mpReflectionVisibilityCache; };
+	CRenderQueue* GetRenderQueue(CRenderQueue::PassType pass = CRenderQueue::Main) { return mpRenderQueues[pass]; };
+	// Whether the mesh passes are gathered on worker threads while the rest of the frame is drawn, on by default.
+	void SetParallelMeshPasses(bool enabled) { mParallelMeshPasses = enabled; };
+	bool GetParallelMeshPasses() { return mParallelMeshPasses; };
+	bool SetRenderDevice(CRenderDevice* device);
+	CRenderDevice* GetRenderDevice() { return mpRenderDevice; };
+	CFrameCapture* GetFrameCapture() { return mpFrameCapture; };
+	CConstantRing* GetConstantRing() { return mpConstantRing; };
 	SentenceType* CreateSentence(std::string text, int posX, int posY, int maxLength);
 	bool UpdateSentence(SentenceType* &sentence, std::string text, int posX, int posY, PrioEngine::RGB colour);
 	bool RemoveSentence(SentenceType* &sentence);
@@ -164,6 +224,58 @@ private:
 	CCloudShader* mpCloudShader;
 	CRain* mpRain;
 	float mRunTime = 0.0f;
+// Water pass gating.
+private:
+	// The height, refraction and reflection passes.
+	const unsigned int kNumberOfWaterPasses = 3;
+	// Below this fraction of the screen, the water textures are not redrawn.
+	float mMinimumWaterCoverage = 0.002f;
+	// When the camera is still, only redraw the water textures once every this many frames.
+	// Off unless turned on with SetAmortiseWaterPasses, as anything moving in the reflection or refraction would stutter.
+	bool mAmortiseWaterPasses = false;
+	unsigned int mWaterRefreshInterval = 4;
+	// Set by the frame governor, how many frames the water textures are kept for even while the camera moves.
+	unsigned int mWaterMovingRefreshInterval = 0;
+	unsigned int mFramesSinceWaterRefresh = 0;
+	CWater* mpLastRefreshedWater;
+	D3DXMATRIX mLastWaterRefreshView;
+	unsigned int mWaterPassesSkipped = 0;
+	unsigned int mWaterPassesAmortised = 0;
+	// Held from the render target pool for as long as there's water, as they're reused between frames.
+	CRenderTexture* mpWaterRefractionTarget;
+	CRenderTexture* mpWaterReflectionTarget;
+public:
+	void SetAmortiseWaterPasses(bool enabled) { mAmortiseWaterPasses = enabled; };
+	void SetWaterRefreshInterval(unsigned int frames) { mWaterRefreshInterval = frames; };
+	void SetMinimumWaterCoverage(float coverage) { mMinimumWaterCoverage = coverage; };
+	unsigned int GetWaterPassesSkipped() { return mWaterPassesSkipped; };
+	unsigned int GetWaterPassesAmortised() { return mWaterPassesAmortised; };
+	// Off by default, see CVisibilityCache. Covers both the main and the reflection pass.
+	void SetVisibilityCacheEnabled(bool enabled) { mpVisibilityCache->SetEnabled(enabled); mpReflectionVisibilityCache->SetEnabled(enabled); };
+	float GetVisibilityCacheHitRate() { return mpVisibilityCache->GetTotalHitRate(); };
+	unsigned long long GetRenderTargetMemory() { return mpRenderTargetPool->GetMemory(); };
+	unsigned long long GetPeakRenderTargetMemory() { return mpRenderTargetPool->GetPeakMemory(); };
+	// 0 for no budget. Only the mesh buffers and textures can be evicted, the other categories only report going over.
+	void SetGpuMemoryBudget(CGpuMemoryTracker::CategoryType category, unsigned long long budget) { CGpuMemoryTracker::GetInstance().SetBudget(category, budget); };
+	CGpuMemoryTracker::CategoryStatsType GetGpuMemoryStats(CGpuMemoryTracker::CategoryType category) { return CGpuMemoryTracker::GetInstance().GetStats(category); };
+// Frame time governor.
+private:
+	const unsigned int kNumberOfRainParticles = 25000;
+	CFrameGovernor* mpFrameGovernor;
+	void ApplyQualitySettings();
+	void ApplyQualitySettings(CMesh* mesh);
+public:
+	// In seconds, 0 leaves the quality where it is.
+	void SetTargetFrameTime(float frameTime) { mpFrameGovernor->SetTargetFrameTime(frameTime); };
+	void SetFrameGovernorEnabled(bool enabled);
+	bool IsFrameGovernorEnabled() { return mpFrameGovernor->IsEnabled(); };
+	// 0 is full quality.
+	unsigned int GetQualityLevel() { return mpFrameGovernor->GetLevel(); };
+	float GetAverageFrameTime() { return mpFrameGovernor->GetAverageFrameTime(); };
+	unsigned int GetNumberOfQualityDowngrades() { return mpFrameGovernor->GetNumberOfDowngrades(); };
+	unsigned int GetNumberOfQualityUpgrades() { return mpFrameGovernor->GetNumberOfUpgrades(); };
+	unsigned int GetFramesOverTargetTime() { return mpFrameGovernor->GetFramesOverTarget(); };
+	unsigned int GetFramesAtLowestQuality() { return mpFrameGovernor->GetFramesAtLowestLevel(); };
 };
 
 #endif
\ No newline at end of file
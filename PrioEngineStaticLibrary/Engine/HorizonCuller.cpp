@@ -0,0 +1,342 @@
+#include "HorizonCuller.h"
+#include <cfloat>
+#include <algorithm>
+
+CHorizonCuller::CHorizonCuller()
+{
+	mHorizon.resize(kNumberOfAzimuthBins * kNumberOfRings, -FLT_MAX);
+	mCameraPosition = D3DXVECTOR3(0.0f, 0.0f, 0.0f);
+	mBuilt = false;
+	mEnabled = true;
+
+	// Each ring sits further out than the last, so the buffer has more detail close to the camera.
+	float distance = kFirstRingDistance;
+	for (int ring = 0; ring < kNumberOfRings; ring++)
+	{
+		mRingDistances[ring] = distance;
+		distance *= kRingGrowth;
+	}
+
+	mInstancesTested = 0;
+	mInstancesCulled = 0;
+	mChunksTested = 0;
+	mChunksCulled = 0;
+	mTotalInstancesTested = 0;
+	mTotalInstancesCulled = 0;
+}
+
+CHorizonCuller::~CHorizonCuller()
+{
+}
+
+/* Resets the horizon so that nothing is considered occluded, and resets the counters for this frame. */
+void CHorizonCuller::Clear()
+{
+	std::fill(mHorizon.begin(), mHorizon.end(), -FLT_MAX);
+	mBuilt = false;
+
+	mInstancesTested = 0;
+	mInstancesCulled = 0;
+	mChunksTested = 0;
+	mChunksCulled = 0;
+}
+
+/* Builds the horizon buffer around the camera position from the min / max chunk data of a terrain.
+* @PARAM CTerrain* terrain - The terrain which will act as the occluder.
+* @PARAM D3DXVECTOR3 cameraPosition - The world position the scene is being viewed from.
+*/
+void CHorizonCuller::Build(CTerrain* terrain, D3DXVECTOR3 cameraPosition)
+{
+	if (terrain == nullptr)
+	{
+		Clear();
+		return;
+	}
+
+	Build(terrain->GetChunks(), terrain->GetPos(), cameraPosition);
+}
+
+/* As above, from the chunk bounds alone so that the culler can be run on a heightfield without a device.
+* @PARAM D3DXVECTOR3 terrainPosition - The world position of the terrain the chunks are local to.
+*/
+void CHorizonCuller::Build(const std::vector<CTerrain::TerrainChunkType>& chunks, D3DXVECTOR3 terrainPosition, D3DXVECTOR3 cameraPosition)
+{
+	Clear();
+
+	if (!mEnabled)
+	{
+		return;
+	}
+
+	mCameraPosition = cameraPosition;
+
+	const float binWidth = 2.0f * PrioEngine::kPi / kNumberOfAzimuthBins;
+
+	for (auto chunk : chunks)
+	{
+		const float minX = chunk.minX + terrainPosition.x;
+		const float minZ = chunk.minZ + terrainPosition.z;
+		const float maxX = chunk.maxX + terrainPosition.x;
+		const float maxZ = chunk.maxZ + terrainPosition.z;
+
+		// A chunk the camera is standing over can't hide anything in a reliable way.
+		if (mCameraPosition.x >= minX && mCameraPosition.x <= maxX && mCameraPosition.z >= minZ && mCameraPosition.z <= maxZ)
+		{
+			continue;
+		}
+
+		// Find the nearest and furthest horizontal distance from the camera to the chunk.
+		const float nearestX = fmaxf(minX - mCameraPosition.x, fmaxf(0.0f, mCameraPosition.x - maxX));
+		const float nearestZ = fmaxf(minZ - mCameraPosition.z, fmaxf(0.0f, mCameraPosition.z - maxZ));
+		const float furthestX = fmaxf(fabsf(minX - mCameraPosition.x), fabsf(maxX - mCameraPosition.x));
+		const float furthestZ = fmaxf(fabsf(minZ - mCameraPosition.z), fabsf(maxZ - mCameraPosition.z));
+		const float nearest = sqrtf(nearestX * nearestX + nearestZ * nearestZ);
+		const float furthest = sqrtf(furthestX * furthestX + furthestZ * furthestZ);
+
+		// Find the first ring which lies entirely beyond this chunk.
+		int ring = 0;
+		while (ring < kNumberOfRings && mRingDistances[ring] < furthest)
+		{
+			ring++;
+		}
+
+		// Too far away to be useful.
+		if (ring == kNumberOfRings)
+		{
+			continue;
+		}
+
+		// The ground in this chunk is never below its min height, so any ray which is under that height for every
+		// distance across the chunk must hit the ground. Take the shallowest elevation which guarantees that.
+		const float rise = chunk.minHeight + terrainPosition.y - mCameraPosition.y;
+		const float elevation = rise >= 0.0f ? rise / furthest : rise / nearest;
+
+		float lowAzimuth;
+		float highAzimuth;
+		GetAngularExtent(minX, minZ, maxX, maxZ, lowAzimuth, highAzimuth);
+
+		// Only update the slices which are entirely covered by this chunk.
+		const int firstBin = static_cast<int>(ceilf(lowAzimuth / binWidth));
+		const int lastBin = static_cast<int>(floorf(highAzimuth / binWidth)) - 1;
+
+		for (int bin = firstBin; bin <= lastBin; bin++)
+		{
+			const int wrappedBin = ((bin % kNumberOfAzimuthBins) + kNumberOfAzimuthBins) % kNumberOfAzimuthBins;
+			float& horizon = mHorizon[wrappedBin * kNumberOfRings + ring];
+
+			if (elevation > horizon)
+			{
+				horizon = elevation;
+			}
+		}
+	}
+
+	// Anything which blocks the view before a ring also blocks it before every ring further out.
+	for (int bin = 0; bin < kNumberOfAzimuthBins; bin++)
+	{
+		float* rings = &mHorizon[bin * kNumberOfRings];
+
+		for (int ring = 1; ring < kNumberOfRings; ring++)
+		{
+			if (rings[ring - 1] > rings[ring])
+			{
+				rings[ring] = rings[ring - 1];
+			}
+		}
+	}
+
+	mBuilt = true;
+
+	CullTerrainChunks(chunks, terrainPosition);
+}
+
+/* Checks whether a bounding sphere sits above the horizon.
+* @Returns bool - False if the whole sphere is hidden by the terrain, true if it may be visible.
+*/
+bool CHorizonCuller::CheckSphere(D3DXVECTOR3 position, float radius)
+{
+	if (!mBuilt)
+	{
+		return true;
+	}
+
+	mInstancesTested++;
+	mTotalInstancesTested++;
+
+	const float distanceX = position.x - mCameraPosition.x;
+	const float distanceZ = position.z - mCameraPosition.z;
+	const float distance = sqrtf(distanceX * distanceX + distanceZ * distanceZ);
+	const float nearest = distance - radius;
+
+	// The camera is inside, or directly above / below the sphere.
+	if (nearest <= 0.0f)
+	{
+		return true;
+	}
+
+	// Work out the steepest elevation that any point on the sphere could have.
+	const float rise = position.y + radius - mCameraPosition.y;
+	const float elevation = rise >= 0.0f ? rise / nearest : rise / (distance + radius);
+
+	const float azimuth = GetAzimuth(distanceX, distanceZ);
+	const float halfAngle = asinf(radius / distance);
+
+	if (IsBelowHorizon(azimuth - halfAngle, azimuth + halfAngle, nearest, elevation))
+	{
+		mInstancesCulled++;
+		mTotalInstancesCulled++;
+		return false;
+	}
+
+	return true;
+}
+
+/* Tests every terrain chunk against the horizon. The terrain is still drawn in a single call, so this only feeds the counters. */
+void CHorizonCuller::CullTerrainChunks(const std::vector<CTerrain::TerrainChunkType>& chunks, D3DXVECTOR3 terrainPosition)
+{
+	for (auto chunk : chunks)
+	{
+		mChunksTested++;
+
+		const float minX = chunk.minX + terrainPosition.x;
+		const float minZ = chunk.minZ + terrainPosition.z;
+		const float maxX = chunk.maxX + terrainPosition.x;
+		const float maxZ = chunk.maxZ + terrainPosition.z;
+
+		if (mCameraPosition.x >= minX && mCameraPosition.x <= maxX && mCameraPosition.z >= minZ && mCameraPosition.z <= maxZ)
+		{
+			continue;
+		}
+
+		const float nearestX = fmaxf(minX - mCameraPosition.x, fmaxf(0.0f, mCameraPosition.x - maxX));
+		const float nearestZ = fmaxf(minZ - mCameraPosition.z, fmaxf(0.0f, mCameraPosition.z - maxZ));
+		const float furthestX = fmaxf(fabsf(minX - mCameraPosition.x), fabsf(maxX - mCameraPosition.x));
+		const float furthestZ = fmaxf(fabsf(minZ - mCameraPosition.z), fabsf(maxZ - mCameraPosition.z));
+		const float nearest = sqrtf(nearestX * nearestX + nearestZ * nearestZ);
+		const float furthest = sqrtf(furthestX * furthestX + furthestZ * furthestZ);
+
+		// Use the top of the chunk, this time we want the steepest elevation any part of it could reach.
+		const float rise = chunk.maxHeight + terrainPosition.y - mCameraPosition.y;
+		const float elevation = rise >= 0.0f ? rise / nearest : rise / furthest;
+
+		float lowAzimuth;
+		float highAzimuth;
+		GetAngularExtent(minX, minZ, maxX, maxZ, lowAzimuth, highAzimuth);
+
+		if (IsBelowHorizon(lowAzimuth, highAzimuth, nearest, elevation))
+		{
+			mChunksCulled++;
+		}
+	}
+}
+
+/* Checks a range of azimuths against the horizon at a given distance.
+* @Returns bool - True only if the elevation is below the horizon in every slice of the range.
+*/
+bool CHorizonCuller::IsBelowHorizon(float lowAzimuth, float highAzimuth, float nearestDistance, float elevation)
+{
+	const int ring = GetRingForDistance(nearestDistance);
+
+	// Closer than the first ring, nothing can be guaranteed to be in the way.
+	if (ring < 0)
+	{
+		return false;
+	}
+
+	const float binWidth = 2.0f * PrioEngine::kPi / kNumberOfAzimuthBins;
+	const int firstBin = static_cast<int>(floorf(lowAzimuth / binWidth));
+	const int lastBin = static_cast<int>(floorf(highAzimuth / binWidth));
+
+	if (lastBin - firstBin + 1 >= kNumberOfAzimuthBins)
+	{
+		return false;
+	}
+
+	for (int bin = firstBin; bin <= lastBin; bin++)
+	{
+		const int wrappedBin = ((bin % kNumberOfAzimuthBins) + kNumberOfAzimuthBins) % kNumberOfAzimuthBins;
+
+		if (elevation >= mHorizon[wrappedBin * kNumberOfRings + ring])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Finds the furthest ring which is still closer than the distance given.
+* @Returns int - The ring index, or -1 if the distance is inside the first ring.
+*/
+int CHorizonCuller::GetRingForDistance(float distance)
+{
+	int ring = -1;
+
+	while (ring + 1 < kNumberOfRings && mRingDistances[ring + 1] <= distance)
+	{
+		ring++;
+	}
+
+	return ring;
+}
+
+float CHorizonCuller::GetAzimuth(float x, float z)
+{
+	return atan2f(z, x);
+}
+
+/* Finds the range of azimuths a rectangle covers when looked at from the camera.
+* The camera must be outside of the rectangle, so the range is always less than half a turn.
+*/
+void CHorizonCuller::GetAngularExtent(float minX, float minZ, float maxX, float maxZ, float& lowest, float& highest)
+{
+	const float centreAzimuth = GetAzimuth((minX + maxX) * 0.5f - mCameraPosition.x, (minZ + maxZ) * 0.5f - mCameraPosition.z);
+	const float cornersX[4] = { minX, maxX, minX, maxX };
+	const float cornersZ[4] = { minZ, minZ, maxZ, maxZ };
+
+	float lowestOffset = 0.0f;
+	float highestOffset = 0.0f;
+
+	for (int corner = 0; corner < 4; corner++)
+	{
+		float offset = GetAzimuth(cornersX[corner] - mCameraPosition.x, cornersZ[corner] - mCameraPosition.z) - centreAzimuth;
+
+		// Keep the offset in the range -pi to pi so that the range doesn't jump across the seam.
+		if (offset > PrioEngine::kPi)
+		{
+			offset -= 2.0f * PrioEngine::kPi;
+		}
+		else if (offset < -PrioEngine::kPi)
+		{
+			offset += 2.0f * PrioEngine::kPi;
+		}
+
+		lowestOffset = fminf(lowestOffset, offset);
+		highestOffset = fmaxf(highestOffset, offset);
+	}
+
+	lowest = centreAzimuth + lowestOffset;
+	highest = centreAzimuth + highestOffset;
+}
+
+/* The share of instances tested this frame which were hidden by the terrain. */
+float CHorizonCuller::GetCulledShare()
+{
+	if (mInstancesTested == 0)
+	{
+		return 0.0f;
+	}
+
+	return static_cast<float>(mInstancesCulled) / static_cast<float>(mInstancesTested);
+}
+
+/* The share of all instances tested since the culler was created which were hidden by the terrain. */
+float CHorizonCuller::GetTotalCulledShare()
+{
+	if (mTotalInstancesTested == 0)
+	{
+		return 0.0f;
+	}
+
+	return static_cast<float>(mTotalInstancesCulled) / static_cast<float>(mTotalInstancesTested);
+}
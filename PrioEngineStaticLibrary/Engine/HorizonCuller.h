@@ -0,0 +1,66 @@
+#ifndef HORIZONCULLER_H
+#define HORIZONCULLER_H
+
+#include <D3DX10math.h>
+#include <vector>
+#include "PrioEngineVars.h"
+#include "Terrain.h"
+
+/* Occlusion culling tuned for heightfields.
+* Each frame a horizon buffer is built around the camera from the terrain chunk bounds. The buffer stores,
+* for each azimuth and each distance ring, the steepest elevation which is guaranteed to be blocked by
+* the ground before that distance. Anything which sits entirely below that elevation cannot be seen.
+*/
+class CHorizonCuller
+{
+private:
+	CLogger* logger;
+public:
+	CHorizonCuller();
+	~CHorizonCuller();
+public:
+	void Build(CTerrain* terrain, D3DXVECTOR3 cameraPosition);
+	void Build(const std::vector<CTerrain::TerrainChunkType>& chunks, D3DXVECTOR3 terrainPosition, D3DXVECTOR3 cameraPosition);
+	bool CheckSphere(D3DXVECTOR3 position, float radius);
+	void Clear();
+private:
+	// Number of slices the circle around the camera is split into.
+	static const int kNumberOfAzimuthBins = 256;
+	// Number of distance rings stored for each slice.
+	static const int kNumberOfRings = 16;
+	// Radius of the first ring, every ring after it is larger by kRingGrowth.
+	const float kFirstRingDistance = 4.0f;
+	const float kRingGrowth = 1.5f;
+
+	float mRingDistances[kNumberOfRings];
+	std::vector<float> mHorizon;
+	D3DXVECTOR3 mCameraPosition;
+	bool mBuilt;
+	bool mEnabled;
+
+	float GetAzimuth(float x, float z);
+	int GetRingForDistance(float distance);
+	void GetAngularExtent(float minX, float minZ, float maxX, float maxZ, float& lowest, float& highest);
+	bool IsBelowHorizon(float lowAzimuth, float highAzimuth, float nearestDistance, float elevation);
+	void CullTerrainChunks(const std::vector<CTerrain::TerrainChunkType>& chunks, D3DXVECTOR3 terrainPosition);
+private:
+	// Counters for the current frame.
+	unsigned int mInstancesTested;
+	unsigned int mInstancesCulled;
+	unsigned int mChunksTested;
+	unsigned int mChunksCulled;
+	// Running totals since the culler was created.
+	unsigned long long mTotalInstancesTested;
+	unsigned long long mTotalInstancesCulled;
+public:
+	void SetEnabled(bool enabled) { mEnabled = enabled; };
+	bool GetEnabled() { return mEnabled; };
+	unsigned int GetInstancesTested() { return mInstancesTested; };
+	unsigned int GetInstancesCulled() { return mInstancesCulled; };
+	unsigned int GetChunksTested() { return mChunksTested; };
+	unsigned int GetChunksCulled() { return mChunksCulled; };
+	float GetCulledShare();
+	float GetTotalCulledShare();
+};
+
+#endif
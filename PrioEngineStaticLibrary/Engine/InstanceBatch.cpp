@@ -0,0 +1,138 @@
+#include "InstanceBatch.h"
+
+CInstanceBatch::CInstanceBatch()
+{
+	mNumberOfBatchedInstances = 0;
+}
+
+CInstanceBatch::~CInstanceBatch()
+{
+}
+
+/* Empties the batch ready to gather a new set of instances. The arrays keep their memory between frames.
+* @PARAM unsigned int numberOfLevels - How many detail levels whole instances can be drawn at.
+*/
+void CInstanceBatch::Begin(unsigned int numberOfSubMeshes, unsigned int numberOfLevels)
+{
+	if (mInstances.size() != numberOfLevels)
+	{
+		mInstances.resize(numberOfLevels);
+	}
+
+	for (auto& instances : mInstances)
+	{
+		instances.clear();
+	}
+
+	mNumberOfBatchedInstances = 0;
+	mCulledInstances.clear();
+
+	if (mDraws.size() != numberOfSubMeshes)
+	{
+		mDraws.resize(numberOfSubMeshes);
+	}
+
+	for (auto& draws : mDraws)
+	{
+		draws.clear();
+	}
+}
+
+/* Adds an instance which will draw every one of its submeshes whole, at the given detail level. */
+void CInstanceBatch::AddInstance(const D3DXMATRIX& world, unsigned int level)
+{
+	mInstances[level].push_back(world);
+	mNumberOfBatchedInstances++;
+}
+
+/* Adds an instance which only draws the ranges passed to AddRange.
+* @Returns unsigned int - The number to pass to AddRange for this instance.
+*/
+unsigned int CInstanceBatch::AddCulledInstance(const D3DXMATRIX& world)
+{
+	mCulledInstances.push_back(world);
+	return static_cast<unsigned int>(mCulledInstances.size() - 1);
+}
+
+/* Adds a range of a submesh's index buffer to be drawn by an instance added with AddCulledInstance. */
+void CInstanceBatch::AddRange(unsigned int subMesh, unsigned int culledInstance, unsigned int startIndex, unsigned int indexCount)
+{
+	DrawType draw;
+	draw.startIndex = startIndex;
+	draw.indexCount = indexCount;
+	draw.startInstance = culledInstance;
+	draw.instanceCount = 1;
+
+	mDraws[subMesh].push_back(draw);
+}
+
+/* Adds one draw per detail level for the whole instances, and moves the culled instances' draws past them.
+* @PARAM const std::vector<std::vector<RangeType>>& subMeshLevels - The index range of each detail level of each submesh, level 0 being full detail.
+* Submeshes with fewer levels than asked for draw their lowest one.
+*/
+void CInstanceBatch::Finish(const std::vector<std::vector<RangeType>>& subMeshLevels)
+{
+	for (unsigned int subMesh = 0; subMesh < mDraws.size(); subMesh++)
+	{
+		std::vector<DrawType>& draws = mDraws[subMesh];
+
+		for (auto& draw : draws)
+		{
+			draw.startInstance += mNumberOfBatchedInstances;
+		}
+
+		const std::vector<RangeType>& levels = subMeshLevels[subMesh];
+		unsigned int startInstance = 0;
+
+		for (unsigned int level = 0; level < mInstances.size(); level++)
+		{
+			const unsigned int numberOfInstances = static_cast<unsigned int>(mInstances[level].size());
+
+			if (numberOfInstances > 0)
+			{
+				const RangeType& range = levels[level < levels.size() ? level : levels.size() - 1];
+
+				DrawType draw;
+				draw.startIndex = range.startIndex;
+				draw.indexCount = range.indexCount;
+				draw.startInstance = startInstance;
+				draw.instanceCount = numberOfInstances;
+
+				draws.push_back(draw);
+			}
+
+			startInstance += numberOfInstances;
+		}
+	}
+}
+
+/* Copies the whole instances level by level, followed by the culled instances, in the order the draws expect. */
+void CInstanceBatch::CopyInstances(D3DXMATRIX* destination)
+{
+	for (auto& instances : mInstances)
+	{
+		if (!instances.empty())
+		{
+			memcpy(destination, &instances[0], sizeof(D3DXMATRIX) * instances.size());
+			destination += instances.size();
+		}
+	}
+
+	if (!mCulledInstances.empty())
+	{
+		memcpy(destination, &mCulledInstances[0], sizeof(D3DXMATRIX) * mCulledInstances.size());
+	}
+}
+
+/* The total number of draws across every submesh. */
+unsigned int CInstanceBatch::GetNumberOfDraws()
+{
+	unsigned int total = 0;
+
+	for (auto& draws : mDraws)
+	{
+		total += static_cast<unsigned int>(draws.size());
+	}
+
+	return total;
+}
@@ -0,0 +1,60 @@
+#ifndef INSTANCEBATCH_H
+#define INSTANCEBATCH_H
+
+#include <D3DX10math.h>
+#include <vector>
+#include "PrioEngineVars.h"
+
+/* Gathers the world matrices of the visible instances of a mesh into one array, and works out the instanced draws needed for each submesh.
+* This has no device dependencies, so the gather can be run and timed on the CPU alone.
+*
+* Instances whose submeshes are all drawn whole go at the front of the array, grouped by detail level, and each level is drawn together with one draw per submesh.
+* Instances which have had some of their meshlets culled go after them, and draw their own index ranges.
+*/
+class CInstanceBatch
+{
+private:
+	CLogger* logger;
+public:
+	struct DrawType
+	{
+		unsigned int startIndex;
+		unsigned int indexCount;
+		unsigned int startInstance;
+		unsigned int instanceCount;
+	};
+
+	// A run of a submesh's index buffer, used for the detail levels.
+	struct RangeType
+	{
+		unsigned int startIndex;
+		unsigned int indexCount;
+	};
+public:
+	CInstanceBatch();
+	~CInstanceBatch();
+public:
+	void Begin(unsigned int numberOfSubMeshes, unsigned int numberOfLevels = 1);
+	void AddInstance(const D3DXMATRIX& world, unsigned int level = 0);
+	unsigned int AddCulledInstance(const D3DXMATRIX& world);
+	void AddRange(unsigned int subMesh, unsigned int culledInstance, unsigned int startIndex, unsigned int indexCount);
+	void Finish(const std::vector<std::vector<RangeType>>& subMeshLevels);
+
+	// Copies every instance into a buffer which has room for GetNumberOfInstances() matrices.
+	void CopyInstances(D3DXMATRIX* destination);
+
+	unsigned int GetNumberOfInstances() { return mNumberOfBatchedInstances + static_cast<unsigned int>(mCulledInstances.size()); };
+	unsigned int GetNumberOfBatchedInstances() { return mNumberOfBatchedInstances; };
+	unsigned int GetNumberOfInstancesAtLevel(unsigned int level) { return static_cast<unsigned int>(mInstances[level].size()); };
+	const std::vector<DrawType>& GetDraws(unsigned int subMesh) { return mDraws[subMesh]; };
+	unsigned int GetNumberOfDraws();
+private:
+	// Instances which draw every submesh whole, one array for each detail level.
+	std::vector<std::vector<D3DXMATRIX>> mInstances;
+	unsigned int mNumberOfBatchedInstances;
+	// Instances which draw parts of their submeshes, their draws are offset past mInstances in Finish.
+	std::vector<D3DXMATRIX> mCulledInstances;
+	std::vector<std::vector<DrawType>> mDraws;
+};
+
+#endif
@@ -1,12 +1,21 @@
 #include "Mesh.h"
+#include "HorizonCuller.h"
+#include "VisibilityCache.h"
+#include <cfloat>
 
-CMesh::CMesh(ID3D11Device* device)
+CMesh::CMesh(CRenderDevice* device) : mModelPool(&mTransforms)
 {
 	// Initialise our counter variables to the default values.
 	mVertexCount = 0;
 	mIndexCount = 0;
 
 	mpDevice = device;
+
+	mpSubMeshes = nullptr;
+	mSubMeshMaterials = nullptr;
+	mNumberOfSubMeshes = 0;
+	mStaticBatching = false;
+	mDetailBias = 1.0f;
 }
 
 CMesh::~CMesh()
@@ -21,24 +30,41 @@ void CMesh::Shutdown()
 		{
 			if (mSubMeshMaterials[i].mTextures[t] != nullptr)
 			{
-				mSubMeshMaterials[i].mTextures[t]->Release();
+				CGpuMemoryTracker::GetInstance().Unregister(mSubMeshMaterials[i].mTextures[t]);
+				mpDevice->ReleaseResource(mSubMeshMaterials[i].mTextures[t]);
 				mSubMeshMaterials[i].mTextures[t] = nullptr;
 			}
 		}
 	}
+	for (unsigned int i = 0; i < mNumberOfSubMeshes; i++)
+	{
+		CGpuMemoryTracker::GetInstance().Unregister(mpSubMeshes[i].vertexBuffer);
+		CGpuMemoryTracker::GetInstance().Unregister(mpSubMeshes[i].indexBuffer);
+		mpDevice->ReleaseResource(mpSubMeshes[i].vertexBuffer);
+		mpDevice->ReleaseResource(mpSubMeshes[i].indexBuffer);
+	}
 	delete[] mpSubMeshes;
 	delete[] mSubMeshMaterials;
 
-	for (auto model : mpModels)
+	for (auto& passData : mPasses)
 	{
-		delete model;
-		logger->GetInstance().MemoryDeallocWriteLine(typeid(model).name());
+		if (passData.instanceBuffer != nullptr)
+		{
+			CGpuMemoryTracker::GetInstance().Unregister(passData.instanceBuffer);
+			mpDevice->ReleaseResource(passData.instanceBuffer);
+			passData.instanceBuffer = nullptr;
+		}
+		passData.instanceBufferCapacity = 0;
 	}
-	mpModels.clear();
+
+	mStaticBatcher.Shutdown();
+	mModelPool.Clear();
 
 }
 
-/* Load data from file into our mesh object. */
+/* Load data from file into our mesh object.
+* @PARAM float modelRadius - No longer used, the bounds are worked out from the vertices. Kept so existing callers still build.
+*/
 bool CMesh::LoadMesh(std::string filename, float modelRadius)
 {
 	mRadius = modelRadius;
@@ -57,53 +83,420 @@ bool CMesh::LoadMesh(std::string filename, float modelRadius)
 	return result;
 }
 
-void CMesh::Render(ID3D11DeviceContext* context, CFrustum* frustum, CDiffuseLightShader* shader, CLight* light)
+/* Rebuilds the matrices of any models which have changed, must be called once a frame before the scene graph is updated. */
+void CMesh::UpdateTransforms()
+{
+	mTransforms.Update();
+}
+
+/* Merges every model of this mesh, now and in future, into one buffer per world cell instead of instancing them.
+* Only worth doing for scenery which rarely moves, as a cell is merged again whenever one of its models does.
+* Batched models take the cell path: each cell is culled by its box against the frustum, horizon and draw distance, thinned, and drawn at one detail level picked
+* from its nearest point. They skip meshlet culling, the visibility cache and the per model bounds tests, which only unbatched models get.
+* @PARAM float cellSize - The width of a cell along the x and z axes.
+*/
+void CMesh::EnableStaticBatching(float cellSize)
+{
+	if (mStaticBatching)
+	{
+		return;
+	}
+
+	mStaticBatching = true;
+	mStaticBatcher.SetCellSize(cellSize);
+
+	for (auto model : mModelPool.GetModels())
+	{
+		mStaticBatcher.Add(model);
+	}
+}
+
+/* Merges any cells whose models have moved again. Must be called once a frame after the scene graph update, and before any pass is gathered.
+* @Returns bool Success
+*/
+bool CMesh::UpdateStaticBatches()
+{
+	if (!mStaticBatching)
+	{
+		return true;
+	}
+
+	if (!mStaticBatcher.Update(mpDevice))
+	{
+		logger->GetInstance().WriteLine("Failed to rebuild the static batches for mesh '" + mFilename + "'.");
+		return false;
+	}
+
+	return true;
+}
+
+/* Finds the visible instances for a pass without touching the device, so different passes can be gathered on different threads at once.
+* Nothing else may change the models of this mesh until the gather has finished.
+* @PARAM D3DXVECTOR3 cameraPosition - Used to find how far away the nearest instance is.
+* @PARAM bool cullBackFaces - Whether meshlets facing away from the camera can be dropped, only true when the rasteriser culls back faces.
+* @Returns bool - True if there is anything to draw.
+*/
+bool CMesh::Gather(CRenderQueue::PassType pass, CFrustum* frustum, CHorizonCuller* horizon, CVisibilityCache* visibilityCache, D3DXVECTOR3 cameraPosition, bool cullBackFaces)
 {
-	for (auto model : mpModels)
+	PassDataType& passData = mPasses[pass];
+
+	passData.instanceBatch.Begin(mNumberOfSubMeshes, kNumberOfLevels);
+	passData.nearestInstanceDistance = FLT_MAX;
+	passData.uploaded = false;
+
+	if (mStaticBatching)
+	{
+		return GatherStaticBatches(pass, frustum, horizon, cameraPosition);
+	}
+
+	for (auto model : mModelPool.GetModels())
 	{
-		model->UpdateMatrices();
 		bool inFrustum = true;
-		inFrustum = frustum->CheckSphere(model->GetPos(), model->GetScaleRadius(mRadius));
 
+		const D3DXMATRIX world = model->GetWorldMatrix();
+		D3DXVECTOR3 centre;
+		float radius;
+		CBoundingVolume::TransformSphere(mBounds.centre, mBounds.radius, world, centre, radius);
+
+		// Distance, screen size and thinning are cheaper than any of the frustum tests, so go first.
+		if (mDistanceCuller.Check(pass, centre, radius, cameraPosition, CDistanceCuller::GetInstanceValue(model->GetPos())) != CDistanceCuller::Visible)
+		{
+			continue;
+		}
+
+		// Reuse last frame's result where the camera hasn't moved enough to change it.
+		if (visibilityCache != nullptr)
+		{
+			inFrustum = visibilityCache->CheckSphere(frustum, model, centre, radius);
+		}
+		else
+		{
+			inFrustum = frustum->CheckSphere(centre, radius);
+		}
+
+		// The box hugs tall, thin meshes such as trees much more closely than the sphere does.
 		if (inFrustum)
 		{
+			D3DXVECTOR3 minPoint;
+			D3DXVECTOR3 maxPoint;
+			CBoundingVolume::TransformBox(mBounds.minPoint, mBounds.maxPoint, world, minPoint, maxPoint);
+			inFrustum = frustum->CheckBox(minPoint, maxPoint);
+		}
+
+		// Skip anything hidden behind the terrain.
+		if (inFrustum && horizon != nullptr)
+		{
+			inFrustum = horizon->CheckSphere(centre, radius);
+		}
 
-			for (unsigned int subMeshCount = 0; subMeshCount < mNumberOfSubMeshes; subMeshCount++)
+		if (inFrustum)
+		{
+			// Only the full detail level is worth culling in pieces, the others are small on screen anyway.
+			unsigned int level = SelectLevel(centre, radius, cameraPosition);
+			if (level == 0)
 			{
-				// Prepare the buffers for rendering.
-				model->RenderBuffers(context, subMeshCount, mpSubMeshes[subMeshCount].vertexBuffer, mpSubMeshes[subMeshCount].indexBuffer, sizeof(VertexType));
-
-				// Get the textures.
-
-				bool useAlpha = mSubMeshMaterials[mpSubMeshes[subMeshCount].materialIndex].mTextures[1] != NULL ? true : false;
-				bool useSpecular = mSubMeshMaterials[mpSubMeshes[subMeshCount].materialIndex].mTextures[2] != NULL ? true : false;
-				shader->UpdateMapBuffer(context, useAlpha, useSpecular);
-				
-				//shader->SetViewMatrix(view);
-				//shader->SetProjMatrix(proj);
-				//shader->SetViewMatrix(view * proj);
-				shader->SetWorldMatrix(model->GetWorldMatrix());
-
-				// Pass over the textures for rendering.
-				if (!shader->Render(context, mpSubMeshes[subMeshCount].numberOfIndices,
-					mSubMeshMaterials[mpSubMeshes[subMeshCount].materialIndex].mTextures, mNumberOfTextures,
-					light->GetDirection(), light->GetDiffuseColour(), light->GetAmbientColour()))
-				{
-					logger->GetInstance().WriteLine("Failed to render the mesh model.");
-				}
+				GatherInstance(passData, world, centre, radius, frustum, cullBackFaces ? &cameraPosition : nullptr);
+			}
+			else
+			{
+				passData.instanceBatch.AddInstance(world, level);
+			}
+
+			D3DXVECTOR3 toModel = centre - cameraPosition;
+			float distance = D3DXVec3Length(&toModel) - radius;
+			distance = distance > 0.0f ? distance : 0.0f;
+			passData.nearestInstanceDistance = distance < passData.nearestInstanceDistance ? distance : passData.nearestInstanceDistance;
+		}
+	}
+
+	passData.instanceBatch.Finish(mSubMeshLevels);
+
+	return passData.instanceBatch.GetNumberOfInstances() > 0;
+}
+
+/* Picks a detail level from how large the bounding sphere looks from the camera, ignoring the field of view.
+* @Returns unsigned int - 0 for full detail, up to kNumberOfLevels - 1.
+*/
+unsigned int CMesh::SelectLevel(D3DXVECTOR3 centre, float radius, D3DXVECTOR3 cameraPosition)
+{
+	D3DXVECTOR3 toCentre = centre - cameraPosition;
+	float distance = D3DXVec3Length(&toCentre);
+
+	// The camera is inside the sphere.
+	if (distance <= radius)
+	{
+		return 0;
+	}
+
+	const float screenSize = radius / distance;
+	unsigned int level = 0;
+
+	while (level < kNumberOfLevels - 1 && screenSize < kLevelScreenSizes[level] * mDetailBias)
+	{
+		level++;
+	}
 
+	return level;
+}
+
+/* Finds which merged cells are visible to a pass. The cells are drawn through the instanced shader with a single identity instance.
+* @Returns bool - True if there is anything to draw.
+*/
+bool CMesh::GatherStaticBatches(CRenderQueue::PassType pass, CFrustum* frustum, CHorizonCuller* horizon, D3DXVECTOR3 cameraPosition)
+{
+	PassDataType& passData = mPasses[pass];
+
+	// The same thresholds SelectLevel uses, so the governor's detail bias reaches batched scenery too.
+	float levelScreenSizes[kNumberOfLevels - 1];
+	for (unsigned int level = 0; level < kNumberOfLevels - 1; level++)
+	{
+		levelScreenSizes[level] = kLevelScreenSizes[level] * mDetailBias;
+	}
+
+	mStaticBatcher.Cull(pass, frustum, horizon, cameraPosition, &mDistanceCuller, levelScreenSizes, kNumberOfLevels - 1);
+
+	if (!mStaticBatcher.HasVisibleCells(pass))
+	{
+		passData.instanceBatch.Finish(mSubMeshLevels);
+		return false;
+	}
+
+	D3DXMATRIX identity;
+	D3DXMatrixIdentity(&identity);
+	unsigned int identityInstance = passData.instanceBatch.AddCulledInstance(identity);
+
+	passData.instanceBatch.Finish(mSubMeshLevels);
+	passData.identityInstance = passData.instanceBatch.GetNumberOfBatchedInstances() + identityInstance;
+	passData.nearestInstanceDistance = mStaticBatcher.GetNearestCellDistance(pass);
+
+	return true;
+}
+
+/* Adds a draw to the queue for each submesh which has something to draw after the last gather of this pass. */
+void CMesh::Submit(CRenderQueue* queue, CRenderQueue::PassType pass)
+{
+	for (unsigned int subMeshCount = 0; subMeshCount < mNumberOfSubMeshes; subMeshCount++)
+	{
+		if (mPasses[pass].instanceBatch.GetDraws(subMeshCount).empty() && !(mStaticBatching && mStaticBatcher.HasVisibleGeometry(pass, subMeshCount)))
+		{
+			continue;
+		}
+
+		// Group by material. The maps themselves can't be read here, as another pass may be reloading evicted ones on the render thread.
+		unsigned int material = queue->GetMaterialId(&mSubMeshMaterials[mpSubMeshes[subMeshCount].materialIndex]);
+		queue->Submit(CRenderQueue::MakeKey(pass, CRenderQueue::DiffuseLight, material, mPasses[pass].nearestInstanceDistance), this, subMeshCount);
+	}
+}
+
+/* The texture maps used by a submesh. */
+ID3D11ShaderResourceView** CMesh::GetSubMeshTextures(unsigned int subMesh)
+{
+	return mSubMeshMaterials[mpSubMeshes[subMesh].materialIndex].mTextures;
+}
+
+/* Draws the instances of one submesh gathered and uploaded for a pass. The instanced shader must already be set.
+* @PARAM bool bindMaterial - Whether the textures of this submesh need binding, false if they are already bound.
+* @Returns unsigned int - The number of draw calls made.
+*/
+unsigned int CMesh::RenderSubMesh(CRenderDevice* device, CDiffuseLightShader* shader, CRenderQueue::PassType pass, unsigned int subMesh, bool bindMaterial)
+{
+	PassDataType& passData = mPasses[pass];
+	const std::vector<CInstanceBatch::DrawType>& draws = passData.instanceBatch.GetDraws(subMesh);
+	const bool drawCells = mStaticBatching && mStaticBatcher.HasVisibleGeometry(pass, subMesh);
+
+	if (!passData.uploaded || (draws.empty() && !drawCells))
+	{
+		return 0;
+	}
+
+	device->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	if (bindMaterial)
+	{
+		ID3D11ShaderResourceView** textures = GetSubMeshTextures(subMesh);
+
+		bool useAlpha = textures[1] != NULL ? true : false;
+		bool useSpecular = textures[2] != NULL ? true : false;
+		shader->UpdateMapBuffer(device, useAlpha, useSpecular);
+		shader->SetTextures(device, textures, mNumberOfTextures);
+	}
+
+	if (drawCells)
+	{
+		return mStaticBatcher.Render(pass, device, shader, subMesh, passData.instanceBuffer, passData.identityInstance);
+	}
+
+	// Prepare the buffers for rendering, the instance buffer goes alongside the vertex buffer.
+	ID3D11Buffer* vertexBuffers[2] = { mpSubMeshes[subMesh].vertexBuffer, passData.instanceBuffer };
+	unsigned int strides[2] = { sizeof(VertexType), sizeof(D3DXMATRIX) };
+	unsigned int offsets[2] = { 0, 0 };
+
+	device->IASetVertexBuffers(0, 2, vertexBuffers, strides, offsets);
+	device->IASetIndexBuffer(mpSubMeshes[subMesh].indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+
+	for (auto& draw : draws)
+	{
+		shader->RenderInstancedRange(device, draw.indexCount, draw.instanceCount, draw.startIndex, draw.startInstance);
+	}
+
+	return static_cast<unsigned int>(draws.size());
+}
+
+/* Adds a visible model to the instance batch, culling the submeshes and meshlets of each of its submeshes on the way.
+* @PARAM D3DXVECTOR3 centre, float radius - The bounding sphere of the whole model in world space.
+*/
+void CMesh::GatherInstance(PassDataType& passData, const D3DXMATRIX& world, D3DXVECTOR3 centre, float radius, CFrustum* frustum, const D3DXVECTOR3* viewPosition)
+{
+	// When the whole model is inside the frustum its submeshes and meshlets must be too, so only the cone test is worth doing.
+	CFrustum* meshletFrustum = frustum->GetSphereMargin(centre, radius) >= 2.0f * radius ? nullptr : frustum;
+
+	// Stays at -1 while every submesh so far is drawn whole, so the model can still join the shared instanced draws.
+	int culledInstance = -1;
+
+	for (unsigned int subMeshCount = 0; subMeshCount < mNumberOfSubMeshes; subMeshCount++)
+	{
+		bool drawWhole = true;
+
+		// A model on the edge of the screen may have whole submeshes off it.
+		bool subMeshVisible = true;
+		if (meshletFrustum != nullptr && mNumberOfSubMeshes > 1)
+		{
+			D3DXVECTOR3 subMeshCentre;
+			float subMeshRadius;
+			CBoundingVolume::TransformSphere(mpSubMeshes[subMeshCount].bounds.centre, mpSubMeshes[subMeshCount].bounds.radius, world, subMeshCentre, subMeshRadius);
+			subMeshVisible = meshletFrustum->CheckSphere(subMeshCentre, subMeshRadius);
+		}
+
+		if (!subMeshVisible)
+		{
+			passData.visibleRanges.clear();
+			drawWhole = false;
+		}
+		else if (mpSubMeshes[subMeshCount].meshlets.size() >= kMinimumMeshletsToCull)
+		{
+			passData.meshletCuller.Cull(mpSubMeshes[subMeshCount].meshlets, world, meshletFrustum, viewPosition, passData.visibleRanges);
+
+			// If most of the submesh survived, one draw of the whole thing is cheaper than several small ones.
+			unsigned int visibleIndices = 0;
+			for (auto& range : passData.visibleRanges)
+			{
+				visibleIndices += range.indexCount;
+			}
+
+			drawWhole = visibleIndices * 4 > mSubMeshIndexCounts[subMeshCount] * 3;
+		}
+
+		if (drawWhole && culledInstance < 0)
+		{
+			continue;
+		}
+
+		// This model has to draw its own ranges, move it over along with any whole submeshes we skipped past.
+		if (culledInstance < 0)
+		{
+			culledInstance = passData.instanceBatch.AddCulledInstance(world);
+
+			for (unsigned int previous = 0; previous < subMeshCount; previous++)
+			{
+				passData.instanceBatch.AddRange(previous, culledInstance, 0, mSubMeshIndexCounts[previous]);
+			}
+		}
+
+		if (drawWhole)
+		{
+			passData.instanceBatch.AddRange(subMeshCount, culledInstance, 0, mSubMeshIndexCounts[subMeshCount]);
+		}
+		else
+		{
+			for (auto& range : passData.visibleRanges)
+			{
+				passData.instanceBatch.AddRange(subMeshCount, culledInstance, range.startIndex, range.indexCount);
 			}
 		}
 	}
+
+	if (culledInstance < 0)
+	{
+		passData.instanceBatch.AddInstance(world);
+	}
+}
+
+/* Copies the instances gathered for a pass into its instance buffer, making the buffer bigger first if they won't fit.
+* Anything the pass draws which was evicted is made again first.
+* Must be called on the thread which owns the device, after the gather has finished.
+* @Returns bool Success
+*/
+bool CMesh::UploadInstances(CRenderDevice* device, CRenderQueue::PassType pass)
+{
+	HRESULT result;
+	PassDataType& passData = mPasses[pass];
+	const unsigned int numberOfInstances = passData.instanceBatch.GetNumberOfInstances();
+
+	if (!MakeResident(pass))
+	{
+		logger->GetInstance().WriteLine("Failed to reload the evicted buffers of mesh '" + mFilename + "', it won't be drawn.");
+		return false;
+	}
+
+	if (numberOfInstances > passData.instanceBufferCapacity)
+	{
+		if (passData.instanceBuffer != nullptr)
+		{
+			CGpuMemoryTracker::GetInstance().Unregister(passData.instanceBuffer);
+			mpDevice->ReleaseResource(passData.instanceBuffer);
+			passData.instanceBuffer = nullptr;
+		}
+
+		// Leave some room to grow so we aren't recreating the buffer every time another model becomes visible.
+		unsigned int newCapacity = passData.instanceBufferCapacity > 0 ? passData.instanceBufferCapacity : kInitialInstanceBufferCapacity;
+		while (newCapacity < numberOfInstances)
+		{
+			newCapacity *= 2;
+		}
+
+		D3D11_BUFFER_DESC bufferDesc;
+		bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+		bufferDesc.ByteWidth = sizeof(D3DXMATRIX) * newCapacity;
+		bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		bufferDesc.MiscFlags = 0;
+		bufferDesc.StructureByteStride = 0;
+
+		result = mpDevice->CreateBuffer(&bufferDesc, NULL, &passData.instanceBuffer);
+		if (FAILED(result))
+		{
+			logger->GetInstance().WriteLine("Failed to create the instance buffer for mesh '" + mFilename + "'.");
+			passData.instanceBufferCapacity = 0;
+			return false;
+		}
+		CGpuMemoryTracker::GetInstance().Register(passData.instanceBuffer, CGpuMemoryTracker::Meshes, bufferDesc.ByteWidth);
+
+		passData.instanceBufferCapacity = newCapacity;
+	}
+
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	result = device->Map(passData.instanceBuffer, 0, D3D11_MAP_WRITE_DISCARD, &mappedResource);
+	if (FAILED(result))
+	{
+		logger->GetInstance().WriteLine("Failed to lock the instance buffer for mesh '" + mFilename + "'.");
+		return false;
+	}
+
+	passData.instanceBatch.CopyInstances(static_cast<D3DXMATRIX*>(mappedResource.pData));
+
+	device->Unmap(passData.instanceBuffer, 0, 0, sizeof(D3DXMATRIX) * numberOfInstances);
+	passData.uploaded = true;
+
+	return true;
 }
 
 /* Create an instance of this mesh.
+@PARAM CModelPool::HandleType* handle - If not null, filled with a handle which can be used to destroy the model.
 @Returns CModel* ptr
  */
-CModel* CMesh::CreateModel()
+CModel* CMesh::CreateModel(CModelPool::HandleType* handle)
 {
-	// Allocate memory to a model.
-	CModel* model = new CModel();
+	CModel* model = mModelPool.Create(handle);
 
 	// Check the model has had space allocated to it.
 	if (model == nullptr)
@@ -111,14 +504,56 @@ CModel* CMesh::CreateModel()
 		logger->GetInstance().WriteLine("Failed to allocate space to model. ");
 		return nullptr;
 	}
-	
-	// Stick our models on a list to prevent losing the pointers.
-	mpModels.push_back(model);
 
-	//return model;
+	if (mStaticBatching)
+	{
+		mStaticBatcher.Add(model);
+	}
+
 	return model;
 }
 
+/* Create many instances of this mesh at once, which is far cheaper than calling CreateModel for each.
+@PARAM const CModelPool::TransformType* transforms - The transform of each model, count long.
+@PARAM CModelPool::HandleType* handles - If not null, filled with a handle for each model.
+@Returns bool Success
+ */
+bool CMesh::CreateModels(unsigned int count, const CModelPool::TransformType* transforms, CModelPool::HandleType* handles)
+{
+	if (!mModelPool.Create(count, transforms, handles))
+	{
+		logger->GetInstance().WriteLine("Failed to allocate space to " + std::to_string(count) + " models on mesh '" + mFilename + "'.");
+		return false;
+	}
+
+	// The new models are always the last ones in the pool's list.
+	if (mStaticBatching)
+	{
+		const std::vector<CModel*>& models = mModelPool.GetModels();
+		for (size_t model = models.size() - count; model < models.size(); model++)
+		{
+			mStaticBatcher.Add(models[model]);
+		}
+	}
+
+	return true;
+}
+
+/* Destroy an instance of this mesh.
+@Returns bool - False if the model had already been destroyed.
+ */
+bool CMesh::DestroyModel(CModelPool::HandleType handle)
+{
+	CModel* model = mModelPool.Get(handle);
+
+	if (model != nullptr && mStaticBatching)
+	{
+		mStaticBatcher.Remove(model);
+	}
+
+	return mModelPool.Destroy(handle);
+}
+
 /* Load a model using our assimp vertex manager.
 @Returns bool Success*/
 bool CMesh::LoadAssimpModel(std::string filename)
@@ -161,7 +596,6 @@ bool CMesh::LoadAssimpModel(std::string filename)
 		aiString diffuseMapName;
 		aiString alphaMapName;
 		aiString specularMapName;
-		HRESULT result;
 		std::string sDir = "Resources/Textures/";
 
 		///////////////////////////////
@@ -171,10 +605,10 @@ bool CMesh::LoadAssimpModel(std::string filename)
 			std::string sTextureName = diffuseMapName.C_Str();
 			std::string sFullPath = sDir + sTextureName;
 
-			// Load in the texture.
-			result = D3DX11CreateShaderResourceViewFromFile(mpDevice, sFullPath.c_str(), NULL, NULL, &mSubMeshMaterials[materialCount].mTextures[0], NULL);
+			// Load in the texture, keeping the path in case it's evicted and has to be loaded again.
+			mSubMeshMaterials[materialCount].mFilenames[0] = sFullPath;
 
-			if (FAILED(result))
+			if (!LoadMaterialTexture(materialCount, 0))
 			{
 				logger->GetInstance().WriteLine("Failed to load the diffuse map for texture " + sFullPath );
 				return false;
@@ -190,10 +624,10 @@ bool CMesh::LoadAssimpModel(std::string filename)
 			std::string sTextureName = alphaMapName.C_Str();
 			std::string sFullPath = sDir + sTextureName;
 
-			// Load in the texture.
-			result = D3DX11CreateShaderResourceViewFromFile(mpDevice, sFullPath.c_str(), NULL, NULL, &mSubMeshMaterials[materialCount].mTextures[1], NULL);
+			// Load in the texture, keeping the path in case it's evicted and has to be loaded again.
+			mSubMeshMaterials[materialCount].mFilenames[1] = sFullPath;
 
-			if (FAILED(result))
+			if (!LoadMaterialTexture(materialCount, 1))
 			{
 				logger->GetInstance().WriteLine("Failed to load the alpha map " + sFullPath);
 				return false;
@@ -208,10 +642,10 @@ bool CMesh::LoadAssimpModel(std::string filename)
 			std::string sTextureName = specularMapName.C_Str();
 			std::string sFullPath = sDir + sTextureName;
 
-			// Load in the texture.
-			result = D3DX11CreateShaderResourceViewFromFile(mpDevice, sFullPath.c_str(), NULL, NULL, &mSubMeshMaterials[materialCount].mTextures[2], NULL);
+			// Load in the texture, keeping the path in case it's evicted and has to be loaded again.
+			mSubMeshMaterials[materialCount].mFilenames[2] = sFullPath;
 
-			if (FAILED(result))
+			if (!LoadMaterialTexture(materialCount, 2))
 			{
 				logger->GetInstance().WriteLine("Failed to load the specular map " + sFullPath);
 				return false;
@@ -224,7 +658,7 @@ bool CMesh::LoadAssimpModel(std::string filename)
 	// Define sub meshes.
 	/////////////////////////////////////////////////////////////////////////
 
-	mpSubMeshes = new SubMesh[mNumberOfSubMeshes];
+	mpSubMeshes = new SubMesh[mNumberOfSubMeshes]();
 
 	for (unsigned int meshCount = 0; meshCount < mNumberOfSubMeshes; meshCount++)
 	{
@@ -232,6 +666,35 @@ bool CMesh::LoadAssimpModel(std::string filename)
 			return false;
 	}
 
+	// Bound the whole mesh using every vertex, which is tighter than bounding the submeshes' bounds.
+	std::vector<D3DXVECTOR3> allPositions;
+	for (unsigned int meshCount = 0; meshCount < mNumberOfSubMeshes; meshCount++)
+	{
+		const aiMesh* subMesh = scene->mMeshes[meshCount];
+		for (unsigned int vertex = 0; vertex < subMesh->mNumVertices; vertex++)
+		{
+			allPositions.push_back(D3DXVECTOR3(subMesh->mVertices[vertex].x, subMesh->mVertices[vertex].y, subMesh->mVertices[vertex].z));
+		}
+	}
+
+	if (allPositions.empty())
+	{
+		CBoundingVolume::ComputeBounds(nullptr, 0, mBounds);
+	}
+	else
+	{
+		CBoundingVolume::ComputeBounds(&allPositions[0], static_cast<unsigned int>(allPositions.size()), mBounds);
+	}
+
+	// Keep the index counts and detail levels together, the instance batch needs them every frame.
+	mSubMeshIndexCounts.resize(mNumberOfSubMeshes);
+	mSubMeshLevels.resize(mNumberOfSubMeshes);
+	for (unsigned int subMesh = 0; subMesh < mNumberOfSubMeshes; subMesh++)
+	{
+		mSubMeshIndexCounts[subMesh] = mpSubMeshes[subMesh].numberOfIndices;
+		mSubMeshLevels[subMesh] = mpSubMeshes[subMesh].levels;
+	}
+
 	logger->GetInstance().WriteLine("Successfully initialised our arrays for mesh '" + mFilename + "'. ");
 
 
@@ -270,72 +733,257 @@ bool CMesh::CreateSubmesh(const aiMesh& mesh, SubMesh* subMesh)
 		}
 	}
 	
-	subMesh->faces = mesh.mFaces;
-	subMesh->numberOfVertices = mesh.mNumVertices;
-	subMesh->numberOfIndices = mesh.mNumFaces * kNumberOfIndicesInFace;
-	subMesh->materialIndex = mesh.mMaterialIndex;
-
-	int offset = 0;
-
-	if (mesh.HasPositions())
-	{
-		offset += 12;
-	}
-	if (mesh.HasNormals())
+	// Group the triangles into meshlets, this reorders the indices so must happen before the index buffer is made.
+	D3DXVECTOR3* positions = new D3DXVECTOR3[mesh.mNumVertices];
+	for (unsigned int vertex = 0; vertex < mesh.mNumVertices; vertex++)
 	{
-		offset += 12;
+		positions[vertex] = vertices[vertex].position;
 	}
-	if (mesh.HasTangentsAndBitangents())
+
+	CMeshletBuilder meshletBuilder;
+	if (!meshletBuilder.Build(positions, mesh.mNumVertices, indices, index, subMesh->meshlets))
 	{
-		offset += 24;
+		logger->GetInstance().WriteLine("Failed to build the meshlets for mesh '" + mFilename + "', it will be drawn without meshlet culling.");
+		subMesh->meshlets.clear();
 	}
-	if (mesh.HasTextureCoords(0))
+
+	CBoundingVolume::ComputeBounds(positions, mesh.mNumVertices, subMesh->bounds);
+
+	/////////////////////////////
+	// Build the lower detail levels, each is added to the index buffer after the one before.
+	/////////////////////////////
+
+	std::vector<unsigned int> allIndices(indices, indices + index);
+
+	CInstanceBatch::RangeType fullDetail;
+	fullDetail.startIndex = 0;
+	fullDetail.indexCount = index;
+	subMesh->levels.push_back(fullDetail);
+
+	CMeshSimplifier simplifier;
+	std::vector<unsigned int> simplified;
+	std::string levelCounts = std::to_string(index / 3);
+
+	for (unsigned int level = 1; level < kNumberOfLevels; level++)
 	{
-		offset += 8;
+		const unsigned int previousCount = subMesh->levels.back().indexCount;
+
+		if (!simplifier.Simplify(positions, mesh.mNumVertices, indices, index, index >> level, simplified))
+		{
+			break;
+		}
+
+		// Stop once the simplifier can't find much more to take away, the level wouldn't be worth a draw.
+		if (simplified.empty() || simplified.size() > previousCount * (1.0f - kMinimumLevelReduction))
+		{
+			break;
+		}
+
+		CInstanceBatch::RangeType range;
+		range.startIndex = static_cast<unsigned int>(allIndices.size());
+		range.indexCount = static_cast<unsigned int>(simplified.size());
+		subMesh->levels.push_back(range);
+
+		allIndices.insert(allIndices.end(), simplified.begin(), simplified.end());
+		levelCounts += ", " + std::to_string(simplified.size() / 3);
 	}
-	if (mesh.HasVertexColors(0))
+
+	logger->GetInstance().WriteLine("Built " + std::to_string(subMesh->levels.size()) + " detail levels for a submesh of '" + mFilename + "' with " + levelCounts + " triangles.");
+
+	delete[] positions;
+	positions = nullptr;
+
+	// Keep a copy on the CPU, in case this mesh is static batched later on.
+	CStaticBatcher::GeometryType geometry;
+	geometry.vertices.resize(mesh.mNumVertices);
+	for (unsigned int vertex = 0; vertex < mesh.mNumVertices; vertex++)
 	{
-		offset += 4;
+		geometry.vertices[vertex].position = vertices[vertex].position;
+		geometry.vertices[vertex].uv = vertices[vertex].uv;
+		geometry.vertices[vertex].normal = vertices[vertex].normal;
 	}
+	geometry.indices = allIndices;
+	geometry.levels = subMesh->levels;
+	mStaticBatcher.AddSubMesh(geometry);
+
+	subMesh->faces = mesh.mFaces;
+	subMesh->numberOfVertices = mesh.mNumVertices;
+	subMesh->numberOfIndices = mesh.mNumFaces * kNumberOfIndicesInFace;
+	subMesh->materialIndex = mesh.mMaterialIndex;
+
+	// Kept in system memory so the buffers can be made again if they're evicted.
+	subMesh->vertexData.assign(vertices, vertices + mesh.mNumVertices);
+	subMesh->indexData.swap(allIndices);
+
+	delete[] vertices;
+	vertices = nullptr;
+	delete[] indices;
+	indices = nullptr;
+
+	return CreateSubMeshBuffers(subMesh);
+}
 
+/* Makes whichever of the vertex and index buffers of a submesh don't exist, from the copy of the geometry kept in system memory.
+* They're registered with the memory tracker as streamable, so they may be evicted again while the mesh isn't drawn.
+* @Returns bool Success
+*/
+bool CMesh::CreateSubMeshBuffers(SubMesh* subMesh)
+{
 	HRESULT result;
 
 	D3D11_BUFFER_DESC bufferDesc;
 	D3D11_SUBRESOURCE_DATA initData;
 	bufferDesc.Usage = D3D11_USAGE_DEFAULT;
-	bufferDesc.ByteWidth = offset * subMesh->numberOfVertices;
-	bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
 	bufferDesc.CPUAccessFlags = 0;
 	bufferDesc.MiscFlags = 0;
+	bufferDesc.StructureByteStride = 0;
+	initData.SysMemPitch = 0;
+	initData.SysMemSlicePitch = 0;
 
-	initData.pSysMem = &vertices[0];
-	result = mpDevice->CreateBuffer(&bufferDesc, &initData, &subMesh->vertexBuffer);
+	if (subMesh->vertexBuffer == nullptr)
+	{
+		bufferDesc.ByteWidth = static_cast<unsigned int>(sizeof(VertexType) * subMesh->vertexData.size());
+		bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		initData.pSysMem = subMesh->vertexData.data();
 
-	if (FAILED(result))
+		result = mpDevice->CreateBuffer(&bufferDesc, &initData, &subMesh->vertexBuffer);
+		if (FAILED(result))
+		{
+			logger->GetInstance().WriteLine("Failed to create the vertex buffer for mesh '" + mFilename + "'.");
+			subMesh->vertexBuffer = nullptr;
+			return false;
+		}
+		CGpuMemoryTracker::GetInstance().Register(subMesh->vertexBuffer, CGpuMemoryTracker::Meshes, bufferDesc.ByteWidth, this);
+	}
+
+	if (subMesh->indexBuffer == nullptr)
 	{
-		logger->GetInstance().WriteLine("Failed to create the vertex buffer for mesh.");
-		return false;
+		bufferDesc.ByteWidth = static_cast<unsigned int>(sizeof(unsigned int) * subMesh->indexData.size());
+		bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+		initData.pSysMem = subMesh->indexData.data();
+
+		result = mpDevice->CreateBuffer(&bufferDesc, &initData, &subMesh->indexBuffer);
+		if (FAILED(result))
+		{
+			logger->GetInstance().WriteLine("Failed to create the index buffer for mesh '" + mFilename + "'.");
+			subMesh->indexBuffer = nullptr;
+			return false;
+		}
+		CGpuMemoryTracker::GetInstance().Register(subMesh->indexBuffer, CGpuMemoryTracker::Meshes, bufferDesc.ByteWidth, this);
 	}
 
-	bufferDesc.Usage = D3D11_USAGE_DEFAULT;
-	bufferDesc.ByteWidth = sizeof(unsigned int) * subMesh->numberOfIndices;
-	bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	bufferDesc.CPUAccessFlags = 0;
-	bufferDesc.MiscFlags = 0;
+	return true;
+}
 
-	initData.pSysMem = &indices[0];
+/* Loads one map of a material from the file it was first loaded from, and registers it with the memory tracker as streamable.
+* @Returns bool Success
+*/
+bool CMesh::LoadMaterialTexture(unsigned int material, unsigned int texture)
+{
+	ID3D11ShaderResourceView*& map = mSubMeshMaterials[material].mTextures[texture];
 
-	result = mpDevice->CreateBuffer(&bufferDesc, &initData, &subMesh->indexBuffer);
-	if (FAILED(result))
+	if (FAILED(mpDevice->CreateTextureFromFile(mSubMeshMaterials[material].mFilenames[texture], &map)))
 	{
-		logger->GetInstance().WriteLine("Failed to create the vertex buffer for mesh.");
+		map = nullptr;
 		return false;
 	}
 
-	delete[] vertices;
-	vertices = nullptr;
-	delete[] indices;
-	indices = nullptr;
+	CGpuMemoryTracker::GetInstance().Register(map, CGpuMemoryTracker::Textures, mpDevice->GetTextureMemory(map), this);
 
 	return true;
+}
+
+/* Makes again anything evicted which the submeshes gathered for a pass need, and marks all of it as used this frame.
+* Only the render thread reads the maps, the gather threads sort by material without touching them.
+* @Returns bool Success, fails if a buffer couldn't be made. A map which can't be loaded is left out, as when the mesh was first loaded.
+*/
+bool CMesh::MakeResident(CRenderQueue::PassType pass)
+{
+	CGpuMemoryTracker& tracker = CGpuMemoryTracker::GetInstance();
+
+	for (unsigned int subMeshCount = 0; subMeshCount < mNumberOfSubMeshes; subMeshCount++)
+	{
+		const bool drawInstances = !mPasses[pass].instanceBatch.GetDraws(subMeshCount).empty();
+		const bool drawCells = mStaticBatching && mStaticBatcher.HasVisibleGeometry(pass, subMeshCount);
+
+		if (!drawInstances && !drawCells)
+		{
+			continue;
+		}
+
+		SubMesh& subMesh = mpSubMeshes[subMeshCount];
+
+		// Static batch cells have buffers of their own.
+		if (drawInstances)
+		{
+			if (!CreateSubMeshBuffers(&subMesh))
+			{
+				return false;
+			}
+
+			tracker.Touch(subMesh.vertexBuffer);
+			tracker.Touch(subMesh.indexBuffer);
+		}
+
+		MaterialType& material = mSubMeshMaterials[subMesh.materialIndex];
+
+		for (unsigned int texture = 0; texture < mNumberOfTextures; texture++)
+		{
+			if (material.mFilenames[texture].empty())
+			{
+				continue;
+			}
+
+			if (material.mTextures[texture] == nullptr && !LoadMaterialTexture(subMesh.materialIndex, texture))
+			{
+				logger->GetInstance().WriteLine("Failed to reload " + material.mFilenames[texture] + " for mesh '" + mFilename + "'.");
+				continue;
+			}
+
+			tracker.Touch(material.mTextures[texture]);
+		}
+	}
+
+	return true;
+}
+
+/* Releases a buffer or texture map the memory tracker has chosen to evict. MakeResident makes it again the next time it's drawn.
+* Only safe while no pass of this mesh is being gathered or drawn.
+* @Returns bool Success, fails if the resource doesn't belong to this mesh.
+*/
+bool CMesh::Evict(const void* resource)
+{
+	for (unsigned int subMeshCount = 0; subMeshCount < mNumberOfSubMeshes; subMeshCount++)
+	{
+		ID3D11Buffer** buffers[2] = { &mpSubMeshes[subMeshCount].vertexBuffer, &mpSubMeshes[subMeshCount].indexBuffer };
+
+		for (auto buffer : buffers)
+		{
+			if (*buffer != nullptr && *buffer == resource)
+			{
+				CGpuMemoryTracker::GetInstance().Unregister(*buffer);
+				mpDevice->ReleaseResource(*buffer);
+				*buffer = nullptr;
+				return true;
+			}
+		}
+	}
+
+	for (unsigned int material = 0; material < mNumberOfSubMeshes; material++)
+	{
+		for (unsigned int texture = 0; texture < mNumberOfTextures; texture++)
+		{
+			ID3D11ShaderResourceView*& map = mSubMeshMaterials[material].mTextures[texture];
+
+			if (map != nullptr && map == resource)
+			{
+				CGpuMemoryTracker::GetInstance().Unregister(map);
+				mpDevice->ReleaseResource(map);
+				map = nullptr;
+				return true;
+			}
+		}
+	}
+
+	return false;
 }
\ No newline at end of file
@@ -18,10 +18,26 @@
 #include <postprocess.h>
 #include "PrioEngineVars.h"
 #include "Frustum.h"
+#include "MeshletBuilder.h"
+#include "MeshletCuller.h"
+#include "InstanceBatch.h"
+#include "RenderQueue.h"
+#include "StaticBatcher.h"
+#include "ModelPool.h"
+#include "BoundingVolume.h"
+#include "MeshSimplifier.h"
+#include "DistanceCuller.h"
+#include "GpuMemoryTracker.h"
+
+class CHorizonCuller;
+class CVisibilityCache;
 
 const int mNumberOfTextures = 3;
 
-class CMesh
+/* The vertex and index buffers and the texture maps of a mesh are streamable, the memory tracker may evict them while the mesh isn't being drawn.
+* They're made again from the copy of the geometry kept in system memory, and from the texture files, the next time the mesh is drawn.
+*/
+class CMesh : public CStreamable
 {
 private:
 	CLogger* logger;
@@ -29,9 +45,15 @@ private:
 	// File strings
 	std::string mFilename;
 	float mRadius;
+	// Tight bounds around every vertex of the mesh, in model space.
+	CBoundingVolume::BoundsType mBounds;
+	// The draw distance, screen size and thinning settings of this mesh.
+	CDistanceCuller mDistanceCuller;
 
-	// A list of the instance of models belonging to this mesh.
-	std::list<CModel*> mpModels;
+	// The transforms of every model, only those which have changed are rebuilt each frame.
+	CTransformStore mTransforms;
+	// The instances of models belonging to this mesh, kept together in slabs.
+	CModelPool mModelPool;
 
 	struct VertexType
 	{
@@ -43,6 +65,8 @@ private:
 	struct MaterialType
 	{
 		ID3D11ShaderResourceView* mTextures[mNumberOfTextures];
+		// Where each map was loaded from, so it can be loaded again after being evicted. Empty if the material doesn't have the map.
+		std::string mFilenames[mNumberOfTextures];
 	};
 
 	// Arrays to store data about vertices in.
@@ -54,22 +78,96 @@ private:
 		aiVector3D* vertices;
 		ID3D11Buffer* vertexBuffer;
 		ID3D11Buffer* indexBuffer;
+		// What the buffers hold, kept so they can be made again after being evicted.
+		std::vector<VertexType> vertexData;
+		std::vector<unsigned int> indexData;
 		aiFace* faces;
+		// Clusters of triangles which can be culled on their own.
+		std::vector<CMeshletBuilder::MeshletType> meshlets;
+		CBoundingVolume::BoundsType bounds;
+		// Where each detail level sits in the index buffer, level 0 is the full detail mesh.
+		std::vector<CInstanceBatch::RangeType> levels;
+	};
+
+	// Each detail level after the first aims for half the triangles of the one before.
+	static const unsigned int kNumberOfLevels = 4;
+	// A level is only kept if it removes at least this fraction of the triangles of the level before.
+	const float kMinimumLevelReduction = 0.1f;
+	// Move to the next level once the bounding sphere's radius over its distance from the camera drops below each of these.
+	const float kLevelScreenSizes[kNumberOfLevels - 1] = { 0.08f, 0.04f, 0.02f };
+	// Multiplies the screen sizes above, set between frames, never while a pass is being gathered.
+	float mDetailBias;
+	unsigned int SelectLevel(D3DXVECTOR3 centre, float radius, D3DXVECTOR3 cameraPosition);
+
+	// Submeshes with fewer meshlets than this are always drawn whole.
+	const unsigned int kMinimumMeshletsToCull = 4;
+	const unsigned int kInitialInstanceBufferCapacity = 64;
+	std::vector<unsigned int> mSubMeshIndexCounts;
+	std::vector<std::vector<CInstanceBatch::RangeType>> mSubMeshLevels;
+
+	// Everything gathered for one pass. Each pass has its own, so the passes can be gathered on different threads at once.
+	struct PassDataType
+	{
+		PassDataType() : instanceBuffer(nullptr), instanceBufferCapacity(0), uploaded(false), nearestInstanceDistance(0.0f), identityInstance(0) {};
+
+		CMeshletCuller meshletCuller;
+		std::vector<CMeshletCuller::IndexRangeType> visibleRanges;
+		// The visible instances, and the buffer they are copied into.
+		CInstanceBatch instanceBatch;
+		ID3D11Buffer* instanceBuffer;
+		unsigned int instanceBufferCapacity;
+		// Whether the instance buffer holds what was last gathered, nothing is drawn if the upload failed.
+		bool uploaded;
+		float nearestInstanceDistance;
+		// The instance holding the identity matrix the merged cells are drawn with, only valid when cells are visible.
+		unsigned int identityInstance;
 	};
+	PassDataType mPasses[CRenderQueue::kNumberOfPasses];
+
+	// When static batching is on, every model of this mesh is merged into the cell it sits in instead of being instanced.
+	CStaticBatcher mStaticBatcher;
+	bool mStaticBatching;
 
-	ID3D11Device* mpDevice;
+	CRenderDevice* mpDevice;
 	SubMesh* mpSubMeshes;
 	unsigned int mNumberOfSubMeshes;
 	bool CreateSubmesh(const aiMesh& mesh, SubMesh* subMesh);
+	bool CreateSubMeshBuffers(SubMesh* subMesh);
+	bool LoadMaterialTexture(unsigned int material, unsigned int texture);
+	bool MakeResident(CRenderQueue::PassType pass);
+	void GatherInstance(PassDataType& passData, const D3DXMATRIX& world, D3DXVECTOR3 centre, float radius, CFrustum* frustum, const D3DXVECTOR3* viewPosition);
+	bool GatherStaticBatches(CRenderQueue::PassType pass, CFrustum* frustum, CHorizonCuller* horizon, D3DXVECTOR3 cameraPosition);
 public:
-	CMesh(ID3D11Device* device);
+	CMesh(CRenderDevice* device);
 	~CMesh();
 
 	// Loads data from file into our mesh object.
-	CModel* CreateModel();
+	CModel* CreateModel(CModelPool::HandleType* handle = nullptr);
+	bool CreateModels(unsigned int count, const CModelPool::TransformType* transforms, CModelPool::HandleType* handles = nullptr);
+	bool DestroyModel(CModelPool::HandleType handle);
+	CModel* GetModel(CModelPool::HandleType handle) { return mModelPool.Get(handle); };
+	unsigned int GetNumberOfModels() { return mModelPool.GetNumberOfModels(); };
 	bool LoadMesh(std::string filename, float modelRadius = 1.0f);
+	void EnableStaticBatching(float cellSize);
+	void SetDetailBias(float bias) { mDetailBias = bias; };
 
-	void Render(ID3D11DeviceContext* context, CFrustum* frustum, CDiffuseLightShader* shader, CLight* light);
+	void UpdateTransforms();
+	bool UpdateStaticBatches();
+	bool Gather(CRenderQueue::PassType pass, CFrustum* frustum, CHorizonCuller* horizon, CVisibilityCache* visibilityCache, D3DXVECTOR3 cameraPosition, bool cullBackFaces);
+	bool UploadInstances(CRenderDevice* device, CRenderQueue::PassType pass);
+	void Submit(CRenderQueue* queue, CRenderQueue::PassType pass);
+	unsigned int RenderSubMesh(CRenderDevice* device, CDiffuseLightShader* shader, CRenderQueue::PassType pass, unsigned int subMesh, bool bindMaterial);
+	ID3D11ShaderResourceView** GetSubMeshTextures(unsigned int subMesh);
+	float GetNearestInstanceDistance(CRenderQueue::PassType pass = CRenderQueue::Main) { return mPasses[pass].nearestInstanceDistance; };
+	CMeshletCuller* GetMeshletCuller(CRenderQueue::PassType pass = CRenderQueue::Main) { return &mPasses[pass].meshletCuller; };
+	std::string GetFilename() { return mFilename; };
+	CTransformStore* GetTransformStore() { return &mTransforms; };
+	const CBoundingVolume::BoundsType& GetBounds() { return mBounds; };
+	CDistanceCuller* GetDistanceCuller() { return &mDistanceCuller; };
+	CInstanceBatch* GetInstanceBatch(CRenderQueue::PassType pass = CRenderQueue::Main) { return &mPasses[pass].instanceBatch; };
+	CStaticBatcher* GetStaticBatcher() { return &mStaticBatcher; };
+	bool IsStaticBatched() { return mStaticBatching; };
+	bool Evict(const void* resource);
 	void Shutdown();
 private:
 	bool LoadAssimpModel(std::string filename);
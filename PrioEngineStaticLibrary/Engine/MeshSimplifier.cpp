@@ -0,0 +1,330 @@
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <unordered_map>
+#include <cmath>
+
+CMeshSimplifier::CMeshSimplifier()
+{
+	mpPositions = nullptr;
+	mLiveTriangles = 0;
+	mError = 0.0f;
+}
+
+CMeshSimplifier::~CMeshSimplifier()
+{
+}
+
+/* Collapses edges until no more than the target number of indices are left, or no collapse remains which wouldn't damage the mesh.
+* @PARAM std::vector<unsigned int>& result - Filled with the simplified triangle list, which indexes the same vertices as the input.
+* @Returns bool Success
+*/
+bool CMeshSimplifier::Simplify(const D3DXVECTOR3* positions, unsigned int numberOfVertices, const unsigned int* indices, unsigned int numberOfIndices, unsigned int targetNumberOfIndices, std::vector<unsigned int>& result)
+{
+	result.clear();
+	mError = 0.0f;
+
+	if (numberOfIndices % 3 != 0)
+	{
+		logger->GetInstance().WriteLine("Can only simplify triangle lists, the number of indices must be a multiple of three.");
+		return false;
+	}
+
+	const unsigned int numberOfTriangles = numberOfIndices / 3;
+
+	mpPositions = positions;
+	mTriangles.assign(indices, indices + numberOfIndices);
+	mTriangleAlive.assign(numberOfTriangles, true);
+	mVertexTriangles.assign(numberOfVertices, std::vector<unsigned int>());
+	mLocked.assign(numberOfVertices, false);
+	mVersions.assign(numberOfVertices, 0);
+	mHeap.clear();
+	mLiveTriangles = numberOfTriangles;
+
+	QuadricType emptyQuadric = { { 0.0 } };
+	mQuadrics.assign(numberOfVertices, emptyQuadric);
+
+	/////////////////////////////
+	// Sum the planes of the triangles around each vertex, weighted by area.
+	/////////////////////////////
+
+	for (unsigned int triangle = 0; triangle < numberOfTriangles; triangle++)
+	{
+		const unsigned int* corners = &mTriangles[triangle * 3];
+
+		if (corners[0] >= numberOfVertices || corners[1] >= numberOfVertices || corners[2] >= numberOfVertices)
+		{
+			logger->GetInstance().WriteLine("Can't simplify a mesh with an index which is out of range.");
+			return false;
+		}
+
+		D3DXVECTOR3 edge1 = positions[corners[1]] - positions[corners[0]];
+		D3DXVECTOR3 edge2 = positions[corners[2]] - positions[corners[0]];
+		D3DXVECTOR3 normal;
+		D3DXVec3Cross(&normal, &edge1, &edge2);
+
+		for (unsigned int corner = 0; corner < 3; corner++)
+		{
+			mVertexTriangles[corners[corner]].push_back(triangle);
+		}
+
+		float length = D3DXVec3Length(&normal);
+		if (length <= 0.0f)
+		{
+			continue;
+		}
+
+		normal /= length;
+		double d = -static_cast<double>(D3DXVec3Dot(&normal, &positions[corners[0]]));
+
+		for (unsigned int corner = 0; corner < 3; corner++)
+		{
+			AddPlane(mQuadrics[corners[corner]], normal.x, normal.y, normal.z, d, length * 0.5);
+		}
+	}
+
+	/////////////////////////////
+	// Lock the vertices on open edges, then queue a collapse for every edge.
+	/////////////////////////////
+
+	std::unordered_map<unsigned long long, unsigned int> edgeUses;
+	edgeUses.reserve(numberOfIndices);
+
+	for (unsigned int index = 0; index < numberOfIndices; index++)
+	{
+		unsigned int first = mTriangles[index];
+		unsigned int second = mTriangles[index - index % 3 + (index + 1) % 3];
+		unsigned int low = first < second ? first : second;
+		unsigned int high = first < second ? second : first;
+
+		edgeUses[(static_cast<unsigned long long>(low) << 32) | high]++;
+	}
+
+	for (auto& edge : edgeUses)
+	{
+		if (edge.second == 1)
+		{
+			mLocked[static_cast<unsigned int>(edge.first >> 32)] = true;
+			mLocked[static_cast<unsigned int>(edge.first & 0xFFFFFFFF)] = true;
+		}
+	}
+
+	for (auto& edge : edgeUses)
+	{
+		PushCollapse(static_cast<unsigned int>(edge.first >> 32), static_cast<unsigned int>(edge.first & 0xFFFFFFFF));
+	}
+
+	/////////////////////////////
+	// Take the cheapest collapse until we reach the target.
+	/////////////////////////////
+
+	while (mLiveTriangles * 3 > targetNumberOfIndices && !mHeap.empty())
+	{
+		std::pop_heap(mHeap.begin(), mHeap.end());
+		CollapseType collapse = mHeap.back();
+		mHeap.pop_back();
+
+		// Either end has changed since this was queued, a newer entry will have been pushed if it's still an edge.
+		if (collapse.fromVersion != mVersions[collapse.from] || collapse.toVersion != mVersions[collapse.to])
+		{
+			continue;
+		}
+
+		if (CollapseFlipsTriangle(collapse.from, collapse.to))
+		{
+			continue;
+		}
+
+		mError = collapse.cost > mError ? collapse.cost : mError;
+		Collapse(collapse.from, collapse.to);
+	}
+
+	result.reserve(mLiveTriangles * 3);
+	for (unsigned int triangle = 0; triangle < numberOfTriangles; triangle++)
+	{
+		if (mTriangleAlive[triangle])
+		{
+			result.push_back(mTriangles[triangle * 3]);
+			result.push_back(mTriangles[triangle * 3 + 1]);
+			result.push_back(mTriangles[triangle * 3 + 2]);
+		}
+	}
+
+	return true;
+}
+
+void CMeshSimplifier::AddPlane(QuadricType& quadric, double a, double b, double c, double d, double weight)
+{
+	quadric.values[0] += weight * a * a;
+	quadric.values[1] += weight * a * b;
+	quadric.values[2] += weight * a * c;
+	quadric.values[3] += weight * a * d;
+	quadric.values[4] += weight * b * b;
+	quadric.values[5] += weight * b * c;
+	quadric.values[6] += weight * b * d;
+	quadric.values[7] += weight * c * c;
+	quadric.values[8] += weight * c * d;
+	quadric.values[9] += weight * d * d;
+}
+
+/* The error of moving to a point, measured against the sum of two quadrics. */
+double CMeshSimplifier::Evaluate(const QuadricType& first, const QuadricType& second, const D3DXVECTOR3& point)
+{
+	double q[10];
+	for (int value = 0; value < 10; value++)
+	{
+		q[value] = first.values[value] + second.values[value];
+	}
+
+	const double x = point.x;
+	const double y = point.y;
+	const double z = point.z;
+
+	double error = q[0] * x * x + 2.0 * q[1] * x * y + 2.0 * q[2] * x * z + 2.0 * q[3] * x
+		+ q[4] * y * y + 2.0 * q[5] * y * z + 2.0 * q[6] * y
+		+ q[7] * z * z + 2.0 * q[8] * z
+		+ q[9];
+
+	// Rounding can take an error which should be zero just below it.
+	return error > 0.0 ? error : 0.0;
+}
+
+/* Queues the cheaper direction of collapsing an edge, locked vertices can be collapsed onto but never moved. */
+void CMeshSimplifier::PushCollapse(unsigned int first, unsigned int second)
+{
+	if (first == second || (mLocked[first] && mLocked[second]))
+	{
+		return;
+	}
+
+	CollapseType collapse;
+
+	double firstOntoSecond = mLocked[first] ? -1.0 : Evaluate(mQuadrics[first], mQuadrics[second], mpPositions[second]);
+	double secondOntoFirst = mLocked[second] ? -1.0 : Evaluate(mQuadrics[first], mQuadrics[second], mpPositions[first]);
+
+	if (secondOntoFirst < 0.0 || (firstOntoSecond >= 0.0 && firstOntoSecond <= secondOntoFirst))
+	{
+		collapse.from = first;
+		collapse.to = second;
+		collapse.cost = static_cast<float>(firstOntoSecond);
+	}
+	else
+	{
+		collapse.from = second;
+		collapse.to = first;
+		collapse.cost = static_cast<float>(secondOntoFirst);
+	}
+
+	collapse.fromVersion = mVersions[collapse.from];
+	collapse.toVersion = mVersions[collapse.to];
+
+	mHeap.push_back(collapse);
+	std::push_heap(mHeap.begin(), mHeap.end());
+}
+
+/* Whether moving a vertex would turn any of the triangles around it over, which would leave a visible crease. */
+bool CMeshSimplifier::CollapseFlipsTriangle(unsigned int from, unsigned int to)
+{
+	for (auto triangle : mVertexTriangles[from])
+	{
+		if (!mTriangleAlive[triangle])
+		{
+			continue;
+		}
+
+		const unsigned int* corners = &mTriangles[triangle * 3];
+
+		// Triangles along the edge disappear, so can't flip.
+		if (corners[0] == to || corners[1] == to || corners[2] == to)
+		{
+			continue;
+		}
+
+		D3DXVECTOR3 before[3];
+		D3DXVECTOR3 after[3];
+		for (unsigned int corner = 0; corner < 3; corner++)
+		{
+			before[corner] = mpPositions[corners[corner]];
+			after[corner] = corners[corner] == from ? mpPositions[to] : before[corner];
+		}
+
+		D3DXVECTOR3 edge1 = before[1] - before[0];
+		D3DXVECTOR3 edge2 = before[2] - before[0];
+		D3DXVECTOR3 normalBefore;
+		D3DXVec3Cross(&normalBefore, &edge1, &edge2);
+
+		edge1 = after[1] - after[0];
+		edge2 = after[2] - after[0];
+		D3DXVECTOR3 normalAfter;
+		D3DXVec3Cross(&normalAfter, &edge1, &edge2);
+
+		if (D3DXVec3Dot(&normalBefore, &normalAfter) <= 0.0f)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Moves every triangle using one vertex over to another, dropping the triangles which shared the edge between them. */
+void CMeshSimplifier::Collapse(unsigned int from, unsigned int to)
+{
+	for (auto triangle : mVertexTriangles[from])
+	{
+		if (!mTriangleAlive[triangle])
+		{
+			continue;
+		}
+
+		unsigned int* corners = &mTriangles[triangle * 3];
+
+		if (corners[0] == to || corners[1] == to || corners[2] == to)
+		{
+			mTriangleAlive[triangle] = false;
+			mLiveTriangles--;
+			continue;
+		}
+
+		for (unsigned int corner = 0; corner < 3; corner++)
+		{
+			if (corners[corner] == from)
+			{
+				corners[corner] = to;
+				mVertexTriangles[to].push_back(triangle);
+			}
+		}
+	}
+
+	mVertexTriangles[from].clear();
+
+	for (int value = 0; value < 10; value++)
+	{
+		mQuadrics[to].values[value] += mQuadrics[from].values[value];
+	}
+
+	// Anything queued for either vertex is now out of date.
+	mVersions[from]++;
+	mVersions[to]++;
+
+	// The vertex which was moved is gone, so make sure nothing can be collapsed onto it again.
+	mLocked[from] = true;
+
+	// Drop the triangles which went and any we were given twice, so the list doesn't keep growing.
+	std::vector<unsigned int>& around = mVertexTriangles[to];
+	around.erase(std::remove_if(around.begin(), around.end(), [this](unsigned int triangle) { return !mTriangleAlive[triangle]; }), around.end());
+	std::sort(around.begin(), around.end());
+	around.erase(std::unique(around.begin(), around.end()), around.end());
+
+	for (auto triangle : around)
+	{
+		if (!mTriangleAlive[triangle])
+		{
+			continue;
+		}
+
+		for (unsigned int corner = 0; corner < 3; corner++)
+		{
+			PushCollapse(to, mTriangles[triangle * 3 + corner]);
+		}
+	}
+}
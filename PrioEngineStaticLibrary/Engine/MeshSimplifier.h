@@ -0,0 +1,63 @@
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+
+#include <D3DX10math.h>
+#include <vector>
+#include "PrioEngineVars.h"
+
+/* Builds lower detail versions of a triangle list by collapsing edges, picking the cheapest collapse each time using quadric error metrics.
+* Vertices are only ever collapsed onto other existing vertices, so the simplified indices can share the original vertex buffer.
+* Vertices on an open edge, which includes texture seams, are never moved so the outline and the UVs stay intact.
+* This has no device dependencies, so it can be run and checked on the CPU alone.
+*/
+class CMeshSimplifier
+{
+private:
+	CLogger* logger;
+public:
+	CMeshSimplifier();
+	~CMeshSimplifier();
+public:
+	bool Simplify(const D3DXVECTOR3* positions, unsigned int numberOfVertices, const unsigned int* indices, unsigned int numberOfIndices, unsigned int targetNumberOfIndices, std::vector<unsigned int>& result);
+
+	// The largest quadric error of any collapse made by the last call to Simplify.
+	float GetError() { return mError; };
+private:
+	// The upper triangle of a symmetric 4x4 matrix: aa, ab, ac, ad, bb, bc, bd, cc, cd, dd.
+	struct QuadricType
+	{
+		double values[10];
+	};
+
+	struct CollapseType
+	{
+		float cost;
+		unsigned int from;
+		unsigned int to;
+		unsigned int fromVersion;
+		unsigned int toVersion;
+
+		// Reversed so the standard priority queue hands out the cheapest collapse first.
+		bool operator<(const CollapseType& other) const { return cost > other.cost; };
+	};
+
+	static void AddPlane(QuadricType& quadric, double a, double b, double c, double d, double weight);
+	static double Evaluate(const QuadricType& first, const QuadricType& second, const D3DXVECTOR3& point);
+
+	void PushCollapse(unsigned int first, unsigned int second);
+	bool CollapseFlipsTriangle(unsigned int from, unsigned int to);
+	void Collapse(unsigned int from, unsigned int to);
+
+	const D3DXVECTOR3* mpPositions;
+	std::vector<unsigned int> mTriangles;
+	std::vector<bool> mTriangleAlive;
+	std::vector<std::vector<unsigned int>> mVertexTriangles;
+	std::vector<QuadricType> mQuadrics;
+	std::vector<bool> mLocked;
+	std::vector<unsigned int> mVersions;
+	std::vector<CollapseType> mHeap;
+	unsigned int mLiveTriangles;
+	float mError;
+};
+
+#endif
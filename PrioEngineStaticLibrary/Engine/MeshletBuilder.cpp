@@ -0,0 +1,261 @@
+#include "MeshletBuilder.h"
+
+CMeshletBuilder::CMeshletBuilder()
+{
+}
+
+CMeshletBuilder::~CMeshletBuilder()
+{
+}
+
+/* Groups the triangles of an indexed triangle list into meshlets.
+* The index buffer is reordered in place so that every meshlet is a contiguous range of it.
+* @PARAM const D3DXVECTOR3* positions - The position of every vertex.
+* @PARAM unsigned int* indices - The triangle list, will be reordered.
+* @PARAM std::vector<MeshletType>& meshlets - Filled with the meshlets that were built.
+* @Returns bool Success
+*/
+bool CMeshletBuilder::Build(const D3DXVECTOR3* positions, unsigned int numberOfVertices, unsigned int* indices, unsigned int numberOfIndices, std::vector<MeshletType>& meshlets)
+{
+	meshlets.clear();
+
+	const unsigned int numberOfTriangles = numberOfIndices / 3;
+
+	if (numberOfTriangles == 0)
+	{
+		return true;
+	}
+
+	for (unsigned int i = 0; i < numberOfTriangles * 3; i++)
+	{
+		if (indices[i] >= numberOfVertices)
+		{
+			logger->GetInstance().WriteLine("Found an index outside of the vertex buffer while building meshlets.");
+			return false;
+		}
+	}
+
+	/////////////////////////////
+	// Find which triangles use each vertex.
+	/////////////////////////////
+
+	std::vector<unsigned int> triangleOffsets(numberOfVertices + 1, 0);
+
+	for (unsigned int i = 0; i < numberOfTriangles * 3; i++)
+	{
+		triangleOffsets[indices[i] + 1]++;
+	}
+
+	for (unsigned int vertex = 0; vertex < numberOfVertices; vertex++)
+	{
+		triangleOffsets[vertex + 1] += triangleOffsets[vertex];
+	}
+
+	std::vector<unsigned int> vertexTriangles(numberOfTriangles * 3);
+	std::vector<unsigned int> fillCount(triangleOffsets.begin(), triangleOffsets.end() - 1);
+
+	for (unsigned int triangle = 0; triangle < numberOfTriangles; triangle++)
+	{
+		for (unsigned int corner = 0; corner < 3; corner++)
+		{
+			const unsigned int vertex = indices[triangle * 3 + corner];
+			vertexTriangles[fillCount[vertex]] = triangle;
+			fillCount[vertex]++;
+		}
+	}
+
+	/////////////////////////////
+	// Grow meshlets out from a seed triangle, through triangles which share a vertex.
+	/////////////////////////////
+
+	std::vector<unsigned int> reordered;
+	reordered.reserve(numberOfTriangles * 3);
+
+	std::vector<bool> assigned(numberOfTriangles, false);
+	// Stores which meshlet last used each vertex, so we can count the unique vertices cheaply.
+	std::vector<unsigned int> vertexStamp(numberOfVertices, 0xFFFFFFFF);
+	std::vector<unsigned int> frontier;
+
+	unsigned int meshletNumber = 0;
+
+	for (unsigned int seed = 0; seed < numberOfTriangles; seed++)
+	{
+		if (assigned[seed])
+		{
+			continue;
+		}
+
+		MeshletType meshlet;
+		meshlet.startIndex = static_cast<unsigned int>(reordered.size());
+		meshlet.indexCount = 0;
+
+		unsigned int meshletVertices = 0;
+		unsigned int meshletTriangles = 0;
+
+		frontier.clear();
+		frontier.push_back(seed);
+		size_t next = 0;
+
+		while (next < frontier.size() && meshletTriangles < kMaxMeshletTriangles)
+		{
+			const unsigned int triangle = frontier[next];
+			next++;
+
+			if (assigned[triangle])
+			{
+				continue;
+			}
+
+			// Count the vertices this triangle would add to the meshlet.
+			unsigned int newVertices = 0;
+			for (unsigned int corner = 0; corner < 3; corner++)
+			{
+				if (vertexStamp[indices[triangle * 3 + corner]] != meshletNumber)
+				{
+					newVertices++;
+				}
+			}
+
+			if (meshletVertices + newVertices > kMaxMeshletVertices)
+			{
+				continue;
+			}
+
+			assigned[triangle] = true;
+			meshletTriangles++;
+
+			for (unsigned int corner = 0; corner < 3; corner++)
+			{
+				const unsigned int vertex = indices[triangle * 3 + corner];
+
+				if (vertexStamp[vertex] != meshletNumber)
+				{
+					vertexStamp[vertex] = meshletNumber;
+					meshletVertices++;
+				}
+
+				reordered.push_back(vertex);
+
+				// Queue up the neighbours of this triangle.
+				for (unsigned int i = triangleOffsets[vertex]; i < triangleOffsets[vertex + 1]; i++)
+				{
+					if (!assigned[vertexTriangles[i]])
+					{
+						frontier.push_back(vertexTriangles[i]);
+					}
+				}
+			}
+		}
+
+		meshlet.indexCount = static_cast<unsigned int>(reordered.size()) - meshlet.startIndex;
+		meshlets.push_back(meshlet);
+		meshletNumber++;
+	}
+
+	// Copy the new triangle order back over the original.
+	for (unsigned int i = 0; i < numberOfTriangles * 3; i++)
+	{
+		indices[i] = reordered[i];
+	}
+
+	for (auto& meshlet : meshlets)
+	{
+		CalculateBounds(positions, indices, meshlet);
+	}
+
+	return true;
+}
+
+/* Works out the bounding sphere and normal cone of a single meshlet. */
+void CMeshletBuilder::CalculateBounds(const D3DXVECTOR3* positions, const unsigned int* indices, MeshletType& meshlet)
+{
+	const unsigned int endIndex = meshlet.startIndex + meshlet.indexCount;
+
+	/////////////////////////////
+	// Bounding sphere
+	/////////////////////////////
+
+	D3DXVECTOR3 minPoint = positions[indices[meshlet.startIndex]];
+	D3DXVECTOR3 maxPoint = minPoint;
+
+	for (unsigned int i = meshlet.startIndex; i < endIndex; i++)
+	{
+		const D3DXVECTOR3& position = positions[indices[i]];
+
+		minPoint.x = position.x < minPoint.x ? position.x : minPoint.x;
+		minPoint.y = position.y < minPoint.y ? position.y : minPoint.y;
+		minPoint.z = position.z < minPoint.z ? position.z : minPoint.z;
+		maxPoint.x = position.x > maxPoint.x ? position.x : maxPoint.x;
+		maxPoint.y = position.y > maxPoint.y ? position.y : maxPoint.y;
+		maxPoint.z = position.z > maxPoint.z ? position.z : maxPoint.z;
+	}
+
+	meshlet.centre = (minPoint + maxPoint) * 0.5f;
+	meshlet.radius = 0.0f;
+
+	for (unsigned int i = meshlet.startIndex; i < endIndex; i++)
+	{
+		D3DXVECTOR3 offset = positions[indices[i]] - meshlet.centre;
+		float distance = D3DXVec3Length(&offset);
+
+		if (distance > meshlet.radius)
+		{
+			meshlet.radius = distance;
+		}
+	}
+
+	/////////////////////////////
+	// Normal cone
+	/////////////////////////////
+
+	std::vector<D3DXVECTOR3> normals;
+	normals.reserve(meshlet.indexCount / 3);
+
+	D3DXVECTOR3 averageNormal = D3DXVECTOR3(0.0f, 0.0f, 0.0f);
+
+	for (unsigned int i = meshlet.startIndex; i + 2 < endIndex; i += 3)
+	{
+		D3DXVECTOR3 edge1 = positions[indices[i + 1]] - positions[indices[i]];
+		D3DXVECTOR3 edge2 = positions[indices[i + 2]] - positions[indices[i]];
+		D3DXVECTOR3 normal;
+		D3DXVec3Cross(&normal, &edge1, &edge2);
+
+		float length = D3DXVec3Length(&normal);
+
+		// Degenerate triangles can't be seen from any side, so they don't affect the cone.
+		if (length > 0.0f)
+		{
+			normal /= length;
+			normals.push_back(normal);
+			averageNormal += normal;
+		}
+	}
+
+	meshlet.coneAxis = D3DXVECTOR3(0.0f, 0.0f, 0.0f);
+	meshlet.coneCutoff = 1.0f;
+
+	float averageLength = D3DXVec3Length(&averageNormal);
+
+	if (normals.empty() || averageLength <= 0.0f)
+	{
+		return;
+	}
+
+	meshlet.coneAxis = averageNormal / averageLength;
+
+	// Find the widest angle between the axis and any triangle.
+	float minimumDot = 1.0f;
+	for (auto& normal : normals)
+	{
+		float dot = D3DXVec3Dot(&normal, &meshlet.coneAxis);
+		minimumDot = dot < minimumDot ? dot : minimumDot;
+	}
+
+	// If the triangles spread over more than a hemisphere, some of them will always face the camera.
+	if (minimumDot <= 0.0f)
+	{
+		return;
+	}
+
+	meshlet.coneCutoff = sqrtf(1.0f - minimumDot * minimumDot);
+}
@@ -0,0 +1,43 @@
+#ifndef MESHLETBUILDER_H
+#define MESHLETBUILDER_H
+
+#include <D3DX10math.h>
+#include <vector>
+#include "PrioEngineVars.h"
+
+/* Splits a triangle list into small clusters of neighbouring triangles (meshlets).
+* Each meshlet covers a contiguous range of the index buffer, and is given a bounding sphere and a normal cone so that
+* whole clusters can be rejected on the CPU when they are off screen or facing away from the camera.
+*/
+class CMeshletBuilder
+{
+private:
+	CLogger* logger;
+public:
+	struct MeshletType
+	{
+		// The range of the index buffer this meshlet covers.
+		unsigned int startIndex;
+		unsigned int indexCount;
+		// Bounding sphere in model space.
+		D3DXVECTOR3 centre;
+		float radius;
+		// The average facing of the triangles, and how far the facings spread from it.
+		// A cutoff of 1 means the triangles face too many ways for the cone to be useful.
+		D3DXVECTOR3 coneAxis;
+		float coneCutoff;
+	};
+public:
+	CMeshletBuilder();
+	~CMeshletBuilder();
+public:
+	bool Build(const D3DXVECTOR3* positions, unsigned int numberOfVertices, unsigned int* indices, unsigned int numberOfIndices, std::vector<MeshletType>& meshlets);
+private:
+	// Limits on the size of a single meshlet, smaller clusters give tighter normal cones but more draw calls.
+	const unsigned int kMaxMeshletVertices = 64;
+	const unsigned int kMaxMeshletTriangles = 124;
+
+	void CalculateBounds(const D3DXVECTOR3* positions, const unsigned int* indices, MeshletType& meshlet);
+};
+
+#endif
@@ -0,0 +1,117 @@
+#include "MeshletCuller.h"
+
+CMeshletCuller::CMeshletCuller()
+{
+	mMeshletsTested = 0;
+	mIndicesSubmitted = 0;
+	mIndicesCulled = 0;
+
+	mTotalMeshletsTested = 0;
+	mTotalIndicesSubmitted = 0;
+	mTotalIndicesCulled = 0;
+	ResetCounters();
+}
+
+CMeshletCuller::~CMeshletCuller()
+{
+}
+
+/* Adds the counts for the frame to the totals and sets them back to zero, call once a frame. */
+void CMeshletCuller::ResetCounters()
+{
+	mTotalMeshletsTested += mMeshletsTested;
+	mTotalIndicesSubmitted += mIndicesSubmitted;
+	mTotalIndicesCulled += mIndicesCulled;
+
+	mMeshletsTested = 0;
+	mMeshletsFrustumCulled = 0;
+	mMeshletsBackFaceCulled = 0;
+	mIndicesSubmitted = 0;
+	mIndicesCulled = 0;
+}
+
+/* Culls the meshlets of one instance.
+* @PARAM D3DXMATRIX worldMatrix - The world matrix of the instance being drawn.
+* @PARAM CFrustum* frustum - The frustum to test against, pass nullptr if the instance is already known to be entirely inside.
+* @PARAM const D3DXVECTOR3* viewPosition - The world position of the camera, pass nullptr if back faces will not be culled by the rasteriser.
+* @PARAM std::vector<IndexRangeType>& ranges - Filled with the ranges of the index buffer which still need to be drawn.
+*/
+void CMeshletCuller::Cull(const std::vector<CMeshletBuilder::MeshletType>& meshlets, D3DXMATRIX worldMatrix, CFrustum* frustum, const D3DXVECTOR3* viewPosition, std::vector<IndexRangeType>& ranges)
+{
+	ranges.clear();
+
+	// The spheres can grow by as much as the largest scale on any axis.
+	float scaleX = sqrtf(worldMatrix._11 * worldMatrix._11 + worldMatrix._12 * worldMatrix._12 + worldMatrix._13 * worldMatrix._13);
+	float scaleY = sqrtf(worldMatrix._21 * worldMatrix._21 + worldMatrix._22 * worldMatrix._22 + worldMatrix._23 * worldMatrix._23);
+	float scaleZ = sqrtf(worldMatrix._31 * worldMatrix._31 + worldMatrix._32 * worldMatrix._32 + worldMatrix._33 * worldMatrix._33);
+	float maxScale = scaleX > scaleY ? scaleX : scaleY;
+	maxScale = scaleZ > maxScale ? scaleZ : maxScale;
+
+	// Which side of a triangle the camera is on doesn't change when both are moved by the same transform, so move the camera into model space
+	// rather than moving every cone out of it. A mirroring transform does flip the winding the rasteriser sees though, so the side it culls is the other one.
+	D3DXVECTOR3 localViewPosition;
+	float facing = 1.0f;
+	bool cullBackFaces = viewPosition != nullptr;
+
+	if (cullBackFaces)
+	{
+		D3DXMATRIX inverseWorld;
+		float determinant = 0.0f;
+		if (D3DXMatrixInverse(&inverseWorld, &determinant, &worldMatrix) == NULL)
+		{
+			cullBackFaces = false;
+		}
+		else
+		{
+			D3DXVec3TransformCoord(&localViewPosition, viewPosition, &inverseWorld);
+			facing = determinant < 0.0f ? -1.0f : 1.0f;
+		}
+	}
+
+	for (auto& meshlet : meshlets)
+	{
+		mMeshletsTested++;
+
+		if (cullBackFaces)
+		{
+			D3DXVECTOR3 toMeshlet = meshlet.centre - localViewPosition;
+			float distance = D3DXVec3Length(&toMeshlet);
+
+			// Every triangle in the cluster faces away from anywhere the camera could be. For a mirrored instance the cone is turned around.
+			if (facing * D3DXVec3Dot(&toMeshlet, &meshlet.coneAxis) >= meshlet.coneCutoff * distance + meshlet.radius)
+			{
+				mMeshletsBackFaceCulled++;
+				mIndicesCulled += meshlet.indexCount;
+				continue;
+			}
+		}
+
+		if (frustum != nullptr)
+		{
+			D3DXVECTOR3 worldCentre;
+			D3DXVec3TransformCoord(&worldCentre, &meshlet.centre, &worldMatrix);
+
+			if (!frustum->CheckSphere(worldCentre, meshlet.radius * maxScale))
+			{
+				mMeshletsFrustumCulled++;
+				mIndicesCulled += meshlet.indexCount;
+				continue;
+			}
+		}
+
+		mIndicesSubmitted += meshlet.indexCount;
+
+		// Join this meshlet on to the last range if they sit next to each other in the index buffer.
+		if (!ranges.empty() && ranges.back().startIndex + ranges.back().indexCount == meshlet.startIndex)
+		{
+			ranges.back().indexCount += meshlet.indexCount;
+		}
+		else
+		{
+			IndexRangeType range;
+			range.startIndex = meshlet.startIndex;
+			range.indexCount = meshlet.indexCount;
+			ranges.push_back(range);
+		}
+	}
+}
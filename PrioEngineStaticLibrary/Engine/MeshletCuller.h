@@ -0,0 +1,52 @@
+#ifndef MESHLETCULLER_H
+#define MESHLETCULLER_H
+
+#include <D3DX10math.h>
+#include <vector>
+#include "PrioEngineVars.h"
+#include "Frustum.h"
+#include "MeshletBuilder.h"
+
+/* Rejects meshlets which are off screen, or which only contain triangles facing away from the camera.
+* The meshlets which survive are merged into as few index ranges as possible, ready to be drawn.
+*/
+class CMeshletCuller
+{
+private:
+	CLogger* logger;
+public:
+	struct IndexRangeType
+	{
+		unsigned int startIndex;
+		unsigned int indexCount;
+	};
+public:
+	CMeshletCuller();
+	~CMeshletCuller();
+public:
+	void Cull(const std::vector<CMeshletBuilder::MeshletType>& meshlets, D3DXMATRIX worldMatrix, CFrustum* frustum, const D3DXVECTOR3* viewPosition, std::vector<IndexRangeType>& ranges);
+	void ResetCounters();
+private:
+	// Counts for the current frame.
+	unsigned int mMeshletsTested;
+	unsigned int mMeshletsFrustumCulled;
+	unsigned int mMeshletsBackFaceCulled;
+	unsigned int mIndicesSubmitted;
+	unsigned int mIndicesCulled;
+
+	// Counts for the whole run, not including the current frame. Index counts run into the billions on dense scenes.
+	unsigned long long mTotalMeshletsTested;
+	unsigned long long mTotalIndicesSubmitted;
+	unsigned long long mTotalIndicesCulled;
+public:
+	unsigned int GetMeshletsTested() { return mMeshletsTested; };
+	unsigned int GetMeshletsFrustumCulled() { return mMeshletsFrustumCulled; };
+	unsigned int GetMeshletsBackFaceCulled() { return mMeshletsBackFaceCulled; };
+	unsigned int GetIndicesSubmitted() { return mIndicesSubmitted; };
+	unsigned int GetIndicesCulled() { return mIndicesCulled; };
+	unsigned long long GetTotalMeshletsTested() { return mTotalMeshletsTested + mMeshletsTested; };
+	unsigned long long GetTotalIndicesSubmitted() { return mTotalIndicesSubmitted + mIndicesSubmitted; };
+	unsigned long long GetTotalIndicesCulled() { return mTotalIndicesCulled + mIndicesCulled; };
+};
+
+#endif
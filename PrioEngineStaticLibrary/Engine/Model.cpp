@@ -1,16 +1,70 @@
 #include "Model.h"
+#include "SceneGraph.h"
 
 
-CModel::CModel()
+/* @PARAM bool logAllocation - False for models built in a pool, which logs its slabs instead. */
+CModel::CModel(CTransformStore* transformStore, bool logAllocation)
 {
-	logger->GetInstance().MemoryAllocWriteLine(typeid(this).name());
+	mLogAllocation = logAllocation;
+	if (mLogAllocation)
+	{
+		logger->GetInstance().MemoryAllocWriteLine(typeid(this).name());
+	}
+
+	mpTransformStore = transformStore;
+	mTransformIndex = 0;
+	mTransformVersion = 0;
+	D3DXMatrixIdentity(&mWorldMatrix);
+
+	if (mpTransformStore != nullptr)
+	{
+		mTransformIndex = mpTransformStore->Add();
+	}
 }
 
 
 CModel::~CModel()
 {
+	if (mpTransformStore != nullptr)
+	{
+		mpTransformStore->Remove(mTransformIndex);
+		mpTransformStore = nullptr;
+	}
+
 	// Write an allocation message to our memory log.
-	logger->GetInstance().MemoryAllocWriteLine(typeid(this).name());
+	if (mLogAllocation)
+	{
+		logger->GetInstance().MemoryAllocWriteLine(typeid(this).name());
+	}
+}
+
+/* Passes the new transform over to the store, which will rebuild the matrix when it next updates. */
+void CModel::TransformChanged()
+{
+	CModelControl::TransformChanged();
+	mTransformVersion++;
+
+	if (mpTransformStore != nullptr)
+	{
+		mpTransformStore->SetTransform(mTransformIndex, mPosition, mRotation, mScale);
+	}
+}
+
+D3DXMATRIX CModel::GetWorldMatrix()
+{
+	// Models with a parent, or with children, have their world matrix built by the scene graph.
+	D3DXMATRIX world;
+	if (mInSceneGraph && CSceneGraph::GetInstance().GetWorldMatrix(this, world))
+	{
+		return world;
+	}
+
+	if (mpTransformStore != nullptr)
+	{
+		return mpTransformStore->GetWorldMatrix(mTransformIndex);
+	}
+
+	return mWorldMatrix;
 }
 
 void CModel::Shutdown()
@@ -19,6 +73,23 @@ void CModel::Shutdown()
 
 void CModel::UpdateMatrices()
 {
+	// The store rebuilds our matrix for us when it updates.
+	if (mpTransformStore != nullptr)
+	{
+		return;
+	}
+
+	mWorldMatrix = GetLocalMatrix();
+}
+
+/* The transform of this model relative to its parent, scale * rotation x * rotation y * rotation z * translation. */
+D3DXMATRIX CModel::GetLocalMatrix()
+{
+	if (mpTransformStore != nullptr)
+	{
+		return mpTransformStore->GetWorldMatrix(mTransformIndex);
+	}
+
 	// Rotation
 	D3DXMATRIX translation;
 	D3DXMATRIX scale;
@@ -39,10 +110,10 @@ void CModel::UpdateMatrices()
 	D3DXMatrixScaling(&scale, GetScaleX(), GetScaleY(), GetScaleZ());
 
 	// Calculate the translation of the model.
-	D3DXMatrixTranslation(&translation, GetPosX(), GetPosY(), GetPosZ());
+	D3DXMatrixTranslation(&translation, mPosition.x, mPosition.y, mPosition.z);
 
-	// Calculate the world matrix
-	mWorldMatrix = scale * matrixRotationX * matrixRotationY * matrixRotationZ * translation;
+	// Calculate the local matrix
+	return scale * matrixRotationX * matrixRotationY * matrixRotationZ * translation;
 }
 
 void CModel::RenderBuffers(ID3D11DeviceContext* deviceContext, int subMeshIndex, ID3D11Buffer* &vertexBuffer, ID3D11Buffer* &indexBuffer, unsigned int stride)
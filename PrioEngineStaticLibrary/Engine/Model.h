@@ -5,6 +5,7 @@
 #include "ModelControl.h"
 #include <vector>
 #include "Logger.h"
+#include "TransformStore.h"
 
 class CModel : public CModelControl
 {
@@ -13,14 +14,25 @@ private:
 
 private:
 	D3DXMATRIX mWorldMatrix;
+
+	// Where the transform of this model is kept, if it belongs to a mesh.
+	CTransformStore* mpTransformStore;
+	unsigned int mTransformIndex;
+	// Goes up every time the transform changes, so anything caching the transform can tell when it is out of date.
+	unsigned int mTransformVersion;
+	bool mLogAllocation;
+protected:
+	void TransformChanged();
 public:
-	CModel();
+	CModel(CTransformStore* transformStore = nullptr, bool logAllocation = true);
 	~CModel();
 	void Shutdown();
 
 	void UpdateMatrices();
 	void RenderBuffers(ID3D11DeviceContext* deviceContext, int subMeshIndex, ID3D11Buffer* &vertexBuffer, ID3D11Buffer* &indexBuffer, unsigned int stride);
-	D3DXMATRIX GetWorldMatrix() { return mWorldMatrix; };
+	D3DXMATRIX GetWorldMatrix();
+	D3DXMATRIX GetLocalMatrix();
+	unsigned int GetTransformVersion() { return mTransformVersion; };
 };
 
 #endif
@@ -1,10 +1,12 @@
 #include "ModelControl.h"
+#include "SceneGraph.h"
 
 
 
 CModelControl::CModelControl()
 {
 	mpParent = nullptr;
+	mInSceneGraph = false;
 
 	mPosition.x = 0.0f;
 	mPosition.y = 0.0f;
@@ -22,6 +24,20 @@ CModelControl::CModelControl()
 
 CModelControl::~CModelControl()
 {
+	// Make sure the scene graph doesn't keep hold of us, or leave our children pointing at us.
+	if (mInSceneGraph)
+	{
+		CSceneGraph::GetInstance().Remove(this);
+	}
+}
+
+/* Lets the scene graph know this object's world matrix, and those of its children, need rebuilding. */
+void CModelControl::TransformChanged()
+{
+	if (mInSceneGraph)
+	{
+		CSceneGraph::GetInstance().MarkDirty(this);
+	}
 }
 
 float CModelControl::ToRadians(float degrees)
@@ -33,16 +49,22 @@ float CModelControl::ToRadians(float degrees)
 void CModelControl::RotateX(float x)
 {
 	mRotation.x += x;
+
+	TransformChanged();
 }
 
 void CModelControl::RotateY(float y)
 {
 	mRotation.y += y;
+
+	TransformChanged();
 }
 
 void CModelControl::RotateZ(float z)
 {
 	mRotation.z += z;
+
+	TransformChanged();
 }
 
 float CModelControl::GetRotationX()
@@ -68,16 +90,22 @@ D3DXVECTOR3 CModelControl::GetRotation()
 void CModelControl::SetRotationX(float x)
 {
 	mRotation.x = x;
+
+	TransformChanged();
 }
 
 void CModelControl::SetRotationY(float y)
 {
 	mRotation.y = y;
+
+	TransformChanged();
 }
 
 void CModelControl::SetRotationZ(float z)
 {
 	mRotation.z = z;
+
+	TransformChanged();
 }
 
 void CModelControl::SetRotation(float x, float y, float z)
@@ -85,28 +113,36 @@ void CModelControl::SetRotation(float x, float y, float z)
 	mRotation.x = x;
 	mRotation.y = y;
 	mRotation.z = z;
+
+	TransformChanged();
 }
 
 void CModelControl::MoveX(float x)
 {
 	mPosition.x += x;
+
+	TransformChanged();
 }
 
 void CModelControl::MoveY(float y)
 {
 	mPosition.y += y;
+
+	TransformChanged();
 }
 
 void CModelControl::MoveZ(float z)
 {
 	mPosition.z += z;
+
+	TransformChanged();
 }
 
 float CModelControl::GetPosX()
 {
 	if (mpParent != nullptr)
 	{
-		return (mPosition.x + mpParent->GetPosX());
+		return GetPos().x;
 	}
 	return mPosition.x;
 }
@@ -115,7 +151,7 @@ float CModelControl::GetPosY()
 {
 	if (mpParent != nullptr)
 	{
-		return (mPosition.y + mpParent->GetPosY());
+		return GetPos().y;
 	}
 	return mPosition.y;
 }
@@ -124,7 +160,7 @@ float CModelControl::GetPosZ()
 {
 	if (mpParent != nullptr)
 	{
-		return (mPosition.z + mpParent->GetPosZ());
+		return GetPos().z;
 	}
 	return mPosition.z;
 }
@@ -133,6 +169,16 @@ D3DXVECTOR3 CModelControl::GetPos()
 {
 	if (mpParent != nullptr)
 	{
+		// Move our position into the parent's space, as of the last scene graph update.
+		D3DXMATRIX parentWorld;
+		if (CSceneGraph::GetInstance().GetWorldMatrix(mpParent, parentWorld))
+		{
+			D3DXVECTOR3 position;
+			D3DXVec3TransformCoord(&position, &mPosition, &parentWorld);
+			return position;
+		}
+
+		// The scene graph hasn't been updated since we were attached.
 		return (mPosition + mpParent->GetPos());
 	}
 	return mPosition;
@@ -141,16 +187,22 @@ D3DXVECTOR3 CModelControl::GetPos()
 void CModelControl::SetXPos(float x)
 {
 	mPosition.x = x;
+
+	TransformChanged();
 }
 
 void CModelControl::SetYPos(float y)
 {
 	mPosition.y = y;
+
+	TransformChanged();
 }
 
 void CModelControl::SetZPos(float z)
 {
 	mPosition.z = z;
+
+	TransformChanged();
 }
 
 void CModelControl::SetPos(float x, float y, float z)
@@ -158,21 +210,29 @@ void CModelControl::SetPos(float x, float y, float z)
 	mPosition.x = x;
 	mPosition.y = y;
 	mPosition.z = z;
+
+	TransformChanged();
 }
 
 void CModelControl::ScaleX(float x)
 {
 	mScale.x += x;
+
+	TransformChanged();
 }
 
 void CModelControl::ScaleY(float y)
 {
 	mScale.y += y;
+
+	TransformChanged();
 }
 
 void CModelControl::ScaleZ(float z)
 {
 	mScale.z += z;
+
+	TransformChanged();
 }
 
 void CModelControl::Scale(float value)
@@ -180,6 +240,8 @@ void CModelControl::Scale(float value)
 	mScale.x += value;
 	mScale.y += value;
 	mScale.z += value;
+
+	TransformChanged();
 }
 
 float CModelControl::GetScaleX()
@@ -216,16 +278,22 @@ float CModelControl::GetScaleRadius(float initialRadius)
 void CModelControl::SetScaleX(float x)
 {
 	mScale.x = x;
+
+	TransformChanged();
 }
 
 void CModelControl::SetScaleY(float y)
 {
 	mScale.y = y;
+
+	TransformChanged();
 }
 
 void CModelControl::SetScaleZ(float z)
 {
 	mScale.z = z;
+
+	TransformChanged();
 }
 
 void CModelControl::SetScale(float x, float y, float z)
@@ -233,6 +301,17 @@ void CModelControl::SetScale(float x, float y, float z)
 	mScale.x = x;
 	mScale.y = y;
 	mScale.z = z;
+
+	TransformChanged();
+}
+
+void CModelControl::SetTransform(D3DXVECTOR3 position, D3DXVECTOR3 rotation, D3DXVECTOR3 scale)
+{
+	mPosition = position;
+	mRotation = rotation;
+	mScale = scale;
+
+	TransformChanged();
 }
 
 void CModelControl::SetScale(float value)
@@ -240,19 +319,49 @@ void CModelControl::SetScale(float value)
 	mScale.x = value;
 	mScale.y = value;
 	mScale.z = value;
+
+	TransformChanged();
 }
 
 void CModelControl::AttatchToParent(CModelControl * parent)
 {
+	if (!CSceneGraph::GetInstance().Attach(this, parent))
+	{
+		return;
+	}
+
 	mpParent = parent;
+	mInSceneGraph = true;
+	parent->mInSceneGraph = true;
+
+	TransformChanged();
 }
 
 void CModelControl::SeperateFromParent()
 {
+	if (mpParent == nullptr)
+	{
+		return;
+	}
+
+	CSceneGraph::GetInstance().Detach(this);
 	mpParent = nullptr;
+
+	TransformChanged();
 }
 
 void CModelControl::UpdateMatrices()
+{
+	mWorldMatrix = GetLocalMatrix();
+
+	// Anything with a parent gets its world matrix from the scene graph.
+	if (mInSceneGraph)
+	{
+		CSceneGraph::GetInstance().GetWorldMatrix(this, mWorldMatrix);
+	}
+}
+
+D3DXMATRIX CModelControl::GetLocalMatrix()
 {
 		// Rotation
 		D3DXMATRIX matrixRotationX;
@@ -269,6 +378,6 @@ void CModelControl::UpdateMatrices()
 		// Calculate the translation of the camera.
 		D3DXMatrixTranslation(&matrixTranslation, mPosition.x, mPosition.y, mPosition.z);
 
-		// Calculate the world matrix
-		mWorldMatrix = matrixRotationZ * matrixRotationX * matrixRotationY * matrixTranslation;
+		// Calculate the local matrix
+		return matrixRotationZ * matrixRotationX * matrixRotationY * matrixTranslation;
 }
@@ -15,6 +15,11 @@ protected:
 	D3DXVECTOR3 mScale;
 	CModelControl* mpParent;
 	D3DXMATRIX mWorldMatrix;
+	// Set once this object has been given a parent or a child, its world matrix then comes from the scene graph.
+	bool mInSceneGraph;
+
+	// Called whenever the position, rotation, scale or parent is changed.
+	virtual void TransformChanged();
 public:
 	/* Rotation. */
 	void RotateX(float x);
@@ -64,15 +69,20 @@ public:
 	void SetScale(float x, float y, float z);
 	void SetScale(float value);
 
+	// Sets the position, rotation and scale together, only telling anything watching the transform once.
+	void SetTransform(D3DXVECTOR3 position, D3DXVECTOR3 rotation, D3DXVECTOR3 scale);
+
 	void AttatchToParent(CModelControl* parent);
 	void SeperateFromParent();
 
 	void UpdateMatrices();
+	// The transform relative to the parent, or to the world if there is no parent.
+	virtual D3DXMATRIX GetLocalMatrix();
 
 	void GetWorldMatrix(D3DXMATRIX& world) { world = mWorldMatrix; };
 public:
 	CModelControl();
-	~CModelControl();
+	virtual ~CModelControl();
 };
 
 #endif
\ No newline at end of file
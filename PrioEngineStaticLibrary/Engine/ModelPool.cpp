@@ -0,0 +1,207 @@
+#include "ModelPool.h"
+#include <new>
+
+CModelPool::CModelPool(CTransformStore* transformStore)
+{
+	mpTransformStore = transformStore;
+}
+
+CModelPool::~CModelPool()
+{
+	Clear();
+}
+
+/* Creates one model at the origin.
+* @PARAM HandleType* handle - If not null, filled with the handle of the new model.
+* @Returns CModel* - The new model, or nullptr if there wasn't room for it.
+*/
+CModel* CModelPool::Create(HandleType* handle)
+{
+	if (mFreeSlots.empty())
+	{
+		unsigned int slabSize = static_cast<unsigned int>(mSlots.size());
+		slabSize = slabSize < kMinimumSlabSize ? kMinimumSlabSize : slabSize;
+
+		if (!AddSlab(slabSize))
+		{
+			return nullptr;
+		}
+	}
+
+	const unsigned int slot = TakeSlot();
+
+	if (handle != nullptr)
+	{
+		handle->index = slot;
+		handle->generation = mSlots[slot].generation;
+	}
+
+	return mSlots[slot].model;
+}
+
+/* Creates many models at once, each with its own transform. Any slots which are short are added as one slab.
+* @PARAM HandleType* handles - If not null, must have room for count handles.
+* @Returns bool Success
+*/
+bool CModelPool::Create(unsigned int count, const TransformType* transforms, HandleType* handles)
+{
+	const unsigned int numberOfFreeSlots = static_cast<unsigned int>(mFreeSlots.size());
+
+	if (count > numberOfFreeSlots && !AddSlab(count - numberOfFreeSlots))
+	{
+		return false;
+	}
+
+	if (mpTransformStore != nullptr)
+	{
+		mpTransformStore->Reserve(mpTransformStore->GetNumberOfInstances() + count);
+	}
+
+	mLiveModels.reserve(mLiveModels.size() + count);
+	mLiveSlots.reserve(mLiveSlots.size() + count);
+
+	for (unsigned int model = 0; model < count; model++)
+	{
+		const unsigned int slot = TakeSlot();
+
+		if (transforms != nullptr)
+		{
+			mSlots[slot].model->SetTransform(transforms[model].position, transforms[model].rotation, transforms[model].scale);
+		}
+
+		if (handles != nullptr)
+		{
+			handles[model].index = slot;
+			handles[model].generation = mSlots[slot].generation;
+		}
+	}
+
+	return true;
+}
+
+/* Destroys the model a handle refers to, by swapping the last live model into its place.
+* @Returns bool - False if the handle was out of date.
+*/
+bool CModelPool::Destroy(HandleType handle)
+{
+	CModel* model = Get(handle);
+
+	if (model == nullptr)
+	{
+		logger->GetInstance().WriteLine("Attempted to destroy a model with a handle which is out of date.");
+		return false;
+	}
+
+	SlotType& slot = mSlots[handle.index];
+
+	const unsigned int lastSlot = mLiveSlots.back();
+	mLiveModels[slot.liveIndex] = mLiveModels.back();
+	mLiveSlots[slot.liveIndex] = lastSlot;
+	mSlots[lastSlot].liveIndex = slot.liveIndex;
+	mLiveModels.pop_back();
+	mLiveSlots.pop_back();
+
+	model->~CModel();
+
+	slot.liveIndex = kNotLive;
+	slot.generation++;
+	mFreeSlots.push_back(handle.index);
+
+	return true;
+}
+
+/* The model a handle refers to, or nullptr if it has since been destroyed. */
+CModel* CModelPool::Get(HandleType handle)
+{
+	if (handle.index >= mSlots.size())
+	{
+		return nullptr;
+	}
+
+	const SlotType& slot = mSlots[handle.index];
+
+	if (slot.generation != handle.generation || slot.liveIndex == kNotLive)
+	{
+		return nullptr;
+	}
+
+	return slot.model;
+}
+
+/* Destroys every model and frees every slab. */
+void CModelPool::Clear()
+{
+	for (auto model : mLiveModels)
+	{
+		model->~CModel();
+	}
+
+	if (!mSlabs.empty())
+	{
+		logger->GetInstance().MemoryDeallocWriteLine(typeid(CModel).name() + std::string(" pool of ") + std::to_string(mSlots.size()));
+	}
+
+	for (auto slab : mSlabs)
+	{
+		::operator delete(slab);
+	}
+
+	mSlabs.clear();
+	mSlots.clear();
+	mFreeSlots.clear();
+	mLiveModels.clear();
+	mLiveSlots.clear();
+}
+
+/* Allocates room for more models in one block, and adds its slots to the free list.
+* @Returns bool Success
+*/
+bool CModelPool::AddSlab(unsigned int numberOfSlots)
+{
+	void* slab = ::operator new(sizeof(CModel) * numberOfSlots, std::nothrow);
+
+	if (slab == nullptr)
+	{
+		logger->GetInstance().WriteLine("Failed to allocate a slab of " + std::to_string(numberOfSlots) + " models.");
+		return false;
+	}
+
+	// One line in the memory log for the whole slab, rather than one per model.
+	logger->GetInstance().MemoryAllocWriteLine(typeid(CModel).name() + std::string(" slab of ") + std::to_string(numberOfSlots));
+
+	mSlabs.push_back(slab);
+
+	const unsigned int firstSlot = static_cast<unsigned int>(mSlots.size());
+	mSlots.resize(firstSlot + numberOfSlots);
+	mFreeSlots.reserve(mFreeSlots.size() + numberOfSlots);
+
+	CModel* models = static_cast<CModel*>(slab);
+
+	// Push in reverse so the slots are handed out front to back.
+	for (unsigned int slot = numberOfSlots; slot > 0; slot--)
+	{
+		SlotType& newSlot = mSlots[firstSlot + slot - 1];
+		newSlot.model = &models[slot - 1];
+		newSlot.generation = 0;
+		newSlot.liveIndex = kNotLive;
+
+		mFreeSlots.push_back(firstSlot + slot - 1);
+	}
+
+	return true;
+}
+
+/* Builds a model in a free slot and marks it live. There must be a free slot. */
+unsigned int CModelPool::TakeSlot()
+{
+	const unsigned int slot = mFreeSlots.back();
+	mFreeSlots.pop_back();
+
+	new (mSlots[slot].model) CModel(mpTransformStore, false);
+
+	mSlots[slot].liveIndex = static_cast<unsigned int>(mLiveModels.size());
+	mLiveModels.push_back(mSlots[slot].model);
+	mLiveSlots.push_back(slot);
+
+	return slot;
+}
@@ -0,0 +1,70 @@
+#ifndef MODELPOOL_H
+#define MODELPOOL_H
+
+#include <vector>
+#include "Model.h"
+
+/* Owns the models of a mesh, keeping them in large contiguous slabs rather than allocating each one on its own.
+* Creating thousands of models at once costs a single slab allocation, and destroying a model is constant time.
+* Models are referred to by handles, which stop working once the model they refer to has been destroyed.
+*/
+class CModelPool
+{
+private:
+	CLogger* logger;
+public:
+	struct HandleType
+	{
+		unsigned int index;
+		unsigned int generation;
+	};
+
+	struct TransformType
+	{
+		D3DXVECTOR3 position;
+		// In degrees around each axis.
+		D3DXVECTOR3 rotation;
+		D3DXVECTOR3 scale;
+	};
+public:
+	CModelPool(CTransformStore* transformStore);
+	~CModelPool();
+public:
+	CModel* Create(HandleType* handle = nullptr);
+	bool Create(unsigned int count, const TransformType* transforms, HandleType* handles = nullptr);
+	bool Destroy(HandleType handle);
+	CModel* Get(HandleType handle);
+	void Clear();
+
+	// Every live model, in no particular order.
+	const std::vector<CModel*>& GetModels() { return mLiveModels; };
+	unsigned int GetNumberOfModels() { return static_cast<unsigned int>(mLiveModels.size()); };
+	unsigned int GetCapacity() { return static_cast<unsigned int>(mSlots.size()); };
+	unsigned int GetNumberOfSlabs() { return static_cast<unsigned int>(mSlabs.size()); };
+private:
+	struct SlotType
+	{
+		CModel* model;
+		// Goes up every time the slot is freed, so old handles to it can be spotted.
+		unsigned int generation;
+		// Where this slot's model is in mLiveModels, or kNotLive if the slot is free.
+		unsigned int liveIndex;
+	};
+
+	// Single models get a slab of at least this many slots, so one at a time creation still allocates rarely.
+	const unsigned int kMinimumSlabSize = 64;
+	static const unsigned int kNotLive = 0xFFFFFFFF;
+
+	bool AddSlab(unsigned int numberOfSlots);
+	unsigned int TakeSlot();
+
+	CTransformStore* mpTransformStore;
+	std::vector<void*> mSlabs;
+	std::vector<SlotType> mSlots;
+	std::vector<unsigned int> mFreeSlots;
+	std::vector<CModel*> mLiveModels;
+	// The slot of each model in mLiveModels, so the last one can be moved in constant time.
+	std::vector<unsigned int> mLiveSlots;
+};
+
+#endif
@@ -0,0 +1,249 @@
+#include "NullRenderDevice.h"
+#include <cstring>
+
+CNullRenderDevice::CNullRenderDevice()
+{
+	mScratch.resize(kScratchSize);
+	mResourceMemory = 0;
+	mRecording = false;
+
+	ResetCounters();
+}
+
+CNullRenderDevice::~CNullRenderDevice()
+{
+	if (!mResources.empty())
+	{
+		logger->GetInstance().WriteLine("The null render device was destroyed with " + std::to_string(mResources.size()) + " resources which were never released.");
+	}
+}
+
+/* Clears the recorded commands and the call counts, the resources are kept. */
+void CNullRenderDevice::ResetCounters()
+{
+	mCommands.clear();
+	mNumberOfCalls = 0;
+	mNumberOfDrawCalls = 0;
+	mNumberOfInstancesDrawn = 0;
+	mNumberOfIndicesDrawn = 0;
+	mNumberOfMaps = 0;
+}
+
+/////////////////////////////
+// Resources
+/////////////////////////////
+
+HRESULT CNullRenderDevice::CreateBuffer(const D3D11_BUFFER_DESC* desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Buffer** buffer)
+{
+	if (desc == nullptr || buffer == nullptr || desc->ByteWidth == 0)
+	{
+		return E_INVALIDARG;
+	}
+
+	ResourceType& resource = CreateResource(desc->ByteWidth);
+	unsigned char* memory = resource.memory.get();
+	resource.desc = *desc;
+
+	if (initialData != nullptr && initialData->pSysMem != nullptr)
+	{
+		std::memcpy(memory, initialData->pSysMem, desc->ByteWidth);
+	}
+
+	*buffer = reinterpret_cast<ID3D11Buffer*>(memory);
+	Record(CreateBufferCommand, memory, desc->ByteWidth, desc->BindFlags);
+
+	return S_OK;
+}
+
+/* The file isn't read, the texture is only given a handle so that materials still sort as they would on a GPU. */
+HRESULT CNullRenderDevice::CreateTextureFromFile(const std::string& filename, ID3D11ShaderResourceView** texture)
+{
+	if (texture == nullptr)
+	{
+		return E_INVALIDARG;
+	}
+
+	unsigned char* memory = CreateResource(kTextureSize).memory.get();
+
+	*texture = reinterpret_cast<ID3D11ShaderResourceView*>(memory);
+	Record(CreateTextureCommand, memory);
+
+	return S_OK;
+}
+
+void CNullRenderDevice::ReleaseResource(IUnknown* resource)
+{
+	auto it = mResources.find(resource);
+	if (it == mResources.end())
+	{
+		return;
+	}
+
+	mResourceMemory -= it->second.size;
+	mResources.erase(it);
+	Record(ReleaseCommand, resource);
+}
+
+bool CNullRenderDevice::GetBufferDesc(ID3D11Buffer* buffer, D3D11_BUFFER_DESC* desc)
+{
+	auto it = mResources.find(buffer);
+	if (it == mResources.end() || it->second.desc.ByteWidth == 0)
+	{
+		return false;
+	}
+
+	*desc = it->second.desc;
+	return true;
+}
+
+unsigned long long CNullRenderDevice::GetTextureMemory(ID3D11ShaderResourceView* texture)
+{
+	auto it = mResources.find(texture);
+	return it != mResources.end() ? it->second.size : 0;
+}
+
+HRESULT CNullRenderDevice::Map(ID3D11Resource* resource, unsigned int subresource, D3D11_MAP mapType, D3D11_MAPPED_SUBRESOURCE* mappedResource)
+{
+	auto it = mResources.find(resource);
+
+	mappedResource->pData = it != mResources.end() ? it->second.memory.get() : mScratch.data();
+	mappedResource->RowPitch = it != mResources.end() ? it->second.size : kScratchSize;
+	mappedResource->DepthPitch = mappedResource->RowPitch;
+
+	mNumberOfMaps++;
+	Record(MapCommand, resource, subresource, static_cast<unsigned int>(mapType));
+
+	return S_OK;
+}
+
+void CNullRenderDevice::Unmap(ID3D11Resource* resource, unsigned int subresource, unsigned int writtenStart, unsigned int writtenSize)
+{
+	Record(UnmapCommand, resource, subresource, writtenStart, writtenSize);
+}
+
+/* Allocates the memory behind a buffer or texture, its address is used as the handle. */
+CNullRenderDevice::ResourceType& CNullRenderDevice::CreateResource(unsigned int size)
+{
+	ResourceType resource;
+	resource.memory.reset(new unsigned char[size]());
+	resource.size = size;
+	resource.desc = D3D11_BUFFER_DESC();
+
+	unsigned char* memory = resource.memory.get();
+	mResourceMemory += size;
+
+	return mResources[memory] = std::move(resource);
+}
+
+/////////////////////////////
+// Pipeline state
+/////////////////////////////
+
+void CNullRenderDevice::IASetVertexBuffers(unsigned int startSlot, unsigned int numberOfBuffers, ID3D11Buffer* const* buffers, const unsigned int* strides, const unsigned int* offsets)
+{
+	Record(SetVertexBuffersCommand, numberOfBuffers > 0 ? buffers[0] : nullptr, startSlot, numberOfBuffers, numberOfBuffers > 0 ? strides[0] : 0, numberOfBuffers > 0 ? offsets[0] : 0);
+}
+
+void CNullRenderDevice::IASetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset)
+{
+	Record(SetIndexBufferCommand, buffer, static_cast<unsigned int>(format), offset);
+}
+
+void CNullRenderDevice::IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+	Record(SetTopologyCommand, nullptr, static_cast<unsigned int>(topology));
+}
+
+void CNullRenderDevice::IASetInputLayout(ID3D11InputLayout* layout)
+{
+	Record(SetInputLayoutCommand, layout);
+}
+
+void CNullRenderDevice::VSSetShader(ID3D11VertexShader* shader)
+{
+	Record(SetVertexShaderCommand, shader);
+}
+
+void CNullRenderDevice::PSSetShader(ID3D11PixelShader* shader)
+{
+	Record(SetPixelShaderCommand, shader);
+}
+
+void CNullRenderDevice::VSSetConstantBuffers(unsigned int startSlot, unsigned int numberOfBuffers, ID3D11Buffer* const* buffers)
+{
+	Record(SetVertexConstantBuffersCommand, numberOfBuffers > 0 ? buffers[0] : nullptr, startSlot, numberOfBuffers);
+}
+
+void CNullRenderDevice::PSSetConstantBuffers(unsigned int startSlot, unsigned int numberOfBuffers, ID3D11Buffer* const* buffers)
+{
+	Record(SetPixelConstantBuffersCommand, numberOfBuffers > 0 ? buffers[0] : nullptr, startSlot, numberOfBuffers);
+}
+
+/* Offsets are always supported, the ranges are only recorded. */
+bool CNullRenderDevice::SupportsConstantBufferOffsets()
+{
+	return true;
+}
+
+void CNullRenderDevice::VSSetConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int numberOfConstants)
+{
+	Record(SetVertexConstantBufferRangeCommand, buffer, slot, firstConstant, numberOfConstants);
+}
+
+void CNullRenderDevice::PSSetConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int numberOfConstants)
+{
+	Record(SetPixelConstantBufferRangeCommand, buffer, slot, firstConstant, numberOfConstants);
+}
+
+void CNullRenderDevice::PSSetSamplers(unsigned int startSlot, unsigned int numberOfSamplers, ID3D11SamplerState* const* samplers)
+{
+	Record(SetSamplersCommand, numberOfSamplers > 0 ? samplers[0] : nullptr, startSlot, numberOfSamplers);
+}
+
+void CNullRenderDevice::PSSetShaderResources(unsigned int startSlot, unsigned int numberOfViews, ID3D11ShaderResourceView* const* views)
+{
+	Record(SetShaderResourcesCommand, numberOfViews > 0 ? views[0] : nullptr, startSlot, numberOfViews);
+}
+
+/////////////////////////////
+// Draws
+/////////////////////////////
+
+void CNullRenderDevice::DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	mNumberOfDrawCalls++;
+	mNumberOfInstancesDrawn++;
+	mNumberOfIndicesDrawn += indexCount;
+
+	Record(DrawIndexedCommand, nullptr, indexCount, startIndex, static_cast<unsigned int>(baseVertex));
+}
+
+void CNullRenderDevice::DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance)
+{
+	mNumberOfDrawCalls++;
+	mNumberOfInstancesDrawn += instanceCount;
+	mNumberOfIndicesDrawn += indexCount * instanceCount;
+
+	Record(DrawIndexedInstancedCommand, nullptr, indexCount, instanceCount, startIndex, static_cast<unsigned int>(baseVertex), startInstance);
+}
+
+/* Counts a call, and keeps it if recording is on. */
+void CNullRenderDevice::Record(CommandId id, const void* object, unsigned int a, unsigned int b, unsigned int c, unsigned int d, unsigned int e)
+{
+	mNumberOfCalls++;
+
+	if (!mRecording)
+	{
+		return;
+	}
+
+	CommandType command;
+	command.id = id;
+	command.object = object;
+	command.arguments[0] = a;
+	command.arguments[1] = b;
+	command.arguments[2] = c;
+	command.arguments[3] = d;
+	command.arguments[4] = e;
+	mCommands.push_back(command);
+}
@@ -0,0 +1,122 @@
+#ifndef NULLRENDERDEVICE_H
+#define NULLRENDERDEVICE_H
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include "RenderDevice.h"
+#include "PrioEngineVars.h"
+
+/* A render device with no GPU behind it, which counts and optionally records the calls made to it.
+* Lets the culling, sorting and constant updates of the mesh render path be run and timed on the CPU alone, such as on a build server.
+*
+* Buffers and textures are given a block of CPU memory, and the address of that block is the handle passed back, so each is distinct and can be mapped and written to.
+* Mapping anything this device didn't make, such as a constant buffer of a shader which was never initialised, gives a shared scratch block instead.
+*/
+class CNullRenderDevice : public CRenderDevice
+{
+private:
+	CLogger* logger;
+public:
+	enum CommandId
+	{
+		CreateBufferCommand,
+		CreateTextureCommand,
+		ReleaseCommand,
+		MapCommand,
+		UnmapCommand,
+		SetVertexBuffersCommand,
+		SetIndexBufferCommand,
+		SetTopologyCommand,
+		SetInputLayoutCommand,
+		SetVertexShaderCommand,
+		SetPixelShaderCommand,
+		SetVertexConstantBuffersCommand,
+		SetPixelConstantBuffersCommand,
+		SetVertexConstantBufferRangeCommand,
+		SetPixelConstantBufferRangeCommand,
+		SetSamplersCommand,
+		SetShaderResourcesCommand,
+		DrawIndexedCommand,
+		DrawIndexedInstancedCommand
+	};
+
+	// One call made to the device. What the arguments hold depends on the command, in the order the Direct3D method takes them.
+	struct CommandType
+	{
+		CommandId id;
+		const void* object;
+		unsigned int arguments[5];
+	};
+public:
+	CNullRenderDevice();
+	~CNullRenderDevice();
+public:
+	HRESULT CreateBuffer(const D3D11_BUFFER_DESC* desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Buffer** buffer);
+	HRESULT CreateTextureFromFile(const std::string& filename, ID3D11ShaderResourceView** texture);
+	void ReleaseResource(IUnknown* resource);
+	bool GetBufferDesc(ID3D11Buffer* buffer, D3D11_BUFFER_DESC* desc);
+	unsigned long long GetTextureMemory(ID3D11ShaderResourceView* texture);
+	HRESULT Map(ID3D11Resource* resource, unsigned int subresource, D3D11_MAP mapType, D3D11_MAPPED_SUBRESOURCE* mappedResource);
+	void Unmap(ID3D11Resource* resource, unsigned int subresource, unsigned int writtenStart, unsigned int writtenSize);
+
+	void IASetVertexBuffers(unsigned int startSlot, unsigned int numberOfBuffers, ID3D11Buffer* const* buffers, const unsigned int* strides, const unsigned int* offsets);
+	void IASetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset);
+	void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology);
+	void IASetInputLayout(ID3D11InputLayout* layout);
+	void VSSetShader(ID3D11VertexShader* shader);
+	void PSSetShader(ID3D11PixelShader* shader);
+	void VSSetConstantBuffers(unsigned int startSlot, unsigned int numberOfBuffers, ID3D11Buffer* const* buffers);
+	void PSSetConstantBuffers(unsigned int startSlot, unsigned int numberOfBuffers, ID3D11Buffer* const* buffers);
+	bool SupportsConstantBufferOffsets();
+	void VSSetConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int numberOfConstants);
+	void PSSetConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int numberOfConstants);
+	void PSSetSamplers(unsigned int startSlot, unsigned int numberOfSamplers, ID3D11SamplerState* const* samplers);
+	void PSSetShaderResources(unsigned int startSlot, unsigned int numberOfViews, ID3D11ShaderResourceView* const* views);
+
+	void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+	void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance);
+public:
+	// Whether each call is kept in the command list as well as counted, off by default so long benchmarks don't fill memory.
+	void SetRecording(bool recording) { mRecording = recording; };
+	const std::vector<CommandType>& GetCommands() { return mCommands; };
+	void ResetCounters();
+
+	unsigned int GetNumberOfCalls() { return mNumberOfCalls; };
+	unsigned int GetNumberOfDrawCalls() { return mNumberOfDrawCalls; };
+	unsigned int GetNumberOfInstancesDrawn() { return mNumberOfInstancesDrawn; };
+	unsigned int GetNumberOfIndicesDrawn() { return mNumberOfIndicesDrawn; };
+	unsigned int GetNumberOfMaps() { return mNumberOfMaps; };
+	unsigned int GetNumberOfResources() { return static_cast<unsigned int>(mResources.size()); };
+	unsigned int GetResourceMemory() { return mResourceMemory; };
+private:
+	struct ResourceType
+	{
+		std::unique_ptr<unsigned char[]> memory;
+		unsigned int size;
+		// Only filled in for buffers.
+		D3D11_BUFFER_DESC desc;
+	};
+
+	void Record(CommandId id, const void* object, unsigned int a = 0, unsigned int b = 0, unsigned int c = 0, unsigned int d = 0, unsigned int e = 0);
+	ResourceType& CreateResource(unsigned int size);
+
+	// Big enough for any constant buffer.
+	const unsigned int kScratchSize = 65536;
+	// Textures aren't loaded, they only need a distinct handle.
+	const unsigned int kTextureSize = 16;
+
+	std::unordered_map<const void*, ResourceType> mResources;
+	std::vector<unsigned char> mScratch;
+	unsigned int mResourceMemory;
+
+	bool mRecording;
+	std::vector<CommandType> mCommands;
+	unsigned int mNumberOfCalls;
+	unsigned int mNumberOfDrawCalls;
+	unsigned int mNumberOfInstancesDrawn;
+	unsigned int mNumberOfIndicesDrawn;
+	unsigned int mNumberOfMaps;
+};
+
+#endif
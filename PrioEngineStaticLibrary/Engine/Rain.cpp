@@ -96,6 +96,30 @@ bool CRain::InitialiseBuffers(ID3D11Device * device)
 	return true;
 }
 
+/* Creates the particle buffers again to hold a different number of particles. The rain starts again from the emitter, so don't call it every frame.
+* @Returns bool Success
+*/
+bool CRain::ResizeParticles(ID3D11Device* device, unsigned int numberOfParticles)
+{
+	if (numberOfParticles == mNumberOfParticles)
+	{
+		return true;
+	}
+
+	ShutdownBuffers();
+
+	mNumberOfParticles = numberOfParticles;
+	mFirstRun = true;
+
+	if (!InitialiseBuffers(device))
+	{
+		logger->GetInstance().WriteLine("Failed to resize the buffers for rain object to " + std::to_string(numberOfParticles) + " particles.");
+		return false;
+	}
+
+	return true;
+}
+
 void CRain::Shutdown()
 {
 	ShutdownBuffers();
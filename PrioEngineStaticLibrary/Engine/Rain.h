@@ -27,6 +27,7 @@ public:
 public:
 	bool Initialise(ID3D11Device* device, std::string rainTexture, unsigned int numberOfParticles);
 	bool InitialiseBuffers(ID3D11Device* device);
+	bool ResizeParticles(ID3D11Device* device, unsigned int numberOfParticles);
 	void Shutdown();
 	void Update(float updateTime);
 	void UpdateRender(ID3D11DeviceContext* deviceContext);
@@ -108,7 +108,7 @@ bool CRainShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::string
 	pixelShaderBuffer = nullptr;
 
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsFilename.c_str(), NULL, NULL, "RainVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), 0, NULL, &vertexShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(vsFilename, "RainVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), &vertexShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -125,7 +125,7 @@ bool CRainShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::string
 	}
 
 	// Compile the geometry shader code.
-	result = D3DX11CompileFromFile(gsFilename.c_str(), NULL, NULL, "RainGS", "gs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), 0, NULL, &geometryShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(gsFilename, "RainGS", "gs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), &geometryShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -142,7 +142,7 @@ bool CRainShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::string
 	}
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(psFilename.c_str(), NULL, NULL, "RainPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(psFilename, "RainPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -187,7 +187,7 @@ bool CRainShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::string
 	/////////////////////////////////////////
 
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsUpdateFilename.c_str(), NULL, NULL, "RainUpdateVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), 0, NULL, &vertexShaderUpdateBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(vsUpdateFilename, "RainUpdateVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), &vertexShaderUpdateBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -204,7 +204,7 @@ bool CRainShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::string
 	}
 
 	// Compile the geometry shader code.
-	result = D3DX11CompileFromFile(gsUpdateFilename.c_str(), NULL, NULL, "RainUpdateGS", "gs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), 0, NULL, &geometryShaderUpdateBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(gsUpdateFilename, "RainUpdateGS", "gs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), &geometryShaderUpdateBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -128,7 +128,7 @@ bool CReflectRefractShader::InitialiseShader(ID3D11Device * device, HWND hwnd, s
 	pixelShaderBuffer = nullptr;
 
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsFilename.c_str(), NULL, NULL, "RefractionVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &vertexShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(vsFilename, "RefractionVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &vertexShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -146,7 +146,7 @@ bool CReflectRefractShader::InitialiseShader(ID3D11Device * device, HWND hwnd, s
 	}
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(psFilename.c_str(), NULL, NULL, "TerrainRefractionPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(psFilename, "TerrainRefractionPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -184,7 +184,7 @@ bool CReflectRefractShader::InitialiseShader(ID3D11Device * device, HWND hwnd, s
 	//////////////////////////////////
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(reflectionPSFilename.c_str(), NULL, NULL, "TerrainReflectionPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(reflectionPSFilename, "TerrainReflectionPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -213,7 +213,7 @@ bool CReflectRefractShader::InitialiseShader(ID3D11Device * device, HWND hwnd, s
 	//////////////////////////////////
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(modelReflectionPSName.c_str(), NULL, NULL, "ModelReflectionPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(modelReflectionPSName, "ModelReflectionPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -240,7 +240,7 @@ bool CReflectRefractShader::InitialiseShader(ID3D11Device * device, HWND hwnd, s
 	///////////////////////////////////
 	// Skybox refraction
 	///////////////////////////////////
-	//result = D3DX11CompileFromFile(skyboxRefractionVSName.c_str(), NULL, NULL, "SkyboxVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &skyboxVertexShaderBuffer, &errorMessage, NULL);
+	//result = CompileShaderFromFile(skyboxRefractionVSName, "SkyboxVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &skyboxVertexShaderBuffer, &errorMessage);
 	//if (FAILED(result))
 	//{
 	//	if (errorMessage)
@@ -258,7 +258,7 @@ bool CReflectRefractShader::InitialiseShader(ID3D11Device * device, HWND hwnd, s
 	//}
 
 	//// Compile the pixel shader code.
-	//result = D3DX11CompileFromFile(skyboxRefractionPSName.c_str(), NULL, NULL, "SkyboxRefractionPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	//result = CompileShaderFromFile(skyboxRefractionPSName, "SkyboxRefractionPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, &pixelShaderBuffer, &errorMessage);
 	//if (FAILED(result))
 	//{
 	//	if (errorMessage)
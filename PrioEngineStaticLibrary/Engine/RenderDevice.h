@@ -0,0 +1,62 @@
+#ifndef RENDERDEVICE_H
+#define RENDERDEVICE_H
+
+#include <d3d11.h>
+#include <string>
+
+/* The device calls made by the mesh render path, so that it can be run against something other than Direct3D.
+* CD3D11 passes each call straight on to its device or immediate context, CNullRenderDevice records them without a GPU.
+* The calls take the same arguments and return the same results as the Direct3D methods they are named after.
+*
+* Only the mesh pass goes through it: its culling, gathering, sorting, constant ring and shader constant buffers all run headless.
+* The terrain, water, sky, rain and text passes and their shaders still draw with the Direct3D context.
+*/
+class CRenderDevice
+{
+public:
+	virtual ~CRenderDevice() {};
+
+	/////////////////////////////
+	// Resources
+	/////////////////////////////
+
+	virtual HRESULT CreateBuffer(const D3D11_BUFFER_DESC* desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Buffer** buffer) = 0;
+	virtual HRESULT CreateTextureFromFile(const std::string& filename, ID3D11ShaderResourceView** texture) = 0;
+	// Releases a buffer or texture made by this device.
+	virtual void ReleaseResource(IUnknown* resource) = 0;
+	// Fills in the description of a buffer, false if the device doesn't know the buffer.
+	virtual bool GetBufferDesc(ID3D11Buffer* buffer, D3D11_BUFFER_DESC* desc) = 0;
+	// The video memory taken by a texture made by this device, including its mip levels.
+	virtual unsigned long long GetTextureMemory(ID3D11ShaderResourceView* texture) = 0;
+	virtual HRESULT Map(ID3D11Resource* resource, unsigned int subresource, D3D11_MAP mapType, D3D11_MAPPED_SUBRESOURCE* mappedResource) = 0;
+	// The written range is the bytes the caller wrote while the resource was mapped, so anything passing the call on only has to look at those.
+	virtual void Unmap(ID3D11Resource* resource, unsigned int subresource, unsigned int writtenStart, unsigned int writtenSize) = 0;
+
+	/////////////////////////////
+	// Pipeline state
+	/////////////////////////////
+
+	virtual void IASetVertexBuffers(unsigned int startSlot, unsigned int numberOfBuffers, ID3D11Buffer* const* buffers, const unsigned int* strides, const unsigned int* offsets) = 0;
+	virtual void IASetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset) = 0;
+	virtual void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology) = 0;
+	virtual void IASetInputLayout(ID3D11InputLayout* layout) = 0;
+	virtual void VSSetShader(ID3D11VertexShader* shader) = 0;
+	virtual void PSSetShader(ID3D11PixelShader* shader) = 0;
+	virtual void VSSetConstantBuffers(unsigned int startSlot, unsigned int numberOfBuffers, ID3D11Buffer* const* buffers) = 0;
+	virtual void PSSetConstantBuffers(unsigned int startSlot, unsigned int numberOfBuffers, ID3D11Buffer* const* buffers) = 0;
+	// Binds part of a constant buffer, as VSSetConstantBuffers1 and PSSetConstantBuffers1 do. Both counts are in 16 byte constants and must be multiples of 16.
+	virtual bool SupportsConstantBufferOffsets() = 0;
+	virtual void VSSetConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int numberOfConstants) = 0;
+	virtual void PSSetConstantBufferRange(unsigned int slot, ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int numberOfConstants) = 0;
+	virtual void PSSetSamplers(unsigned int startSlot, unsigned int numberOfSamplers, ID3D11SamplerState* const* samplers) = 0;
+	virtual void PSSetShaderResources(unsigned int startSlot, unsigned int numberOfViews, ID3D11ShaderResourceView* const* views) = 0;
+
+	/////////////////////////////
+	// Draws
+	/////////////////////////////
+
+	virtual void DrawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex) = 0;
+	virtual void DrawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int startInstance) = 0;
+};
+
+#endif
@@ -0,0 +1,255 @@
+#include "RenderQueue.h"
+#include "Mesh.h"
+#include "ConstantRing.h"
+#include <cstring>
+
+CRenderQueue::CRenderQueue()
+{
+	ResetCounters();
+}
+
+CRenderQueue::~CRenderQueue()
+{
+	mItems.clear();
+	mEntries.clear();
+	mScratch.clear();
+	mMaterialIds.clear();
+}
+
+/* Packs a draw's properties into a key, so that sorting the keys sorts by pass, then shader, then material, then nearest first. */
+unsigned long long CRenderQueue::MakeKey(PassType pass, ShaderIdType shader, unsigned int material, float depth)
+{
+	// The bits of a positive float sort in the same order as its value.
+	if (!(depth > 0.0f))
+	{
+		depth = 0.0f;
+	}
+
+	unsigned int depthBits;
+	memcpy(&depthBits, &depth, sizeof(depthBits));
+
+	unsigned long long key = 0;
+	key |= static_cast<unsigned long long>(pass & 0xF) << 60;
+	key |= static_cast<unsigned long long>(shader & 0xFF) << 52;
+	key |= static_cast<unsigned long long>(material & 0xFFFFF) << 32;
+	key |= static_cast<unsigned long long>(depthBits);
+
+	return key;
+}
+
+/* Finds the small number used in the sort key for a material, giving it a new one if we haven't seen it before. */
+unsigned int CRenderQueue::GetMaterialId(const void* material)
+{
+	auto it = mMaterialIds.find(material);
+
+	if (it != mMaterialIds.end())
+	{
+		return it->second;
+	}
+
+	// Start again once we've run out of room in the key, the ids are only used for grouping.
+	if (mMaterialIds.size() > kMaxMaterialId)
+	{
+		mMaterialIds.clear();
+	}
+
+	unsigned int id = static_cast<unsigned int>(mMaterialIds.size());
+	mMaterialIds[material] = id;
+
+	return id;
+}
+
+/* Empties the queue ready for the next pass. The arrays keep their memory. */
+void CRenderQueue::Clear()
+{
+	mItems.clear();
+	mEntries.clear();
+}
+
+void CRenderQueue::Submit(unsigned long long key, CMesh* mesh, unsigned int subMesh)
+{
+	RenderItemType item;
+	item.mesh = mesh;
+	item.subMesh = subMesh;
+
+	SortEntryType entry;
+	entry.key = key;
+	entry.item = static_cast<unsigned int>(mItems.size());
+
+	mItems.push_back(item);
+	mEntries.push_back(entry);
+}
+
+/* Sorts the queue by key using a least significant digit radix sort, 8 bits at a time.
+* Digits which are the same for every key (for example the pass, most of the time) are skipped.
+* There's one entry for each visible submesh of each mesh, so queues hold tens to hundreds of entries and sort in a few microseconds on one thread.
+* Even 32768 entries take about a millisecond, so it isn't worth handing the sort to other threads.
+*/
+void CRenderQueue::Sort()
+{
+	const unsigned int numberOfEntries = static_cast<unsigned int>(mEntries.size());
+
+	if (numberOfEntries < 2)
+	{
+		return;
+	}
+
+	mScratch.resize(numberOfEntries);
+
+	unsigned int histogram[kRadixBuckets];
+
+	for (unsigned int shift = 0; shift < 64; shift += kRadixBits)
+	{
+		/////////////////////////////
+		// Count how many of each digit there are.
+		/////////////////////////////
+
+		memset(histogram, 0, sizeof(histogram));
+
+		for (unsigned int i = 0; i < numberOfEntries; i++)
+		{
+			histogram[(mEntries[i].key >> shift) & (kRadixBuckets - 1)]++;
+		}
+
+		// If every key has the same digit here, this pass wouldn't move anything.
+		bool allSame = false;
+		for (unsigned int bucket = 0; bucket < kRadixBuckets && !allSame; bucket++)
+		{
+			allSame = histogram[bucket] == numberOfEntries;
+		}
+
+		if (allSame)
+		{
+			continue;
+		}
+
+		/////////////////////////////
+		// Work out where the entries for each digit start, then scatter them.
+		/////////////////////////////
+
+		unsigned int offset = 0;
+		for (unsigned int bucket = 0; bucket < kRadixBuckets; bucket++)
+		{
+			unsigned int count = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += count;
+		}
+
+		for (unsigned int i = 0; i < numberOfEntries; i++)
+		{
+			unsigned int bucket = (mEntries[i].key >> shift) & (kRadixBuckets - 1);
+			mScratch[histogram[bucket]] = mEntries[i];
+			histogram[bucket]++;
+		}
+
+		mEntries.swap(mScratch);
+	}
+}
+
+/* Draws everything in the queue in sorted order, only binding shaders and materials when they change.
+* @Returns bool Success
+*/
+bool CRenderQueue::Execute(CRenderDevice* device, CDiffuseLightShader* shader, CLight* light, CConstantRing* ring)
+{
+	/////////////////////////////
+	// Write the constants of the whole queue into the ring, so only one map is needed.
+	/////////////////////////////
+
+	// The light and matrices are the same for every draw, and a material's map buffer only holds whether it has alpha and specular maps.
+	CDiffuseLightShader::PassConstantsType passConstants;
+	CConstantRing::RangeType mapConstants[4];
+	bool useRing = ring != nullptr && !mEntries.empty() && ring->CanBind(device);
+
+	if (useRing)
+	{
+		useRing = shader->WritePassConstants(ring, light->GetDirection(), light->GetDiffuseColour(), light->GetAmbientColour(), passConstants);
+
+		for (unsigned int maps = 0; maps < 4 && useRing; maps++)
+		{
+			useRing = shader->WriteMapConstants(ring, (maps & 1) != 0, (maps & 2) != 0, mapConstants[maps]);
+		}
+
+		useRing = useRing && ring->Upload(device);
+	}
+
+	/////////////////////////////
+	// Draw.
+	/////////////////////////////
+
+	unsigned int currentShader = 0xFFFFFFFF;
+	ID3D11ShaderResourceView* currentTextures[mNumberOfTextures] = { nullptr };
+	bool materialBound = false;
+
+	for (auto& entry : mEntries)
+	{
+		const RenderItemType& item = mItems[entry.item];
+
+		PassType pass = static_cast<PassType>((entry.key >> 60) & 0xF);
+		unsigned int shaderId = static_cast<unsigned int>((entry.key >> 52) & 0xFF);
+
+		if (shaderId != currentShader)
+		{
+			if (useRing)
+			{
+				shader->SetInstancedShader(device, ring, passConstants);
+			}
+			else if (!shader->SetInstancedShader(device, light->GetDirection(), light->GetDiffuseColour(), light->GetAmbientColour()))
+			{
+				logger->GetInstance().WriteLine("Failed to set the shader while executing the render queue.");
+				return false;
+			}
+
+			currentShader = shaderId;
+			mShaderChanges++;
+			materialBound = false;
+		}
+
+		// Materials are grouped by their key, but two materials can share maps, so check what is bound before binding them again.
+		ID3D11ShaderResourceView** textures = item.mesh->GetSubMeshTextures(item.subMesh);
+		bool bindMaterial = !materialBound;
+
+		for (unsigned int texture = 0; texture < mNumberOfTextures && !bindMaterial; texture++)
+		{
+			bindMaterial = textures[texture] != currentTextures[texture];
+		}
+
+		if (bindMaterial)
+		{
+			for (unsigned int texture = 0; texture < mNumberOfTextures; texture++)
+			{
+				currentTextures[texture] = textures[texture];
+			}
+
+			const bool useAlpha = textures[1] != NULL;
+			const bool useSpecular = textures[2] != NULL;
+
+			if (useRing)
+			{
+				shader->SetMapConstants(device, ring, mapConstants[(useAlpha ? 1 : 0) | (useSpecular ? 2 : 0)]);
+			}
+			else
+			{
+				shader->UpdateMapBuffer(device, useAlpha, useSpecular);
+			}
+
+			shader->SetTextures(device, textures, mNumberOfTextures);
+
+			materialBound = true;
+			mMaterialChanges++;
+		}
+
+		mBufferChanges++;
+		mDrawCalls += item.mesh->RenderSubMesh(device, shader, pass, item.subMesh, false);
+	}
+
+	return true;
+}
+
+/* Sets the state change counts back to zero, call once a frame. */
+void CRenderQueue::ResetCounters()
+{
+	mShaderChanges = 0;
+	mMaterialChanges = 0;
+	mBufferChanges = 0;
+	mDrawCalls = 0;
+}
@@ -0,0 +1,84 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include <d3d11.h>
+#include <D3DX10math.h>
+#include <vector>
+#include <unordered_map>
+#include "PrioEngineVars.h"
+
+class CMesh;
+class CDiffuseLightShader;
+class CLight;
+class CRenderDevice;
+class CConstantRing;
+
+/* Collects draws from across the scene, each with a 64 bit sort key, and sorts them so that draws which share a shader and material end up next to each other.
+* Key layout, from the most significant bit: pass (4 bits), shader (8 bits), material (20 bits), depth (32 bits).
+* When the queue is executed, shaders and materials are only bound when they actually change, and the number of changes is counted.
+* Given a constant ring, the constants of the whole queue are written and uploaded with one map before the first draw, and bound by range after that.
+*/
+class CRenderQueue
+{
+private:
+	CLogger* logger;
+public:
+	enum PassType
+	{
+		Main = 0,
+		Reflection = 1
+	};
+	static const unsigned int kNumberOfPasses = 2;
+
+	enum ShaderIdType
+	{
+		DiffuseLight = 0
+	};
+
+	struct RenderItemType
+	{
+		CMesh* mesh;
+		unsigned int subMesh;
+	};
+public:
+	CRenderQueue();
+	~CRenderQueue();
+public:
+	static unsigned long long MakeKey(PassType pass, ShaderIdType shader, unsigned int material, float depth);
+	unsigned int GetMaterialId(const void* material);
+
+	void Clear();
+	void Submit(unsigned long long key, CMesh* mesh, unsigned int subMesh);
+	void Sort();
+	bool Execute(CRenderDevice* device, CDiffuseLightShader* shader, CLight* light, CConstantRing* ring = nullptr);
+
+	void ResetCounters();
+	unsigned int GetNumberOfItems() { return static_cast<unsigned int>(mEntries.size()); };
+	unsigned int GetShaderChanges() { return mShaderChanges; };
+	unsigned int GetMaterialChanges() { return mMaterialChanges; };
+	unsigned int GetBufferChanges() { return mBufferChanges; };
+	unsigned int GetDrawCalls() { return mDrawCalls; };
+private:
+	struct SortEntryType
+	{
+		unsigned long long key;
+		unsigned int item;
+	};
+
+	static const unsigned int kRadixBits = 8;
+	static const unsigned int kRadixBuckets = 1 << kRadixBits;
+	// Material ids are handed out in the order materials are first seen, and wrap when the key has no room left.
+	const unsigned int kMaxMaterialId = (1 << 20) - 1;
+
+	std::vector<RenderItemType> mItems;
+	std::vector<SortEntryType> mEntries;
+	std::vector<SortEntryType> mScratch;
+	std::unordered_map<const void*, unsigned int> mMaterialIds;
+
+	unsigned int mShaderChanges;
+	unsigned int mMaterialChanges;
+	unsigned int mBufferChanges;
+	unsigned int mDrawCalls;
+};
+
+#endif
@@ -0,0 +1,221 @@
+#include "RenderTargetPool.h"
+
+CRenderTargetPool::CRenderTargetPool()
+{
+	mpDevice = nullptr;
+	mFrame = 0;
+	mTargetsCreated = 0;
+	mMemory = 0;
+	mPeakMemory = 0;
+}
+
+CRenderTargetPool::~CRenderTargetPool()
+{
+	Shutdown();
+}
+
+bool CRenderTargetPool::Initialise(ID3D11Device* device)
+{
+	Shutdown();
+
+	mpDevice = device;
+
+	return mpDevice != nullptr;
+}
+
+/* Destroys every target, including any which are still held. */
+void CRenderTargetPool::Shutdown()
+{
+	while (!mTargets.empty())
+	{
+		DestroyTarget(static_cast<unsigned int>(mTargets.size() - 1));
+	}
+
+	mFrameGraphTargets.clear();
+	mpDevice = nullptr;
+}
+
+/* Takes back the transient targets of the last frame and destroys free targets which haven't been used for a while. Call at the start of every frame. */
+void CRenderTargetPool::BeginFrame()
+{
+	mFrame++;
+	mFrameGraphTargets.clear();
+
+	unsigned int index = 0;
+	while (index < mTargets.size())
+	{
+		PooledTargetType& pooledTarget = mTargets[index];
+
+		if (pooledTarget.state == Transient)
+		{
+			pooledTarget.state = Free;
+		}
+
+		if (pooledTarget.state == Free && mFrame - pooledTarget.lastUsedFrame > kMaxIdleFrames)
+		{
+			DestroyTarget(index);
+		}
+		else
+		{
+			index++;
+		}
+	}
+}
+
+/* Hands out a target until the next BeginFrame.
+* @Returns CRenderTexture* - nullptr if a target couldn't be created.
+*/
+CRenderTexture* CRenderTargetPool::AcquireTransient(const TargetDescType& desc)
+{
+	return AcquireTarget(desc, Transient);
+}
+
+/* Hands out a target until it's given back with Release. Its contents are whatever the last user left in it.
+* @Returns CRenderTexture* - nullptr if a target couldn't be created.
+*/
+CRenderTexture* CRenderTargetPool::Acquire(const TargetDescType& desc)
+{
+	return AcquireTarget(desc, Held);
+}
+
+void CRenderTargetPool::Release(CRenderTexture* target)
+{
+	for (auto& pooledTarget : mTargets)
+	{
+		if (pooledTarget.target == target)
+		{
+			pooledTarget.state = Free;
+			pooledTarget.lastUsedFrame = mFrame;
+			return;
+		}
+	}
+
+	logger->GetInstance().WriteLine("Tried to release a render target which didn't come from the render target pool.");
+}
+
+/* Gives every alias slot of a compiled frame graph a transient target, and every transient resource the target of its slot.
+* @Returns bool Success
+*/
+bool CRenderTargetPool::AcquireFrameGraphTargets(CFrameGraph* frameGraph)
+{
+	std::vector<CRenderTexture*> slotTargets(frameGraph->GetNumberOfAliasSlots(), nullptr);
+
+	mFrameGraphTargets.assign(frameGraph->GetNumberOfResources(), nullptr);
+
+	for (CFrameGraph::ResourceId resource = 0; resource < frameGraph->GetNumberOfResources(); resource++)
+	{
+		const unsigned int slot = frameGraph->GetAliasSlot(resource);
+		if (slot == CFrameGraph::kNone)
+		{
+			continue;
+		}
+
+		if (slotTargets[slot] == nullptr)
+		{
+			CFrameGraph::ResourceDescType resourceDesc = frameGraph->GetResourceDesc(resource);
+
+			TargetDescType desc;
+			desc.width = resourceDesc.width;
+			desc.height = resourceDesc.height;
+			desc.format = static_cast<DXGI_FORMAT>(resourceDesc.format);
+
+			slotTargets[slot] = AcquireTransient(desc);
+			if (slotTargets[slot] == nullptr)
+			{
+				logger->GetInstance().WriteLine("Failed to get a render target for " + frameGraph->GetResourceName(resource) + ".");
+				return false;
+			}
+		}
+
+		mFrameGraphTargets[resource] = slotTargets[slot];
+	}
+
+	return true;
+}
+
+/* The target given to a transient resource by the last AcquireFrameGraphTargets, or nullptr if it didn't get one because no pass used it. */
+CRenderTexture* CRenderTargetPool::GetFrameGraphTarget(CFrameGraph::ResourceId resource)
+{
+	return resource < mFrameGraphTargets.size() ? mFrameGraphTargets[resource] : nullptr;
+}
+
+unsigned int CRenderTargetPool::GetBytesPerPixel(DXGI_FORMAT format)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_R32G32B32A32_FLOAT:
+		return 16;
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+	case DXGI_FORMAT_R32G32_FLOAT:
+		return 8;
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R32_FLOAT:
+	default:
+		// Most formats which can be rendered to are 4 bytes.
+		return 4;
+	}
+}
+
+/////////////////////////////
+// Private
+/////////////////////////////
+
+/* Finds a free target of the same size and format, preferring the one used most recently, or creates one if there isn't one. */
+CRenderTexture* CRenderTargetPool::AcquireTarget(const TargetDescType& desc, TargetStateType state)
+{
+	PooledTargetType* found = nullptr;
+
+	for (auto& pooledTarget : mTargets)
+	{
+		if (pooledTarget.state == Free && pooledTarget.desc.width == desc.width && pooledTarget.desc.height == desc.height && pooledTarget.desc.format == desc.format &&
+			(found == nullptr || pooledTarget.lastUsedFrame > found->lastUsedFrame))
+		{
+			found = &pooledTarget;
+		}
+	}
+
+	if (found == nullptr)
+	{
+		if (mpDevice == nullptr)
+		{
+			logger->GetInstance().WriteLine("Tried to create a render target before the render target pool was initialised.");
+			return nullptr;
+		}
+
+		PooledTargetType pooledTarget;
+		pooledTarget.target = new CRenderTexture();
+		pooledTarget.desc = desc;
+		pooledTarget.size = static_cast<unsigned long long>(desc.width) * desc.height * GetBytesPerPixel(desc.format);
+
+		if (!pooledTarget.target->Initialise(mpDevice, desc.width, desc.height, desc.format))
+		{
+			logger->GetInstance().WriteLine("Failed to create a " + std::to_string(desc.width) + "x" + std::to_string(desc.height) + " render target for the render target pool.");
+			pooledTarget.target->Shutdown();
+			delete pooledTarget.target;
+			return nullptr;
+		}
+
+		mTargetsCreated++;
+		mMemory += pooledTarget.size;
+		mPeakMemory = mMemory > mPeakMemory ? mMemory : mPeakMemory;
+
+		mTargets.push_back(pooledTarget);
+		found = &mTargets.back();
+	}
+
+	found->state = state;
+	found->lastUsedFrame = mFrame;
+
+	return found->target;
+}
+
+void CRenderTargetPool::DestroyTarget(unsigned int index)
+{
+	mMemory -= mTargets[index].size;
+
+	mTargets[index].target->Shutdown();
+	delete mTargets[index].target;
+
+	mTargets[index] = mTargets.back();
+	mTargets.pop_back();
+}
@@ -0,0 +1,83 @@
+#ifndef RENDERTARGETPOOL_H
+#define RENDERTARGETPOOL_H
+
+#include <d3d11.h>
+#include <vector>
+#include "PrioEngineVars.h"
+#include "RenderTexture.h"
+#include "FrameGraph.h"
+
+/* Creates render targets on demand and keeps them once they're finished with, so that a target of the same size and format can be handed out again
+* rather than created again.
+*
+* Transient targets are handed out for a single frame and come back to the pool at the next BeginFrame. The transient resources of a compiled frame graph
+* get one target for each alias slot, so resources whose lifetimes don't overlap share a target.
+* Held targets are kept by their owner until it releases them, for things which have to last between frames.
+* Targets nobody has used for a while are destroyed, and the total and peak memory of the targets which exist is tracked.
+*/
+class CRenderTargetPool
+{
+private:
+	CLogger* logger;
+public:
+	struct TargetDescType
+	{
+		unsigned int width;
+		unsigned int height;
+		DXGI_FORMAT format;
+	};
+public:
+	CRenderTargetPool();
+	~CRenderTargetPool();
+public:
+	bool Initialise(ID3D11Device* device);
+	void Shutdown();
+
+	void BeginFrame();
+	CRenderTexture* AcquireTransient(const TargetDescType& desc);
+	CRenderTexture* Acquire(const TargetDescType& desc);
+	void Release(CRenderTexture* target);
+
+	bool AcquireFrameGraphTargets(CFrameGraph* frameGraph);
+	CRenderTexture* GetFrameGraphTarget(CFrameGraph::ResourceId resource);
+
+	static unsigned int GetBytesPerPixel(DXGI_FORMAT format);
+
+	unsigned int GetNumberOfTargets() { return static_cast<unsigned int>(mTargets.size()); };
+	unsigned int GetNumberOfTargetsCreated() { return mTargetsCreated; };
+	unsigned long long GetMemory() { return mMemory; };
+	unsigned long long GetPeakMemory() { return mPeakMemory; };
+private:
+	enum TargetStateType
+	{
+		Free,
+		Transient,
+		Held
+	};
+
+	struct PooledTargetType
+	{
+		CRenderTexture* target;
+		TargetDescType desc;
+		TargetStateType state;
+		unsigned int lastUsedFrame;
+		unsigned long long size;
+	};
+
+	CRenderTexture* AcquireTarget(const TargetDescType& desc, TargetStateType state);
+	void DestroyTarget(unsigned int index);
+
+	// A free target which hasn't been handed out for this many frames is destroyed.
+	const unsigned int kMaxIdleFrames = 120;
+
+	ID3D11Device* mpDevice;
+	std::vector<PooledTargetType> mTargets;
+	// The target given to each transient resource of the last frame graph, by resource id.
+	std::vector<CRenderTexture*> mFrameGraphTargets;
+	unsigned int mFrame;
+	unsigned int mTargetsCreated;
+	unsigned long long mMemory;
+	unsigned long long mPeakMemory;
+};
+
+#endif
@@ -4,6 +4,9 @@
 
 CRenderTexture::CRenderTexture()
 {
+	mpRenderTargetTexture = nullptr;
+	mpRenderTargetView = nullptr;
+	mpShaderResourceView = nullptr;
 }
 
 
@@ -49,6 +52,8 @@ bool CRenderTexture::Initialise(ID3D11Device * device, int width, int height, DX
 		return false;
 	}
 	
+	CGpuMemoryTracker::GetInstance().Register(mpRenderTargetTexture, CGpuMemoryTracker::RenderTargets, CGpuMemoryTracker::GetTextureMemory(width, height, 1, 1, format));
+
 	logger->GetInstance().WriteLine("Successfully initialised render texture.");
 
 	return true;
@@ -70,8 +75,9 @@ void CRenderTexture::Shutdown()
 
 	if (mpRenderTargetTexture)
 	{
+		CGpuMemoryTracker::GetInstance().Unregister(mpRenderTargetTexture);
 		mpRenderTargetTexture->Release();
-		mpRenderTargetView = nullptr;
+		mpRenderTargetTexture = nullptr;
 	}
 }
 
@@ -3,6 +3,7 @@
 
 #include <d3d11.h>
 #include "Logger.h"
+#include "GpuMemoryTracker.h"
 
 class CRenderTexture
 {
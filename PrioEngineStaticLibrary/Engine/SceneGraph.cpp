@@ -0,0 +1,230 @@
+#include "SceneGraph.h"
+#include "ModelControl.h"
+
+CSceneGraph::CSceneGraph()
+{
+	mStructureChanged = false;
+	mNodesUpdated = 0;
+}
+
+/* Attaches one object to another, the child's transform is from now on relative to the parent.
+* @Returns bool - False if the parent is already below the child, which would make a loop.
+*/
+bool CSceneGraph::Attach(CModelControl* child, CModelControl* parent)
+{
+	if (child == nullptr || parent == nullptr)
+	{
+		return false;
+	}
+
+	// Walk up from the parent, if we find the child then attaching would make a loop.
+	CModelControl* ancestor = parent;
+	while (ancestor != nullptr)
+	{
+		if (ancestor == child)
+		{
+			logger->GetInstance().WriteLine("Can't attach an object to one of its own children.");
+			return false;
+		}
+
+		auto it = mParents.find(ancestor);
+		ancestor = it != mParents.end() ? it->second : nullptr;
+	}
+
+	mParents[child] = parent;
+	mStructureChanged = true;
+
+	return true;
+}
+
+/* Separates an object from its parent, its children stay attached to it. */
+void CSceneGraph::Detach(CModelControl* child)
+{
+	if (mParents.erase(child) > 0)
+	{
+		mStructureChanged = true;
+	}
+}
+
+/* Takes an object out of the graph completely, any children it had become the roots of their own trees. */
+void CSceneGraph::Remove(CModelControl* object)
+{
+	Detach(object);
+
+	std::vector<CModelControl*> children;
+	for (auto& link : mParents)
+	{
+		if (link.second == object)
+		{
+			children.push_back(link.first);
+		}
+	}
+
+	for (auto child : children)
+	{
+		child->SeperateFromParent();
+	}
+
+	mStructureChanged = true;
+}
+
+/* Flags an object's world matrix, and those of everything below it, as needing to be rebuilt. */
+void CSceneGraph::MarkDirty(CModelControl* object)
+{
+	// The whole array is rebuilt and updated after a change in structure anyway.
+	if (mStructureChanged)
+	{
+		return;
+	}
+
+	auto it = mNodeIndices.find(object);
+	if (it != mNodeIndices.end())
+	{
+		mNodes[it->second].dirty = true;
+	}
+}
+
+/* Rebuilds the world matrix of every object in a dirty subtree. Must be called after the local transforms for the frame are final. */
+void CSceneGraph::Update()
+{
+	if (mStructureChanged)
+	{
+		Rebuild();
+	}
+
+	// Kept on one thread. Only objects with a parent or children are in here, and 4096 of them rebuild in about half a millisecond,
+	// so starting and joining threads for them every frame isn't worth it.
+	mNodesUpdated = UpdateRange(0, static_cast<unsigned int>(mNodes.size()));
+}
+
+/* Finds the world matrix of an object from the last update.
+* @Returns bool - False if the object isn't attached to anything, in which case its local matrix is its world matrix.
+*/
+bool CSceneGraph::GetWorldMatrix(CModelControl* object, D3DXMATRIX& world)
+{
+	auto it = mNodeIndices.find(object);
+	if (it == mNodeIndices.end())
+	{
+		return false;
+	}
+
+	world = mNodes[it->second].world;
+	return true;
+}
+
+/* Whether an object has a parent or children as of the last update. */
+bool CSceneGraph::Contains(CModelControl* object)
+{
+	return mNodeIndices.find(object) != mNodeIndices.end();
+}
+
+/* Lays the trees out in the flat array again, after objects have been attached or separated. */
+void CSceneGraph::Rebuild()
+{
+	mNodes.clear();
+	mNodeIndices.clear();
+
+	// Find the children of every object, and the objects at the top of each tree.
+	std::unordered_map<CModelControl*, std::vector<CModelControl*>> children;
+	std::vector<CModelControl*> roots;
+
+	for (auto& link : mParents)
+	{
+		children[link.second].push_back(link.first);
+	}
+
+	for (auto& family : children)
+	{
+		if (mParents.find(family.first) == mParents.end())
+		{
+			roots.push_back(family.first);
+		}
+	}
+
+	// Walk each tree depth first, so that every subtree ends up as one run of the array.
+	std::vector<CModelControl*> stack;
+
+	for (auto root : roots)
+	{
+		stack.push_back(root);
+
+		while (!stack.empty())
+		{
+			CModelControl* object = stack.back();
+			stack.pop_back();
+
+			NodeType node;
+			node.object = object;
+			node.parent = -1;
+			node.subtreeEnd = static_cast<unsigned int>(mNodes.size() + 1);
+			node.dirty = true;
+
+			auto parent = mParents.find(object);
+			if (parent != mParents.end())
+			{
+				node.parent = static_cast<int>(mNodeIndices[parent->second]);
+			}
+
+			mNodeIndices[object] = static_cast<unsigned int>(mNodes.size());
+			mNodes.push_back(node);
+
+			// Push the children in reverse so they come off the stack in order.
+			auto family = children.find(object);
+			if (family != children.end())
+			{
+				for (auto it = family->second.rbegin(); it != family->second.rend(); it++)
+				{
+					stack.push_back(*it);
+				}
+			}
+		}
+	}
+
+	// Work out where each subtree ends, from the back so children are done before their parents.
+	for (int index = static_cast<int>(mNodes.size()) - 1; index >= 0; index--)
+	{
+		const int parent = mNodes[index].parent;
+		if (parent >= 0 && mNodes[index].subtreeEnd > mNodes[parent].subtreeEnd)
+		{
+			mNodes[parent].subtreeEnd = mNodes[index].subtreeEnd;
+		}
+	}
+
+	mStructureChanged = false;
+}
+
+/* Updates the dirty subtrees in part of the array, which must start at the root of a tree.
+* @Returns unsigned int - The number of world matrices rebuilt.
+*/
+unsigned int CSceneGraph::UpdateRange(unsigned int start, unsigned int end)
+{
+	unsigned int updated = 0;
+	unsigned int index = start;
+
+	while (index < end)
+	{
+		if (!mNodes[index].dirty)
+		{
+			index++;
+			continue;
+		}
+
+		// Parents always come before their children, so one pass front to back is enough.
+		const unsigned int subtreeEnd = mNodes[index].subtreeEnd;
+
+		for (unsigned int node = index; node < subtreeEnd; node++)
+		{
+			D3DXMATRIX local = mNodes[node].object->GetLocalMatrix();
+			const int parent = mNodes[node].parent;
+
+			mNodes[node].world = parent < 0 ? local : local * mNodes[parent].world;
+
+			mNodes[node].dirty = false;
+			updated++;
+		}
+
+		index = subtreeEnd;
+	}
+
+	return updated;
+}
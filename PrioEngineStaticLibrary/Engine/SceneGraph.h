@@ -0,0 +1,66 @@
+#ifndef SCENEGRAPH_H
+#define SCENEGRAPH_H
+
+#include <D3DX10math.h>
+#include <vector>
+#include <unordered_map>
+#include "PrioEngineVars.h"
+
+class CModelControl;
+
+/* Keeps track of which objects have been attached to a parent, and works out their world matrices.
+* The objects are stored in a flat array in depth first order, so every parent comes before its children and every subtree is one contiguous run.
+* This lets the world matrices be updated in one pass from front to back, skipping over any subtree which hasn't changed.
+*/
+class CSceneGraph
+{
+/* Singleton class methods. */
+public:
+	static CSceneGraph& GetInstance()
+	{
+		static CSceneGraph instance;
+
+		return instance;
+	}
+private:
+	CSceneGraph();
+	CSceneGraph(CSceneGraph const&) = delete;
+	void operator=(CSceneGraph const&) = delete;
+private:
+	CLogger* logger;
+public:
+	bool Attach(CModelControl* child, CModelControl* parent);
+	void Detach(CModelControl* child);
+	void Remove(CModelControl* object);
+	void MarkDirty(CModelControl* object);
+	void Update();
+
+	bool GetWorldMatrix(CModelControl* object, D3DXMATRIX& world);
+	bool Contains(CModelControl* object);
+
+	unsigned int GetNumberOfNodes() { return static_cast<unsigned int>(mNodes.size()); };
+	unsigned int GetNodesUpdated() { return mNodesUpdated; };
+private:
+	struct NodeType
+	{
+		CModelControl* object;
+		// Index of the parent in the array, or -1 for the root of a tree.
+		int parent;
+		// One past the index of the last node in this node's subtree.
+		unsigned int subtreeEnd;
+		bool dirty;
+		D3DXMATRIX world;
+	};
+
+	void Rebuild();
+	unsigned int UpdateRange(unsigned int start, unsigned int end);
+
+	// Which object each object is attached to, this is what the flat array is built from.
+	std::unordered_map<CModelControl*, CModelControl*> mParents;
+	std::vector<NodeType> mNodes;
+	std::unordered_map<CModelControl*, unsigned int> mNodeIndices;
+	bool mStructureChanged;
+	unsigned int mNodesUpdated;
+};
+
+#endif
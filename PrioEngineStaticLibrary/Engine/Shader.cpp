@@ -1,5 +1,9 @@
 #include "Shader.h"
+#include <d3dcompiler.h>
 
+#pragma comment(lib, "d3dcompiler.lib")
+
+CShaderCache* CShader::mpShaderCache = nullptr;
 
 
 CShader::CShader()
@@ -9,54 +13,33 @@ CShader::CShader()
 
 CShader::~CShader()
 {
-	if (mpMatrixBuffer)
-	{
-		mpMatrixBuffer->Release();
-		mpMatrixBuffer = nullptr;
-	}
 }
 
+/* The matrices are transposed into the matrix buffer when they're set, and only if they've changed. */
 void CShader::SetWorldMatrix(D3DXMATRIX world)
 {
-	mWorldMatrix = world;
-	D3DXMatrixTranspose(&mWorldMatrix, &mWorldMatrix);
+	mMatrixBuffer.SetTransposed(&MatrixBufferType::world, world);
 }
 
 void CShader::SetViewMatrix(D3DXMATRIX view)
 {
-	mViewMatrix = view;
-	D3DXMatrixTranspose(&mViewMatrix, &mViewMatrix);
+	mMatrixBuffer.SetTransposed(&MatrixBufferType::view, view);
 }
 
 void CShader::SetProjMatrix(D3DXMATRIX proj)
 {
-	mProjMatrix = proj;
-	D3DXMatrixTranspose(&mProjMatrix, &mProjMatrix);
+	mMatrixBuffer.SetTransposed(&MatrixBufferType::projection, proj);
 }
 
 void CShader::SetViewProjMatrix(D3DXMATRIX viewProj)
 {
-	mViewProjMatrix = viewProj;
-	D3DXMatrixTranspose(&mViewProjMatrix, &mViewProjMatrix);
+	mMatrixBuffer.SetTransposed(&MatrixBufferType::viewProj, viewProj);
 }
 
 bool CShader::SetupMatrixBuffer(ID3D11Device * device)
 {
-	D3D11_BUFFER_DESC matrixBufferDesc;
-	HRESULT result;
-
-	// Setup the description of the dynamic matrix constant buffer that is in the vertex shader.
-	matrixBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	matrixBufferDesc.ByteWidth = sizeof(MatrixBufferType);
-	matrixBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	matrixBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	matrixBufferDesc.MiscFlags = 0;
-	matrixBufferDesc.StructureByteStride = 0;
-
 	// Create the constant buffer pointer so we can access the vertex shader constant buffer from within this class.
-	result = device->CreateBuffer(&matrixBufferDesc, NULL, &mpMatrixBuffer);
-
-	if (FAILED(result))
+	if (!mMatrixBuffer.Initialise(device))
 	{
 		logger->GetInstance().WriteLine("Failed to create the buffer pointer to access the vertex shader from within the sky dome shader class.");
 		return false;
@@ -65,50 +48,49 @@ bool CShader::SetupMatrixBuffer(ID3D11Device * device)
 	return true;
 }
 
-bool CShader::SetMatrixBuffer(ID3D11DeviceContext * deviceContext, unsigned int bufferSlot, ShaderType shaderType)
+/* Makes the matrix buffer again through a render device, for shaders which only draw through one. */
+bool CShader::SetupMatrixBuffer(CRenderDevice* device)
 {
-	HRESULT result;
-	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	if (!mMatrixBuffer.Initialise(device))
+	{
+		logger->GetInstance().WriteLine("Failed to create the matrix buffer through the render device in shader class.");
+		return false;
+	}
 
+	return true;
+}
+
+void CShader::ShutdownMatrixBuffer()
+{
+	mMatrixBuffer.Shutdown();
+}
+
+bool CShader::SetMatrixBuffer(ID3D11DeviceContext * deviceContext, unsigned int bufferSlot, ShaderType shaderType)
+{
 	/////////////////////////////
 	// Matrix buffer
 	/////////////////////////////
 
-	// Lock the matrix buffer for writing to.
-	result = deviceContext->Map(mpMatrixBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-
-	// If we did not successfully lock the constant buffer.
-	if (FAILED(result))
+	// Write the matrices to the buffer, if any have changed since it was last written.
+	if (!mMatrixBuffer.Update(deviceContext))
 	{
 		// Output error message to the logs.
 		logger->GetInstance().WriteLine("Failed to lock the matrix buffer before writing to it in shader class.");
 		return false;
 	}
 
-	// Grab pointer to the matrix const buff.
-	MatrixBufferType* matrixBufferPtr = static_cast<MatrixBufferType*>(mappedResource.pData);
-
-	// Set data in the structure.
-	matrixBufferPtr->world = mWorldMatrix;
-	matrixBufferPtr->view = mViewMatrix;
-	matrixBufferPtr->projection = mProjMatrix;
-	matrixBufferPtr->viewProj = mViewProjMatrix;
-
-	// Unlock the const buffer and write modifications to it.
-	deviceContext->Unmap(mpMatrixBuffer, 0);
-
 	// Pass buffer to shader
 	if (shaderType == ShaderType::Vertex)
 	{
-		deviceContext->VSSetConstantBuffers(bufferSlot, 1, &mpMatrixBuffer);
+		deviceContext->VSSetConstantBuffers(bufferSlot, 1, mMatrixBuffer.GetBufferAddress());
 	}
 	else if (shaderType == ShaderType::Pixel)
 	{
-		deviceContext->PSSetConstantBuffers(bufferSlot, 1, &mpMatrixBuffer);
+		deviceContext->PSSetConstantBuffers(bufferSlot, 1, mMatrixBuffer.GetBufferAddress());
 	}
 	else if (shaderType == ShaderType::Geometry)
 	{
-		deviceContext->GSSetConstantBuffers(bufferSlot, 1, &mpMatrixBuffer);
+		deviceContext->GSSetConstantBuffers(bufferSlot, 1, mMatrixBuffer.GetBufferAddress());
 	}
 	else
 	{
@@ -118,3 +100,94 @@ bool CShader::SetMatrixBuffer(ID3D11DeviceContext * deviceContext, unsigned int
 
 	return true;
 }
+
+/* Writes the matrices through a render device, which only supports the vertex and pixel shader stages. */
+bool CShader::SetMatrixBuffer(CRenderDevice* device, unsigned int bufferSlot, ShaderType shaderType)
+{
+	if (!mMatrixBuffer.Update(device))
+	{
+		logger->GetInstance().WriteLine("Failed to lock the matrix buffer before writing to it in shader class.");
+		return false;
+	}
+
+	if (shaderType == ShaderType::Vertex)
+	{
+		device->VSSetConstantBuffers(bufferSlot, 1, mMatrixBuffer.GetBufferAddress());
+	}
+	else if (shaderType == ShaderType::Pixel)
+	{
+		device->PSSetConstantBuffers(bufferSlot, 1, mMatrixBuffer.GetBufferAddress());
+	}
+	else
+	{
+		logger->GetInstance().WriteLine("Render devices can only set the matrix buffer on the vertex and pixel shaders.");
+		return false;
+	}
+
+	return true;
+}
+
+/* Writes the matrices into the constant ring instead of the matrix buffer, to be bound by range once the ring has been uploaded. */
+bool CShader::WriteMatrixBuffer(CConstantRing* ring, CConstantRing::RangeType& range)
+{
+	MatrixBufferType* matrixBufferPtr = static_cast<MatrixBufferType*>(ring->Allocate(sizeof(MatrixBufferType), range));
+
+	if (matrixBufferPtr == nullptr)
+	{
+		logger->GetInstance().WriteLine("The constant ring had no room left for the matrix buffer.");
+		return false;
+	}
+
+	*matrixBufferPtr = mMatrixBuffer.Get();
+
+	return true;
+}
+
+void CShader::SetShaderCache(CShaderCache* cache)
+{
+	mpShaderCache = cache;
+}
+
+/* Compiles one entry point of a shader file, taking the bytecode from the shader cache if there is one.
+* Behaves like D3DX11CompileFromFile: on failure the error message is only set if the compiler produced one, so a missing file still leaves it null.
+* @Returns HRESULT S_OK on success.
+*/
+HRESULT CShader::CompileShaderFromFile(std::string filename, std::string entryPoint, std::string profile, unsigned int flags, ID3D10Blob** shaderBuffer, ID3D10Blob** errorMessage)
+{
+	*shaderBuffer = nullptr;
+	*errorMessage = nullptr;
+
+	if (mpShaderCache == nullptr)
+	{
+		return D3DX11CompileFromFile(filename.c_str(), NULL, NULL, entryPoint.c_str(), profile.c_str(), flags, 0, NULL, shaderBuffer, errorMessage, NULL);
+	}
+
+	CShaderCache::ShaderKeyType key;
+	key.filename = filename;
+	key.entryPoint = entryPoint;
+	key.profile = profile;
+	key.flags = flags;
+
+	std::vector<unsigned char> bytecode;
+	std::string errors;
+
+	if (!mpShaderCache->GetBytecode(key, bytecode, errors))
+	{
+		if (!errors.empty() && SUCCEEDED(D3DCreateBlob(errors.size() + 1, errorMessage)))
+		{
+			memcpy((*errorMessage)->GetBufferPointer(), errors.c_str(), errors.size() + 1);
+		}
+		return E_FAIL;
+	}
+
+	HRESULT result = D3DCreateBlob(bytecode.size(), shaderBuffer);
+	if (FAILED(result))
+	{
+		logger->GetInstance().WriteLine("Failed to create a blob to hold the bytecode of " + entryPoint + " from " + filename + ".");
+		return result;
+	}
+
+	memcpy((*shaderBuffer)->GetBufferPointer(), bytecode.data(), bytecode.size());
+
+	return S_OK;
+}
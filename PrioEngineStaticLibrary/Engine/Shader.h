@@ -6,6 +6,10 @@
 #include <D3DX11async.h>
 #include "PrioEngineVars.h"
 #include "Texture.h"
+#include "RenderDevice.h"
+#include "ConstantRing.h"
+#include "ConstantBuffer.h"
+#include "ShaderCache.h"
 
 class CShader
 {
@@ -23,20 +27,21 @@ public:
 protected:
 	CLogger* logger;
 private:
-	ID3D11Buffer* mpMatrixBuffer;
+	// Holds the matrices transposed, and is only written when one of them changes.
+	CConstantBuffer<MatrixBufferType> mMatrixBuffer;
 public:
 	virtual bool Initialise(ID3D11Device* device, HWND hwnd) = 0;
 	virtual void Shutdown() = 0;
-protected:
-	D3DXMATRIX mWorldMatrix;
-	D3DXMATRIX mViewMatrix;
-	D3DXMATRIX mProjMatrix;
-	D3DXMATRIX mViewProjMatrix;
 public:
 	void SetWorldMatrix(D3DXMATRIX world);
 	void SetViewMatrix(D3DXMATRIX view);
 	void SetProjMatrix(D3DXMATRIX proj);
 	void SetViewProjMatrix(D3DXMATRIX viewProj);
+
+	// Shaders are compiled through this cache when one is set, and straight from their files when it isn't.
+	static void SetShaderCache(CShaderCache* cache);
+private:
+	static CShaderCache* mpShaderCache;
 protected:
 	enum ShaderType
 	{
@@ -45,7 +50,12 @@ protected:
 		Pixel
 	};
 	bool SetupMatrixBuffer(ID3D11Device * device);
+	bool SetupMatrixBuffer(CRenderDevice* device);
+	void ShutdownMatrixBuffer();
 	bool SetMatrixBuffer(ID3D11DeviceContext * deviceContext, unsigned int bufferSlot, ShaderType shaderType);
+	bool SetMatrixBuffer(CRenderDevice* device, unsigned int bufferSlot, ShaderType shaderType);
+	bool WriteMatrixBuffer(CConstantRing* ring, CConstantRing::RangeType& range);
+	HRESULT CompileShaderFromFile(std::string filename, std::string entryPoint, std::string profile, unsigned int flags, ID3D10Blob** shaderBuffer, ID3D10Blob** errorMessage);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,434 @@
+#include "ShaderCache.h"
+#include <windows.h>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+
+CShaderCache::CShaderCache(CShaderCompiler* compiler, std::string directory)
+{
+	mpCompiler = compiler;
+	mDirectory = directory;
+	mManifestChanged = false;
+	mHits = 0;
+	mMisses = 0;
+	mCompiles = 0;
+}
+
+CShaderCache::~CShaderCache()
+{
+	mWarmed.clear();
+	mManifest.clear();
+	mManifestLines.clear();
+}
+
+/* Makes sure the cache directory exists and reads the list of shaders used last time.
+* @Returns bool Success
+*/
+bool CShaderCache::Initialise()
+{
+	if (!CreateDirectoryA(mDirectory.c_str(), NULL) && GetLastError() != ERROR_ALREADY_EXISTS)
+	{
+		logger->GetInstance().WriteLine("Failed to create the shader cache directory " + mDirectory + ".");
+		return false;
+	}
+
+	std::ifstream manifestFile(mDirectory + "/manifest.txt");
+
+	// No manifest just means the cache hasn't been used yet.
+	if (!manifestFile.is_open())
+	{
+		return true;
+	}
+
+	std::string line;
+	while (std::getline(manifestFile, line))
+	{
+		std::istringstream lineStream(line);
+		ShaderKeyType key;
+
+		// The filename goes last as it's the only part which may contain spaces.
+		if (!(lineStream >> key.flags >> key.profile >> key.entryPoint) || !std::getline(lineStream >> std::ws, key.filename) || key.filename.empty())
+		{
+			logger->GetInstance().WriteLine("Skipping a line of the shader cache manifest which couldn't be read: " + line);
+			continue;
+		}
+
+		if (mManifestLines.insert(MakeManifestLine(key)).second)
+		{
+			mManifest.push_back(key);
+		}
+	}
+
+	return true;
+}
+
+/////////////////////////////
+// Warm-up
+/////////////////////////////
+
+/* Compiles every shader in the manifest which isn't in the cache, see below.
+* @Returns unsigned int The number of shaders compiled.
+*/
+unsigned int CShaderCache::WarmUp()
+{
+	// Copied, so the shaders can be added to the manifest while it's being read.
+	std::vector<ShaderKeyType> keys = mManifest;
+	return WarmUp(keys);
+}
+
+/* Compiles any of the shaders given which aren't in the cache yet, spread across threads. Each compiled shader is written to the cache and also kept
+* in memory until GetBytecode asks for it. Shaders which fail to compile are logged and skipped, GetBytecode will try again and report the errors properly.
+* @Returns unsigned int The number of shaders compiled.
+*/
+unsigned int CShaderCache::WarmUp(const std::vector<ShaderKeyType>& keys)
+{
+	struct WarmUpJobType
+	{
+		const ShaderKeyType* key;
+		unsigned long long hash;
+	};
+
+	std::vector<WarmUpJobType> jobs;
+	std::unordered_set<unsigned long long> queued;
+
+	for (auto& key : keys)
+	{
+		WarmUpJobType job;
+		job.key = &key;
+
+		// Files which no longer exist drop out of the manifest the next time it's saved, as nothing will ask for them.
+		if (!Hash(key, job.hash))
+		{
+			continue;
+		}
+
+		std::ifstream cacheFile(GetCachePath(job.hash), std::ios::binary);
+		if (!cacheFile.is_open() && queued.insert(job.hash).second)
+		{
+			jobs.push_back(job);
+		}
+	}
+
+	if (jobs.empty())
+	{
+		return 0;
+	}
+
+	unsigned int numberOfThreads = std::thread::hardware_concurrency();
+	numberOfThreads = numberOfThreads > kMaxWarmUpThreads ? kMaxWarmUpThreads : numberOfThreads;
+	numberOfThreads = numberOfThreads > jobs.size() ? static_cast<unsigned int>(jobs.size()) : numberOfThreads;
+	numberOfThreads = numberOfThreads < 1 ? 1 : numberOfThreads;
+
+	std::atomic<unsigned int> nextJob(0);
+	std::atomic<unsigned int> compiled(0);
+
+	// Each thread takes the next job until there are none left, as some shaders take much longer to compile than others.
+	auto compileJobs = [&]()
+	{
+		std::vector<unsigned char> bytecode;
+		std::string errors;
+
+		for (unsigned int job = nextJob++; job < jobs.size(); job = nextJob++)
+		{
+			if (!Compile(*jobs[job].key, jobs[job].hash, bytecode, errors))
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				logger->GetInstance().WriteLine("Failed to compile " + jobs[job].key->entryPoint + " from " + jobs[job].key->filename + " while warming up the shader cache.");
+				continue;
+			}
+
+			std::lock_guard<std::mutex> lock(mMutex);
+			mWarmed[jobs[job].hash].swap(bytecode);
+			compiled++;
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (unsigned int thread = 1; thread < numberOfThreads; thread++)
+	{
+		threads.push_back(std::thread(compileJobs));
+	}
+
+	compileJobs();
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	logger->GetInstance().WriteLine("Compiled " + std::to_string(compiled.load()) + " of " + std::to_string(jobs.size()) + " shaders missing from the shader cache on " + std::to_string(numberOfThreads) + " threads.");
+
+	return compiled.load();
+}
+
+/////////////////////////////
+// Lookup
+/////////////////////////////
+
+/* Finds the bytecode for a shader, from the warm-up, the cache on disk, or by compiling it and adding it to the cache.
+* @Returns bool Success
+*/
+bool CShaderCache::GetBytecode(const ShaderKeyType& key, std::vector<unsigned char>& bytecode, std::string& errors)
+{
+	unsigned long long hash;
+
+	errors.clear();
+
+	// Left to the compiler to report, as it does for a missing file.
+	if (!Hash(key, hash))
+	{
+		return false;
+	}
+
+	bool found = false;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto it = mWarmed.find(hash);
+		if (it != mWarmed.end())
+		{
+			bytecode.swap(it->second);
+			mWarmed.erase(it);
+			found = true;
+		}
+	}
+
+	if (found || ReadCacheFile(hash, bytecode))
+	{
+		mHits++;
+	}
+	else
+	{
+		mMisses++;
+
+		if (!Compile(key, hash, bytecode, errors))
+		{
+			return false;
+		}
+	}
+
+	AddToManifest(key);
+
+	return true;
+}
+
+/* Writes the list of every shader the cache knows about, for the next warm-up. Does nothing if nothing new has been used.
+* @Returns bool Success
+*/
+bool CShaderCache::SaveManifest()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	if (!mManifestChanged)
+	{
+		return true;
+	}
+
+	std::ofstream manifestFile(mDirectory + "/manifest.txt");
+	if (!manifestFile.is_open())
+	{
+		logger->GetInstance().WriteLine("Failed to open the shader cache manifest for writing.");
+		return false;
+	}
+
+	for (auto& key : mManifest)
+	{
+		manifestFile << MakeManifestLine(key) << std::endl;
+	}
+
+	mManifestChanged = false;
+
+	return true;
+}
+
+/////////////////////////////
+// Hashing
+/////////////////////////////
+
+/* Hashes everything which decides what a shader compiles to. Fails if the shader's file can't be read.
+* @Returns bool Success
+*/
+bool CShaderCache::Hash(const ShaderKeyType& key, unsigned long long& hash)
+{
+	std::string compilerName = mpCompiler->GetName();
+	std::unordered_set<std::string> visited;
+
+	hash = kHashOffset;
+
+	// The strings are hashed with their terminators, so "ab" + "c" doesn't hash the same as "a" + "bc".
+	HashBytes(hash, compilerName.c_str(), compilerName.size() + 1);
+	HashBytes(hash, key.entryPoint.c_str(), key.entryPoint.size() + 1);
+	HashBytes(hash, key.profile.c_str(), key.profile.size() + 1);
+	HashBytes(hash, &key.flags, sizeof(key.flags));
+
+	return HashFile(key.filename, hash, visited);
+}
+
+/* Hashes the contents of a file, followed by the contents of each file it includes with quotes, which are found relative to the including file.
+* Include paths in angle brackets would need the compiler's include handler to find, and the engine's shaders don't use them.
+* @Returns bool Success
+*/
+bool CShaderCache::HashFile(const std::string& filename, unsigned long long& hash, std::unordered_set<std::string>& visited)
+{
+	// Each file is only hashed once, which also stops include cycles.
+	if (!visited.insert(filename).second)
+	{
+		return true;
+	}
+
+	std::ifstream file(filename, std::ios::binary);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	HashBytes(hash, source.c_str(), source.size() + 1);
+
+	const size_t lastSlash = filename.find_last_of("/\\");
+	const std::string directory = lastSlash == std::string::npos ? "" : filename.substr(0, lastSlash + 1);
+
+	std::istringstream sourceStream(source);
+	std::string line;
+	while (std::getline(sourceStream, line))
+	{
+		const size_t include = line.find("#include");
+		if (include == std::string::npos)
+		{
+			continue;
+		}
+
+		const size_t open = line.find('"', include);
+		const size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+		if (close == std::string::npos)
+		{
+			continue;
+		}
+
+		// A missing include is hashed as missing, and the compiler reports it.
+		if (!HashFile(directory + line.substr(open + 1, close - open - 1), hash, visited))
+		{
+			HashBytes(hash, "missing", sizeof("missing"));
+		}
+	}
+
+	return true;
+}
+
+void CShaderCache::HashBytes(unsigned long long& hash, const void* data, size_t size)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= kHashPrime;
+	}
+}
+
+/////////////////////////////
+// Cache files
+/////////////////////////////
+
+std::string CShaderCache::GetCachePath(unsigned long long hash)
+{
+	char name[17];
+	std::snprintf(name, sizeof(name), "%016llx", hash);
+
+	return mDirectory + "/" + name + ".cso";
+}
+
+bool CShaderCache::ReadCacheFile(unsigned long long hash, std::vector<unsigned char>& bytecode)
+{
+	std::ifstream cacheFile(GetCachePath(hash), std::ios::binary);
+	if (!cacheFile.is_open())
+	{
+		return false;
+	}
+
+	bytecode.assign(std::istreambuf_iterator<char>(cacheFile), std::istreambuf_iterator<char>());
+
+	// Files are only ever renamed into place whole, so an empty one wasn't written by us.
+	return !bytecode.empty();
+}
+
+/* Writes the bytecode to a temporary file and then renames it over the cache file, so a crash or a full disk part way through
+* never leaves a truncated file under the hash, which would be loaded from then on.
+* @Returns bool Success
+*/
+bool CShaderCache::WriteCacheFile(unsigned long long hash, const std::vector<unsigned char>& bytecode)
+{
+	const std::string path = GetCachePath(hash);
+
+	// Named after the thread too, in case two threads compile the same shader at once.
+	const std::string temporaryPath = path + "." + std::to_string(GetCurrentThreadId()) + ".tmp";
+
+	{
+		std::ofstream cacheFile(temporaryPath, std::ios::binary);
+		if (!cacheFile.is_open())
+		{
+			return false;
+		}
+
+		cacheFile.write(reinterpret_cast<const char*>(bytecode.data()), bytecode.size());
+		cacheFile.close();
+
+		if (!cacheFile.good())
+		{
+			DeleteFileA(temporaryPath.c_str());
+			return false;
+		}
+	}
+
+	if (!MoveFileExA(temporaryPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		DeleteFileA(temporaryPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+/* Compiles a shader and writes it to the cache. A shader which can't be written is still returned, it'll just be compiled again next time.
+* @Returns bool Success
+*/
+bool CShaderCache::Compile(const ShaderKeyType& key, unsigned long long hash, std::vector<unsigned char>& bytecode, std::string& errors)
+{
+	if (!mpCompiler->Compile(key.filename, key.entryPoint, key.profile, key.flags, bytecode, errors))
+	{
+		return false;
+	}
+
+	bool written = WriteCacheFile(hash, bytecode);
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mCompiles++;
+
+	if (!written)
+	{
+		logger->GetInstance().WriteLine("Failed to write " + key.entryPoint + " from " + key.filename + " to the shader cache.");
+	}
+
+	return true;
+}
+
+/////////////////////////////
+// Manifest
+/////////////////////////////
+
+void CShaderCache::AddToManifest(const ShaderKeyType& key)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+
+	if (mManifestLines.insert(MakeManifestLine(key)).second)
+	{
+		mManifest.push_back(key);
+		mManifestChanged = true;
+	}
+}
+
+std::string CShaderCache::MakeManifestLine(const ShaderKeyType& key)
+{
+	return std::to_string(key.flags) + " " + key.profile + " " + key.entryPoint + " " + key.filename;
+}
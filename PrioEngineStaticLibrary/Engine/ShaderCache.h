@@ -0,0 +1,76 @@
+#ifndef SHADERCACHE_H
+#define SHADERCACHE_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include "PrioEngineVars.h"
+#include "ShaderCompiler.h"
+
+/* Keeps compiled shader bytecode on disk so that shaders are only compiled again when something that affects them changes.
+* Each shader is keyed by a 64 bit FNV-1a hash of its source, the source of every file it includes, its entry point, profile, flags and the compiler's name,
+* and stored as <hash>.cso in the cache directory. Editing a shader changes its hash, so stale bytecode is never used and never has to be deleted.
+*
+* Every shader asked for is written to a manifest in the cache directory. WarmUp reads the manifest at startup and compiles whichever of those shaders
+* are missing from the cache on several threads at once, so that the shader classes find their bytecode waiting for them.
+*/
+class CShaderCache
+{
+private:
+	CLogger* logger;
+public:
+	struct ShaderKeyType
+	{
+		std::string filename;
+		std::string entryPoint;
+		std::string profile;
+		unsigned int flags;
+	};
+public:
+	CShaderCache(CShaderCompiler* compiler, std::string directory);
+	~CShaderCache();
+public:
+	bool Initialise();
+	unsigned int WarmUp();
+	unsigned int WarmUp(const std::vector<ShaderKeyType>& keys);
+	bool GetBytecode(const ShaderKeyType& key, std::vector<unsigned char>& bytecode, std::string& errors);
+	bool SaveManifest();
+
+	bool Hash(const ShaderKeyType& key, unsigned long long& hash);
+
+	unsigned int GetHits() { return mHits; };
+	unsigned int GetMisses() { return mMisses; };
+	unsigned int GetNumberOfCompiles() { return mCompiles; };
+private:
+	bool HashFile(const std::string& filename, unsigned long long& hash, std::unordered_set<std::string>& visited);
+	static void HashBytes(unsigned long long& hash, const void* data, size_t size);
+	std::string GetCachePath(unsigned long long hash);
+	bool ReadCacheFile(unsigned long long hash, std::vector<unsigned char>& bytecode);
+	bool WriteCacheFile(unsigned long long hash, const std::vector<unsigned char>& bytecode);
+	bool Compile(const ShaderKeyType& key, unsigned long long hash, std::vector<unsigned char>& bytecode, std::string& errors);
+	void AddToManifest(const ShaderKeyType& key);
+
+	static std::string MakeManifestLine(const ShaderKeyType& key);
+
+	const unsigned long long kHashOffset = 14695981039346656037ull;
+	static const unsigned long long kHashPrime = 1099511628211ull;
+	const unsigned int kMaxWarmUpThreads = 8;
+
+	CShaderCompiler* mpCompiler;
+	std::string mDirectory;
+
+	// Bytecode compiled during warm-up, waiting for its shader class to ask for it.
+	std::unordered_map<unsigned long long, std::vector<unsigned char>> mWarmed;
+	std::vector<ShaderKeyType> mManifest;
+	std::unordered_set<std::string> mManifestLines;
+	bool mManifestChanged;
+	std::mutex mMutex;
+
+	unsigned int mHits;
+	unsigned int mMisses;
+	unsigned int mCompiles;
+};
+
+#endif
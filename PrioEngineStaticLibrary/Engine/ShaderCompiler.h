@@ -0,0 +1,22 @@
+#ifndef SHADERCOMPILER_H
+#define SHADERCOMPILER_H
+
+#include <string>
+#include <vector>
+
+/* Turns HLSL source into bytecode. The shader cache only talks to the compiler through this, so its hashing, disk and threading can be exercised without Direct3D.
+* Compile may be called from several threads at once.
+*/
+class CShaderCompiler
+{
+public:
+	virtual ~CShaderCompiler() {};
+public:
+	// Errors holds the compiler's messages, and is left empty if the file couldn't be found.
+	virtual bool Compile(const std::string& filename, const std::string& entryPoint, const std::string& profile, unsigned int flags,
+		std::vector<unsigned char>& bytecode, std::string& errors) = 0;
+	// Part of every cache key, so bytecode from one compiler is never handed out for another.
+	virtual std::string GetName() = 0;
+};
+
+#endif
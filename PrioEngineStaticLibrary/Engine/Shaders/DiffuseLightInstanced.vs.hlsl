@@ -0,0 +1,54 @@
+// Globals
+cbuffer MatrixBuffer
+{
+	matrix worldMatrix;
+	matrix viewMatrix;
+	matrix projMatrix;
+	matrix ViewProjMatrix;
+};
+
+// Type defs.
+struct VertexInputType
+{
+	float4 position : POSITION;
+	float2 tex : TEXCOORD0;
+	float3 normal : NORMAL;
+	// The rows of the world matrix for this instance, not transposed.
+	float4 world0 : WORLD0;
+	float4 world1 : WORLD1;
+	float4 world2 : WORLD2;
+	float4 world3 : WORLD3;
+};
+
+struct PixelInputType
+{
+	float4 position : SV_POSITION;
+	float2 tex : TEXCOORD0;
+	float3 normal : NORMAL;
+};
+
+// Vertex shader.
+PixelInputType LightInstancedVertexShader(VertexInputType input)
+{
+	PixelInputType output;
+
+	float4x4 instanceWorld = float4x4(input.world0, input.world1, input.world2, input.world3);
+
+	// Change the position vector to have a 4th element to allow for maths calcs.
+	input.position.w = 1.0f;
+
+	// Calculate the position of the vertex against the instance's world matrix, then the view and proj matrices.
+	output.position = mul(input.position, instanceWorld);
+	output.position = mul(output.position, ViewProjMatrix);
+
+	// Store the texture coordinates for the pixel shader.
+	output.tex = input.tex;
+
+	// Calculate the normal vector against the world matrix only.
+	output.normal = mul(input.normal, (float3x3)instanceWorld);
+
+	// Normalise the vector.
+	output.normal = normalize(output.normal);
+
+	return output;
+}
@@ -0,0 +1,141 @@
+#include "StateCache.h"
+#include <cstring>
+
+CStateCache::CStateCache(ID3D11Device* device)
+{
+	mpDevice = device;
+	mHits = 0;
+	mMisses = 0;
+}
+
+CStateCache::~CStateCache()
+{
+	Shutdown();
+}
+
+/* Releases every state the cache has handed out. */
+void CStateCache::Shutdown()
+{
+	Release(mDepthStencilStates);
+	Release(mRasterizerStates);
+	Release(mBlendStates);
+}
+
+template <typename StateMap>
+void CStateCache::Release(StateMap& states)
+{
+	for (auto& entry : states)
+	{
+		if (entry.second.state != nullptr)
+		{
+			entry.second.state->Release();
+		}
+	}
+
+	states.clear();
+}
+
+/* FNV-1a over the bytes of a description. */
+unsigned int CStateCache::Hash(const void* data, unsigned int size)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	unsigned int hash = 2166136261u;
+
+	for (unsigned int i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+/* Looks a description up, creating and storing the state if it hasn't been seen before.
+* The description must have its padding cleared, as it is compared byte for byte.
+* @Returns StateType* - Null if the state couldn't be created.
+*/
+template <typename DescType, typename StateType, typename CreateType>
+StateType* CStateCache::Find(StateMapType<DescType, StateType>& states, const DescType& desc, CreateType create)
+{
+	const unsigned int hash = Hash(&desc, sizeof(DescType));
+
+	auto range = states.equal_range(hash);
+	for (auto it = range.first; it != range.second; it++)
+	{
+		if (memcmp(&it->second.desc, &desc, sizeof(DescType)) == 0)
+		{
+			mHits++;
+			return it->second.state;
+		}
+	}
+
+	EntryType<DescType, StateType> entry;
+	entry.desc = desc;
+	entry.state = nullptr;
+
+	if (FAILED(create(&desc, &entry.state)))
+	{
+		logger->GetInstance().WriteLine("Failed to create a state object for the state cache.");
+		return nullptr;
+	}
+
+	mMisses++;
+	states.insert(std::make_pair(hash, entry));
+
+	return entry.state;
+}
+
+ID3D11DepthStencilState* CStateCache::GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc)
+{
+	// The stencil masks are single bytes, so copy the fields over to leave the padding after them cleared.
+	D3D11_DEPTH_STENCIL_DESC key;
+	ZeroMemory(&key, sizeof(key));
+	key.DepthEnable = desc.DepthEnable;
+	key.DepthWriteMask = desc.DepthWriteMask;
+	key.DepthFunc = desc.DepthFunc;
+	key.StencilEnable = desc.StencilEnable;
+	key.StencilReadMask = desc.StencilReadMask;
+	key.StencilWriteMask = desc.StencilWriteMask;
+	key.FrontFace = desc.FrontFace;
+	key.BackFace = desc.BackFace;
+
+	return Find(mDepthStencilStates, key, [this](const D3D11_DEPTH_STENCIL_DESC* stateDesc, ID3D11DepthStencilState** state)
+	{
+		return mpDevice->CreateDepthStencilState(stateDesc, state);
+	});
+}
+
+/* The rasterizer description has no padding, so it can be used as it is. */
+ID3D11RasterizerState* CStateCache::GetRasterizerState(const D3D11_RASTERIZER_DESC& desc)
+{
+	return Find(mRasterizerStates, desc, [this](const D3D11_RASTERIZER_DESC* stateDesc, ID3D11RasterizerState** state)
+	{
+		return mpDevice->CreateRasterizerState(stateDesc, state);
+	});
+}
+
+ID3D11BlendState* CStateCache::GetBlendState(const D3D11_BLEND_DESC& desc)
+{
+	// Each render target ends with a single byte write mask, so copy the fields over to leave the padding after it cleared.
+	D3D11_BLEND_DESC key;
+	ZeroMemory(&key, sizeof(key));
+	key.AlphaToCoverageEnable = desc.AlphaToCoverageEnable;
+	key.IndependentBlendEnable = desc.IndependentBlendEnable;
+
+	for (unsigned int target = 0; target < 8; target++)
+	{
+		key.RenderTarget[target].BlendEnable = desc.RenderTarget[target].BlendEnable;
+		key.RenderTarget[target].SrcBlend = desc.RenderTarget[target].SrcBlend;
+		key.RenderTarget[target].DestBlend = desc.RenderTarget[target].DestBlend;
+		key.RenderTarget[target].BlendOp = desc.RenderTarget[target].BlendOp;
+		key.RenderTarget[target].SrcBlendAlpha = desc.RenderTarget[target].SrcBlendAlpha;
+		key.RenderTarget[target].DestBlendAlpha = desc.RenderTarget[target].DestBlendAlpha;
+		key.RenderTarget[target].BlendOpAlpha = desc.RenderTarget[target].BlendOpAlpha;
+		key.RenderTarget[target].RenderTargetWriteMask = desc.RenderTarget[target].RenderTargetWriteMask;
+	}
+
+	return Find(mBlendStates, key, [this](const D3D11_BLEND_DESC* stateDesc, ID3D11BlendState** state)
+	{
+		return mpDevice->CreateBlendState(stateDesc, state);
+	});
+}
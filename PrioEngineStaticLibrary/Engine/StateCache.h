@@ -0,0 +1,56 @@
+#ifndef STATECACHE_H
+#define STATECACHE_H
+
+#include <d3d11.h>
+#include <unordered_map>
+#include "PrioEngineVars.h"
+
+/* Hands out depth stencil, rasterizer and blend state objects from their descriptions, only creating a state the first time its description is seen.
+* Descriptions are hashed with their padding cleared, so two descriptions which set the same fields always find the same state.
+* The cache owns every state it hands out, they're released by Shutdown and must not be released by the caller.
+*/
+class CStateCache
+{
+private:
+	CLogger* logger;
+public:
+	CStateCache(ID3D11Device* device);
+	~CStateCache();
+public:
+	ID3D11DepthStencilState* GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc);
+	ID3D11RasterizerState* GetRasterizerState(const D3D11_RASTERIZER_DESC& desc);
+	ID3D11BlendState* GetBlendState(const D3D11_BLEND_DESC& desc);
+	void Shutdown();
+
+	unsigned int GetNumberOfStates() { return static_cast<unsigned int>(mDepthStencilStates.size() + mRasterizerStates.size() + mBlendStates.size()); };
+	unsigned int GetHits() { return mHits; };
+	unsigned int GetMisses() { return mMisses; };
+private:
+	template <typename DescType, typename StateType>
+	struct EntryType
+	{
+		DescType desc;
+		StateType* state;
+	};
+
+	template <typename DescType, typename StateType>
+	using StateMapType = std::unordered_multimap<unsigned int, EntryType<DescType, StateType>>;
+
+	template <typename DescType, typename StateType, typename CreateType>
+	StateType* Find(StateMapType<DescType, StateType>& states, const DescType& desc, CreateType create);
+
+	template <typename StateMap>
+	static void Release(StateMap& states);
+
+	static unsigned int Hash(const void* data, unsigned int size);
+
+	ID3D11Device* mpDevice;
+	StateMapType<D3D11_DEPTH_STENCIL_DESC, ID3D11DepthStencilState> mDepthStencilStates;
+	StateMapType<D3D11_RASTERIZER_DESC, ID3D11RasterizerState> mRasterizerStates;
+	StateMapType<D3D11_BLEND_DESC, ID3D11BlendState> mBlendStates;
+
+	unsigned int mHits;
+	unsigned int mMisses;
+};
+
+#endif
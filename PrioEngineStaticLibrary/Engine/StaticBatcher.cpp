@@ -0,0 +1,542 @@
+#include "StaticBatcher.h"
+#include "Model.h"
+#include "Frustum.h"
+#include "HorizonCuller.h"
+#include "DiffuseLightShader.h"
+#include "DistanceCuller.h"
+#include "GpuMemoryTracker.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+CStaticBatcher::CStaticBatcher()
+{
+	mpDevice = nullptr;
+	mCellSize = 32.0f;
+	mCellsRebuilt = 0;
+
+	for (auto& distance : mNearestCellDistance)
+	{
+		distance = FLT_MAX;
+	}
+}
+
+CStaticBatcher::~CStaticBatcher()
+{
+}
+
+/* Copies every submesh once for each world matrix, moving the vertices into world space as it goes.
+* Normals are moved by the inverse transpose so they stay correct under uneven scaling, and mirrored instances have their winding flipped.
+* The vertices are shared by every detail level, each level of each submesh gets its own run of indices holding every instance in order.
+* @PARAM BatchType& batch - Filled with the merged geometry, any previous contents are thrown away.
+*/
+void CStaticBatcher::Merge(const std::vector<GeometryType>& subMeshes, const std::vector<D3DXMATRIX>& worlds, BatchType& batch)
+{
+	const unsigned int numberOfSubMeshes = static_cast<unsigned int>(subMeshes.size());
+	const unsigned int numberOfInstances = static_cast<unsigned int>(worlds.size());
+
+	batch.vertices.clear();
+	batch.indices.clear();
+	batch.subMeshLevels.assign(numberOfSubMeshes, std::vector<CInstanceBatch::RangeType>());
+	batch.minPoint = D3DXVECTOR3(FLT_MAX, FLT_MAX, FLT_MAX);
+	batch.maxPoint = D3DXVECTOR3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	batch.instanceRadius = 0.0f;
+
+	size_t totalVertices = 0;
+	size_t totalIndices = 0;
+	for (auto& geometry : subMeshes)
+	{
+		totalVertices += geometry.vertices.size() * numberOfInstances;
+		totalIndices += geometry.indices.size() * numberOfInstances;
+	}
+	batch.vertices.reserve(totalVertices);
+	batch.indices.reserve(totalIndices);
+
+	// Work out the normal matrices once, rather than once per submesh.
+	std::vector<D3DXMATRIX> normalMatrices(numberOfInstances);
+	std::vector<bool> mirrored(numberOfInstances);
+	std::vector<D3DXVECTOR3> instanceMinPoints(numberOfInstances, D3DXVECTOR3(FLT_MAX, FLT_MAX, FLT_MAX));
+	std::vector<D3DXVECTOR3> instanceMaxPoints(numberOfInstances, D3DXVECTOR3(-FLT_MAX, -FLT_MAX, -FLT_MAX));
+	std::vector<unsigned int> baseVertices(numberOfInstances);
+
+	for (unsigned int instance = 0; instance < numberOfInstances; instance++)
+	{
+		float determinant = 0.0f;
+		D3DXMATRIX inverse;
+
+		if (D3DXMatrixInverse(&inverse, &determinant, &worlds[instance]) != nullptr)
+		{
+			D3DXMatrixTranspose(&normalMatrices[instance], &inverse);
+		}
+		else
+		{
+			normalMatrices[instance] = worlds[instance];
+		}
+
+		mirrored[instance] = determinant < 0.0f;
+	}
+
+	for (unsigned int subMesh = 0; subMesh < numberOfSubMeshes; subMesh++)
+	{
+		const GeometryType& geometry = subMeshes[subMesh];
+
+		for (unsigned int instance = 0; instance < numberOfInstances; instance++)
+		{
+			baseVertices[instance] = static_cast<unsigned int>(batch.vertices.size());
+
+			for (auto& source : geometry.vertices)
+			{
+				VertexType vertex;
+				D3DXVec3TransformCoord(&vertex.position, &source.position, &worlds[instance]);
+				D3DXVec3TransformNormal(&vertex.normal, &source.normal, &normalMatrices[instance]);
+				D3DXVec3Normalize(&vertex.normal, &vertex.normal);
+				vertex.uv = source.uv;
+
+				D3DXVec3Minimize(&instanceMinPoints[instance], &instanceMinPoints[instance], &vertex.position);
+				D3DXVec3Maximize(&instanceMaxPoints[instance], &instanceMaxPoints[instance], &vertex.position);
+
+				batch.vertices.push_back(vertex);
+			}
+		}
+
+		// A submesh without detail levels is one level made of all of its indices.
+		std::vector<CInstanceBatch::RangeType> levels = geometry.levels;
+		if (levels.empty())
+		{
+			levels.push_back({ 0, static_cast<unsigned int>(geometry.indices.size()) });
+		}
+
+		for (auto& level : levels)
+		{
+			CInstanceBatch::RangeType run;
+			run.startIndex = static_cast<unsigned int>(batch.indices.size());
+
+			for (unsigned int instance = 0; instance < numberOfInstances; instance++)
+			{
+				// A mirrored instance turns its triangles inside out, so swap two corners to keep them facing outwards.
+				const unsigned int second = mirrored[instance] ? 2 : 1;
+				const unsigned int third = mirrored[instance] ? 1 : 2;
+				const unsigned int baseVertex = baseVertices[instance];
+				const unsigned int levelEnd = level.startIndex + level.indexCount / 3 * 3;
+
+				for (unsigned int index = level.startIndex; index < levelEnd; index += 3)
+				{
+					batch.indices.push_back(baseVertex + geometry.indices[index]);
+					batch.indices.push_back(baseVertex + geometry.indices[index + second]);
+					batch.indices.push_back(baseVertex + geometry.indices[index + third]);
+				}
+			}
+
+			run.indexCount = static_cast<unsigned int>(batch.indices.size()) - run.startIndex;
+			batch.subMeshLevels[subMesh].push_back(run);
+		}
+	}
+
+	for (unsigned int instance = 0; instance < numberOfInstances; instance++)
+	{
+		if (instanceMinPoints[instance].x > instanceMaxPoints[instance].x)
+		{
+			continue;
+		}
+
+		D3DXVec3Minimize(&batch.minPoint, &batch.minPoint, &instanceMinPoints[instance]);
+		D3DXVec3Maximize(&batch.maxPoint, &batch.maxPoint, &instanceMaxPoints[instance]);
+
+		D3DXVECTOR3 halfSize = (instanceMaxPoints[instance] - instanceMinPoints[instance]) * 0.5f;
+		float radius = D3DXVec3Length(&halfSize);
+		batch.instanceRadius = radius > batch.instanceRadius ? radius : batch.instanceRadius;
+	}
+
+	if (batch.vertices.empty())
+	{
+		batch.minPoint = D3DXVECTOR3(0.0f, 0.0f, 0.0f);
+		batch.maxPoint = D3DXVECTOR3(0.0f, 0.0f, 0.0f);
+	}
+}
+
+/* Keeps a copy of a submesh's geometry to merge from, submeshes must be added in the same order as the mesh draws them. */
+void CStaticBatcher::AddSubMesh(GeometryType& geometry)
+{
+	mSubMeshes.push_back(geometry);
+}
+
+/* Hands a model over to the batcher, it will be merged into its cell on the next update. */
+void CStaticBatcher::Add(CModel* model)
+{
+	PlacementType placement;
+	placement.cell = FindCell(model);
+	placement.transformVersion = model->GetTransformVersion();
+
+	mPlacements[model] = placement;
+
+	CellType& cell = mCells[placement.cell];
+	cell.models.push_back(model);
+	cell.dirty = true;
+}
+
+/* Takes a model back out of its cell, the cell is merged again on the next update. */
+void CStaticBatcher::Remove(CModel* model)
+{
+	auto placement = mPlacements.find(model);
+	if (placement == mPlacements.end())
+	{
+		return;
+	}
+
+	CellType& cell = mCells[placement->second.cell];
+	for (auto it = cell.models.begin(); it != cell.models.end(); it++)
+	{
+		if (*it == model)
+		{
+			cell.models.erase(it);
+			break;
+		}
+	}
+	cell.dirty = true;
+
+	mPlacements.erase(placement);
+}
+
+/* Moves any model whose transform has changed into its new cell, then merges every cell which changed again.
+* Checking for changes is one comparison per model, cells which nothing happened to are left alone.
+* @Returns bool Success
+*/
+bool CStaticBatcher::Update(CRenderDevice* device)
+{
+	mpDevice = device;
+
+	// The visible lists point into the cells, which may be about to go.
+	for (auto& visibleCells : mVisibleCells)
+	{
+		visibleCells.clear();
+	}
+
+	for (auto& placement : mPlacements)
+	{
+		CModel* model = placement.first;
+		const unsigned int transformVersion = model->GetTransformVersion();
+
+		if (transformVersion == placement.second.transformVersion)
+		{
+			continue;
+		}
+
+		placement.second.transformVersion = transformVersion;
+
+		CellType& oldCell = mCells[placement.second.cell];
+		oldCell.dirty = true;
+
+		const long long cellKey = FindCell(model);
+		if (cellKey != placement.second.cell)
+		{
+			for (auto it = oldCell.models.begin(); it != oldCell.models.end(); it++)
+			{
+				if (*it == model)
+				{
+					oldCell.models.erase(it);
+					break;
+				}
+			}
+
+			CellType& newCell = mCells[cellKey];
+			newCell.models.push_back(model);
+			newCell.dirty = true;
+
+			placement.second.cell = cellKey;
+		}
+	}
+
+	bool success = true;
+
+	for (auto it = mCells.begin(); it != mCells.end();)
+	{
+		CellType& cell = it->second;
+
+		if (cell.dirty && cell.models.empty())
+		{
+			ReleaseCell(cell);
+			it = mCells.erase(it);
+			continue;
+		}
+
+		if (cell.dirty && !RebuildCell(device, cell))
+		{
+			success = false;
+		}
+
+		it++;
+	}
+
+	return success;
+}
+
+/* Finds which cells can be seen from this pass, how many of each cell's models are left after thinning, and which detail level they're drawn at.
+* Must be called after Update. Only this pass's list is written, so different passes can be culled at the same time.
+* The draw distance, screen size, thinning and detail level are all measured to the nearest point of the cell, using the size of its largest model.
+* @PARAM const float* levelScreenSizes - The screen size below which each level gives way to the next, as in CMesh. Null keeps every cell at full detail.
+*/
+void CStaticBatcher::Cull(CRenderQueue::PassType pass, CFrustum* frustum, CHorizonCuller* horizon, D3DXVECTOR3 cameraPosition, CDistanceCuller* distanceCuller,
+	const float* levelScreenSizes, unsigned int numberOfLevelScreenSizes)
+{
+	std::vector<VisibleCellType>& visibleCells = mVisibleCells[pass];
+	float& nearestCellDistance = mNearestCellDistance[pass];
+
+	visibleCells.clear();
+	nearestCellDistance = FLT_MAX;
+
+	for (auto& entry : mCells)
+	{
+		CellType& cell = entry.second;
+
+		if (cell.vertexBuffer == nullptr)
+		{
+			continue;
+		}
+
+		D3DXVECTOR3 nearestPoint;
+		D3DXVec3Maximize(&nearestPoint, &cameraPosition, &cell.minPoint);
+		D3DXVec3Minimize(&nearestPoint, &nearestPoint, &cell.maxPoint);
+
+		D3DXVECTOR3 toNearestPoint = nearestPoint - cameraPosition;
+		float nearestDistance = D3DXVec3Length(&toNearestPoint);
+
+		unsigned int visibleModels = cell.numberOfModels;
+
+		if (distanceCuller != nullptr)
+		{
+			if (distanceCuller->IsBeyondDrawDistance(nearestDistance))
+			{
+				distanceCuller->AddCulledByDistance(pass, cell.numberOfModels);
+				continue;
+			}
+
+			// Even the largest model, standing at the nearest point, would be too small to see.
+			if (distanceCuller->IsBelowMinimumScreenSize(cell.instanceRadius, nearestDistance))
+			{
+				distanceCuller->AddCulledByCoverage(pass, cell.numberOfModels);
+				continue;
+			}
+
+			visibleModels = static_cast<unsigned int>(ceilf(distanceCuller->GetKeptFraction(nearestDistance) * cell.numberOfModels));
+			visibleModels = visibleModels < cell.numberOfModels ? visibleModels : cell.numberOfModels;
+			distanceCuller->AddThinned(pass, cell.numberOfModels - visibleModels);
+
+			if (visibleModels == 0)
+			{
+				continue;
+			}
+		}
+
+		if (!frustum->CheckBox(cell.minPoint, cell.maxPoint))
+		{
+			continue;
+		}
+
+		D3DXVECTOR3 centre = (cell.minPoint + cell.maxPoint) * 0.5f;
+		D3DXVECTOR3 halfSize = cell.maxPoint - centre;
+		float radius = D3DXVec3Length(&halfSize);
+
+		if (horizon != nullptr && !horizon->CheckSphere(centre, radius))
+		{
+			continue;
+		}
+
+		// The nearest model in the cell could be at its nearest point, so no model is drawn at less detail than it would be unbatched.
+		unsigned int level = 0;
+		if (levelScreenSizes != nullptr && nearestDistance > cell.instanceRadius)
+		{
+			float screenSize = cell.instanceRadius / nearestDistance;
+			while (level < numberOfLevelScreenSizes && screenSize < levelScreenSizes[level])
+			{
+				level++;
+			}
+		}
+
+		VisibleCellType visibleCell;
+		visibleCell.cell = &cell;
+		visibleCell.visibleModels = visibleModels;
+		visibleCell.level = level;
+		visibleCells.push_back(visibleCell);
+
+		D3DXVECTOR3 toCell = centre - cameraPosition;
+		float distance = D3DXVec3Length(&toCell) - radius;
+		distance = distance > 0.0f ? distance : 0.0f;
+		nearestCellDistance = distance < nearestCellDistance ? distance : nearestCellDistance;
+	}
+}
+
+/* Whether any cell visible to this pass has geometry for this submesh. */
+bool CStaticBatcher::HasVisibleGeometry(CRenderQueue::PassType pass, unsigned int subMesh)
+{
+	for (auto& visibleCell : mVisibleCells[pass])
+	{
+		if (!visibleCell.cell->subMeshLevels[subMesh].empty() && visibleCell.cell->subMeshLevels[subMesh][0].indexCount > 0)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Draws one submesh of every cell visible to this pass. The instanced shader and the submesh's material must already be set.
+* @PARAM unsigned int identityInstance - An instance in the instance buffer holding an identity matrix, as the cells are already in world space.
+* @Returns unsigned int - The number of draw calls made.
+*/
+unsigned int CStaticBatcher::Render(CRenderQueue::PassType pass, CRenderDevice* device, CDiffuseLightShader* shader, unsigned int subMesh, ID3D11Buffer* instanceBuffer, unsigned int identityInstance)
+{
+	unsigned int drawCalls = 0;
+	unsigned int strides[2] = { sizeof(VertexType), sizeof(D3DXMATRIX) };
+	unsigned int offsets[2] = { 0, 0 };
+
+	for (auto& visibleCell : mVisibleCells[pass])
+	{
+		const CellType* cell = visibleCell.cell;
+
+		const std::vector<CInstanceBatch::RangeType>& levels = cell->subMeshLevels[subMesh];
+		if (levels.empty())
+		{
+			continue;
+		}
+
+		const unsigned int level = visibleCell.level < levels.size() ? visibleCell.level : static_cast<unsigned int>(levels.size()) - 1;
+		const CInstanceBatch::RangeType& run = levels[level];
+
+		// The models were merged in thinning order, so the ones which survive thinning come first in every level's run.
+		unsigned int indexCount = visibleCell.visibleModels * (run.indexCount / cell->numberOfModels);
+		indexCount = indexCount < run.indexCount ? indexCount : run.indexCount;
+
+		if (indexCount == 0)
+		{
+			continue;
+		}
+
+		ID3D11Buffer* vertexBuffers[2] = { cell->vertexBuffer, instanceBuffer };
+		device->IASetVertexBuffers(0, 2, vertexBuffers, strides, offsets);
+		device->IASetIndexBuffer(cell->indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+
+		shader->RenderInstancedRange(device, indexCount, 1, run.startIndex, identityInstance);
+		drawCalls++;
+	}
+
+	return drawCalls;
+}
+
+void CStaticBatcher::Shutdown()
+{
+	for (auto& entry : mCells)
+	{
+		ReleaseCell(entry.second);
+	}
+
+	mCells.clear();
+	mPlacements.clear();
+	for (auto& visibleCells : mVisibleCells)
+	{
+		visibleCells.clear();
+	}
+	mSubMeshes.clear();
+}
+
+/* The key of the cell a model's position falls in, made from its cell coordinates on the ground plane. */
+long long CStaticBatcher::FindCell(CModel* model)
+{
+	D3DXVECTOR3 position = model->GetPos();
+
+	int cellX = static_cast<int>(floorf(position.x / mCellSize));
+	int cellZ = static_cast<int>(floorf(position.z / mCellSize));
+
+	return (static_cast<long long>(cellX) << 32) | static_cast<unsigned int>(cellZ);
+}
+
+/* Merges the models in a cell and replaces its buffers with the result.
+* @Returns bool Success
+*/
+bool CStaticBatcher::RebuildCell(CRenderDevice* device, CellType& cell)
+{
+	ReleaseCell(cell);
+	cell.dirty = false;
+
+	// Lowest thinning value first, as those are the last to be thinned out.
+	std::sort(cell.models.begin(), cell.models.end(), [](CModel* first, CModel* second)
+	{
+		return CDistanceCuller::GetInstanceValue(first->GetPos()) < CDistanceCuller::GetInstanceValue(second->GetPos());
+	});
+
+	mWorlds.clear();
+	for (auto model : cell.models)
+	{
+		mWorlds.push_back(model->GetWorldMatrix());
+	}
+
+	Merge(mSubMeshes, mWorlds, mBatch);
+	mCellsRebuilt++;
+
+	if (mBatch.vertices.empty() || mBatch.indices.empty())
+	{
+		return true;
+	}
+
+	HRESULT result;
+	D3D11_BUFFER_DESC bufferDesc;
+	D3D11_SUBRESOURCE_DATA initData;
+
+	bufferDesc.Usage = D3D11_USAGE_DEFAULT;
+	bufferDesc.ByteWidth = static_cast<unsigned int>(sizeof(VertexType) * mBatch.vertices.size());
+	bufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	bufferDesc.CPUAccessFlags = 0;
+	bufferDesc.MiscFlags = 0;
+	bufferDesc.StructureByteStride = 0;
+
+	initData.pSysMem = &mBatch.vertices[0];
+	initData.SysMemPitch = 0;
+	initData.SysMemSlicePitch = 0;
+
+	result = device->CreateBuffer(&bufferDesc, &initData, &cell.vertexBuffer);
+	if (FAILED(result))
+	{
+		logger->GetInstance().WriteLine("Failed to create the vertex buffer for a static batch cell.");
+		cell.vertexBuffer = nullptr;
+		return false;
+	}
+	CGpuMemoryTracker::GetInstance().Register(cell.vertexBuffer, CGpuMemoryTracker::StaticBatches, bufferDesc.ByteWidth);
+
+	bufferDesc.ByteWidth = static_cast<unsigned int>(sizeof(unsigned int) * mBatch.indices.size());
+	bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+
+	initData.pSysMem = &mBatch.indices[0];
+
+	result = device->CreateBuffer(&bufferDesc, &initData, &cell.indexBuffer);
+	if (FAILED(result))
+	{
+		logger->GetInstance().WriteLine("Failed to create the index buffer for a static batch cell.");
+		ReleaseCell(cell);
+		return false;
+	}
+	CGpuMemoryTracker::GetInstance().Register(cell.indexBuffer, CGpuMemoryTracker::StaticBatches, bufferDesc.ByteWidth);
+
+	cell.numberOfModels = static_cast<unsigned int>(cell.models.size());
+	cell.subMeshLevels = mBatch.subMeshLevels;
+	cell.instanceRadius = mBatch.instanceRadius;
+	cell.minPoint = mBatch.minPoint;
+	cell.maxPoint = mBatch.maxPoint;
+
+	return true;
+}
+
+void CStaticBatcher::ReleaseCell(CellType& cell)
+{
+	if (cell.vertexBuffer != nullptr)
+	{
+		CGpuMemoryTracker::GetInstance().Unregister(cell.vertexBuffer);
+		mpDevice->ReleaseResource(cell.vertexBuffer);
+		cell.vertexBuffer = nullptr;
+	}
+
+	if (cell.indexBuffer != nullptr)
+	{
+		CGpuMemoryTracker::GetInstance().Unregister(cell.indexBuffer);
+		mpDevice->ReleaseResource(cell.indexBuffer);
+		cell.indexBuffer = nullptr;
+	}
+}
@@ -0,0 +1,134 @@
+#ifndef STATICBATCHER_H
+#define STATICBATCHER_H
+
+#include <d3d11.h>
+#include <D3DX10math.h>
+#include <vector>
+#include <unordered_map>
+#include "PrioEngineVars.h"
+#include "RenderDevice.h"
+#include "RenderQueue.h"
+#include "InstanceBatch.h"
+
+class CModel;
+class CFrustum;
+class CHorizonCuller;
+class CDiffuseLightShader;
+class CDistanceCuller;
+
+/* Merges the static instances of a mesh which sit in the same world cell into one pre-transformed vertex and index buffer.
+* Thousands of trees become one draw per submesh per visible cell. A cell is only merged again when one of its models moves.
+* Merge has no device dependencies, so it can be run and checked on the CPU alone.
+* The models in a cell are merged in order of their thinning value, so thinning a cell out with distance is just drawing fewer of its indices.
+* Every detail level of every submesh is merged, and each visible cell draws the level its nearest point needs, so distant cells draw far fewer triangles.
+*
+* Batched models are only culled a cell at a time. The per-model meshlet culling, visibility cache and bounds tests of unbatched meshes don't apply to them.
+*/
+class CStaticBatcher
+{
+private:
+	CLogger* logger;
+public:
+	// Must match the vertex layout of CMesh.
+	struct VertexType
+	{
+		D3DXVECTOR3 position;
+		D3DXVECTOR2 uv;
+		D3DXVECTOR3 normal;
+	};
+
+	// The untransformed vertices and indices of one submesh.
+	struct GeometryType
+	{
+		std::vector<VertexType> vertices;
+		std::vector<unsigned int> indices;
+		// Where each detail level sits in the indices, level 0 being full detail. If empty, all of the indices are one level.
+		std::vector<CInstanceBatch::RangeType> levels;
+	};
+
+	// The output of a merge. Each submesh has one run of the index array per detail level, each run holding every instance.
+	struct BatchType
+	{
+		std::vector<VertexType> vertices;
+		std::vector<unsigned int> indices;
+		std::vector<std::vector<CInstanceBatch::RangeType>> subMeshLevels;
+		D3DXVECTOR3 minPoint;
+		D3DXVECTOR3 maxPoint;
+		// Half the diagonal of the largest instance's box, used to pick the detail level of a cell.
+		float instanceRadius;
+	};
+public:
+	CStaticBatcher();
+	~CStaticBatcher();
+public:
+	static void Merge(const std::vector<GeometryType>& subMeshes, const std::vector<D3DXMATRIX>& worlds, BatchType& batch);
+
+	void AddSubMesh(GeometryType& geometry);
+	void SetCellSize(float cellSize) { mCellSize = cellSize; };
+	void Add(CModel* model);
+	void Remove(CModel* model);
+	bool Update(CRenderDevice* device);
+	void Cull(CRenderQueue::PassType pass, CFrustum* frustum, CHorizonCuller* horizon, D3DXVECTOR3 cameraPosition, CDistanceCuller* distanceCuller = nullptr,
+		const float* levelScreenSizes = nullptr, unsigned int numberOfLevelScreenSizes = 0);
+	unsigned int Render(CRenderQueue::PassType pass, CRenderDevice* device, CDiffuseLightShader* shader, unsigned int subMesh, ID3D11Buffer* instanceBuffer, unsigned int identityInstance);
+	void Shutdown();
+
+	bool HasVisibleCells(CRenderQueue::PassType pass) { return !mVisibleCells[pass].empty(); };
+	bool HasVisibleGeometry(CRenderQueue::PassType pass, unsigned int subMesh);
+	float GetNearestCellDistance(CRenderQueue::PassType pass) { return mNearestCellDistance[pass]; };
+	unsigned int GetNumberOfCells() { return static_cast<unsigned int>(mCells.size()); };
+	unsigned int GetNumberOfVisibleCells(CRenderQueue::PassType pass = CRenderQueue::Main) { return static_cast<unsigned int>(mVisibleCells[pass].size()); };
+	unsigned int GetCellsRebuilt() { return mCellsRebuilt; };
+private:
+	struct CellType
+	{
+		CellType() : dirty(true), vertexBuffer(nullptr), indexBuffer(nullptr), instanceRadius(0.0f), numberOfModels(0) {};
+
+		std::vector<CModel*> models;
+		bool dirty;
+		ID3D11Buffer* vertexBuffer;
+		ID3D11Buffer* indexBuffer;
+		std::vector<std::vector<CInstanceBatch::RangeType>> subMeshLevels;
+		D3DXVECTOR3 minPoint;
+		D3DXVECTOR3 maxPoint;
+		float instanceRadius;
+		unsigned int numberOfModels;
+	};
+
+	// A cell seen by a pass, how many of its models are left after thinning for that pass, and the detail level they're drawn at.
+	struct VisibleCellType
+	{
+		CellType* cell;
+		unsigned int visibleModels;
+		unsigned int level;
+	};
+
+	// Which cell a model was last merged into, and the version of its transform at the time.
+	struct PlacementType
+	{
+		long long cell;
+		unsigned int transformVersion;
+	};
+
+	long long FindCell(CModel* model);
+	bool RebuildCell(CRenderDevice* device, CellType& cell);
+	void ReleaseCell(CellType& cell);
+
+	// The device the cell buffers were made with, so they can be released through it.
+	CRenderDevice* mpDevice;
+	std::vector<GeometryType> mSubMeshes;
+	std::unordered_map<long long, CellType> mCells;
+	std::unordered_map<CModel*, PlacementType> mPlacements;
+	// Each pass has its own list, so different passes can be culled on different threads at once.
+	std::vector<VisibleCellType> mVisibleCells[CRenderQueue::kNumberOfPasses];
+
+	// Kept between rebuilds so the arrays keep their memory.
+	std::vector<D3DXMATRIX> mWorlds;
+	BatchType mBatch;
+
+	float mCellSize;
+	float mNearestCellDistance[CRenderQueue::kNumberOfPasses];
+	unsigned int mCellsRebuilt;
+};
+
+#endif
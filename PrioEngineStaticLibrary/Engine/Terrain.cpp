@@ -1,13 +1,10 @@
 #include "Terrain.h"
 
-CTerrain::CTerrain(ID3D11Device* device, int screenWidth, int screenHeight)
+CTerrain::CTerrain(ID3D11Device* device)
 {
 	// Output alloc message to memory log.
 	logger->GetInstance().MemoryAllocWriteLine(typeid(this).name());
 
-	mScreenWidth = screenWidth;
-	mScreenHeight = screenHeight;
-
 	// Initialise pointers to nullptr.
 	mpVertexBuffer = nullptr;
 	mpIndexBuffer = nullptr;
@@ -26,13 +23,13 @@ CTerrain::CTerrain(ID3D11Device* device, int screenWidth, int screenHeight)
 	mpTextures = new CTexture*[kmNumberOfTextures];
 	// Dirt
 	mpTextures[0] = new CTexture();
-	mpTextures[0]->Initialise(device, "Resources/Textures/Dirt.dds");
+	mpTextures[0]->Initialise(device, "Resources/Textures/Dirt.dds", CGpuMemoryTracker::Terrain);
 	// Sand.
 	mpTextures[1] = new CTexture();
-	mpTextures[1]->Initialise(device, "Resources/Textures/Sand.dds");
+	mpTextures[1]->Initialise(device, "Resources/Textures/Sand.dds", CGpuMemoryTracker::Terrain);
 
 	mpPatchMap = new CTexture();
-	mpPatchMap->Initialise(device, "Resources/Patch Maps/PatchMap.png");
+	mpPatchMap->Initialise(device, "Resources/Patch Maps/PatchMap.png", CGpuMemoryTracker::Terrain);
 
 	///////////////////////
 	// Grass textures
@@ -41,13 +38,13 @@ CTerrain::CTerrain(ID3D11Device* device, int screenWidth, int screenHeight)
 	mpGrassTextures = new CTexture*[kNumberOfGrassTextures];
 
 	mpGrassTextures[0] = new CTexture();
-	if (!mpGrassTextures[0]->Initialise(device, "Resources/Textures/BrightGrass.dds"))
+	if (!mpGrassTextures[0]->Initialise(device, "Resources/Textures/BrightGrass.dds", CGpuMemoryTracker::Terrain))
 	{
 		logger->GetInstance().WriteLine("Failed to load 'Resources/Textures/BrightGrass.dds'.");
 	}
 
 	mpGrassTextures[1] = new CTexture();
-	if (!mpGrassTextures[1]->Initialise(device, "Resources/Textures/DarkGrass.dds"))
+	if (!mpGrassTextures[1]->Initialise(device, "Resources/Textures/DarkGrass.dds", CGpuMemoryTracker::Terrain))
 	{
 		logger->GetInstance().WriteLine("Failed to load 'Resources/Textures/DarkGrass.dds'.");
 	}
@@ -58,13 +55,13 @@ CTerrain::CTerrain(ID3D11Device* device, int screenWidth, int screenHeight)
 	mpRockTextures = new CTexture*[kNumberOfRockTextures];
 
 	mpRockTextures[0] = new CTexture();
-	if (!mpRockTextures[0]->Initialise(device, "Resources/Textures/Stone.dds"))
+	if (!mpRockTextures[0]->Initialise(device, "Resources/Textures/Stone.dds", CGpuMemoryTracker::Terrain))
 	{
 		logger->GetInstance().WriteLine("Failed to load 'Resources/Textures/Stone.dds'.");
 	}
 
 	mpRockTextures[1] = new CTexture();
-	if (!mpRockTextures[1]->Initialise(device, "Resources/Textures/LightRock.dds"))
+	if (!mpRockTextures[1]->Initialise(device, "Resources/Textures/LightRock.dds", CGpuMemoryTracker::Terrain))
 	{
 		logger->GetInstance().WriteLine("Failed to load 'Resources/Textures/LightRock.dds'.");
 	}
@@ -469,6 +466,9 @@ bool CTerrain::InitialiseBuffers(ID3D11Device * device)
 		}
 	}
 
+	// Find the height range of each chunk now the height map is in place.
+	CalculateChunkBounds();
+
 	// Set up the descriptor of the static vertex buffer.
 	vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
 	vertexBufferDesc.ByteWidth = sizeof(VertexType) * mVertexCount;
@@ -489,6 +489,7 @@ bool CTerrain::InitialiseBuffers(ID3D11Device * device)
 		logger->GetInstance().WriteLine("Failed to create the vertex buffer from the buffer description.");
 		return false;
 	}
+	CGpuMemoryTracker::GetInstance().Register(mpVertexBuffer, CGpuMemoryTracker::Terrain, vertexBufferDesc.ByteWidth);
 
 	// Set up the description of the static index buffer.
 	indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
@@ -510,6 +511,7 @@ bool CTerrain::InitialiseBuffers(ID3D11Device * device)
 		logger->GetInstance().WriteLine("Failed to create the index buffer from the buffer description.");
 		return false;
 	}
+	CGpuMemoryTracker::GetInstance().Register(mpIndexBuffer, CGpuMemoryTracker::Terrain, indexBufferDesc.ByteWidth);
 
 
 	// Clean up the memory allocated to arrays.
@@ -522,7 +524,7 @@ bool CTerrain::InitialiseBuffers(ID3D11Device * device)
 	indices = nullptr;
 
 	mpWater = new CWater();
-	if (!mpWater->Initialise(device, D3DXVECTOR3(0.0f, 0.0f, 0.0f), D3DXVECTOR3(mWidth - 1.0f, 0.0f, mHeight - 1.0f), 200, 200, "Resources/Textures/WaterNormalHeight.png", mScreenWidth, mScreenHeight))
+	if (!mpWater->Initialise(device, D3DXVECTOR3(0.0f, 0.0f, 0.0f), D3DXVECTOR3(mWidth - 1.0f, 0.0f, mHeight - 1.0f), 200, 200, "Resources/Textures/WaterNormalHeight.png"))
 	{
 		logger->GetInstance().WriteLine("Failed to initialise the body of water.");
 		return false;
@@ -539,6 +541,7 @@ void CTerrain::ShutdownBuffers()
 	// Release any memory given to the vertex buffer.
 	if (mpVertexBuffer)
 	{
+		CGpuMemoryTracker::GetInstance().Unregister(mpVertexBuffer);
 		mpVertexBuffer->Release();
 		mpVertexBuffer = nullptr;
 	}
@@ -546,6 +549,7 @@ void CTerrain::ShutdownBuffers()
 	// Release any memory given to the index buffer.
 	if (mpIndexBuffer)
 	{
+		CGpuMemoryTracker::GetInstance().Unregister(mpIndexBuffer);
 		mpIndexBuffer->Release();
 		mpIndexBuffer = nullptr;
 	}
@@ -570,6 +574,72 @@ void CTerrain::RenderBuffers(ID3D11DeviceContext * context)
 	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 }
 
+/* Splits the grid into square chunks and records the lowest and highest point found in each one.
+* These are used as a cheap, conservative description of the heightfield for occlusion tests.
+*/
+void CTerrain::CalculateChunkBounds()
+{
+	mChunks.clear();
+
+	// Work out how many chunks we need to cover every grid square.
+	mNumberOfChunksX = (mWidth - 1 + kChunkSize - 1) / kChunkSize;
+	mNumberOfChunksZ = (mHeight - 1 + kChunkSize - 1) / kChunkSize;
+
+	if (mNumberOfChunksX <= 0 || mNumberOfChunksZ <= 0)
+	{
+		mNumberOfChunksX = 0;
+		mNumberOfChunksZ = 0;
+		return;
+	}
+
+	mChunks.reserve(mNumberOfChunksX * mNumberOfChunksZ);
+
+	for (int chunkZ = 0; chunkZ < mNumberOfChunksZ; chunkZ++)
+	{
+		for (int chunkX = 0; chunkX < mNumberOfChunksX; chunkX++)
+		{
+			// Vertices shared along the edges belong to both neighbouring chunks.
+			const int startX = chunkX * kChunkSize;
+			const int startZ = chunkZ * kChunkSize;
+			const int endX = startX + kChunkSize < mWidth - 1 ? startX + kChunkSize : mWidth - 1;
+			const int endZ = startZ + kChunkSize < mHeight - 1 ? startZ + kChunkSize : mHeight - 1;
+
+			TerrainChunkType chunk;
+			chunk.minX = static_cast<float>(startX);
+			chunk.minZ = static_cast<float>(startZ);
+			chunk.maxX = static_cast<float>(endX);
+			chunk.maxZ = static_cast<float>(endZ);
+			chunk.minHeight = 0.0f;
+			chunk.maxHeight = 0.0f;
+
+			if (mHeightMapLoaded)
+			{
+				chunk.minHeight = static_cast<float>(mpHeightMap[startZ][startX]);
+				chunk.maxHeight = chunk.minHeight;
+
+				for (int z = startZ; z <= endZ; z++)
+				{
+					for (int x = startX; x <= endX; x++)
+					{
+						const float height = static_cast<float>(mpHeightMap[z][x]);
+
+						if (height < chunk.minHeight)
+						{
+							chunk.minHeight = height;
+						}
+						else if (height > chunk.maxHeight)
+						{
+							chunk.maxHeight = height;
+						}
+					}
+				}
+			}
+
+			mChunks.push_back(chunk);
+		}
+	}
+}
+
 PrioEngine::Math::VEC3 CTerrain::CalculateNormal(VertexType * vertices, int index)
 {
 	// Bottom left
@@ -806,12 +876,14 @@ bool CTerrain::UpdateBuffers(ID3D11Device * device, ID3D11DeviceContext* deviceC
 
 	if (mpVertexBuffer)
 	{
+		CGpuMemoryTracker::GetInstance().Unregister(mpVertexBuffer);
 		mpVertexBuffer->Release();
 		mpVertexBuffer = nullptr;
 	}
 
 	if (mpIndexBuffer)
 	{
+		CGpuMemoryTracker::GetInstance().Unregister(mpIndexBuffer);
 		mpIndexBuffer->Release();
 		mpIndexBuffer = nullptr;
 	}
@@ -33,7 +33,7 @@ private:
 	};
 
 public:
-	CTerrain(ID3D11Device* device, int screenWidth, int screenHeight);
+	CTerrain(ID3D11Device* device);
 	~CTerrain();
 private:
 	void ReleaseHeightMap();
@@ -125,11 +125,32 @@ public:
 	CWater* GetWater() { return mpWater; };
 private:
 	CWater* mpWater;
-	int mScreenWidth;
-	int mScreenHeight;
 	bool mUpdating = false;
 public:
 	bool GetUpdateFlag() { return mUpdating; };
+// Chunk bounds, used for occlusion tests against the heightfield.
+public:
+	struct TerrainChunkType
+	{
+		// Extents of the chunk in the local space of the terrain.
+		float minX;
+		float minZ;
+		float maxX;
+		float maxZ;
+		// The lowest and highest height found in any vertex of this chunk.
+		float minHeight;
+		float maxHeight;
+	};
+	const std::vector<TerrainChunkType>& GetChunks() { return mChunks; };
+	int GetNumberOfChunksX() { return mNumberOfChunksX; };
+	int GetNumberOfChunksZ() { return mNumberOfChunksZ; };
+private:
+	// The number of grid squares along each side of a chunk.
+	const int kChunkSize = 16;
+	std::vector<TerrainChunkType> mChunks;
+	int mNumberOfChunksX = 0;
+	int mNumberOfChunksZ = 0;
+	void CalculateChunkBounds();
 };
 
 #endif
\ No newline at end of file
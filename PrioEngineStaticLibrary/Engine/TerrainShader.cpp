@@ -6,8 +6,20 @@ CTerrainShader::CTerrainShader()
 	mpPixelShader = nullptr;
 	mpLayout = nullptr;
 	mpSampleState = nullptr;
-	mpLightBuffer = nullptr;
 	mpPatchMap = new CTexture();
+
+	CHECK_CONSTANT_BUFFER_MEMBER(LightBufferType, ambientColour);
+	CHECK_CONSTANT_BUFFER_MEMBER(LightBufferType, diffuseColour);
+	CHECK_CONSTANT_BUFFER_MEMBER(LightBufferType, lightDirection);
+	CHECK_CONSTANT_BUFFER_MEMBER(LightBufferType, padding);
+	CHECK_CONSTANT_BUFFER_MEMBER(PositioningBufferType, yOffset);
+	CHECK_CONSTANT_BUFFER_MEMBER(PositioningBufferType, posPadding);
+	CHECK_CONSTANT_BUFFER_MEMBER(PositioningBufferType, posPadding2);
+	CHECK_CONSTANT_BUFFER_MEMBER(TerrainAreaBufferType, snowHeight);
+	CHECK_CONSTANT_BUFFER_MEMBER(TerrainAreaBufferType, grassHeight);
+	CHECK_CONSTANT_BUFFER_MEMBER(TerrainAreaBufferType, dirtHeight);
+	CHECK_CONSTANT_BUFFER_MEMBER(TerrainAreaBufferType, sandHeight);
+	CHECK_CONSTANT_BUFFER_MEMBER(TerrainAreaBufferType, terrainAreaPadding);
 }
 
 CTerrainShader::~CTerrainShader()
@@ -77,9 +89,6 @@ bool CTerrainShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::str
 	D3D11_INPUT_ELEMENT_DESC polygonLayout[kNumberOfPolygonElements];
 	unsigned int numElements;
 	D3D11_SAMPLER_DESC samplerDesc;
-	D3D11_BUFFER_DESC lightBufferDesc;
-	D3D11_BUFFER_DESC positioningBufferDesc;
-	D3D11_BUFFER_DESC terrainAreaBufferDesc;
 
 	// Initialise pointers in this function to null.
 	errorMessage = nullptr;
@@ -87,7 +96,7 @@ bool CTerrainShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::str
 	pixelShaderBuffer = nullptr;
 
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(vsFilename.c_str(), NULL, NULL, "TerrainVertex", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), 0, NULL, &vertexShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(vsFilename, "TerrainVertex", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), &vertexShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -104,7 +113,7 @@ bool CTerrainShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::str
 	}
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(psFilename.c_str(), NULL, NULL, "TerrainPixel", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(psFilename, "TerrainPixel", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -220,49 +229,19 @@ bool CTerrainShader::InitialiseShader(ID3D11Device * device, HWND hwnd, std::str
 		return false;
 	}
 
-	lightBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	lightBufferDesc.ByteWidth = sizeof(LightBufferType);
-	lightBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	lightBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	lightBufferDesc.MiscFlags = 0;
-	lightBufferDesc.StructureByteStride = 0;
-
-	result = device->CreateBuffer(&lightBufferDesc, NULL, &mpLightBuffer);
-	if (FAILED(result))
+	if (!mLightBuffer.Initialise(device))
 	{
 		logger->GetInstance().WriteLine("Failed to create the buffer from the light buffer descriptor from within the texture diffuse light shader class.");
 		return false;
 	}
 
-	///////////////////////////////
-	// Position buffer description
-	positioningBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	positioningBufferDesc.ByteWidth = sizeof(PositioningBufferType);
-	positioningBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	positioningBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	positioningBufferDesc.MiscFlags = 0;
-	positioningBufferDesc.StructureByteStride = 0;
-
-	result = device->CreateBuffer(&positioningBufferDesc, NULL, &mpPositioningBuffer);
-	if (FAILED(result))
+	if (!mPositioningBuffer.Initialise(device))
 	{
 		logger->GetInstance().WriteLine("Failed to create the constant position information buffer in the terrrain shader from the positioning buffer description given.");
 		return false;
 	}
 
-	///////////////////////////
-	// Terrain area buffer description
-
-	terrainAreaBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	terrainAreaBufferDesc.ByteWidth = sizeof(TerrainAreaBufferType);
-	terrainAreaBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	terrainAreaBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	terrainAreaBufferDesc.MiscFlags = 0;
-	terrainAreaBufferDesc.StructureByteStride = 0;
-
-	result = device->CreateBuffer(&terrainAreaBufferDesc, NULL, &mpTerrainAreaBuffer);
-
-	if (FAILED(result))
+	if (!mTerrainAreaBuffer.Initialise(device))
 	{
 		logger->GetInstance().WriteLine("Failed to create the terrain area constant buffer from the description provided.");
 		return false;
@@ -280,23 +259,9 @@ void CTerrainShader::ShutdownShader()
 		mpPatchMap = nullptr;
 	}
 
-	if (mpLightBuffer)
-	{
-		mpLightBuffer->Release();
-		mpLightBuffer = nullptr;
-	}
-	
-	if (mpTerrainAreaBuffer)
-	{
-		mpTerrainAreaBuffer->Release();
-		mpTerrainAreaBuffer = nullptr;
-	}
-
-	if (mpPositioningBuffer)
-	{
-		mpPositioningBuffer->Release();
-		mpPositioningBuffer = nullptr;
-	}
+	mLightBuffer.Shutdown();
+	mTerrainAreaBuffer.Shutdown();
+	mPositioningBuffer.Shutdown();
 
 	if (mpSampleState)
 	{
@@ -380,13 +345,7 @@ bool CTerrainShader::SetShaderParameters(ID3D11DeviceContext* deviceContext, CTe
 		rockTextures[i] = rockTexturesArray[i]->GetTexture();
 	}
 
-	HRESULT result;
-	D3D11_MAPPED_SUBRESOURCE mappedResource;
 	unsigned int bufferNumber;
-	MatrixBufferType* dataPtr;
-	LightBufferType* dataPtr2;
-	PositioningBufferType* positioningConstBuffPtr;
-	TerrainAreaBufferType* terrainAreaConstBuffPtr;
 
 	bufferNumber = 0;
 
@@ -405,75 +364,56 @@ bool CTerrainShader::SetShaderParameters(ID3D11DeviceContext* deviceContext, CTe
 	deviceContext->PSSetShaderResources(numberOfTextures + numberOfGrassTextures, 1, &patchMap);
 	deviceContext->PSSetShaderResources(numberOfTextures + numberOfGrassTextures + 1, numberOfRockTextures, rockTextures);
 
-	// Lock the light constant buffer so it can be written to.
-	result = deviceContext->Map(mpLightBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	if (FAILED(result))
+	// Copy the lighting variables into the light buffer, each buffer is only written again when its values change.
+	mLightBuffer.Set(&LightBufferType::diffuseColour, diffuseColour);
+	mLightBuffer.Set(&LightBufferType::ambientColour, ambientColour);
+	mLightBuffer.Set(&LightBufferType::lightDirection, lightDirection);
+
+	if (!mLightBuffer.Update(deviceContext))
 	{
 		return false;
 	}
 
-	// Get a pointer to the data in the constant buffer.
-	dataPtr2 = (LightBufferType*)mappedResource.pData;
-
-	// Copy the lighting variables into the constant buffer.
-	dataPtr2->diffuseColour = diffuseColour;
-	dataPtr2->ambientColour = ambientColour;
-	dataPtr2->lightDirection = lightDirection;
-	dataPtr2->padding = 0.0f;
-
-	// Unlock the constant buffer.
-	deviceContext->Unmap(mpLightBuffer, 0);
-
 	// Set the position of the light constant buffer in the pixel shader.
 	bufferNumber = 0;
 
 	// Finally set the light constant buffer in the pixel shader with the updated values.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpLightBuffer);
+	deviceContext->PSSetConstantBuffers(bufferNumber, 1, mLightBuffer.GetBufferAddress());
 
 	////////////////////////////////////////
 	// Positioning buffer.
 
-	// Lock the terrain info constant buffer so it can be written to.
-	result = deviceContext->Map(mpPositioningBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	if (FAILED(result))
+	mPositioningBuffer.Set(&PositioningBufferType::yOffset, worldPosition.y);
+
+	if (!mPositioningBuffer.Update(deviceContext))
 	{
 		logger->GetInstance().WriteLine("Failed to map the positioning cosntant buffer when setting shader parameters in terrain shader class.");
 		return false;
 	}
 
-	positioningConstBuffPtr = (PositioningBufferType*)mappedResource.pData;
-
-	// Append the positions before it gets locked in the const buffer.
-	positioningConstBuffPtr->yOffset = worldPosition.y;
-	positioningConstBuffPtr->posPadding = D3DXVECTOR3(0.0f, 0.0f, 0.0f);
-
-	// Unlock the terrain constant buffer.
-	deviceContext->Unmap(mpPositioningBuffer, 0);
-
 	// We'll need to modify the buffer position in the pixel shader as we're looking at the next buffer now.
 	bufferNumber = 1;
 
 	// Update the terrain constant buffer in the pixel shader.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpPositioningBuffer);
-
-	result = deviceContext->Map(mpTerrainAreaBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	deviceContext->PSSetConstantBuffers(bufferNumber, 1, mPositioningBuffer.GetBufferAddress());
 
-	terrainAreaConstBuffPtr = (TerrainAreaBufferType*)mappedResource.pData;
+	// The area heights are relative to the terrain's position.
+	mTerrainAreaBuffer.Set(&TerrainAreaBufferType::snowHeight, snowHeight + worldPosition.y);
+	mTerrainAreaBuffer.Set(&TerrainAreaBufferType::grassHeight, grassHeight + worldPosition.y);
+	mTerrainAreaBuffer.Set(&TerrainAreaBufferType::dirtHeight, dirtHeight + worldPosition.y);
+	mTerrainAreaBuffer.Set(&TerrainAreaBufferType::sandHeight, sandHeight + worldPosition.y);
 
-	// Append the positions before it gets locked in the const buffer.
-	terrainAreaConstBuffPtr->snowHeight = snowHeight + worldPosition.y;
-	terrainAreaConstBuffPtr->grassHeight = grassHeight + worldPosition.y;
-	terrainAreaConstBuffPtr->dirtHeight = dirtHeight + worldPosition.y;
-	terrainAreaConstBuffPtr->sandHeight = sandHeight + worldPosition.y;
-
-	// Unlock the terrain constant buffer.
-	deviceContext->Unmap(mpTerrainAreaBuffer, 0);
+	if (!mTerrainAreaBuffer.Update(deviceContext))
+	{
+		logger->GetInstance().WriteLine("Failed to map the terrain area constant buffer when setting shader parameters in terrain shader class.");
+		return false;
+	}
 
 	// We'll need to modify the buffer position in the pixel shader as we're looking at the next buffer now.
 	bufferNumber = 2;
 
 	// Update the terrain constant buffer in the pixel shader.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &mpTerrainAreaBuffer);
+	deviceContext->PSSetConstantBuffers(bufferNumber, 1, mTerrainAreaBuffer.GetBufferAddress());
 
 	delete[] textures;
 	delete[] grassTextures;
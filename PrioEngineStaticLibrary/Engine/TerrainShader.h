@@ -64,9 +64,9 @@ private:
 	ID3D11PixelShader* mpPixelShader;
 	ID3D11InputLayout* mpLayout;
 	ID3D11SamplerState* mpSampleState;
-	ID3D11Buffer* mpLightBuffer;
-	ID3D11Buffer* mpPositioningBuffer;
-	ID3D11Buffer* mpTerrainAreaBuffer;
+	CConstantBuffer<LightBufferType> mLightBuffer;
+	CConstantBuffer<PositioningBufferType> mPositioningBuffer;
+	CConstantBuffer<TerrainAreaBufferType> mTerrainAreaBuffer;
 	CTexture* mpPatchMap;
 };
 
@@ -11,8 +11,10 @@ CTexture::~CTexture()
 {
 }
 
-/* Load in a texture. */
-bool CTexture::Initialise(ID3D11Device * device, std::string filename)
+/* Load in a texture.
+* @PARAM CGpuMemoryTracker::CategoryType category - Which budget the texture counts against in the memory tracker.
+*/
+bool CTexture::Initialise(ID3D11Device * device, std::string filename, CGpuMemoryTracker::CategoryType category)
 {
 	mFilename = filename;
 	HRESULT result;
@@ -26,12 +28,22 @@ bool CTexture::Initialise(ID3D11Device * device, std::string filename)
 		return false;
 	}
 
+	// Other objects keep hold of the texture itself, so it's counted but can't be evicted.
+	CGpuMemoryTracker::GetInstance().Register(mpTexture, category, GetMemory(mpTexture));
+
 	return true;
 }
 
 /* Deallocates memory and cleans up after object. */
 void CTexture::Shutdown()
 {
+	if (mpTexture == nullptr)
+	{
+		return;
+	}
+
+	CGpuMemoryTracker::GetInstance().Unregister(mpTexture);
+
 	// Let go of the sample texture.
 	mpTexture->Release();
 	mpTexture = nullptr;
@@ -43,6 +55,33 @@ ID3D11ShaderResourceView * CTexture::GetTexture()
 	return mpTexture;
 }
 
+/* The video memory taken by a 2D texture and its mip levels, 0 for any other kind of texture. */
+unsigned long long CTexture::GetMemory(ID3D11ShaderResourceView* texture)
+{
+	if (texture == nullptr)
+	{
+		return 0;
+	}
+
+	ID3D11Resource* resource = nullptr;
+	ID3D11Texture2D* texture2D = nullptr;
+
+	texture->GetResource(&resource);
+	HRESULT result = resource->QueryInterface(__uuidof(ID3D11Texture2D), reinterpret_cast<void**>(&texture2D));
+	resource->Release();
+
+	if (FAILED(result))
+	{
+		return 0;
+	}
+
+	D3D11_TEXTURE2D_DESC desc;
+	texture2D->GetDesc(&desc);
+	texture2D->Release();
+
+	return CGpuMemoryTracker::GetTextureMemory(desc.Width, desc.Height, desc.MipLevels, desc.ArraySize, desc.Format);
+}
+
 std::wstring CTexture::s2ws(const std::string str)
 {
 	int len;
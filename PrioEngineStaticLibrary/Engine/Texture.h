@@ -5,6 +5,7 @@
 #include <d3d11.h>
 #include <D3DX11tex.h>
 #include "PrioEngineVars.h"
+#include "GpuMemoryTracker.h"
 
 class CTexture
 {
@@ -14,10 +15,12 @@ public:
 	CTexture();
 	~CTexture();
 
-	bool Initialise(ID3D11Device * device, std::string filename);
+	bool Initialise(ID3D11Device * device, std::string filename, CGpuMemoryTracker::CategoryType category = CGpuMemoryTracker::Textures);
 	void Shutdown();
 
 	ID3D11ShaderResourceView* GetTexture();
+
+	static unsigned long long GetMemory(ID3D11ShaderResourceView* texture);
 private:
 	ID3D11ShaderResourceView* mpTexture;
 	std::wstring s2ws(const std::string str);
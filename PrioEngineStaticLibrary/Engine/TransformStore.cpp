@@ -0,0 +1,217 @@
+#include "TransformStore.h"
+#include <xmmintrin.h>
+
+CTransformStore::CTransformStore()
+{
+	mNumberOfInstances = 0;
+	mNumberOfSlots = 0;
+	mInstancesUpdated = 0;
+	mTotalInstancesUpdated = 0;
+}
+
+CTransformStore::~CTransformStore()
+{
+}
+
+/* Reserves a slot for a new instance, which starts at the origin with no rotation and a scale of one.
+* @Returns unsigned int - The index of the slot, used to refer to the instance from now on.
+*/
+unsigned int CTransformStore::Add()
+{
+	unsigned int index;
+
+	// Reuse the slot of an instance which has been removed if we can.
+	if (!mFreeSlots.empty())
+	{
+		index = mFreeSlots.back();
+		mFreeSlots.pop_back();
+	}
+	else
+	{
+		if (mNumberOfSlots == mWorldMatrices.size())
+		{
+			Grow();
+		}
+
+		index = mNumberOfSlots;
+		mNumberOfSlots++;
+	}
+
+	mNumberOfInstances++;
+
+	SetTransform(index, D3DXVECTOR3(0.0f, 0.0f, 0.0f), D3DXVECTOR3(0.0f, 0.0f, 0.0f), D3DXVECTOR3(1.0f, 1.0f, 1.0f));
+
+	return index;
+}
+
+/* Frees up the slot of an instance which is no longer needed. */
+void CTransformStore::Remove(unsigned int index)
+{
+	if (index >= mNumberOfSlots)
+	{
+		logger->GetInstance().WriteLine("Attempted to remove an instance which isn't in the transform store.");
+		return;
+	}
+
+	mFreeSlots.push_back(index);
+	mNumberOfInstances--;
+}
+
+/* Makes room for this many instances in one go, so adding them one at a time afterwards doesn't keep growing the arrays. */
+void CTransformStore::Reserve(unsigned int numberOfInstances)
+{
+	// Round up to whole batches, as the arrays always hold a multiple of the batch size.
+	const size_t newSize = ((numberOfInstances + kBatchSize - 1) / kBatchSize) * kBatchSize;
+
+	mPositionX.reserve(newSize);
+	mPositionY.reserve(newSize);
+	mPositionZ.reserve(newSize);
+	mSinX.reserve(newSize);
+	mCosX.reserve(newSize);
+	mSinY.reserve(newSize);
+	mCosY.reserve(newSize);
+	mSinZ.reserve(newSize);
+	mCosZ.reserve(newSize);
+	mScaleX.reserve(newSize);
+	mScaleY.reserve(newSize);
+	mScaleZ.reserve(newSize);
+	mWorldMatrices.reserve(newSize);
+	mDirtyBatches.reserve(newSize / kBatchSize);
+}
+
+/* Stores a new transform for an instance, its world matrix will be rebuilt on the next update.
+* @PARAM D3DXVECTOR3 rotation - The rotation in degrees around each axis.
+*/
+void CTransformStore::SetTransform(unsigned int index, D3DXVECTOR3 position, D3DXVECTOR3 rotation, D3DXVECTOR3 scale)
+{
+	const float kToRadians = PrioEngine::kPi / 180.0f;
+
+	mPositionX[index] = position.x;
+	mPositionY[index] = position.y;
+	mPositionZ[index] = position.z;
+
+	mSinX[index] = sinf(rotation.x * kToRadians);
+	mCosX[index] = cosf(rotation.x * kToRadians);
+	mSinY[index] = sinf(rotation.y * kToRadians);
+	mCosY[index] = cosf(rotation.y * kToRadians);
+	mSinZ[index] = sinf(rotation.z * kToRadians);
+	mCosZ[index] = cosf(rotation.z * kToRadians);
+
+	mScaleX[index] = scale.x;
+	mScaleY[index] = scale.y;
+	mScaleZ[index] = scale.z;
+
+	mDirtyBatches[index / kBatchSize] = true;
+}
+
+/* Rebuilds the world matrix of every instance which has changed since the last update. */
+void CTransformStore::Update()
+{
+	mInstancesUpdated = 0;
+
+	const unsigned int numberOfBatches = static_cast<unsigned int>(mDirtyBatches.size());
+
+	for (unsigned int batch = 0; batch < numberOfBatches; batch++)
+	{
+		if (!mDirtyBatches[batch])
+		{
+			continue;
+		}
+
+		ComposeBatch(batch * kBatchSize);
+		mDirtyBatches[batch] = false;
+		mInstancesUpdated += kBatchSize;
+	}
+
+	mTotalInstancesUpdated += mInstancesUpdated;
+}
+
+/* Makes room for another batch of instances. */
+void CTransformStore::Grow()
+{
+	const size_t newSize = mWorldMatrices.size() + kBatchSize;
+
+	// Free slots hold a plain identity transform, so the kernel can run over them without producing garbage.
+	mPositionX.resize(newSize, 0.0f);
+	mPositionY.resize(newSize, 0.0f);
+	mPositionZ.resize(newSize, 0.0f);
+	mSinX.resize(newSize, 0.0f);
+	mCosX.resize(newSize, 1.0f);
+	mSinY.resize(newSize, 0.0f);
+	mCosY.resize(newSize, 1.0f);
+	mSinZ.resize(newSize, 0.0f);
+	mCosZ.resize(newSize, 1.0f);
+	mScaleX.resize(newSize, 1.0f);
+	mScaleY.resize(newSize, 1.0f);
+	mScaleZ.resize(newSize, 1.0f);
+
+	D3DXMATRIX identity;
+	D3DXMatrixIdentity(&identity);
+	mWorldMatrices.resize(newSize, identity);
+
+	mDirtyBatches.resize(newSize / kBatchSize, false);
+}
+
+/* Builds scale * rotationX * rotationY * rotationZ * translation for four instances at once.
+* Each lane of the SSE registers holds one instance, the rows are transposed back into matrices at the end.
+*/
+void CTransformStore::ComposeBatch(unsigned int firstIndex)
+{
+	const __m128 sinX = _mm_loadu_ps(&mSinX[firstIndex]);
+	const __m128 cosX = _mm_loadu_ps(&mCosX[firstIndex]);
+	const __m128 sinY = _mm_loadu_ps(&mSinY[firstIndex]);
+	const __m128 cosY = _mm_loadu_ps(&mCosY[firstIndex]);
+	const __m128 sinZ = _mm_loadu_ps(&mSinZ[firstIndex]);
+	const __m128 cosZ = _mm_loadu_ps(&mCosZ[firstIndex]);
+	const __m128 scaleX = _mm_loadu_ps(&mScaleX[firstIndex]);
+	const __m128 scaleY = _mm_loadu_ps(&mScaleY[firstIndex]);
+	const __m128 scaleZ = _mm_loadu_ps(&mScaleZ[firstIndex]);
+	const __m128 zero = _mm_setzero_ps();
+
+	const __m128 sinXsinY = _mm_mul_ps(sinX, sinY);
+	const __m128 cosXsinY = _mm_mul_ps(cosX, sinY);
+
+	// Row 0: [cy.cz, cy.sz, -sy] * scale x
+	__m128 row0x = _mm_mul_ps(_mm_mul_ps(cosY, cosZ), scaleX);
+	__m128 row0y = _mm_mul_ps(_mm_mul_ps(cosY, sinZ), scaleX);
+	__m128 row0z = _mm_mul_ps(_mm_sub_ps(zero, sinY), scaleX);
+	__m128 row0w = zero;
+
+	// Row 1: [sx.sy.cz - cx.sz, sx.sy.sz + cx.cz, sx.cy] * scale y
+	__m128 row1x = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(sinXsinY, cosZ), _mm_mul_ps(cosX, sinZ)), scaleY);
+	__m128 row1y = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(sinXsinY, sinZ), _mm_mul_ps(cosX, cosZ)), scaleY);
+	__m128 row1z = _mm_mul_ps(_mm_mul_ps(sinX, cosY), scaleY);
+	__m128 row1w = zero;
+
+	// Row 2: [cx.sy.cz + sx.sz, cx.sy.sz - sx.cz, cx.cy] * scale z
+	__m128 row2x = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(cosXsinY, cosZ), _mm_mul_ps(sinX, sinZ)), scaleZ);
+	__m128 row2y = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(cosXsinY, sinZ), _mm_mul_ps(sinX, cosZ)), scaleZ);
+	__m128 row2z = _mm_mul_ps(_mm_mul_ps(cosX, cosY), scaleZ);
+	__m128 row2w = zero;
+
+	// Row 3: the translation.
+	__m128 row3x = _mm_loadu_ps(&mPositionX[firstIndex]);
+	__m128 row3y = _mm_loadu_ps(&mPositionY[firstIndex]);
+	__m128 row3z = _mm_loadu_ps(&mPositionZ[firstIndex]);
+	__m128 row3w = _mm_set1_ps(1.0f);
+
+	// Turn each set of four components into four rows, one for each instance.
+	_MM_TRANSPOSE4_PS(row0x, row0y, row0z, row0w);
+	_MM_TRANSPOSE4_PS(row1x, row1y, row1z, row1w);
+	_MM_TRANSPOSE4_PS(row2x, row2y, row2z, row2w);
+	_MM_TRANSPOSE4_PS(row3x, row3y, row3z, row3w);
+
+	const __m128 row0[kBatchSize] = { row0x, row0y, row0z, row0w };
+	const __m128 row1[kBatchSize] = { row1x, row1y, row1z, row1w };
+	const __m128 row2[kBatchSize] = { row2x, row2y, row2z, row2w };
+	const __m128 row3[kBatchSize] = { row3x, row3y, row3z, row3w };
+
+	for (unsigned int lane = 0; lane < kBatchSize; lane++)
+	{
+		D3DXMATRIX& world = mWorldMatrices[firstIndex + lane];
+		_mm_storeu_ps(world.m[0], row0[lane]);
+		_mm_storeu_ps(world.m[1], row1[lane]);
+		_mm_storeu_ps(world.m[2], row2[lane]);
+		_mm_storeu_ps(world.m[3], row3[lane]);
+	}
+}
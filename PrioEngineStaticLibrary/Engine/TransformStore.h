@@ -0,0 +1,62 @@
+#ifndef TRANSFORMSTORE_H
+#define TRANSFORMSTORE_H
+
+#include <D3DX10math.h>
+#include <vector>
+#include "PrioEngineVars.h"
+
+/* Holds the position, rotation and scale of many instances as separate arrays (structure of arrays).
+* Only instances which have been marked dirty have their world matrix rebuilt, and they are rebuilt four at a time with SSE.
+*/
+class CTransformStore
+{
+private:
+	CLogger* logger;
+public:
+	CTransformStore();
+	~CTransformStore();
+public:
+	unsigned int Add();
+	void Remove(unsigned int index);
+	void Reserve(unsigned int numberOfInstances);
+	void SetTransform(unsigned int index, D3DXVECTOR3 position, D3DXVECTOR3 rotation, D3DXVECTOR3 scale);
+	void Update();
+
+	const D3DXMATRIX& GetWorldMatrix(unsigned int index) { return mWorldMatrices[index]; };
+	unsigned int GetNumberOfInstances() { return mNumberOfInstances; };
+	unsigned int GetInstancesUpdated() { return mInstancesUpdated; };
+	unsigned int GetTotalInstancesUpdated() { return mTotalInstancesUpdated; };
+private:
+	// Instances are composed in groups of this many, the arrays are always a multiple of it long.
+	static const unsigned int kBatchSize = 4;
+
+	void Grow();
+	void ComposeBatch(unsigned int firstIndex);
+
+	// Sines and cosines are worked out when the rotation is set, so the batch kernel is only multiplies.
+	std::vector<float> mPositionX;
+	std::vector<float> mPositionY;
+	std::vector<float> mPositionZ;
+	std::vector<float> mSinX;
+	std::vector<float> mCosX;
+	std::vector<float> mSinY;
+	std::vector<float> mCosY;
+	std::vector<float> mSinZ;
+	std::vector<float> mCosZ;
+	std::vector<float> mScaleX;
+	std::vector<float> mScaleY;
+	std::vector<float> mScaleZ;
+
+	std::vector<D3DXMATRIX> mWorldMatrices;
+
+	// One flag per group of instances, set when any instance in the group has changed.
+	std::vector<bool> mDirtyBatches;
+	std::vector<unsigned int> mFreeSlots;
+
+	unsigned int mNumberOfInstances;
+	unsigned int mNumberOfSlots;
+	unsigned int mInstancesUpdated;
+	unsigned int mTotalInstancesUpdated;
+};
+
+#endif
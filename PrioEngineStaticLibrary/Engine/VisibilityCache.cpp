@@ -0,0 +1,185 @@
+#include "VisibilityCache.h"
+
+CVisibilityCache::CVisibilityCache()
+{
+	D3DXMatrixIdentity(&mViewMatrix);
+	D3DXMatrixIdentity(&mProjMatrix);
+	mViewPosition = D3DXVECTOR3(0.0f, 0.0f, 0.0f);
+	mViewTravel = 0.0;
+	mViewTurn = 0.0;
+	mFrameNumber = 0;
+	mEnabled = false;
+
+	mHits = 0;
+	mMisses = 0;
+	mTotalHits = 0;
+	mTotalMisses = 0;
+}
+
+CVisibilityCache::~CVisibilityCache()
+{
+	mEntries.clear();
+}
+
+/* Prepares the cache for a new frame, must be called once the view and projection for this pass are known.
+* @PARAM D3DXMATRIX viewMatrix - The view matrix the frustum for this pass was built from.
+* @PARAM D3DXMATRIX projMatrix - The projection matrix the frustum for this pass was built from.
+*/
+void CVisibilityCache::BeginFrame(D3DXMATRIX viewMatrix, D3DXMATRIX projMatrix)
+{
+	mFrameNumber++;
+	mHits = 0;
+	mMisses = 0;
+
+	// A change in the projection moves every plane, nothing we have stored can be trusted.
+	if (projMatrix != mProjMatrix)
+	{
+		Invalidate();
+		mProjMatrix = projMatrix;
+	}
+
+	// The view position sits in the translation row of the inverse view matrix.
+	D3DXMATRIX inverseView;
+	D3DXMatrixInverse(&inverseView, NULL, &viewMatrix);
+	D3DXVECTOR3 viewPosition = D3DXVECTOR3(inverseView._41, inverseView._42, inverseView._43);
+
+	D3DXVECTOR3 viewMovement = viewPosition - mViewPosition;
+	mViewTravel += D3DXVec3Length(&viewMovement);
+	mViewTurn += GetRotationDifference(viewMatrix, mViewMatrix);
+
+	mViewMatrix = viewMatrix;
+	mViewPosition = viewPosition;
+
+	// Every so often, clear out anything which hasn't been looked at in a while.
+	if (mFrameNumber % kEntryLifetime == 0)
+	{
+		auto it = mEntries.begin();
+		while (it != mEntries.end())
+		{
+			if (mFrameNumber - it->second.lastUsedFrame > kEntryLifetime)
+			{
+				it = mEntries.erase(it);
+			}
+			else
+			{
+				it++;
+			}
+		}
+	}
+}
+
+/* Tests a sphere against the frustum, reusing an earlier result when the view can't have moved enough to change it.
+* @PARAM CFrustum* frustum - The frustum for this pass, must have been built from the matrices passed to BeginFrame.
+* @PARAM const void* key - Something which identifies the object, usually a pointer to the model.
+* @Returns bool - True if the sphere may be visible.
+*/
+bool CVisibilityCache::CheckSphere(CFrustum* frustum, const void* key, D3DXVECTOR3 position, float radius)
+{
+	if (!mEnabled)
+	{
+		return frustum->CheckSphere(position, radius);
+	}
+
+	auto it = mEntries.find(key);
+
+	if (it != mEntries.end())
+	{
+		CacheEntryType& entry = it->second;
+
+		// Only reuse the result if the object itself hasn't changed.
+		if (entry.position == position && entry.radius == radius)
+		{
+			// The most any plane could have moved relative to the object since the result was stored. The view may have travelled away before
+			// turning, so the turn sweeps the object through an arc as large as its distance now, not just its distance when it was tested.
+			const float travel = static_cast<float>(mViewTravel - entry.viewTravel);
+			const float turn = static_cast<float>(mViewTurn - entry.viewTurn);
+			float movement = travel + (entry.distance + travel) * turn;
+
+			if (movement < entry.slack)
+			{
+				entry.lastUsedFrame = mFrameNumber;
+				mHits++;
+				mTotalHits++;
+				return entry.visible;
+			}
+		}
+	}
+
+	mMisses++;
+	mTotalMisses++;
+
+	// Do the full test and record how close it was to changing.
+	float margin = frustum->GetSphereMargin(position, radius);
+	D3DXVECTOR3 toObject = position - mViewPosition;
+
+	CacheEntryType entry;
+	entry.position = position;
+	entry.radius = radius;
+	entry.visible = margin > 0.0f;
+	entry.slack = fabsf(margin);
+	entry.distance = D3DXVec3Length(&toObject);
+	entry.viewTravel = mViewTravel;
+	entry.viewTurn = mViewTurn;
+	entry.lastUsedFrame = mFrameNumber;
+
+	mEntries[key] = entry;
+
+	return entry.visible;
+}
+
+/* Throws away every stored result. */
+void CVisibilityCache::Invalidate()
+{
+	mEntries.clear();
+
+	// Nothing refers to the totals any more, so start them again before they lose precision.
+	mViewTravel = 0.0;
+	mViewTurn = 0.0;
+}
+
+/* Throws away the stored result for one object. */
+void CVisibilityCache::Remove(const void* key)
+{
+	mEntries.erase(key);
+}
+
+/* Finds an upper bound on how far any direction can have been turned between two views.
+* @Returns float - The difference between the rotation parts of the two matrices (Frobenius norm).
+*/
+float CVisibilityCache::GetRotationDifference(const D3DXMATRIX& first, const D3DXMATRIX& second)
+{
+	float total = 0.0f;
+
+	for (int row = 0; row < 3; row++)
+	{
+		for (int column = 0; column < 3; column++)
+		{
+			float difference = first.m[row][column] - second.m[row][column];
+			total += difference * difference;
+		}
+	}
+
+	return sqrtf(total);
+}
+
+/* The share of tests this frame which were answered from the cache. */
+float CVisibilityCache::GetHitRate()
+{
+	if (mHits + mMisses == 0)
+	{
+		return 0.0f;
+	}
+
+	return static_cast<float>(mHits) / static_cast<float>(mHits + mMisses);
+}
+
+/* The share of all tests since the cache was created which were answered from the cache. */
+float CVisibilityCache::GetTotalHitRate()
+{
+	if (mTotalHits + mTotalMisses == 0)
+	{
+		return 0.0f;
+	}
+
+	return static_cast<float>(mTotalHits) / static_cast<float>(mTotalHits + mTotalMisses);
+}
@@ -0,0 +1,76 @@
+#ifndef VISIBILITYCACHE_H
+#define VISIBILITYCACHE_H
+
+#include <D3DX10math.h>
+#include <unordered_map>
+#include "PrioEngineVars.h"
+#include "Frustum.h"
+
+/* Reuses frustum test results from earlier frames.
+* Each result is stored along with how far the object was from crossing a frustum plane, and how far the view had travelled and turned in total when it was tested.
+* The result is reused for as long as the view can't have moved far enough since then to use up that slack, so only objects
+* which moved, or sit close to the edges of the frustum, are tested again.
+*
+* A hit still costs a hash lookup, which measured about the same as the six plane test it saves, so the cache is off by default.
+* Turn it on with SetEnabled, or CGraphics::SetVisibilityCacheEnabled, where the frustum test is more expensive than the lookup.
+*/
+class CVisibilityCache
+{
+private:
+	CLogger* logger;
+public:
+	CVisibilityCache();
+	~CVisibilityCache();
+public:
+	void BeginFrame(D3DXMATRIX viewMatrix, D3DXMATRIX projMatrix);
+	bool CheckSphere(CFrustum* frustum, const void* key, D3DXVECTOR3 position, float radius);
+	void Invalidate();
+	void Remove(const void* key);
+private:
+	struct CacheEntryType
+	{
+		D3DXVECTOR3 position;
+		float radius;
+		bool visible;
+		// How far the sphere was from changing result when it was tested.
+		float slack;
+		// Distance from the view position to the sphere when it was tested.
+		float distance;
+		// The travel and turn totals of the view when the result was worked out.
+		double viewTravel;
+		double viewTurn;
+		unsigned int lastUsedFrame;
+	};
+
+	std::unordered_map<const void*, CacheEntryType> mEntries;
+	D3DXMATRIX mViewMatrix;
+	D3DXMATRIX mProjMatrix;
+	D3DXVECTOR3 mViewPosition;
+	// How far the view has moved and turned, summed over every frame. The difference between two frames' totals bounds the movement between them,
+	// so it's worked out once a frame rather than once for every entry.
+	double mViewTravel;
+	double mViewTurn;
+	unsigned int mFrameNumber;
+	bool mEnabled;
+
+	// Entries which have not been used for this many frames will be thrown away.
+	const unsigned int kEntryLifetime = 120;
+
+	float GetRotationDifference(const D3DXMATRIX& first, const D3DXMATRIX& second);
+private:
+	// Counters for the current frame.
+	unsigned int mHits;
+	unsigned int mMisses;
+	// Running totals since the cache was created.
+	unsigned long long mTotalHits;
+	unsigned long long mTotalMisses;
+public:
+	void SetEnabled(bool enabled) { mEnabled = enabled; };
+	bool GetEnabled() { return mEnabled; };
+	unsigned int GetHits() { return mHits; };
+	unsigned int GetMisses() { return mMisses; };
+	float GetHitRate();
+	float GetTotalHitRate();
+};
+
+#endif
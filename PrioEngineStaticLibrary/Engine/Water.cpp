@@ -16,6 +16,8 @@ CWater::CWater()
 	mRefractionStrength = 0.95f;
 	mReflectionStrength = 0.9f;
 	mWaterDepth = 6.0f;
+	mMinPoint = D3DXVECTOR3(0.0f, 0.0f, 0.0f);
+	mMaxPoint = D3DXVECTOR3(0.0f, 0.0f, 0.0f);
 }
 
 
@@ -23,11 +25,14 @@ CWater::~CWater()
 {
 }
 
-bool CWater::Initialise(ID3D11Device* device, D3DXVECTOR3 minPoint, D3DXVECTOR3 maxPoint, unsigned int subDivisionX, unsigned int subDivisionZ, std::string normalMap, int screenWidth, int screenHeight)
+bool CWater::Initialise(ID3D11Device* device, D3DXVECTOR3 minPoint, D3DXVECTOR3 maxPoint, unsigned int subDivisionX, unsigned int subDivisionZ, std::string normalMap)
 {
 	// Release the existing data.
 	Shutdown();
 
+	mMinPoint = minPoint;
+	mMaxPoint = maxPoint;
+
 	if (!InitialiseBuffers(device, minPoint, maxPoint, subDivisionX, subDivisionZ))
 	{
 		logger->GetInstance().WriteLine("Failed to initialise the buffers of the body of water.");
@@ -35,45 +40,12 @@ bool CWater::Initialise(ID3D11Device* device, D3DXVECTOR3 minPoint, D3DXVECTOR3
 	}
 
 	mpNormalMap = new CTexture();
-	if (!mpNormalMap->Initialise(device, "Resources/Textures/WaterNormalHeight.png"))
+	if (!mpNormalMap->Initialise(device, "Resources/Textures/WaterNormalHeight.png", CGpuMemoryTracker::Terrain))
 	{
 		logger->GetInstance().WriteLine("Failed to load the normal map for water. Filename was: " + normalMap);
 		return false;
 	}
 
-	///////////////////////////
-	// Refraction render target
-	//////////////////////////
-
-	mpRefractionRenderTexture = new CRenderTexture();
-	if (!mpRefractionRenderTexture->Initialise(device, screenWidth, screenHeight, DXGI_FORMAT_R8G8B8A8_UNORM))
-	{
-		logger->GetInstance().WriteLine("Failed to initialise the refraction render texture.");
-		return false;
-	}
-
-	///////////////////////////
-	// Reflection render target
-	///////////////////////////
-
-	mpReflectionRenderTexture = new CRenderTexture();
-	if (!mpReflectionRenderTexture->Initialise(device, screenWidth, screenHeight, DXGI_FORMAT_R8G8B8A8_UNORM))
-	{
-		logger->GetInstance().WriteLine("Failed to initialise the reflection render texture.");
-		return false;
-	}
-
-	///////////////////////////
-	// Height map render target
-	///////////////////////////
-
-	mpHeightRenderTexture = new CRenderTexture();
-	if (!mpHeightRenderTexture->Initialise(device, screenWidth, screenHeight, DXGI_FORMAT_R32_FLOAT))
-	{
-		logger->GetInstance().WriteLine("Failed to initialise the height render texture.");
-		return false;
-	}
-
 	logger->GetInstance().WriteLine("Successfully loaded the texture for the water model.");
 
 	return true;
@@ -81,27 +53,6 @@ bool CWater::Initialise(ID3D11Device* device, D3DXVECTOR3 minPoint, D3DXVECTOR3
 
 void CWater::Shutdown()
 {
-	if (mpHeightRenderTexture)
-	{
-		mpHeightRenderTexture->Shutdown();
-		delete mpHeightRenderTexture;
-		mpHeightRenderTexture = nullptr;
-	}
-
-	if (mpRefractionRenderTexture)
-	{
-		mpRefractionRenderTexture->Shutdown();
-		delete mpRefractionRenderTexture;
-		mpRefractionRenderTexture = nullptr;
-	}
-
-	if (mpReflectionRenderTexture)
-	{
-		mpReflectionRenderTexture->Shutdown();
-		delete mpReflectionRenderTexture;
-		mpReflectionRenderTexture = nullptr;
-	}
-
 	if (mpNormalMap)
 	{
 		mpNormalMap->Shutdown();
@@ -111,12 +62,14 @@ void CWater::Shutdown()
 
 	if (mpIndexBuffer)
 	{
+		CGpuMemoryTracker::GetInstance().Unregister(mpIndexBuffer);
 		mpIndexBuffer->Release();
 		mpIndexBuffer = nullptr;
 	}
 
 	if (mpVertexBuffer)
 	{
+		CGpuMemoryTracker::GetInstance().Unregister(mpVertexBuffer);
 		mpVertexBuffer->Release();
 		mpVertexBuffer = nullptr;
 	}
@@ -207,6 +160,7 @@ bool CWater::InitialiseBuffers(ID3D11Device * device, D3DXVECTOR3 minPoint, D3DX
 	{
 		return false;
 	}
+	CGpuMemoryTracker::GetInstance().Register(mpVertexBuffer, CGpuMemoryTracker::Terrain, bufferDesc.ByteWidth);
 	
 	bufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
 	bufferDesc.Usage = D3D11_USAGE_DEFAULT;
@@ -218,6 +172,7 @@ bool CWater::InitialiseBuffers(ID3D11Device * device, D3DXVECTOR3 minPoint, D3DX
 	{
 		return false;
 	}
+	CGpuMemoryTracker::GetInstance().Register(mpIndexBuffer, CGpuMemoryTracker::Terrain, bufferDesc.ByteWidth);
 
 	return true;
 }
@@ -232,34 +187,16 @@ CTexture * CWater::GetNormalMap()
 	return mpNormalMap;
 }
 
-CRenderTexture * CWater::GetRefractionTexture()
+/* Gets a world space box which contains the water surface, including the height of the waves. */
+void CWater::GetBoundingBox(D3DXVECTOR3& minPoint, D3DXVECTOR3& maxPoint)
 {
-	return mpRefractionRenderTexture;
-}
+	D3DXVECTOR3 position = GetPos();
 
-CRenderTexture * CWater::GetReflectionTexture()
-{
-	return mpReflectionRenderTexture;
-}
+	minPoint = mMinPoint + position;
+	maxPoint = mMaxPoint + position;
 
-CRenderTexture * CWater::GetHeightTexture()
-{
-	return mpHeightRenderTexture;
-}
-
-void CWater::SetRefractionRenderTarget(ID3D11DeviceContext * deviceContext, ID3D11DepthStencilView * depthStencilView)
-{
-	mpRefractionRenderTexture->SetRenderTarget(deviceContext, depthStencilView);
-}
-
-void CWater::SetReflectionRenderTarget(ID3D11DeviceContext * deviceContext, ID3D11DepthStencilView * depthStencilView)
-{
-	mpReflectionRenderTexture->SetRenderTarget(deviceContext, depthStencilView);
-}
-
-void CWater::SetHeightMapRenderTarget(ID3D11DeviceContext * deviceContext, ID3D11DepthStencilView * depthStencilView)
-{
-	mpHeightRenderTexture->SetRenderTarget(deviceContext, depthStencilView);
+	minPoint.y -= mWaveHeight;
+	maxPoint.y += mWaveHeight;
 }
 
 void CWater::RenderBuffers(ID3D11DeviceContext* deviceContext)
@@ -102,7 +102,7 @@ bool CWaterShader::InitialiseShader(ID3D11Device* device, HWND hwnd, std::string
 	////////////////////////////////
 
 	// Compile the vertex shader code.
-	result = D3DX11CompileFromFile(surfaceVSFilename.c_str(), NULL, NULL, "WaterSurfaceVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), 0, NULL, &vertexShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(surfaceVSFilename, "WaterSurfaceVS", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), &vertexShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -119,7 +119,7 @@ bool CWaterShader::InitialiseShader(ID3D11Device* device, HWND hwnd, std::string
 	}
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(surfacePsFilename.c_str(), NULL, NULL, "WaterSurfacePS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(surfacePsFilename, "WaterSurfacePS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
@@ -159,7 +159,7 @@ bool CWaterShader::InitialiseShader(ID3D11Device* device, HWND hwnd, std::string
 	pixelShaderBuffer = nullptr;
 
 	// Compile the pixel shader code.
-	result = D3DX11CompileFromFile(heightPsFilename.c_str(), NULL, NULL, "WaterHeightPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), 0, NULL, &pixelShaderBuffer, &errorMessage, NULL);
+	result = CompileShaderFromFile(heightPsFilename, "WaterHeightPS", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS || (1 << 0), &pixelShaderBuffer, &errorMessage);
 	if (FAILED(result))
 	{
 		if (errorMessage)
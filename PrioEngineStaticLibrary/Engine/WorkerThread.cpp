@@ -0,0 +1,84 @@
+#include "WorkerThread.h"
+
+CWorkerThread::CWorkerThread()
+{
+	mBusy = false;
+	mStopping = false;
+}
+
+CWorkerThread::~CWorkerThread()
+{
+	Stop();
+}
+
+/* Hands a job to the worker, waiting for the last one to finish first. The thread is started the first time this is called. */
+void CWorkerThread::Run(std::function<void()> job)
+{
+	Wait();
+
+	if (!mThread.joinable())
+	{
+		mStopping = false;
+		mThread = std::thread(&CWorkerThread::Loop, this);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mJob = job;
+		mBusy = true;
+	}
+
+	mJobReady.notify_one();
+}
+
+/* Blocks until the job handed to the worker has finished, returns straight away if there isn't one. */
+void CWorkerThread::Wait()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mJobDone.wait(lock, [this]() { return !mBusy; });
+}
+
+/* Lets any job in progress finish, then ends the thread. The next call to Run starts it again. */
+void CWorkerThread::Stop()
+{
+	if (!mThread.joinable())
+	{
+		return;
+	}
+
+	Wait();
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopping = true;
+	}
+
+	mJobReady.notify_one();
+	mThread.join();
+}
+
+void CWorkerThread::Loop()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	while (true)
+	{
+		mJobReady.wait(lock, [this]() { return mBusy || mStopping; });
+
+		if (mStopping)
+		{
+			return;
+		}
+
+		// Let go of the lock while the job runs, so Wait can be called on the owner's thread.
+		std::function<void()> job;
+		job.swap(mJob);
+		lock.unlock();
+
+		job();
+
+		lock.lock();
+		mBusy = false;
+		mJobDone.notify_all();
+	}
+}
@@ -0,0 +1,35 @@
+#ifndef WORKERTHREAD_H
+#define WORKERTHREAD_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/* One long lived thread which runs a job at a time, sleeping between them.
+* Used for work which is handed off every frame, so the cost of starting and joining a thread isn't paid each time.
+* Run and Wait must only be called from the thread which owns the worker.
+*/
+class CWorkerThread
+{
+public:
+	CWorkerThread();
+	~CWorkerThread();
+public:
+	void Run(std::function<void()> job);
+	void Wait();
+	void Stop();
+private:
+	void Loop();
+
+	std::thread mThread;
+	std::mutex mMutex;
+	// Signalled when a job is handed over or the worker is stopped, and when a job finishes.
+	std::condition_variable mJobReady;
+	std::condition_variable mJobDone;
+	std::function<void()> mJob;
+	bool mBusy;
+	bool mStopping;
+};
+
+#endif
@@ -0,0 +1,227 @@
+﻿#include "CppUnitTest.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include "FrameCapture.h"
+#include "NullRenderDevice.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace PrioEngineTests
+{
+	TEST_CLASS(FrameCaptureTests)
+	{
+	private:
+		const std::string kFilename = "FrameCaptureTests.capture";
+
+		// What the captured frame writes to its constant buffer, and where.
+		const unsigned int kConstantBufferSize = 64;
+		const unsigned int kWrittenStart = 16;
+		const unsigned int kWrittenSize = 16;
+
+		ID3D11Buffer* mVertexBuffer;
+		ID3D11Buffer* mIndexBuffer;
+		ID3D11Buffer* mConstantBuffer;
+
+		static ID3D11Buffer* CreateBuffer(CRenderDevice* device, unsigned int size, unsigned int bindFlags, D3D11_USAGE usage)
+		{
+			D3D11_BUFFER_DESC desc = D3D11_BUFFER_DESC();
+			desc.ByteWidth = size;
+			desc.BindFlags = bindFlags;
+			desc.Usage = usage;
+
+			ID3D11Buffer* buffer = nullptr;
+			Assert::IsTrue(SUCCEEDED(device->CreateBuffer(&desc, NULL, &buffer)));
+			return buffer;
+		}
+
+		// One frame as the mesh pass would submit it: bind the buffers, write the constants, then draw.
+		void CaptureFrame(CFrameCapture& capture)
+		{
+			mVertexBuffer = CreateBuffer(&capture, 1024, D3D11_BIND_VERTEX_BUFFER, D3D11_USAGE_IMMUTABLE);
+			mIndexBuffer = CreateBuffer(&capture, 256, D3D11_BIND_INDEX_BUFFER, D3D11_USAGE_IMMUTABLE);
+			mConstantBuffer = CreateBuffer(&capture, kConstantBufferSize, D3D11_BIND_CONSTANT_BUFFER, D3D11_USAGE_DYNAMIC);
+
+			capture.Start(1);
+			capture.BeginFrame();
+
+			const unsigned int stride = 32;
+			const unsigned int offset = 0;
+			capture.IASetVertexBuffers(0, 1, &mVertexBuffer, &stride, &offset);
+			capture.IASetIndexBuffer(mIndexBuffer, DXGI_FORMAT_R32_UINT, 0);
+			capture.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+			capture.VSSetConstantBuffers(1, 1, &mConstantBuffer);
+
+			D3D11_MAPPED_SUBRESOURCE mappedResource;
+			Assert::IsTrue(SUCCEEDED(capture.Map(mConstantBuffer, 0, D3D11_MAP_WRITE_DISCARD, &mappedResource)));
+			unsigned char* data = static_cast<unsigned char*>(mappedResource.pData);
+			for (unsigned int i = 0; i < kWrittenSize; i++)
+			{
+				data[kWrittenStart + i] = static_cast<unsigned char>(i + 1);
+			}
+			capture.Unmap(mConstantBuffer, 0, kWrittenStart, kWrittenSize);
+
+			capture.DrawIndexedInstanced(36, 4, 6, 0, 2);
+			capture.EndFrame();
+		}
+
+		void ReleaseBuffers(CFrameCapture& capture)
+		{
+			capture.ReleaseResource(mVertexBuffer);
+			capture.ReleaseResource(mIndexBuffer);
+			capture.ReleaseResource(mConstantBuffer);
+		}
+
+		std::vector<unsigned char> ReadFile()
+		{
+			std::ifstream file(kFilename, std::ios::binary);
+			return std::vector<unsigned char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		}
+
+		void WriteFile(const std::vector<unsigned char>& contents)
+		{
+			std::ofstream file(kFilename, std::ios::binary);
+			file.write(reinterpret_cast<const char*>(contents.data()), contents.size());
+		}
+
+		// Captures a frame on a device of its own and saves it, returning the size of the stream at the end of the file.
+		unsigned int SaveCapture()
+		{
+			CNullRenderDevice device;
+			CFrameCapture capture(&device);
+
+			CaptureFrame(capture);
+			Assert::IsTrue(capture.Save(kFilename));
+
+			const unsigned int streamSize = capture.GetStreamSize();
+			ReleaseBuffers(capture);
+			return streamSize;
+		}
+	public:
+		TEST_METHOD_CLEANUP(DeleteFile)
+		{
+			std::remove(kFilename.c_str());
+		}
+
+		TEST_METHOD(SavedFrameReplaysTheSameCalls)
+		{
+			SaveCapture();
+
+			CFrameCapture loaded(nullptr);
+			Assert::IsTrue(loaded.Load(kFilename));
+			Assert::AreEqual(1u, loaded.GetNumberOfFrames());
+
+			CNullRenderDevice replayDevice;
+			replayDevice.SetRecording(true);
+			Assert::IsTrue(loaded.BeginReplay(&replayDevice, false));
+
+			// A new buffer is made for each of the three the frame used.
+			Assert::AreEqual(3u, replayDevice.GetNumberOfResources());
+			replayDevice.ResetCounters();
+
+			Assert::IsTrue(loaded.ReplayFrame(0));
+
+			const std::vector<CNullRenderDevice::CommandType>& commands = replayDevice.GetCommands();
+			Assert::AreEqual(7u, static_cast<unsigned int>(commands.size()));
+
+			Assert::IsTrue(commands[0].id == CNullRenderDevice::SetVertexBuffersCommand);
+			Assert::AreEqual(1u, commands[0].arguments[1]);
+			Assert::AreEqual(32u, commands[0].arguments[2]);
+
+			Assert::IsTrue(commands[1].id == CNullRenderDevice::SetIndexBufferCommand);
+			Assert::AreEqual(static_cast<unsigned int>(DXGI_FORMAT_R32_UINT), commands[1].arguments[0]);
+
+			Assert::IsTrue(commands[2].id == CNullRenderDevice::SetTopologyCommand);
+			Assert::AreEqual(static_cast<unsigned int>(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST), commands[2].arguments[0]);
+
+			Assert::IsTrue(commands[3].id == CNullRenderDevice::SetVertexConstantBuffersCommand);
+			Assert::AreEqual(1u, commands[3].arguments[0]);
+
+			// The constants written are put back into the replay's own buffer, only the range which was written.
+			Assert::IsTrue(commands[4].id == CNullRenderDevice::MapCommand);
+			Assert::IsTrue(commands[4].object == commands[3].object);
+			Assert::IsTrue(commands[5].id == CNullRenderDevice::UnmapCommand);
+			Assert::AreEqual(kWrittenStart, commands[5].arguments[1]);
+			Assert::AreEqual(kWrittenSize, commands[5].arguments[2]);
+
+			const unsigned char* constants = static_cast<const unsigned char*>(commands[3].object);
+			for (unsigned int i = 0; i < kWrittenSize; i++)
+			{
+				Assert::AreEqual(static_cast<unsigned int>(i + 1), static_cast<unsigned int>(constants[kWrittenStart + i]));
+			}
+
+			Assert::IsTrue(commands[6].id == CNullRenderDevice::DrawIndexedInstancedCommand);
+			Assert::AreEqual(36u, commands[6].arguments[0]);
+			Assert::AreEqual(4u, commands[6].arguments[1]);
+			Assert::AreEqual(6u, commands[6].arguments[2]);
+			Assert::AreEqual(2u, commands[6].arguments[4]);
+
+			loaded.EndReplay();
+			Assert::AreEqual(0u, replayDevice.GetNumberOfResources());
+		}
+
+		TEST_METHOD(TruncatedFileIsRejected)
+		{
+			SaveCapture();
+
+			std::vector<unsigned char> file = ReadFile();
+			file.resize(file.size() - 3);
+			WriteFile(file);
+
+			CFrameCapture loaded(nullptr);
+			Assert::IsFalse(loaded.Load(kFilename));
+			Assert::AreEqual(0u, loaded.GetNumberOfFrames());
+			Assert::AreEqual(0u, loaded.GetStreamSize());
+
+			// Cut off in the middle of the header as well.
+			file.resize(10);
+			WriteFile(file);
+			Assert::IsFalse(loaded.Load(kFilename));
+		}
+
+		TEST_METHOD(FileOfAnotherKindIsRejected)
+		{
+			SaveCapture();
+
+			std::vector<unsigned char> file = ReadFile();
+			file[0] ^= 0xFF;
+			WriteFile(file);
+
+			CFrameCapture loaded(nullptr);
+			Assert::IsFalse(loaded.Load(kFilename));
+			Assert::AreEqual(0u, loaded.GetNumberOfFrames());
+		}
+
+		TEST_METHOD(DamagedStreamStopsTheReplay)
+		{
+			const unsigned int streamSize = SaveCapture();
+
+			// The header is intact, but the first op of the frame is one which doesn't exist.
+			std::vector<unsigned char> file = ReadFile();
+			file[file.size() - streamSize] = 0xEE;
+			WriteFile(file);
+
+			CFrameCapture loaded(nullptr);
+			Assert::IsTrue(loaded.Load(kFilename));
+
+			CNullRenderDevice replayDevice;
+			Assert::IsTrue(loaded.BeginReplay(&replayDevice, false));
+			replayDevice.ResetCounters();
+
+			Assert::IsFalse(loaded.ReplayFrame(0));
+			Assert::AreEqual(0u, replayDevice.GetNumberOfDrawCalls());
+
+			loaded.EndReplay();
+		}
+
+		TEST_METHOD(ReplayNeedsBeginReplay)
+		{
+			SaveCapture();
+
+			CFrameCapture loaded(nullptr);
+			Assert::IsTrue(loaded.Load(kFilename));
+			Assert::IsFalse(loaded.ReplayFrame(0));
+		}
+	};
+}
@@ -0,0 +1,228 @@
+#include "CppUnitTest.h"
+#include <vector>
+#include "FrameGraph.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace PrioEngineTests
+{
+	TEST_CLASS(FrameGraphTests)
+	{
+	private:
+		// DXGI_FORMAT_R8G8B8A8_UNORM and DXGI_FORMAT_R16G16B16A16_FLOAT, the graph only compares them.
+		const unsigned int kColourFormat = 28;
+		const unsigned int kHdrFormat = 10;
+
+		CFrameGraph mGraph;
+		std::vector<std::string> mExecuted;
+
+		// A pass which notes down that it ran.
+		CFrameGraph::PassId AddPass(const std::string& name)
+		{
+			return mGraph.AddPass(name, [this, name]() { mExecuted.push_back(name); return true; });
+		}
+	public:
+		TEST_METHOD(UnreadTransientWriteIsCulled)
+		{
+			const CFrameGraph::ResourceId backBuffer = mGraph.ImportResource("Back buffer");
+			const CFrameGraph::ResourceId shadowMap = mGraph.CreateResource("Shadow map", { 1024, 1024, kHdrFormat });
+
+			const CFrameGraph::PassId shadows = AddPass("Shadows");
+			mGraph.Write(shadows, shadowMap);
+
+			const CFrameGraph::PassId main = AddPass("Main");
+			mGraph.Write(main, backBuffer);
+
+			Assert::IsTrue(mGraph.Execute());
+
+			Assert::IsTrue(mGraph.IsPassCulled(shadows));
+			Assert::IsFalse(mGraph.IsPassCulled(main));
+			Assert::AreEqual(1u, mGraph.GetNumberOfCulledPasses());
+			Assert::AreEqual(1u, static_cast<unsigned int>(mExecuted.size()));
+			Assert::AreEqual(std::string("Main"), mExecuted[0]);
+
+			// Nothing kept uses the shadow map, so it never needs memory.
+			Assert::AreEqual(CFrameGraph::kNone, mGraph.GetFirstUse(shadowMap));
+			Assert::AreEqual(CFrameGraph::kNone, mGraph.GetAliasSlot(shadowMap));
+		}
+
+		TEST_METHOD(SideEffectsKeepAPass)
+		{
+			const CFrameGraph::ResourceId readback = mGraph.CreateResource("Readback", { 1, 1, kColourFormat });
+
+			const CFrameGraph::PassId query = AddPass("Query");
+			mGraph.Write(query, readback);
+			mGraph.SetSideEffects(query);
+
+			Assert::IsTrue(mGraph.Compile());
+
+			Assert::IsFalse(mGraph.IsPassCulled(query));
+			Assert::AreEqual(0u, mGraph.GetNumberOfCulledPasses());
+		}
+
+		TEST_METHOD(ImportedWriteKeepsItsProducers)
+		{
+			const CFrameGraph::ResourceId backBuffer = mGraph.ImportResource("Back buffer");
+			const CFrameGraph::ResourceId albedo = mGraph.CreateResource("Albedo", { 1280, 720, kColourFormat });
+			const CFrameGraph::ResourceId hdr = mGraph.CreateResource("HDR", { 1280, 720, kHdrFormat });
+			const CFrameGraph::ResourceId unused = mGraph.CreateResource("Unused", { 1280, 720, kHdrFormat });
+
+			const CFrameGraph::PassId geometry = AddPass("Geometry");
+			mGraph.Write(geometry, albedo);
+
+			const CFrameGraph::PassId debug = AddPass("Debug");
+			mGraph.Read(debug, albedo);
+			mGraph.Write(debug, unused);
+
+			const CFrameGraph::PassId lighting = AddPass("Lighting");
+			mGraph.Read(lighting, albedo);
+			mGraph.Write(lighting, hdr);
+
+			const CFrameGraph::PassId tonemap = AddPass("Tonemap");
+			mGraph.Read(tonemap, hdr);
+			mGraph.Write(tonemap, backBuffer);
+
+			Assert::IsTrue(mGraph.Execute());
+
+			// Only the back buffer is imported, everything it depends on is kept through the chain of transients.
+			Assert::IsFalse(mGraph.IsPassCulled(geometry));
+			Assert::IsFalse(mGraph.IsPassCulled(lighting));
+			Assert::IsFalse(mGraph.IsPassCulled(tonemap));
+			Assert::IsTrue(mGraph.IsPassCulled(debug));
+
+			Assert::AreEqual(3u, static_cast<unsigned int>(mExecuted.size()));
+			Assert::AreEqual(std::string("Geometry"), mExecuted[0]);
+			Assert::AreEqual(std::string("Lighting"), mExecuted[1]);
+			Assert::AreEqual(std::string("Tonemap"), mExecuted[2]);
+		}
+
+		TEST_METHOD(TransientReadBeforeWriteRunsAfterEveryWriter)
+		{
+			const CFrameGraph::ResourceId backBuffer = mGraph.ImportResource("Back buffer");
+			const CFrameGraph::ResourceId bloom = mGraph.CreateResource("Bloom", { 640, 360, kHdrFormat });
+
+			// Added first, but reads what the two passes added after it write.
+			const CFrameGraph::PassId composite = AddPass("Composite");
+			mGraph.Read(composite, bloom);
+			mGraph.Write(composite, backBuffer);
+
+			const CFrameGraph::PassId bright = AddPass("Bright");
+			mGraph.Write(bright, bloom);
+
+			const CFrameGraph::PassId blur = AddPass("Blur");
+			mGraph.Read(blur, bloom);
+			mGraph.Write(blur, bloom);
+
+			Assert::IsTrue(mGraph.Compile());
+
+			Assert::AreEqual(0u, mGraph.GetNumberOfCulledPasses());
+
+			const std::vector<CFrameGraph::PassId>& order = mGraph.GetExecutionOrder();
+			Assert::AreEqual(3u, static_cast<unsigned int>(order.size()));
+			Assert::AreEqual(bright, order[0]);
+			Assert::AreEqual(blur, order[1]);
+			Assert::AreEqual(composite, order[2]);
+		}
+
+		TEST_METHOD(TransientReadWithNoWriterFails)
+		{
+			const CFrameGraph::ResourceId backBuffer = mGraph.ImportResource("Back buffer");
+			const CFrameGraph::ResourceId bloom = mGraph.CreateResource("Bloom", { 640, 360, kHdrFormat });
+
+			const CFrameGraph::PassId composite = AddPass("Composite");
+			mGraph.Read(composite, bloom);
+			mGraph.Write(composite, backBuffer);
+
+			Assert::IsFalse(mGraph.Compile());
+			Assert::IsFalse(mGraph.Execute());
+			Assert::IsTrue(mExecuted.empty());
+		}
+
+		TEST_METHOD(CycleFails)
+		{
+			const CFrameGraph::ResourceId backBuffer = mGraph.ImportResource("Back buffer");
+			const CFrameGraph::ResourceId first = mGraph.CreateResource("First", { 256, 256, kColourFormat });
+			const CFrameGraph::ResourceId second = mGraph.CreateResource("Second", { 256, 256, kColourFormat });
+
+			// A reads what B writes later, and B reads what A writes, so neither can go first.
+			const CFrameGraph::PassId a = AddPass("A");
+			mGraph.Read(a, first);
+			mGraph.Write(a, second);
+
+			const CFrameGraph::PassId b = AddPass("B");
+			mGraph.Read(b, second);
+			mGraph.Write(b, first);
+			mGraph.Write(b, backBuffer);
+
+			Assert::IsFalse(mGraph.Compile());
+			Assert::IsTrue(mGraph.GetExecutionOrder().empty());
+			Assert::IsFalse(mGraph.Execute());
+			Assert::IsTrue(mExecuted.empty());
+		}
+
+		TEST_METHOD(TransientsWhichDontOverlapShareASlot)
+		{
+			const CFrameGraph::ResourceId backBuffer = mGraph.ImportResource("Back buffer");
+			const CFrameGraph::ResourceId first = mGraph.CreateResource("First", { 512, 512, kColourFormat });
+			const CFrameGraph::ResourceId second = mGraph.CreateResource("Second", { 512, 512, kColourFormat });
+			const CFrameGraph::ResourceId third = mGraph.CreateResource("Third", { 512, 512, kColourFormat });
+
+			// A ping-pong chain: first is in use at 0 and 1, second at 1 and 2, third at 2 and 3.
+			const CFrameGraph::PassId a = AddPass("A");
+			mGraph.Write(a, first);
+
+			const CFrameGraph::PassId b = AddPass("B");
+			mGraph.Read(b, first);
+			mGraph.Write(b, second);
+
+			const CFrameGraph::PassId c = AddPass("C");
+			mGraph.Read(c, second);
+			mGraph.Write(c, third);
+
+			const CFrameGraph::PassId d = AddPass("D");
+			mGraph.Read(d, third);
+			mGraph.Write(d, backBuffer);
+
+			Assert::IsTrue(mGraph.Compile());
+
+			Assert::AreEqual(0u, mGraph.GetFirstUse(first));
+			Assert::AreEqual(1u, mGraph.GetLastUse(first));
+			Assert::AreEqual(2u, mGraph.GetFirstUse(third));
+			Assert::AreEqual(3u, mGraph.GetLastUse(third));
+
+			Assert::AreEqual(2u, mGraph.GetNumberOfAliasSlots());
+			Assert::AreEqual(mGraph.GetAliasSlot(first), mGraph.GetAliasSlot(third));
+			Assert::AreNotEqual(mGraph.GetAliasSlot(first), mGraph.GetAliasSlot(second));
+			Assert::AreEqual(CFrameGraph::kNone, mGraph.GetAliasSlot(backBuffer));
+		}
+
+		TEST_METHOD(TransientsOfDifferentFormatsDontShareASlot)
+		{
+			const CFrameGraph::ResourceId backBuffer = mGraph.ImportResource("Back buffer");
+			const CFrameGraph::ResourceId first = mGraph.CreateResource("First", { 512, 512, kColourFormat });
+			const CFrameGraph::ResourceId second = mGraph.CreateResource("Second", { 512, 512, kColourFormat });
+			const CFrameGraph::ResourceId third = mGraph.CreateResource("Third", { 512, 512, kHdrFormat });
+
+			const CFrameGraph::PassId a = AddPass("A");
+			mGraph.Write(a, first);
+
+			const CFrameGraph::PassId b = AddPass("B");
+			mGraph.Read(b, first);
+			mGraph.Write(b, second);
+
+			const CFrameGraph::PassId c = AddPass("C");
+			mGraph.Read(c, second);
+			mGraph.Write(c, third);
+
+			const CFrameGraph::PassId d = AddPass("D");
+			mGraph.Read(d, third);
+			mGraph.Write(d, backBuffer);
+
+			Assert::IsTrue(mGraph.Compile());
+
+			// The same lifetimes as above, but third could only take first's memory if it was the same format.
+			Assert::AreEqual(3u, mGraph.GetNumberOfAliasSlots());
+			Assert::AreNotEqual(mGraph.GetAliasSlot(first), mGraph.GetAliasSlot(third));
+		}
+	};
+}
@@ -0,0 +1,193 @@
+﻿#include "CppUnitTest.h"
+#include <vector>
+#include <unordered_set>
+#include "GpuMemoryTracker.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace PrioEngineTests
+{
+	/* Owns resources which are only addresses, and notes down the order they're evicted in. */
+	class CFakeStreamable : public CStreamable
+	{
+	public:
+		bool Evict(const void* resource) override
+		{
+			if (mRefused.find(resource) != mRefused.end())
+			{
+				return false;
+			}
+
+			mEvicted.push_back(resource);
+			CGpuMemoryTracker::GetInstance().Unregister(resource);
+			return true;
+		}
+
+		void Refuse(const void* resource) { mRefused.insert(resource); };
+		const std::vector<const void*>& GetEvicted() { return mEvicted; };
+	private:
+		std::vector<const void*> mEvicted;
+		std::unordered_set<const void*> mRefused;
+	};
+
+	TEST_CLASS(GpuMemoryTrackerTests)
+	{
+	private:
+		static const unsigned int kNumberOfResources = 4;
+		const unsigned long long kResourceSize = 100;
+		const CGpuMemoryTracker::CategoryType kCategory = CGpuMemoryTracker::Other;
+
+		// Only their addresses are used, as the tracker never looks inside a resource.
+		int mResources[kNumberOfResources];
+		CFakeStreamable mOwner;
+
+		CGpuMemoryTracker& GetTracker() { return CGpuMemoryTracker::GetInstance(); };
+	public:
+		TEST_METHOD_CLEANUP(UnregisterResources)
+		{
+			// The tracker is shared by every test, so leave it as it was found.
+			for (unsigned int resource = 0; resource < kNumberOfResources; resource++)
+			{
+				GetTracker().Unregister(&mResources[resource]);
+			}
+
+			GetTracker().SetBudget(kCategory, 0);
+		}
+
+		TEST_METHOD(LeastRecentlyUsedIsEvictedFirst)
+		{
+			const void* a = &mResources[0];
+			const void* b = &mResources[1];
+			const void* c = &mResources[2];
+
+			GetTracker().Register(a, kCategory, kResourceSize, &mOwner);
+			GetTracker().Register(b, kCategory, kResourceSize, &mOwner);
+			GetTracker().Register(c, kCategory, kResourceSize, &mOwner);
+
+			// Used in a different order to the one they were registered in.
+			GetTracker().BeginFrame();
+			GetTracker().Touch(c);
+			GetTracker().BeginFrame();
+			GetTracker().Touch(a);
+			GetTracker().BeginFrame();
+			GetTracker().Touch(b);
+			GetTracker().BeginFrame();
+			GetTracker().BeginFrame();
+
+			GetTracker().SetBudget(kCategory, kResourceSize);
+
+			Assert::AreEqual(2u, GetTracker().EnforceBudgets());
+			Assert::AreEqual(2u, static_cast<unsigned int>(mOwner.GetEvicted().size()));
+			Assert::IsTrue(mOwner.GetEvicted()[0] == c);
+			Assert::IsTrue(mOwner.GetEvicted()[1] == a);
+			Assert::IsTrue(GetTracker().IsRegistered(b));
+		}
+
+		TEST_METHOD(TiesGoInTheOrderTheyWereRegistered)
+		{
+			const unsigned int evictionsBefore = GetTracker().GetStats(kCategory).numberOfEvictions;
+
+			// Registered from the highest address down, so neither the addresses nor the map's order can line up with it by chance.
+			for (unsigned int resource = kNumberOfResources; resource > 0; resource--)
+			{
+				GetTracker().Register(&mResources[resource - 1], kCategory, kResourceSize, &mOwner);
+			}
+
+			GetTracker().BeginFrame();
+			GetTracker().BeginFrame();
+
+			GetTracker().SetBudget(kCategory, kResourceSize);
+
+			Assert::AreEqual(kNumberOfResources - 1, GetTracker().EnforceBudgets());
+
+			const std::vector<const void*>& evicted = mOwner.GetEvicted();
+			Assert::AreEqual(kNumberOfResources - 1, static_cast<unsigned int>(evicted.size()));
+			Assert::IsTrue(evicted[0] == &mResources[3]);
+			Assert::IsTrue(evicted[1] == &mResources[2]);
+			Assert::IsTrue(evicted[2] == &mResources[1]);
+
+			Assert::IsTrue(GetTracker().GetStats(kCategory).memory == kResourceSize);
+			Assert::AreEqual(evictionsBefore + kNumberOfResources - 1, GetTracker().GetStats(kCategory).numberOfEvictions);
+		}
+
+		TEST_METHOD(ResourcesUsedThisFrameOrLastAreKept)
+		{
+			const void* a = &mResources[0];
+			const void* b = &mResources[1];
+			const void* c = &mResources[2];
+
+			GetTracker().Register(a, kCategory, kResourceSize, &mOwner);
+			GetTracker().Register(b, kCategory, kResourceSize, &mOwner);
+			GetTracker().Register(c, kCategory, kResourceSize, &mOwner);
+
+			GetTracker().BeginFrame();
+			GetTracker().Touch(b);
+			GetTracker().BeginFrame();
+			GetTracker().Touch(c);
+
+			// Nothing fits in the budget, but b was used last frame and c this frame.
+			GetTracker().SetBudget(kCategory, 1);
+
+			Assert::AreEqual(1u, GetTracker().EnforceBudgets());
+			Assert::IsTrue(mOwner.GetEvicted()[0] == a);
+			Assert::IsTrue(GetTracker().IsRegistered(b));
+			Assert::IsTrue(GetTracker().IsRegistered(c));
+
+			// A frame later, b is old enough to go but c still isn't.
+			GetTracker().BeginFrame();
+
+			Assert::AreEqual(1u, GetTracker().EnforceBudgets());
+			Assert::IsTrue(mOwner.GetEvicted()[1] == b);
+			Assert::IsTrue(GetTracker().IsRegistered(c));
+		}
+
+		TEST_METHOD(OnlyStreamableResourcesWhichAgreeAreEvicted)
+		{
+			const void* fixed = &mResources[0];
+			const void* busy = &mResources[1];
+			const void* streamable = &mResources[2];
+
+			GetTracker().Register(fixed, kCategory, kResourceSize);
+			GetTracker().Register(busy, kCategory, kResourceSize, &mOwner);
+			GetTracker().Register(streamable, kCategory, kResourceSize, &mOwner);
+
+			mOwner.Refuse(busy);
+
+			GetTracker().BeginFrame();
+			GetTracker().BeginFrame();
+
+			GetTracker().SetBudget(kCategory, 1);
+
+			Assert::AreEqual(1u, GetTracker().EnforceBudgets());
+			Assert::AreEqual(1u, static_cast<unsigned int>(mOwner.GetEvicted().size()));
+			Assert::IsTrue(mOwner.GetEvicted()[0] == streamable);
+			Assert::IsTrue(GetTracker().IsRegistered(fixed));
+			Assert::IsTrue(GetTracker().IsRegistered(busy));
+		}
+
+		TEST_METHOD(TextureMemoryCountsEveryMipLevel)
+		{
+			// DXGI_FORMAT_R8G8B8A8_UNORM is 4 bytes a pixel, the full chain is 4x4, 2x2 and 1x1.
+			Assert::IsTrue(CGpuMemoryTracker::GetTextureMemory(4, 4, 0, 1, 28) == (16ull + 4ull + 1ull) * 4ull);
+
+			// DXGI_FORMAT_BC1_UNORM is 8 bytes for each 4x4 block, and a level smaller than a block still takes a whole one.
+			Assert::IsTrue(CGpuMemoryTracker::GetTextureMemory(8, 8, 0, 1, 71) == (4ull + 1ull + 1ull + 1ull) * 8ull);
+
+			// Only the top level, once for each slice of the array.
+			Assert::IsTrue(CGpuMemoryTracker::GetTextureMemory(4, 4, 1, 6, 28) == 16ull * 4ull * 6ull);
+		}
+
+		TEST_METHOD(NothingIsEvictedWithinBudget)
+		{
+			GetTracker().Register(&mResources[0], kCategory, kResourceSize, &mOwner);
+
+			GetTracker().BeginFrame();
+			GetTracker().BeginFrame();
+
+			GetTracker().SetBudget(kCategory, kResourceSize);
+
+			Assert::AreEqual(0u, GetTracker().EnforceBudgets());
+			Assert::IsTrue(mOwner.GetEvicted().empty());
+		}
+	};
+}
@@ -0,0 +1,186 @@
+﻿#include "CppUnitTest.h"
+#include <cmath>
+#include <string>
+#include <vector>
+#include "HorizonCuller.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace PrioEngineTests
+{
+	TEST_CLASS(HorizonCullerTests)
+	{
+	private:
+		typedef float(*HeightFunction)(float x, float z);
+
+		// The same layout CTerrain uses: one unit between vertices and chunks of 16 squares, so a 257 vertex map is 16 chunks across.
+		static const int kMapSize = 257;
+		static const int kChunkSize = 16;
+
+		// Trees and bushes are planted this far apart, with a sphere about the size of a tree sitting on the ground.
+		static const int kInstanceSpacing = 4;
+		const float kInstanceRadius = 2.0f;
+		// The camera stands this far above the ground.
+		const float kEyeHeight = 2.0f;
+
+		static float Flat(float x, float z)
+		{
+			return 0.0f;
+		}
+
+		// Hills about 60 units apart and 24 units from the lowest to the highest point.
+		static float RollingHills(float x, float z)
+		{
+			return 12.0f * sinf(x * 0.1f) * sinf(z * 0.1f);
+		}
+
+		// The same hills with smaller, steeper ones on top, closer to what a noise generated map looks like.
+		static float RoughHills(float x, float z)
+		{
+			return RollingHills(x, z) + 4.0f * sinf(x * 0.37f + 1.0f) * sinf(z * 0.29f);
+		}
+
+		// A valley running along the z axis, rising to 60 units at the edges of the map.
+		static float Valley(float x, float z)
+		{
+			const float across = (x - 128.0f) / 128.0f;
+			return 60.0f * across * across;
+		}
+
+		// A wall 30 units high across the middle of the map, two chunks thick so that the chunks it covers are 30 units high all over.
+		static float Ridge(float x, float z)
+		{
+			return x >= 112.0f && x <= 144.0f ? 30.0f : 0.0f;
+		}
+
+		// Works out the chunk bounds as CTerrain does from its height map.
+		static std::vector<CTerrain::TerrainChunkType> MakeChunks(HeightFunction height)
+		{
+			std::vector<CTerrain::TerrainChunkType> chunks;
+			const int numberOfChunks = (kMapSize - 1) / kChunkSize;
+
+			for (int chunkZ = 0; chunkZ < numberOfChunks; chunkZ++)
+			{
+				for (int chunkX = 0; chunkX < numberOfChunks; chunkX++)
+				{
+					CTerrain::TerrainChunkType chunk;
+					chunk.minX = static_cast<float>(chunkX * kChunkSize);
+					chunk.minZ = static_cast<float>(chunkZ * kChunkSize);
+					chunk.maxX = chunk.minX + kChunkSize;
+					chunk.maxZ = chunk.minZ + kChunkSize;
+					chunk.minHeight = height(chunk.minX, chunk.minZ);
+					chunk.maxHeight = chunk.minHeight;
+
+					for (float z = chunk.minZ; z <= chunk.maxZ; z++)
+					{
+						for (float x = chunk.minX; x <= chunk.maxX; x++)
+						{
+							chunk.minHeight = fminf(chunk.minHeight, height(x, z));
+							chunk.maxHeight = fmaxf(chunk.maxHeight, height(x, z));
+						}
+					}
+
+					chunks.push_back(chunk);
+				}
+			}
+
+			return chunks;
+		}
+
+		// Stands the camera at nine points spread over the map and tests every instance from each, in every direction.
+		// There's no frustum here, so this is the share of everything around the camera rather than of what passed the frustum test.
+		float MeasureCulledShare(HeightFunction height)
+		{
+			const std::vector<CTerrain::TerrainChunkType> chunks = MakeChunks(height);
+			const D3DXVECTOR3 terrainPosition(0.0f, 0.0f, 0.0f);
+			const float cameraPositions[3] = { 64.0f, 128.0f, 192.0f };
+
+			CHorizonCuller culler;
+
+			for (float cameraX : cameraPositions)
+			{
+				for (float cameraZ : cameraPositions)
+				{
+					culler.Build(chunks, terrainPosition, D3DXVECTOR3(cameraX, height(cameraX, cameraZ) + kEyeHeight, cameraZ));
+
+					for (int z = 0; z < kMapSize; z += kInstanceSpacing)
+					{
+						for (int x = 0; x < kMapSize; x += kInstanceSpacing)
+						{
+							const float instanceX = static_cast<float>(x);
+							const float instanceZ = static_cast<float>(z);
+							culler.CheckSphere(D3DXVECTOR3(instanceX, height(instanceX, instanceZ) + kInstanceRadius, instanceZ), kInstanceRadius);
+						}
+					}
+				}
+			}
+
+			return culler.GetTotalCulledShare();
+		}
+
+		static void WriteShare(const std::string& map, float share)
+		{
+			const std::string message = map + ": " + std::to_string(share * 100.0f) + "% of instances hidden by the terrain.";
+			Logger::WriteMessage(message.c_str());
+		}
+	public:
+		TEST_METHOD(NothingIsHiddenOnFlatGround)
+		{
+			const float share = MeasureCulledShare(Flat);
+			WriteShare("Flat", share);
+
+			Assert::AreEqual(0.0f, share);
+		}
+
+		TEST_METHOD(NothingIsHiddenInAValley)
+		{
+			// The ground curves upwards everywhere, so every point can see every other, and anything hidden would be a mistake.
+			const float share = MeasureCulledShare(Valley);
+			WriteShare("Valley", share);
+
+			Assert::AreEqual(0.0f, share);
+		}
+
+		TEST_METHOD(OnlyWhatIsBelowTheRidgeIsHidden)
+		{
+			CHorizonCuller culler;
+			culler.Build(MakeChunks(Ridge), D3DXVECTOR3(0.0f, 0.0f, 0.0f), D3DXVECTOR3(64.0f, kEyeHeight, 128.0f));
+
+			// On the ground well behind the ridge.
+			Assert::IsFalse(culler.CheckSphere(D3DXVECTOR3(200.0f, kInstanceRadius, 128.0f), kInstanceRadius));
+			// In front of it.
+			Assert::IsTrue(culler.CheckSphere(D3DXVECTOR3(100.0f, kInstanceRadius, 128.0f), kInstanceRadius));
+			// Behind it, but high enough to be seen over the top.
+			Assert::IsTrue(culler.CheckSphere(D3DXVECTOR3(200.0f, 80.0f, 128.0f), kInstanceRadius));
+			// Behind the camera, where there's nothing in the way.
+			Assert::IsTrue(culler.CheckSphere(D3DXVECTOR3(8.0f, kInstanceRadius, 128.0f), kInstanceRadius));
+
+			Assert::AreEqual(4u, culler.GetInstancesTested());
+			Assert::AreEqual(1u, culler.GetInstancesCulled());
+		}
+
+		TEST_METHOD(NothingIsHiddenWhenDisabled)
+		{
+			CHorizonCuller culler;
+			culler.SetEnabled(false);
+			culler.Build(MakeChunks(Ridge), D3DXVECTOR3(0.0f, 0.0f, 0.0f), D3DXVECTOR3(64.0f, kEyeHeight, 128.0f));
+
+			Assert::IsTrue(culler.CheckSphere(D3DXVECTOR3(200.0f, kInstanceRadius, 128.0f), kInstanceRadius));
+		}
+
+		TEST_METHOD(CulledShareOnGeneratedMaps)
+		{
+			// Writes the share culled on a few kinds of map to the test output, so a change to the culler can be compared against these.
+			const float hills = MeasureCulledShare(RollingHills);
+			const float rough = MeasureCulledShare(RoughHills);
+			const float ridge = MeasureCulledShare(Ridge);
+			WriteShare("Rolling hills", hills);
+			WriteShare("Rough hills", rough);
+			WriteShare("Ridge", ridge);
+
+			Assert::IsTrue(hills > 0.0f && hills < 1.0f);
+			Assert::IsTrue(rough > 0.0f && rough < 1.0f);
+			Assert::IsTrue(ridge > 0.0f && ridge < 1.0f);
+		}
+	};
+}
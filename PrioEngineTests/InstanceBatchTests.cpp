@@ -0,0 +1,193 @@
+﻿#include "CppUnitTest.h"
+#include <chrono>
+#include <string>
+#include "InstanceBatch.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace PrioEngineTests
+{
+	TEST_CLASS(InstanceBatchTests)
+	{
+	private:
+		static const unsigned int kNumberOfLevels = 4;
+
+		CInstanceBatch mBatch;
+
+		// A matrix which can be told apart from the others by its translation.
+		static D3DXMATRIX MakeWorld(float x)
+		{
+			D3DXMATRIX world;
+			D3DXMatrixTranslation(&world, x, 0.0f, 0.0f);
+			return world;
+		}
+
+		// Two submeshes, the first with every detail level and the second with only two.
+		static std::vector<std::vector<CInstanceBatch::RangeType>> MakeLevels()
+		{
+			std::vector<std::vector<CInstanceBatch::RangeType>> subMeshLevels(2);
+			subMeshLevels[0] = { { 0, 300 }, { 300, 150 }, { 450, 75 }, { 525, 36 } };
+			subMeshLevels[1] = { { 0, 60 }, { 60, 30 } };
+			return subMeshLevels;
+		}
+	public:
+		TEST_METHOD(WholeInstancesAreDrawnOncePerLevel)
+		{
+			mBatch.Begin(2, kNumberOfLevels);
+			mBatch.AddInstance(MakeWorld(0.0f), 0);
+			mBatch.AddInstance(MakeWorld(1.0f), 2);
+			mBatch.AddInstance(MakeWorld(2.0f), 0);
+			mBatch.AddInstance(MakeWorld(3.0f), 3);
+			mBatch.Finish(MakeLevels());
+
+			Assert::AreEqual(4u, mBatch.GetNumberOfInstances());
+			Assert::AreEqual(4u, mBatch.GetNumberOfBatchedInstances());
+			Assert::AreEqual(2u, mBatch.GetNumberOfInstancesAtLevel(0));
+			Assert::AreEqual(0u, mBatch.GetNumberOfInstancesAtLevel(1));
+
+			// Level 1 has nobody in it, so it gets no draw.
+			const std::vector<CInstanceBatch::DrawType>& draws = mBatch.GetDraws(0);
+			Assert::AreEqual(3u, static_cast<unsigned int>(draws.size()));
+			Assert::AreEqual(0u, draws[0].startIndex);
+			Assert::AreEqual(300u, draws[0].indexCount);
+			Assert::AreEqual(0u, draws[0].startInstance);
+			Assert::AreEqual(2u, draws[0].instanceCount);
+			Assert::AreEqual(450u, draws[1].startIndex);
+			Assert::AreEqual(2u, draws[1].startInstance);
+			Assert::AreEqual(1u, draws[1].instanceCount);
+			Assert::AreEqual(525u, draws[2].startIndex);
+			Assert::AreEqual(3u, draws[2].startInstance);
+
+			// The second submesh runs out of levels, so both of the far instances draw its lowest one.
+			const std::vector<CInstanceBatch::DrawType>& clamped = mBatch.GetDraws(1);
+			Assert::AreEqual(3u, static_cast<unsigned int>(clamped.size()));
+			Assert::AreEqual(60u, clamped[1].startIndex);
+			Assert::AreEqual(30u, clamped[1].indexCount);
+			Assert::AreEqual(60u, clamped[2].startIndex);
+
+			Assert::AreEqual(6u, mBatch.GetNumberOfDraws());
+
+			// The instances are grouped by level in the buffer, in the order the draws expect.
+			D3DXMATRIX instances[4];
+			mBatch.CopyInstances(instances);
+			Assert::AreEqual(0.0f, instances[0]._41);
+			Assert::AreEqual(2.0f, instances[1]._41);
+			Assert::AreEqual(1.0f, instances[2]._41);
+			Assert::AreEqual(3.0f, instances[3]._41);
+		}
+
+		TEST_METHOD(CulledInstancesDrawTheirOwnRangesAfterTheWholeOnes)
+		{
+			mBatch.Begin(2, kNumberOfLevels);
+			mBatch.AddInstance(MakeWorld(0.0f), 0);
+			const unsigned int culled = mBatch.AddCulledInstance(MakeWorld(5.0f));
+			mBatch.AddInstance(MakeWorld(1.0f), 1);
+
+			// Two meshlet ranges of the first submesh survived, none of the second.
+			mBatch.AddRange(0, culled, 0, 96);
+			mBatch.AddRange(0, culled, 192, 48);
+			mBatch.Finish(MakeLevels());
+
+			Assert::AreEqual(3u, mBatch.GetNumberOfInstances());
+			Assert::AreEqual(2u, mBatch.GetNumberOfBatchedInstances());
+
+			// The culled instance's draws come first, moved past the whole instances.
+			const std::vector<CInstanceBatch::DrawType>& draws = mBatch.GetDraws(0);
+			Assert::AreEqual(4u, static_cast<unsigned int>(draws.size()));
+			Assert::AreEqual(0u, draws[0].startIndex);
+			Assert::AreEqual(96u, draws[0].indexCount);
+			Assert::AreEqual(2u, draws[0].startInstance);
+			Assert::AreEqual(1u, draws[0].instanceCount);
+			Assert::AreEqual(192u, draws[1].startIndex);
+			Assert::AreEqual(2u, draws[1].startInstance);
+
+			// A culled instance adds nothing to a submesh it has no ranges in.
+			Assert::AreEqual(2u, static_cast<unsigned int>(mBatch.GetDraws(1).size()));
+
+			D3DXMATRIX instances[3];
+			mBatch.CopyInstances(instances);
+			Assert::AreEqual(5.0f, instances[2]._41);
+		}
+
+		TEST_METHOD(CellsDrawThroughOneIdentityInstance)
+		{
+			// The same steps CMesh::GatherStaticBatches takes, the cells are already in world space.
+			D3DXMATRIX identity;
+			D3DXMatrixIdentity(&identity);
+
+			mBatch.Begin(2, kNumberOfLevels);
+			const unsigned int identityInstance = mBatch.AddCulledInstance(identity);
+			mBatch.Finish(MakeLevels());
+
+			Assert::AreEqual(0u, mBatch.GetNumberOfBatchedInstances() + identityInstance);
+			Assert::AreEqual(1u, mBatch.GetNumberOfInstances());
+
+			// The batcher makes the draws, the batch has none of its own.
+			Assert::AreEqual(0u, mBatch.GetNumberOfDraws());
+
+			D3DXMATRIX instance;
+			mBatch.CopyInstances(&instance);
+			Assert::IsFalse(instance != identity);
+		}
+
+		TEST_METHOD(BeginForgetsTheLastFrame)
+		{
+			mBatch.Begin(2, kNumberOfLevels);
+			mBatch.AddInstance(MakeWorld(0.0f), 0);
+			mBatch.AddRange(0, mBatch.AddCulledInstance(MakeWorld(1.0f)), 0, 3);
+			mBatch.Finish(MakeLevels());
+
+			mBatch.Begin(2, kNumberOfLevels);
+			mBatch.Finish(MakeLevels());
+
+			Assert::AreEqual(0u, mBatch.GetNumberOfInstances());
+			Assert::AreEqual(0u, mBatch.GetNumberOfDraws());
+		}
+
+		TEST_METHOD(GatherTiming)
+		{
+			// Not a pass or fail test, it writes how long a gather of a large forest takes to the test output so changes can be compared.
+			const unsigned int kNumberOfInstances = 20000;
+			const unsigned int kNumberOfFrames = 50;
+			const std::vector<std::vector<CInstanceBatch::RangeType>> subMeshLevels = MakeLevels();
+
+			std::vector<D3DXMATRIX> worlds(kNumberOfInstances);
+			for (unsigned int instance = 0; instance < kNumberOfInstances; instance++)
+			{
+				worlds[instance] = MakeWorld(static_cast<float>(instance));
+			}
+			std::vector<D3DXMATRIX> instanceBuffer(kNumberOfInstances);
+
+			auto start = std::chrono::high_resolution_clock::now();
+
+			for (unsigned int frame = 0; frame < kNumberOfFrames; frame++)
+			{
+				mBatch.Begin(2, kNumberOfLevels);
+
+				// One in sixteen has meshlets culled, the rest are spread over the levels.
+				for (unsigned int instance = 0; instance < kNumberOfInstances; instance++)
+				{
+					if (instance % 16 == 0)
+					{
+						mBatch.AddRange(0, mBatch.AddCulledInstance(worlds[instance]), 0, 96);
+					}
+					else
+					{
+						mBatch.AddInstance(worlds[instance], instance % kNumberOfLevels);
+					}
+				}
+
+				mBatch.Finish(subMeshLevels);
+				mBatch.CopyInstances(&instanceBuffer[0]);
+			}
+
+			auto end = std::chrono::high_resolution_clock::now();
+			const double microseconds = std::chrono::duration<double, std::micro>(end - start).count() / kNumberOfFrames;
+
+			Assert::AreEqual(kNumberOfInstances, mBatch.GetNumberOfInstances());
+
+			const std::string message = "Gathered, finished and copied " + std::to_string(kNumberOfInstances) + " instances in " + std::to_string(microseconds) + "us a frame.";
+			Logger::WriteMessage(message.c_str());
+		}
+	};
+}
@@ -0,0 +1,106 @@
+﻿#include "CppUnitTest.h"
+#include "MeshletCuller.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace PrioEngineTests
+{
+	TEST_CLASS(MeshletCullerTests)
+	{
+	private:
+		CMeshletCuller mCuller;
+		std::vector<CMeshletCuller::IndexRangeType> mRanges;
+
+		// A flat cluster at the origin whose triangles all face +Z.
+		static CMeshletBuilder::MeshletType MakeMeshlet(unsigned int startIndex, unsigned int indexCount)
+		{
+			CMeshletBuilder::MeshletType meshlet;
+			meshlet.startIndex = startIndex;
+			meshlet.indexCount = indexCount;
+			meshlet.centre = D3DXVECTOR3(0.0f, 0.0f, 0.0f);
+			meshlet.radius = 1.0f;
+			meshlet.coneAxis = D3DXVECTOR3(0.0f, 0.0f, 1.0f);
+			meshlet.coneCutoff = 0.0f;
+			return meshlet;
+		}
+
+		void Cull(const D3DXMATRIX& world, D3DXVECTOR3 viewPosition)
+		{
+			std::vector<CMeshletBuilder::MeshletType> meshlets = { MakeMeshlet(0, 30) };
+			mCuller.Cull(meshlets, world, nullptr, &viewPosition, mRanges);
+		}
+	public:
+		TEST_METHOD(MeshletFacingAwayIsCulled)
+		{
+			D3DXMATRIX identity;
+			D3DXMatrixIdentity(&identity);
+
+			Cull(identity, D3DXVECTOR3(0.0f, 0.0f, -10.0f));
+
+			Assert::IsTrue(mRanges.empty());
+			Assert::AreEqual(1u, mCuller.GetMeshletsBackFaceCulled());
+			Assert::AreEqual(30u, mCuller.GetIndicesCulled());
+		}
+
+		TEST_METHOD(MeshletFacingTheCameraIsKept)
+		{
+			D3DXMATRIX identity;
+			D3DXMatrixIdentity(&identity);
+
+			Cull(identity, D3DXVECTOR3(0.0f, 0.0f, 10.0f));
+
+			Assert::AreEqual(1u, static_cast<unsigned int>(mRanges.size()));
+			Assert::AreEqual(30u, mRanges[0].indexCount);
+			Assert::AreEqual(0u, mCuller.GetMeshletsBackFaceCulled());
+		}
+
+		TEST_METHOD(MirroredInstanceCullsTheSideTheRasteriserCulls)
+		{
+			// Mirroring in Z flips the winding, so the rasteriser draws the side which now faces +Z in the world, and culls the other.
+			D3DXMATRIX mirror;
+			D3DXMatrixScaling(&mirror, 1.0f, 1.0f, -1.0f);
+
+			Cull(mirror, D3DXVECTOR3(0.0f, 0.0f, 10.0f));
+
+			Assert::AreEqual(1u, static_cast<unsigned int>(mRanges.size()));
+			Assert::AreEqual(0u, mCuller.GetMeshletsBackFaceCulled());
+
+			Cull(mirror, D3DXVECTOR3(0.0f, 0.0f, -10.0f));
+
+			Assert::IsTrue(mRanges.empty());
+			Assert::AreEqual(1u, mCuller.GetMeshletsBackFaceCulled());
+		}
+
+		TEST_METHOD(RotatedInstanceIsNotTreatedAsMirrored)
+		{
+			// Half a turn about Y also points the cluster at -Z, but keeps the winding.
+			D3DXMATRIX rotation;
+			D3DXMatrixRotationY(&rotation, D3DX_PI);
+
+			Cull(rotation, D3DXVECTOR3(0.0f, 0.0f, -10.0f));
+
+			Assert::AreEqual(1u, static_cast<unsigned int>(mRanges.size()));
+
+			Cull(rotation, D3DXVECTOR3(0.0f, 0.0f, 10.0f));
+
+			Assert::IsTrue(mRanges.empty());
+		}
+
+		TEST_METHOD(NeighbouringMeshletsAreJoined)
+		{
+			D3DXMATRIX identity;
+			D3DXMatrixIdentity(&identity);
+			D3DXVECTOR3 viewPosition(0.0f, 0.0f, 10.0f);
+
+			std::vector<CMeshletBuilder::MeshletType> meshlets = { MakeMeshlet(0, 30), MakeMeshlet(30, 12), MakeMeshlet(60, 9) };
+			mCuller.Cull(meshlets, identity, nullptr, &viewPosition, mRanges);
+
+			Assert::AreEqual(2u, static_cast<unsigned int>(mRanges.size()));
+			Assert::AreEqual(0u, mRanges[0].startIndex);
+			Assert::AreEqual(42u, mRanges[0].indexCount);
+			Assert::AreEqual(60u, mRanges[1].startIndex);
+			Assert::AreEqual(9u, mRanges[1].indexCount);
+			Assert::AreEqual(51u, mCuller.GetIndicesSubmitted());
+		}
+	};
+}
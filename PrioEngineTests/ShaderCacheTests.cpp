@@ -0,0 +1,304 @@
+#include "CppUnitTest.h"
+#include <windows.h>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+#include "ShaderCache.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace PrioEngineTests
+{
+	/* Stands in for the HLSL compiler. Its bytecode is just the file, entry point and profile it was asked for, and it counts how many times
+	* each of those it has compiled, so the tests can tell a cache hit from a compile.
+	*/
+	class CFakeShaderCompiler : public CShaderCompiler
+	{
+	public:
+		bool Compile(const std::string& filename, const std::string& entryPoint, const std::string& profile, unsigned int flags,
+			std::vector<unsigned char>& bytecode, std::string& errors) override
+		{
+			std::ifstream file(filename);
+			if (!file.is_open())
+			{
+				errors.clear();
+				return false;
+			}
+
+			const std::string output = filename + ":" + entryPoint + ":" + profile;
+			bytecode.assign(output.begin(), output.end());
+
+			std::lock_guard<std::mutex> lock(mMutex);
+			mCompiles[output]++;
+			mTotalCompiles++;
+
+			return true;
+		}
+
+		std::string GetName() override
+		{
+			return "fake";
+		}
+
+		unsigned int GetCompiles(const std::string& filename, const std::string& entryPoint, const std::string& profile)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			return mCompiles[filename + ":" + entryPoint + ":" + profile];
+		}
+
+		unsigned int GetTotalCompiles()
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			return mTotalCompiles;
+		}
+	private:
+		std::mutex mMutex;
+		std::unordered_map<std::string, unsigned int> mCompiles;
+		unsigned int mTotalCompiles = 0;
+	};
+
+	TEST_CLASS(ShaderCacheTests)
+	{
+	private:
+		const std::string kDirectory = "ShaderCacheTests";
+		const std::string kCacheDirectory = "ShaderCacheTests/Cache";
+
+		CFakeShaderCompiler mCompiler;
+
+		void WriteFile(const std::string& name, const std::string& contents)
+		{
+			std::ofstream file(kDirectory + "/" + name, std::ios::binary);
+			file << contents;
+		}
+
+		CShaderCache::ShaderKeyType MakeKey(const std::string& name, const std::string& entryPoint)
+		{
+			CShaderCache::ShaderKeyType key;
+			key.filename = kDirectory + "/" + name;
+			key.entryPoint = entryPoint;
+			key.profile = "vs_5_0";
+			key.flags = 0;
+			return key;
+		}
+
+		static void DeleteDirectory(const std::string& directory)
+		{
+			WIN32_FIND_DATAA findData;
+			HANDLE find = FindFirstFileA((directory + "/*").c_str(), &findData);
+
+			if (find != INVALID_HANDLE_VALUE)
+			{
+				do
+				{
+					const std::string name = findData.cFileName;
+					if (name == "." || name == "..")
+					{
+						continue;
+					}
+
+					if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+					{
+						DeleteDirectory(directory + "/" + name);
+					}
+					else
+					{
+						DeleteFileA((directory + "/" + name).c_str());
+					}
+				} while (FindNextFileA(find, &findData));
+
+				FindClose(find);
+			}
+
+			RemoveDirectoryA(directory.c_str());
+		}
+	public:
+		TEST_METHOD_INITIALIZE(CreateDirectories)
+		{
+			// Anything left behind by a test which failed part way through would turn the first miss into a hit.
+			DeleteDirectory(kDirectory);
+			CreateDirectoryA(kDirectory.c_str(), NULL);
+		}
+
+		TEST_METHOD_CLEANUP(DeleteDirectories)
+		{
+			DeleteDirectory(kDirectory);
+		}
+
+		TEST_METHOD(FirstRequestMissesAndCompiles)
+		{
+			WriteFile("Mesh.hlsl", "float4 VS() : SV_POSITION { return 0; }");
+
+			CShaderCache cache(&mCompiler, kCacheDirectory);
+			Assert::IsTrue(cache.Initialise());
+
+			std::vector<unsigned char> bytecode;
+			std::string errors;
+			Assert::IsTrue(cache.GetBytecode(MakeKey("Mesh.hlsl", "VS"), bytecode, errors));
+
+			Assert::AreEqual(0u, cache.GetHits());
+			Assert::AreEqual(1u, cache.GetMisses());
+			Assert::AreEqual(1u, cache.GetNumberOfCompiles());
+			Assert::AreEqual(1u, mCompiler.GetTotalCompiles());
+			Assert::IsFalse(bytecode.empty());
+		}
+
+		TEST_METHOD(SecondRequestHitsWithoutCompiling)
+		{
+			WriteFile("Mesh.hlsl", "float4 VS() : SV_POSITION { return 0; }");
+
+			std::vector<unsigned char> compiled;
+			std::vector<unsigned char> cached;
+			std::string errors;
+
+			CShaderCache cache(&mCompiler, kCacheDirectory);
+			Assert::IsTrue(cache.Initialise());
+			Assert::IsTrue(cache.GetBytecode(MakeKey("Mesh.hlsl", "VS"), compiled, errors));
+			Assert::IsTrue(cache.GetBytecode(MakeKey("Mesh.hlsl", "VS"), cached, errors));
+
+			Assert::AreEqual(1u, cache.GetHits());
+			Assert::AreEqual(1u, cache.GetMisses());
+			Assert::IsTrue(compiled == cached);
+
+			// A new cache over the same directory, as on the next run, finds it on disk.
+			CShaderCache nextRun(&mCompiler, kCacheDirectory);
+			Assert::IsTrue(nextRun.Initialise());
+			Assert::IsTrue(nextRun.GetBytecode(MakeKey("Mesh.hlsl", "VS"), cached, errors));
+
+			Assert::AreEqual(1u, nextRun.GetHits());
+			Assert::AreEqual(0u, nextRun.GetMisses());
+			Assert::AreEqual(1u, mCompiler.GetTotalCompiles());
+			Assert::IsTrue(compiled == cached);
+		}
+
+		TEST_METHOD(DifferentEntryPointMisses)
+		{
+			WriteFile("Mesh.hlsl", "float4 VS() : SV_POSITION { return 0; }\nfloat4 PS() : SV_TARGET { return 1; }");
+
+			std::vector<unsigned char> bytecode;
+			std::string errors;
+
+			CShaderCache cache(&mCompiler, kCacheDirectory);
+			Assert::IsTrue(cache.Initialise());
+			Assert::IsTrue(cache.GetBytecode(MakeKey("Mesh.hlsl", "VS"), bytecode, errors));
+			Assert::IsTrue(cache.GetBytecode(MakeKey("Mesh.hlsl", "PS"), bytecode, errors));
+
+			Assert::AreEqual(0u, cache.GetHits());
+			Assert::AreEqual(2u, cache.GetMisses());
+		}
+
+		TEST_METHOD(ChangingAnIncludedFileMisses)
+		{
+			WriteFile("Common.hlsl", "#define SCALE 1");
+			WriteFile("Mesh.hlsl", "#include \"Common.hlsl\"\nfloat4 VS() : SV_POSITION { return SCALE; }");
+
+			const CShaderCache::ShaderKeyType key = MakeKey("Mesh.hlsl", "VS");
+			std::vector<unsigned char> bytecode;
+			std::string errors;
+			unsigned long long before;
+			unsigned long long after;
+
+			CShaderCache cache(&mCompiler, kCacheDirectory);
+			Assert::IsTrue(cache.Initialise());
+			Assert::IsTrue(cache.Hash(key, before));
+			Assert::IsTrue(cache.GetBytecode(key, bytecode, errors));
+
+			// Only the included file changes, the shader itself is untouched.
+			WriteFile("Common.hlsl", "#define SCALE 2");
+
+			Assert::IsTrue(cache.Hash(key, after));
+			Assert::IsTrue(before != after);
+			Assert::IsTrue(cache.GetBytecode(key, bytecode, errors));
+
+			Assert::AreEqual(0u, cache.GetHits());
+			Assert::AreEqual(2u, cache.GetMisses());
+			Assert::AreEqual(2u, mCompiler.GetCompiles(key.filename, "VS", "vs_5_0"));
+
+			// Changing it back finds the first bytecode again.
+			WriteFile("Common.hlsl", "#define SCALE 1");
+			Assert::IsTrue(cache.GetBytecode(key, bytecode, errors));
+
+			Assert::AreEqual(1u, cache.GetHits());
+			Assert::AreEqual(2u, mCompiler.GetTotalCompiles());
+		}
+
+		TEST_METHOD(MissingFileFails)
+		{
+			std::vector<unsigned char> bytecode;
+			std::string errors;
+
+			CShaderCache cache(&mCompiler, kCacheDirectory);
+			Assert::IsTrue(cache.Initialise());
+			Assert::IsFalse(cache.GetBytecode(MakeKey("Missing.hlsl", "VS"), bytecode, errors));
+
+			Assert::AreEqual(0u, mCompiler.GetTotalCompiles());
+		}
+
+		TEST_METHOD(WarmUpCompilesEachMissingShaderOnce)
+		{
+			const unsigned int kNumberOfShaders = 40;
+
+			std::vector<CShaderCache::ShaderKeyType> keys;
+			for (unsigned int shader = 0; shader < kNumberOfShaders; shader++)
+			{
+				const std::string name = "Shader" + std::to_string(shader) + ".hlsl";
+				WriteFile(name, "float4 VS() : SV_POSITION { return " + std::to_string(shader) + "; }");
+				keys.push_back(MakeKey(name, "VS"));
+			}
+
+			// The same shader twice is only one job.
+			keys.push_back(keys[0]);
+
+			std::vector<unsigned char> bytecode;
+			std::string errors;
+
+			CShaderCache cache(&mCompiler, kCacheDirectory);
+			Assert::IsTrue(cache.Initialise());
+
+			// Already in the cache, so it isn't a job at all.
+			Assert::IsTrue(cache.GetBytecode(keys[1], bytecode, errors));
+
+			Assert::AreEqual(kNumberOfShaders - 1, cache.WarmUp(keys));
+
+			// Every job was taken by exactly one thread, none were skipped or compiled twice.
+			for (unsigned int shader = 0; shader < kNumberOfShaders; shader++)
+			{
+				Assert::AreEqual(1u, mCompiler.GetCompiles(keys[shader].filename, "VS", "vs_5_0"));
+			}
+
+			// The shader classes then find everything waiting for them.
+			for (unsigned int shader = 0; shader < kNumberOfShaders; shader++)
+			{
+				Assert::IsTrue(cache.GetBytecode(keys[shader], bytecode, errors));
+			}
+
+			Assert::AreEqual(kNumberOfShaders, cache.GetHits());
+			Assert::AreEqual(1u, cache.GetMisses());
+			Assert::AreEqual(kNumberOfShaders, mCompiler.GetTotalCompiles());
+		}
+
+		TEST_METHOD(WarmUpFromManifestOnlyCompilesChangedShaders)
+		{
+			WriteFile("Mesh.hlsl", "float4 VS() : SV_POSITION { return 0; }");
+			WriteFile("Terrain.hlsl", "float4 VS() : SV_POSITION { return 1; }");
+
+			std::vector<unsigned char> bytecode;
+			std::string errors;
+
+			{
+				CShaderCache cache(&mCompiler, kCacheDirectory);
+				Assert::IsTrue(cache.Initialise());
+				Assert::IsTrue(cache.GetBytecode(MakeKey("Mesh.hlsl", "VS"), bytecode, errors));
+				Assert::IsTrue(cache.GetBytecode(MakeKey("Terrain.hlsl", "VS"), bytecode, errors));
+				Assert::IsTrue(cache.SaveManifest());
+			}
+
+			WriteFile("Terrain.hlsl", "float4 VS() : SV_POSITION { return 2; }");
+
+			CShaderCache nextRun(&mCompiler, kCacheDirectory);
+			Assert::IsTrue(nextRun.Initialise());
+			Assert::AreEqual(1u, nextRun.WarmUp());
+			Assert::AreEqual(2u, mCompiler.GetCompiles(kDirectory + "/Terrain.hlsl", "VS", "vs_5_0"));
+			Assert::AreEqual(1u, mCompiler.GetCompiles(kDirectory + "/Mesh.hlsl", "VS", "vs_5_0"));
+		}
+	};
+}
@@ -0,0 +1,256 @@
+﻿#include "CppUnitTest.h"
+#include "StaticBatcher.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace PrioEngineTests
+{
+	TEST_CLASS(StaticBatcherTests)
+	{
+	private:
+		const float kTolerance = 0.0001f;
+
+		static CStaticBatcher::VertexType MakeVertex(float x, float y, float z, D3DXVECTOR3 normal)
+		{
+			CStaticBatcher::VertexType vertex;
+			vertex.position = D3DXVECTOR3(x, y, z);
+			vertex.uv = D3DXVECTOR2(x, y);
+			D3DXVec3Normalize(&vertex.normal, &normal);
+			return vertex;
+		}
+
+		// One triangle in the XY plane, wound clockwise when seen from -Z, with its normal facing -Z.
+		static CStaticBatcher::GeometryType MakeTriangle()
+		{
+			CStaticBatcher::GeometryType triangle;
+			triangle.vertices.push_back(MakeVertex(0.0f, 0.0f, 0.0f, D3DXVECTOR3(0.0f, 0.0f, -1.0f)));
+			triangle.vertices.push_back(MakeVertex(0.0f, 1.0f, 0.0f, D3DXVECTOR3(0.0f, 0.0f, -1.0f)));
+			triangle.vertices.push_back(MakeVertex(1.0f, 0.0f, 0.0f, D3DXVECTOR3(0.0f, 0.0f, -1.0f)));
+			triangle.indices = { 0, 1, 2 };
+			return triangle;
+		}
+
+		// The way a merged triangle faces, from its winding in a left handed space, as Direct3D culls it.
+		static D3DXVECTOR3 GetFacing(const CStaticBatcher::BatchType& batch, unsigned int firstIndex)
+		{
+			const D3DXVECTOR3& a = batch.vertices[batch.indices[firstIndex]].position;
+			const D3DXVECTOR3& b = batch.vertices[batch.indices[firstIndex + 1]].position;
+			const D3DXVECTOR3& c = batch.vertices[batch.indices[firstIndex + 2]].position;
+
+			D3DXVECTOR3 ab = b - a;
+			D3DXVECTOR3 ac = c - a;
+			D3DXVECTOR3 facing;
+			D3DXVec3Cross(&facing, &ab, &ac);
+			return facing;
+		}
+	public:
+		TEST_METHOD(PositionsAreMovedIntoWorldSpace)
+		{
+			D3DXMATRIX scale;
+			D3DXMATRIX translation;
+			D3DXMatrixScaling(&scale, 2.0f, 3.0f, 1.0f);
+			D3DXMatrixTranslation(&translation, 10.0f, 0.0f, -5.0f);
+
+			std::vector<CStaticBatcher::GeometryType> subMeshes = { MakeTriangle() };
+			std::vector<D3DXMATRIX> worlds = { scale * translation };
+			CStaticBatcher::BatchType batch;
+
+			CStaticBatcher::Merge(subMeshes, worlds, batch);
+
+			Assert::AreEqual(3u, static_cast<unsigned int>(batch.vertices.size()));
+			Assert::AreEqual(10.0f, batch.vertices[1].position.x, kTolerance);
+			Assert::AreEqual(3.0f, batch.vertices[1].position.y, kTolerance);
+			Assert::AreEqual(-5.0f, batch.vertices[1].position.z, kTolerance);
+			Assert::AreEqual(12.0f, batch.vertices[2].position.x, kTolerance);
+			Assert::AreEqual(0.0f, batch.vertices[2].position.y, kTolerance);
+
+			// Texture coordinates are copied untouched.
+			Assert::AreEqual(1.0f, batch.vertices[2].uv.x, kTolerance);
+
+			Assert::AreEqual(10.0f, batch.minPoint.x, kTolerance);
+			Assert::AreEqual(0.0f, batch.minPoint.y, kTolerance);
+			Assert::AreEqual(12.0f, batch.maxPoint.x, kTolerance);
+			Assert::AreEqual(3.0f, batch.maxPoint.y, kTolerance);
+		}
+
+		TEST_METHOD(NormalsUseTheInverseTranspose)
+		{
+			// A surface sloping at 45 degrees, which stops being at 45 degrees once it's stretched along X.
+			CStaticBatcher::GeometryType slope;
+			slope.vertices.push_back(MakeVertex(0.0f, 0.0f, 0.0f, D3DXVECTOR3(1.0f, 1.0f, 0.0f)));
+			slope.vertices.push_back(MakeVertex(1.0f, -1.0f, 0.0f, D3DXVECTOR3(1.0f, 1.0f, 0.0f)));
+			slope.vertices.push_back(MakeVertex(0.0f, 0.0f, 1.0f, D3DXVECTOR3(1.0f, 1.0f, 0.0f)));
+			slope.indices = { 0, 1, 2 };
+
+			D3DXMATRIX scale;
+			D3DXMatrixScaling(&scale, 4.0f, 1.0f, 1.0f);
+
+			std::vector<CStaticBatcher::GeometryType> subMeshes = { slope };
+			std::vector<D3DXMATRIX> worlds = { scale };
+			CStaticBatcher::BatchType batch;
+
+			CStaticBatcher::Merge(subMeshes, worlds, batch);
+
+			const D3DXVECTOR3& normal = batch.vertices[0].normal;
+			D3DXVECTOR3 along = batch.vertices[1].position - batch.vertices[0].position;
+
+			// Still at right angles to the stretched surface, and still unit length. Moving it by the world matrix would give (4, 1, 0) instead.
+			Assert::AreEqual(0.0f, D3DXVec3Dot(&normal, &along), kTolerance);
+			Assert::AreEqual(1.0f, D3DXVec3Length(&normal), kTolerance);
+			Assert::AreEqual(0.25f / sqrtf(0.0625f + 1.0f), normal.x, kTolerance);
+			Assert::AreEqual(1.0f / sqrtf(0.0625f + 1.0f), normal.y, kTolerance);
+		}
+
+		TEST_METHOD(MirroredInstancesHaveTheirWindingFlipped)
+		{
+			D3DXMATRIX identity;
+			D3DXMATRIX mirror;
+			D3DXMatrixIdentity(&identity);
+			D3DXMatrixScaling(&mirror, -1.0f, 1.0f, 1.0f);
+
+			std::vector<CStaticBatcher::GeometryType> subMeshes = { MakeTriangle() };
+			std::vector<D3DXMATRIX> worlds = { identity, mirror };
+			CStaticBatcher::BatchType batch;
+
+			CStaticBatcher::Merge(subMeshes, worlds, batch);
+
+			Assert::AreEqual(6u, static_cast<unsigned int>(batch.indices.size()));
+
+			Assert::AreEqual(0u, batch.indices[0]);
+			Assert::AreEqual(1u, batch.indices[1]);
+			Assert::AreEqual(2u, batch.indices[2]);
+
+			Assert::AreEqual(3u, batch.indices[3]);
+			Assert::AreEqual(5u, batch.indices[4]);
+			Assert::AreEqual(4u, batch.indices[5]);
+
+			// Both triangles still face the way their normals point, so neither gets back face culled.
+			for (unsigned int triangle = 0; triangle < 2; triangle++)
+			{
+				D3DXVECTOR3 facing = GetFacing(batch, triangle * 3);
+				const D3DXVECTOR3& normal = batch.vertices[batch.indices[triangle * 3]].normal;
+
+				Assert::IsTrue(D3DXVec3Dot(&facing, &normal) > 0.0f);
+			}
+		}
+
+		TEST_METHOD(RotatedInstancesKeepTheirWinding)
+		{
+			D3DXMATRIX rotation;
+			D3DXMatrixRotationY(&rotation, 2.0f);
+
+			std::vector<CStaticBatcher::GeometryType> subMeshes = { MakeTriangle() };
+			std::vector<D3DXMATRIX> worlds = { rotation };
+			CStaticBatcher::BatchType batch;
+
+			CStaticBatcher::Merge(subMeshes, worlds, batch);
+
+			Assert::AreEqual(0u, batch.indices[0]);
+			Assert::AreEqual(1u, batch.indices[1]);
+			Assert::AreEqual(2u, batch.indices[2]);
+		}
+
+		TEST_METHOD(IndicesAreRebasedForEachInstance)
+		{
+			CStaticBatcher::GeometryType quad;
+			quad.vertices.push_back(MakeVertex(0.0f, 0.0f, 0.0f, D3DXVECTOR3(0.0f, 0.0f, -1.0f)));
+			quad.vertices.push_back(MakeVertex(0.0f, 1.0f, 0.0f, D3DXVECTOR3(0.0f, 0.0f, -1.0f)));
+			quad.vertices.push_back(MakeVertex(1.0f, 1.0f, 0.0f, D3DXVECTOR3(0.0f, 0.0f, -1.0f)));
+			quad.vertices.push_back(MakeVertex(1.0f, 0.0f, 0.0f, D3DXVECTOR3(0.0f, 0.0f, -1.0f)));
+			quad.indices = { 0, 1, 2, 0, 2, 3 };
+
+			std::vector<CStaticBatcher::GeometryType> subMeshes = { MakeTriangle(), quad };
+			std::vector<D3DXMATRIX> worlds(3);
+			for (unsigned int instance = 0; instance < worlds.size(); instance++)
+			{
+				D3DXMatrixTranslation(&worlds[instance], 5.0f * instance, 0.0f, 0.0f);
+			}
+
+			CStaticBatcher::BatchType batch;
+
+			CStaticBatcher::Merge(subMeshes, worlds, batch);
+
+			Assert::AreEqual(3u * 3u + 4u * 3u, static_cast<unsigned int>(batch.vertices.size()));
+			Assert::AreEqual(3u * 3u + 6u * 3u, static_cast<unsigned int>(batch.indices.size()));
+
+			// Without detail levels, each submesh is one run of indices holding every instance.
+			Assert::AreEqual(2u, static_cast<unsigned int>(batch.subMeshLevels.size()));
+			Assert::AreEqual(1u, static_cast<unsigned int>(batch.subMeshLevels[0].size()));
+			Assert::AreEqual(0u, batch.subMeshLevels[0][0].startIndex);
+			Assert::AreEqual(9u, batch.subMeshLevels[0][0].indexCount);
+			Assert::AreEqual(9u, batch.subMeshLevels[1][0].startIndex);
+			Assert::AreEqual(18u, batch.subMeshLevels[1][0].indexCount);
+
+			// The quads' vertices come after all of the triangles' vertices, one instance after another.
+			for (unsigned int instance = 0; instance < worlds.size(); instance++)
+			{
+				const unsigned int baseVertex = 3u * 3u + 4u * instance;
+				const unsigned int firstIndex = batch.subMeshLevels[1][0].startIndex + 6u * instance;
+
+				for (unsigned int index = 0; index < quad.indices.size(); index++)
+				{
+					Assert::AreEqual(baseVertex + quad.indices[index], batch.indices[firstIndex + index]);
+				}
+
+				Assert::AreEqual(5.0f * instance, batch.vertices[baseVertex].position.x, kTolerance);
+			}
+		}
+
+		TEST_METHOD(EachDetailLevelIsARunOfEveryInstance)
+		{
+			// A quad as two triangles at full detail, and one triangle of it as the lower level.
+			CStaticBatcher::GeometryType quad;
+			quad.vertices.push_back(MakeVertex(0.0f, 0.0f, 0.0f, D3DXVECTOR3(0.0f, 0.0f, -1.0f)));
+			quad.vertices.push_back(MakeVertex(0.0f, 1.0f, 0.0f, D3DXVECTOR3(0.0f, 0.0f, -1.0f)));
+			quad.vertices.push_back(MakeVertex(1.0f, 1.0f, 0.0f, D3DXVECTOR3(0.0f, 0.0f, -1.0f)));
+			quad.vertices.push_back(MakeVertex(1.0f, 0.0f, 0.0f, D3DXVECTOR3(0.0f, 0.0f, -1.0f)));
+			quad.indices = { 0, 1, 2, 0, 2, 3, 0, 1, 3 };
+			quad.levels = { { 0, 6 }, { 6, 3 } };
+
+			std::vector<CStaticBatcher::GeometryType> subMeshes = { quad };
+			std::vector<D3DXMATRIX> worlds(2);
+			D3DXMatrixTranslation(&worlds[0], 0.0f, 0.0f, 0.0f);
+			D3DXMatrixScaling(&worlds[1], 2.0f, 2.0f, 2.0f);
+
+			CStaticBatcher::BatchType batch;
+
+			CStaticBatcher::Merge(subMeshes, worlds, batch);
+
+			// The levels share the vertices, only the indices are copied for each.
+			Assert::AreEqual(8u, static_cast<unsigned int>(batch.vertices.size()));
+			Assert::AreEqual(2u, static_cast<unsigned int>(batch.subMeshLevels[0].size()));
+			Assert::AreEqual(0u, batch.subMeshLevels[0][0].startIndex);
+			Assert::AreEqual(12u, batch.subMeshLevels[0][0].indexCount);
+			Assert::AreEqual(12u, batch.subMeshLevels[0][1].startIndex);
+			Assert::AreEqual(6u, batch.subMeshLevels[0][1].indexCount);
+
+			// Each level's run holds the instances in the same order, so thinning draws the same models at any level.
+			const unsigned int lowStart = batch.subMeshLevels[0][1].startIndex;
+			Assert::AreEqual(0u, batch.indices[lowStart]);
+			Assert::AreEqual(1u, batch.indices[lowStart + 1]);
+			Assert::AreEqual(3u, batch.indices[lowStart + 2]);
+			Assert::AreEqual(4u, batch.indices[lowStart + 3]);
+			Assert::AreEqual(5u, batch.indices[lowStart + 4]);
+			Assert::AreEqual(7u, batch.indices[lowStart + 5]);
+
+			// The larger instance picks the detail level, its box is 2 by 2 by 0.
+			Assert::AreEqual(sqrtf(2.0f), batch.instanceRadius, kTolerance);
+		}
+
+		TEST_METHOD(NothingToMergeGivesAnEmptyBatch)
+		{
+			std::vector<CStaticBatcher::GeometryType> subMeshes = { MakeTriangle() };
+			std::vector<D3DXMATRIX> worlds;
+			CStaticBatcher::BatchType batch;
+
+			CStaticBatcher::Merge(subMeshes, worlds, batch);
+
+			Assert::IsTrue(batch.vertices.empty());
+			Assert::IsTrue(batch.indices.empty());
+			Assert::AreEqual(0u, batch.subMeshLevels[0][0].indexCount);
+			Assert::AreEqual(0.0f, batch.instanceRadius, kTolerance);
+			Assert::AreEqual(0.0f, batch.minPoint.x, kTolerance);
+			Assert::AreEqual(0.0f, batch.maxPoint.x, kTolerance);
+		}
+	};
+}